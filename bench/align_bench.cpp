@@ -0,0 +1,262 @@
+// 强制对齐与完整识别的开销对比
+//
+// 用法：align_bench --models 模型1,模型2 [--threads 4] [--test-files 目录] [--language en] [--output 文件]
+//
+// 对测试目录中的每个媒体文件，先在子进程中做一次完整识别（贪心解码），再在另一个子进程中
+// 把文本强制对齐到同一音频。有同名.txt文件（剧本）时对齐该文本，否则对齐识别出的文本。
+// 结果以JSON输出：两种模式各自的墙钟时间、CPU时间、解码token数、峰值RSS，以及对齐相对识别的加速比。
+
+#include "benchutil.h"
+#include "speechrecognizer.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+
+namespace {
+
+/**
+ * @brief 子进程模式：加载模型，识别或对齐一个文件，把测量结果作为一行JSON写到标准输出
+ */
+int runOne(const QString &input, const QString &mode, const QString &textFile, const QString &model, int threads,
+           const QString &language)
+{
+    QJsonObject result;
+    result["mode"] = mode;
+
+    SpeechRecognizer recognizer;
+    // 基准测试只测量本地whisper，不受用户“优先使用在线API”设置的影响
+    recognizer.setPreferOnlineAPI(false);
+    if (!recognizer.initialize(model)) {
+        result["error"] = "failed to load model";
+        QTextStream(stdout) << QJsonDocument(result).toJson(QJsonDocument::Compact) << endl;
+        return 1;
+    }
+    recognizer.configure(language);
+    recognizer.setThreadCount(threads);
+    recognizer.setDecodingProfile("greedy");
+
+    QString text;
+    if (mode == "align") {
+        QFile file(textFile);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            result["error"] = "cannot read text file";
+            QTextStream(stdout) << QJsonDocument(result).toJson(QJsonDocument::Compact) << endl;
+            return 1;
+        }
+        text = QString::fromUtf8(file.readAll());
+    }
+
+    RecognitionJobStats stats;
+    int segmentCount = 0;
+    QString transcript;
+    QString error;
+    QObject::connect(&recognizer, &SpeechRecognizer::jobStatsReady, [&](const RecognitionJobStats &jobStats) {
+        stats = jobStats;
+    });
+    QObject::connect(&recognizer, &SpeechRecognizer::segmentsRecognized,
+                     [&](const QString &, const QVector<TranscriptSegment> &segments, qint64, qint64) {
+        segmentCount = segments.size();
+    });
+    QObject::connect(&recognizer, &SpeechRecognizer::recognitionFinished, [&](const QString &finished) {
+        transcript = finished;
+        QCoreApplication::quit();
+    });
+    QObject::connect(&recognizer, &SpeechRecognizer::recognitionError, [&](const QString &message) {
+        error = message;
+        QCoreApplication::quit();
+    });
+
+    const ResourceUsage before = currentUsage();
+    QElapsedTimer timer;
+    timer.start();
+    const bool started = (mode == "align") ? recognizer.alignText(input, text) : recognizer.recognizeFile(input);
+    if (!started) {
+        result["error"] = error.isEmpty() ? QString("failed to start") : error;
+        QTextStream(stdout) << QJsonDocument(result).toJson(QJsonDocument::Compact) << endl;
+        return 1;
+    }
+    QCoreApplication::exec();
+
+    const double wallSeconds = timer.nsecsElapsed() / 1e9;
+    const ResourceUsage after = currentUsage();
+    if (!error.isEmpty()) {
+        result["error"] = error;
+    }
+    result["wall_seconds"] = wallSeconds;
+    result["inference_ms"] = stats.inferenceMs;
+    result["cpu_seconds"] = after.cpuSeconds - before.cpuSeconds;
+    result["peak_rss_kb"] = after.peakRssKb;
+    result["tokens"] = stats.tokensGenerated;
+    result["segments"] = segmentCount;
+    result["text"] = transcript;
+
+    QTextStream(stdout) << QJsonDocument(result).toJson(QJsonDocument::Compact) << endl;
+    return error.isEmpty() ? 0 : 1;
+}
+
+/**
+ * @brief 在子进程中运行一次，返回它输出的JSON
+ */
+QJsonObject runChild(const QStringList &args)
+{
+    QProcess child;
+    child.setProcessChannelMode(QProcess::SeparateChannels);
+    child.start(QCoreApplication::applicationFilePath(), args);
+    child.waitForFinished(-1);
+
+    const QList<QByteArray> lines = child.readAllStandardOutput().trimmed().split('\n');
+    QJsonObject result = QJsonDocument::fromJson(lines.last()).object();
+    if (result.isEmpty()) {
+        result["error"] = QString("child exited with code %1: %2").arg(child.exitCode())
+                              .arg(QString::fromLocal8Bit(child.readAllStandardError().right(500)));
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("align_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("EnPlayer forced alignment vs. recognition benchmark");
+    parser.addHelpOption();
+    QCommandLineOption modelsOption("models", "逗号分隔的whisper模型文件", "paths");
+    QCommandLineOption threadsOption("threads", "线程数", "count", QString::number(qMin(8, QThread::idealThreadCount())));
+    QCommandLineOption testFilesOption("test-files", "测试媒体目录", "dir", ENPLAYER_TEST_FILES_DIR);
+    QCommandLineOption languageOption("language", "识别语言", "code", "en");
+    QCommandLineOption outputOption("output", "JSON结果输出文件，默认输出到标准输出", "file");
+    QCommandLineOption runOneOption("run-one", "内部使用：在子进程中处理一个文件", "file");
+    QCommandLineOption modeOption("mode", "内部使用：recognize或align", "mode", "recognize");
+    QCommandLineOption textFileOption("text-file", "内部使用：要对齐的文本", "file");
+    parser.addOption(modelsOption);
+    parser.addOption(threadsOption);
+    parser.addOption(testFilesOption);
+    parser.addOption(languageOption);
+    parser.addOption(outputOption);
+    parser.addOption(runOneOption);
+    parser.addOption(modeOption);
+    parser.addOption(textFileOption);
+    parser.process(app);
+
+    const QString language = parser.value(languageOption);
+    const QString threads = parser.value(threadsOption);
+
+    if (parser.isSet(runOneOption)) {
+        return runOne(parser.value(runOneOption), parser.value(modeOption), parser.value(textFileOption),
+                      parser.value(modelsOption), threads.toInt(), language);
+    }
+
+    const QStringList models = splitList(parser.value(modelsOption));
+    if (models.isEmpty()) {
+        QTextStream(stderr) << "需要通过--models指定至少一个whisper模型" << endl;
+        return 2;
+    }
+
+    const QDir testDir(parser.value(testFilesOption));
+    const QStringList filters = { "*.wav", "*.mp3", "*.m4a", "*.flac", "*.ogg", "*.mp4", "*.mkv", "*.webm" };
+    QStringList inputs;
+    for (const QString &name : testDir.entryList(filters, QDir::Files, QDir::Name)) {
+        inputs << testDir.filePath(name);
+    }
+    if (inputs.isEmpty()) {
+        QTextStream(stderr) << "测试目录中没有媒体文件" << endl;
+        return 2;
+    }
+
+    QTemporaryDir textDir;
+    QJsonArray runs;
+    int failures = 0;
+
+    for (const QString &model : models) {
+        for (const QString &input : inputs) {
+            const QStringList common = QStringList() << "--run-one" << input << "--models" << model
+                                                     << "--threads" << threads << "--language" << language;
+            QTextStream(stderr) << QFileInfo(model).fileName() << " input=" << QFileInfo(input).fileName() << " ... " << flush;
+
+            QJsonObject entry;
+            entry["model"] = QFileInfo(model).fileName();
+            entry["input"] = QFileInfo(input).fileName();
+            entry["threads"] = threads.toInt();
+            entry["audio_seconds"] = mediaDurationSeconds(input);
+
+            QJsonObject recognition = runChild(QStringList(common) << "--mode" << "recognize");
+
+            // 优先对齐同名剧本，否则对齐刚识别出的文本
+            QString textPath = QFileInfo(input).path() + "/" + QFileInfo(input).completeBaseName() + ".txt";
+            entry["text_source"] = QFileInfo::exists(textPath) ? "script" : "recognized";
+            if (!QFileInfo::exists(textPath)) {
+                textPath = textDir.filePath(QFileInfo(input).completeBaseName() + ".txt");
+                QFile file(textPath);
+                if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                    file.write(recognition.value("text").toString().toUtf8());
+                }
+            }
+            recognition.remove("text");
+
+            QJsonObject alignment;
+            if (recognition.contains("error")) {
+                alignment["error"] = "skipped: recognition failed";
+            } else {
+                alignment = runChild(QStringList(common) << "--mode" << "align" << "--text-file" << textPath);
+                alignment.remove("text");
+            }
+            entry["recognition"] = recognition;
+            entry["alignment"] = alignment;
+
+            if (recognition.contains("error") || alignment.contains("error")) {
+                ++failures;
+                QTextStream(stderr) << "failed: " << (recognition.contains("error") ? recognition : alignment).value("error").toString() << endl;
+            } else {
+                const double recognitionSeconds = recognition["wall_seconds"].toDouble();
+                const double alignmentSeconds = alignment["wall_seconds"].toDouble();
+                const double speedup = alignmentSeconds > 0 ? recognitionSeconds / alignmentSeconds : 0.0;
+                entry["alignment_speedup"] = speedup;
+                entry["cpu_ratio"] = recognition["cpu_seconds"].toDouble() > 0
+                        ? alignment["cpu_seconds"].toDouble() / recognition["cpu_seconds"].toDouble() : 0.0;
+                QTextStream(stderr) << QString::number(speedup, 'f', 2) << "x faster than recognition" << endl;
+            }
+            runs.append(entry);
+        }
+    }
+
+    QJsonObject context;
+    context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    context["host"] = QSysInfo::machineHostName();
+    context["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+    context["logical_cpus"] = QThread::idealThreadCount();
+    context["language"] = language;
+
+    QJsonObject report;
+    report["context"] = context;
+    report["runs"] = runs;
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    const QString outputPath = parser.value(outputOption);
+    if (outputPath.isEmpty()) {
+        QTextStream(stdout) << json;
+    } else {
+        QFile output(outputPath);
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "无法写入结果文件: " << outputPath << endl;
+            return 1;
+        }
+        output.write(json);
+    }
+    return failures == 0 ? 0 : 1;
+}
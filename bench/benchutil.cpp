@@ -0,0 +1,52 @@
+#include "benchutil.h"
+#include "wavreader.h"
+
+#include <QProcess>
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+ResourceUsage currentUsage()
+{
+    ResourceUsage usage;
+#if defined(Q_OS_UNIX)
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        usage.cpuSeconds = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6
+                         + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+#if defined(Q_OS_MACOS)
+        usage.peakRssKb = ru.ru_maxrss / 1024; // macOS以字节为单位
+#else
+        usage.peakRssKb = ru.ru_maxrss;
+#endif
+    }
+#endif
+    return usage;
+}
+
+double mediaDurationSeconds(const QString &path)
+{
+    WavReader reader;
+    if (reader.open(path) && reader.format().sampleRate > 0) {
+        return double(reader.frameCount()) / reader.format().sampleRate;
+    }
+
+    QProcess ffprobe;
+    ffprobe.start("ffprobe", QStringList() << "-v" << "error" << "-show_entries" << "format=duration"
+                                           << "-of" << "default=noprint_wrappers=1:nokey=1" << path);
+    if (!ffprobe.waitForFinished(30000)) {
+        ffprobe.kill();
+        return 0;
+    }
+    return QString::fromUtf8(ffprobe.readAllStandardOutput()).trimmed().toDouble();
+}
+
+QStringList splitList(const QString &value)
+{
+    QStringList items;
+    for (const QString &item : value.split(',', QString::SkipEmptyParts)) {
+        items << item.trimmed();
+    }
+    return items;
+}
@@ -0,0 +1,31 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief 进程资源使用情况
+ */
+struct ResourceUsage
+{
+    double cpuSeconds = 0;     ///< 用户态和内核态CPU时间之和
+    qint64 peakRssKb = 0;      ///< 进程峰值常驻内存
+};
+
+/**
+ * @brief 读取当前进程的CPU时间和峰值RSS（非Unix平台返回0）
+ */
+ResourceUsage currentUsage();
+
+/**
+ * @brief 媒体时长（秒）：WAV直接读取文件头，其他格式使用ffprobe
+ */
+double mediaDurationSeconds(const QString &path);
+
+/**
+ * @brief 拆分逗号分隔的命令行参数，去掉空项和首尾空白
+ */
+QStringList splitList(const QString &value);
+
+#endif // BENCHUTIL_H
@@ -0,0 +1,245 @@
+// 字幕全文索引的查询延迟测试
+//
+// 用法：index_bench [--hours 10000] [--queries 2000] [--dir 目录] [--output 文件]
+//
+// 生成一个合成媒体库：每个文档是一小时的字幕（5秒一段，每段约12个词，词频服从Zipf分布），
+// 逐个加入索引（与识别任务完成时的增量索引相同），然后随机查询单个常见词、单个罕见词、
+// 两个词的组合和前缀，统计每类查询的延迟分位数。指定--dir时索引保留在该目录中，
+// 再次运行时文档数足够则跳过建库，只测查询。结果以JSON输出，p99超过50毫秒时返回1。
+
+#include "benchutil.h"
+#include "mappedtranscript.h"
+#include "transcriptindex.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 查询延迟目标（毫秒）
+const double kTargetMs = 50.0;
+
+const int kVocabularySize = 20000;
+const int kSegmentMs = 5000;
+const int kSegmentsPerHour = 3600 * 1000 / kSegmentMs;
+
+/**
+ * @brief 第i个合成词：i+16的十六进制各位映射为音节，至少两个音节，互不相同
+ */
+QString syntheticWord(int i)
+{
+    static const char *const syllables[16] = { "ka", "lo", "mi", "ne", "ru", "sa", "ti", "vo",
+                                               "ze", "pu", "da", "fe", "gi", "ho", "ju", "be" };
+    QString word;
+    for (int value = i + 16; value > 0; value /= 16) {
+        word.prepend(QLatin1String(syllables[value % 16]));
+    }
+    return word;
+}
+
+/**
+ * @brief 按Zipf分布抽取词的序号，序号越小越常见
+ */
+class ZipfSampler
+{
+public:
+    explicit ZipfSampler(int size) : m_cumulative(size)
+    {
+        double sum = 0;
+        for (int rank = 0; rank < size; ++rank) {
+            sum += 1.0 / (rank + 1);
+            m_cumulative[rank] = sum;
+        }
+    }
+
+    int operator()(std::mt19937 &random) const
+    {
+        std::uniform_real_distribution<double> uniform(0, m_cumulative.back());
+        const auto it = std::upper_bound(m_cumulative.begin(), m_cumulative.end(), uniform(random));
+        return qMin(int(it - m_cumulative.begin()), int(m_cumulative.size()) - 1);
+    }
+
+private:
+    std::vector<double> m_cumulative;
+};
+
+QJsonObject latencySummary(std::vector<double> millis, int totalHits)
+{
+    QJsonObject summary;
+    summary["queries"] = int(millis.size());
+    if (millis.empty()) {
+        return summary;
+    }
+    std::sort(millis.begin(), millis.end());
+    const auto percentile = [&millis](double p) {
+        return millis[qMin(millis.size() - 1, size_t(p * millis.size()))];
+    };
+    summary["p50_ms"] = percentile(0.50);
+    summary["p95_ms"] = percentile(0.95);
+    summary["p99_ms"] = percentile(0.99);
+    summary["max_ms"] = millis.back();
+    summary["mean_hits"] = double(totalHits) / millis.size();
+    return summary;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("index_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("EnPlayer transcript index query latency benchmark");
+    parser.addHelpOption();
+    QCommandLineOption hoursOption("hours", "合成媒体库的小时数（每小时一个文档）", "count", "10000");
+    QCommandLineOption queriesOption("queries", "每类查询的次数", "count", "2000");
+    QCommandLineOption dirOption("dir", "索引和字幕目录，默认使用临时目录", "dir");
+    QCommandLineOption outputOption("output", "JSON结果输出文件，默认输出到标准输出", "file");
+    parser.addOption(hoursOption);
+    parser.addOption(queriesOption);
+    parser.addOption(dirOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    const int hours = qMax(1, parser.value(hoursOption).toInt());
+    const int queryCount = qMax(1, parser.value(queriesOption).toInt());
+
+    QTemporaryDir temporaryDir;
+    const QDir libraryDir(parser.isSet(dirOption) ? parser.value(dirOption) : temporaryDir.path());
+    if (!libraryDir.mkpath(".")) {
+        QTextStream(stderr) << "无法创建目录: " << libraryDir.path() << endl;
+        return 2;
+    }
+
+    QString error;
+    TranscriptIndex index;
+    if (!index.open(libraryDir.filePath("index"), &error)) {
+        QTextStream(stderr) << "无法打开索引: " << error << endl;
+        return 2;
+    }
+
+    QStringList vocabulary;
+    vocabulary.reserve(kVocabularySize);
+    for (int i = 0; i < kVocabularySize; ++i) {
+        vocabulary << syntheticWord(i);
+    }
+    const ZipfSampler sampler(kVocabularySize);
+    std::mt19937 random(20240601);
+
+    // 建库：逐个文档写字幕缓存并加入索引
+    QElapsedTimer buildTimer;
+    buildTimer.start();
+    const int existing = index.documentCount();
+    for (int document = existing; document < hours; ++document) {
+        QVector<TranscriptSegment> segments;
+        segments.reserve(kSegmentsPerHour);
+        for (int i = 0; i < kSegmentsPerHour; ++i) {
+            TranscriptSegment segment;
+            segment.startMs = qint64(i) * kSegmentMs;
+            segment.endMs = segment.startMs + kSegmentMs - 200;
+            const int wordCount = 8 + int(random() % 9);
+            for (int w = 0; w < wordCount; ++w) {
+                segment.text += QLatin1Char(' ') + vocabulary[sampler(random)];
+            }
+            segments << segment;
+        }
+        const QString name = QString("hour%1").arg(document, 6, 10, QLatin1Char('0'));
+        const QString transcriptPath = libraryDir.filePath(name + ".qet");
+        if (!MappedTranscript::write(transcriptPath, segments, &error)
+            || !index.addDocument("/library/" + name + ".mp4", transcriptPath, segments, &error)) {
+            QTextStream(stderr) << "建库失败: " << error << endl;
+            return 2;
+        }
+        if ((document + 1) % 100 == 0) {
+            QTextStream(stderr) << "indexed " << (document + 1) << "/" << hours << " hours, "
+                                << index.runCount() << " runs\r" << flush;
+        }
+    }
+    const double buildSeconds = buildTimer.elapsed() / 1000.0;
+    QTextStream(stderr) << endl;
+
+    // 查询：常见词取前100个，罕见词取后半部分，组合查询是同一段中出现的两个词
+    struct QueryKind
+    {
+        const char *name;
+        std::vector<double> millis;
+        int hits = 0;
+    };
+    QueryKind kinds[] = { { "common_term", {}, 0 }, { "rare_term", {}, 0 }, { "two_terms", {}, 0 }, { "prefix", {}, 0 } };
+    for (int q = 0; q < queryCount; ++q) {
+        const QString common = vocabulary[int(random() % 100)];
+        const QString rare = vocabulary[kVocabularySize / 2 + int(random() % (kVocabularySize / 2))];
+        const QString queries[] = {
+            common + QLatin1Char(' '),
+            rare + QLatin1Char(' '),
+            vocabulary[sampler(random)] + QLatin1Char(' ') + vocabulary[sampler(random)] + QLatin1Char(' '),
+            vocabulary[sampler(random)].left(3),
+        };
+        for (int k = 0; k < 4; ++k) {
+            QElapsedTimer timer;
+            timer.start();
+            const QVector<TranscriptSearchHit> hits = index.search(queries[k]);
+            kinds[k].millis.push_back(timer.nsecsElapsed() / 1e6);
+            kinds[k].hits += hits.size();
+        }
+    }
+
+    QJsonObject results;
+    double worstP99 = 0;
+    for (const QueryKind &kind : kinds) {
+        const QJsonObject summary = latencySummary(kind.millis, kind.hits);
+        worstP99 = qMax(worstP99, summary["p99_ms"].toDouble());
+        results[kind.name] = summary;
+    }
+
+    const ResourceUsage usage = currentUsage();
+    QJsonObject library;
+    library["hours"] = hours;
+    library["documents"] = index.documentCount();
+    library["runs"] = index.runCount();
+    library["segments"] = double(hours) * kSegmentsPerHour;
+    library["build_seconds"] = buildSeconds;
+    library["peak_rss_kb"] = double(usage.peakRssKb);
+
+    QJsonObject context;
+    context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    context["host"] = QSysInfo::machineHostName();
+    context["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+    context["logical_cpus"] = QThread::idealThreadCount();
+
+    QJsonObject report;
+    report["context"] = context;
+    report["library"] = library;
+    report["queries"] = results;
+    report["target_ms"] = kTargetMs;
+    report["within_target"] = worstP99 <= kTargetMs;
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    const QString outputPath = parser.value(outputOption);
+    if (outputPath.isEmpty()) {
+        QTextStream(stdout) << json;
+    } else {
+        QFile output(outputPath);
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "无法写入结果文件: " << outputPath << endl;
+            return 1;
+        }
+        output.write(json);
+    }
+    return worstP99 <= kTargetMs ? 0 : 1;
+}
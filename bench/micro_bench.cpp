@@ -0,0 +1,379 @@
+// 音频和文本热点路径的微基准测试
+//
+// 用法：bench [--test-files 目录] [--seconds 秒数] [--filter 名称] [--model 模型] [--output 文件]
+// 输入由test_files/test_audio.wav循环拼接生成，结果以JSON输出，每个内核一项，便于跟踪性能回归。
+
+#include "pcmconvert.h"
+#include "resampler.h"
+#include "transcript.h"
+#include "vad.h"
+#include "wavreader.h"
+#include "whisper.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTextStream>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+const int kRepetitions = 5;
+const double kMinRepetitionSeconds = 0.2;
+
+// 阻止编译器把基准循环中的计算当作无用代码删除
+template <class T>
+inline void keepAlive(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+double elapsedSeconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief 一个基准项：itemsPerIteration和bytesPerIteration用于换算吞吐量
+ */
+struct Benchmark
+{
+    QString name;
+    double itemsPerIteration;
+    double bytesPerIteration;
+    std::function<void()> body;
+};
+
+/**
+ * @brief 先校准迭代次数使每轮至少运行kMinRepetitionSeconds，再重复kRepetitions轮取中位数
+ */
+QJsonObject runBenchmark(const Benchmark &benchmark)
+{
+    benchmark.body(); // 预热：页面分配、系数表和CPU特性检测
+
+    qint64 iterations = 1;
+    for (;;) {
+        auto start = std::chrono::steady_clock::now();
+        for (qint64 i = 0; i < iterations; ++i) {
+            benchmark.body();
+        }
+        double seconds = elapsedSeconds(start);
+        if (seconds >= kMinRepetitionSeconds || iterations >= (qint64(1) << 30)) {
+            break;
+        }
+        double scale = seconds > 0 ? kMinRepetitionSeconds / seconds * 1.2 : 10.0;
+        iterations = std::max(iterations + 1, qint64(iterations * std::min(scale, 10.0)));
+    }
+
+    std::vector<double> nsPerIteration;
+    for (int r = 0; r < kRepetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        for (qint64 i = 0; i < iterations; ++i) {
+            benchmark.body();
+        }
+        nsPerIteration.push_back(elapsedSeconds(start) * 1e9 / iterations);
+    }
+    std::sort(nsPerIteration.begin(), nsPerIteration.end());
+    const double median = nsPerIteration[nsPerIteration.size() / 2];
+
+    QJsonObject result;
+    result["name"] = benchmark.name;
+    result["iterations"] = iterations;
+    result["repetitions"] = kRepetitions;
+    result["ns_per_iter_median"] = median;
+    result["ns_per_iter_min"] = nsPerIteration.front();
+    result["ns_per_iter_max"] = nsPerIteration.back();
+    if (benchmark.itemsPerIteration > 0) {
+        result["items_per_second"] = benchmark.itemsPerIteration * 1e9 / median;
+    }
+    if (benchmark.bytesPerIteration > 0) {
+        result["bytes_per_second"] = benchmark.bytesPerIteration * 1e9 / median;
+    }
+    return result;
+}
+
+/**
+ * @brief 读取test_files中的音频并循环拼接到指定长度；文件不可用时生成固定种子的合成信号
+ */
+std::vector<int16_t> loadInputAudio(const QString &path, int seconds, int &sampleRate, QString &source)
+{
+    std::vector<int16_t> base;
+    WavReader reader;
+    if (reader.open(path) && reader.isPcm16()) {
+        const WavFormat &format = reader.format();
+        std::vector<float> mono(size_t(reader.frameCount()));
+        downmixS16ToMono(reader.pcm16Data(), mono.size(), format.channels, mono.data());
+        base.resize(mono.size());
+        convertF32ToS16(mono.data(), base.data(), mono.size());
+        sampleRate = format.sampleRate;
+        source = path;
+    }
+
+    if (base.empty()) {
+        sampleRate = 44100;
+        source = "synthetic";
+        std::mt19937 random(42);
+        std::normal_distribution<float> noise(0.0f, 200.0f);
+        base.resize(size_t(sampleRate) * 5);
+        for (size_t i = 0; i < base.size(); ++i) {
+            // 每秒交替出现0.6秒的调制音和0.4秒的噪声，近似语音和停顿
+            double t = double(i) / sampleRate;
+            bool voiced = std::fmod(t, 1.0) < 0.6;
+            double tone = voiced ? 8000.0 * std::sin(2 * kPi * 220 * t) * (0.6 + 0.4 * std::sin(2 * kPi * 4 * t)) : 0.0;
+            base[i] = int16_t(std::max(-32768.0, std::min(32767.0, tone + noise(random))));
+        }
+    }
+
+    std::vector<int16_t> samples(size_t(sampleRate) * seconds);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = base[i % base.size()];
+    }
+    return samples;
+}
+
+/**
+ * @brief 生成固定种子的字幕片段，文本长度与实际识别结果相近
+ */
+QVector<TranscriptSegment> makeSegments(int count, qint64 startMs)
+{
+    static const char *const words[] = {
+        "the", "lecture", "continues", "with", "a", "short", "review", "of", "signal",
+        "processing", "and", "then", "moves", "on", "to", "speech", "recognition", "models"
+    };
+    const int wordCount = int(sizeof(words) / sizeof(words[0]));
+
+    std::mt19937 random(7);
+    QVector<TranscriptSegment> segments;
+    segments.reserve(count);
+    qint64 time = startMs;
+    for (int i = 0; i < count; ++i) {
+        TranscriptSegment segment;
+        segment.startMs = time;
+        segment.endMs = time + 1500 + qint64(random() % 3000);
+        time = segment.endMs + qint64(random() % 500);
+
+        int n = 6 + int(random() % 10);
+        for (int w = 0; w < n; ++w) {
+            if (w > 0) {
+                segment.text += ' ';
+            }
+            segment.text += QLatin1String(words[random() % wordCount]);
+        }
+        segments.append(segment);
+    }
+    return segments;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("EnPlayer micro-benchmarks");
+    parser.addHelpOption();
+    QCommandLineOption testFilesOption("test-files", "测试音频目录", "dir", ENPLAYER_TEST_FILES_DIR);
+    QCommandLineOption secondsOption("seconds", "基准输入音频长度（秒）", "seconds", "60");
+    QCommandLineOption filterOption("filter", "只运行名称包含该字符串的基准", "text");
+    QCommandLineOption modelOption("model", "whisper模型文件，指定后才测试梅尔频谱计算", "path");
+    QCommandLineOption outputOption("output", "JSON结果输出文件，默认输出到标准输出", "file");
+    parser.addOption(testFilesOption);
+    parser.addOption(secondsOption);
+    parser.addOption(filterOption);
+    parser.addOption(modelOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    const int seconds = std::max(1, parser.value(secondsOption).toInt());
+    const QString filter = parser.value(filterOption);
+
+    int inputRate = 0;
+    QString inputSource;
+    const std::vector<int16_t> input = loadInputAudio(parser.value(testFilesOption) + "/test_audio.wav",
+                                                      seconds, inputRate, inputSource);
+    const size_t inputCount = input.size();
+
+    // 各基准共用的缓冲区在计时之外分配
+    std::vector<float> inputFloat(inputCount);
+    convertS16ToF32(input.data(), inputFloat.data(), inputCount);
+
+    std::vector<int16_t> stereo(inputCount * 2);
+    for (size_t i = 0; i < inputCount; ++i) {
+        stereo[i * 2] = input[i];
+        stereo[i * 2 + 1] = int16_t(input[i] / 2);
+    }
+
+    std::vector<int16_t> speech16k;
+    {
+        AudioConverter converter(inputRate, 1, WHISPER_SAMPLE_RATE);
+        converter.pushFrames(input.data(), inputCount, speech16k);
+        converter.finish(speech16k);
+    }
+    std::vector<float> speech16kFloat(speech16k.size());
+    convertS16ToF32(speech16k.data(), speech16kFloat.data(), speech16k.size());
+
+    QByteArray wavBytes;
+    {
+        QFile file(parser.value(testFilesOption) + "/test_audio.wav");
+        if (file.open(QIODevice::ReadOnly)) {
+            wavBytes = file.read(4096);
+        }
+    }
+
+    const QVector<TranscriptSegment> transcript = makeSegments(10000, 0);
+    const qint64 rangeStart = transcript[transcript.size() / 2].startMs;
+    const QVector<TranscriptSegment> rangeSegments = makeSegments(100, rangeStart);
+    const qint64 rangeEnd = rangeSegments.last().endMs;
+
+    std::vector<float> floatOutput(inputCount * 2);
+    std::vector<int16_t> s16Output(inputCount * 2);
+    std::vector<float> resampled;
+    resampled.reserve(inputCount);
+    std::vector<int16_t> converted;
+    converted.reserve(inputCount);
+
+    std::vector<Benchmark> benchmarks;
+
+    benchmarks.push_back({ "pcm/s16_to_f32", double(inputCount), double(inputCount * sizeof(int16_t)), [&]() {
+        convertS16ToF32(input.data(), floatOutput.data(), inputCount);
+        keepAlive(floatOutput[0]);
+    } });
+    benchmarks.push_back({ "pcm/s16_to_f32_scalar", double(inputCount), double(inputCount * sizeof(int16_t)), [&]() {
+        convertS16ToF32Scalar(input.data(), floatOutput.data(), inputCount);
+        keepAlive(floatOutput[0]);
+    } });
+    benchmarks.push_back({ "pcm/f32_to_s16", double(inputCount), double(inputCount * sizeof(float)), [&]() {
+        convertF32ToS16(inputFloat.data(), s16Output.data(), inputCount);
+        keepAlive(s16Output[0]);
+    } });
+
+    benchmarks.push_back({ "downmix/stereo", double(inputCount), double(stereo.size() * sizeof(int16_t)), [&]() {
+        downmixS16ToMono(stereo.data(), inputCount, 2, floatOutput.data());
+        keepAlive(floatOutput[0]);
+    } });
+
+    const int resampleRates[] = { inputRate, 48000, 22050 };
+    for (int rate : resampleRates) {
+        benchmarks.push_back({ QString("resample/%1_to_16000").arg(rate), double(inputCount), double(inputCount * sizeof(float)), [&, rate]() {
+            PolyphaseResampler resampler(rate, WHISPER_SAMPLE_RATE);
+            resampled.clear();
+            resampler.process(inputFloat.data(), inputCount, resampled);
+            resampler.flush(resampled);
+            keepAlive(resampled[0]);
+        } });
+    }
+    benchmarks.push_back({ "convert/stereo_to_16k_s16", double(inputCount), double(stereo.size() * sizeof(int16_t)), [&]() {
+        AudioConverter converter(inputRate, 2, WHISPER_SAMPLE_RATE);
+        converted.clear();
+        converter.pushFrames(stereo.data(), inputCount, converted);
+        converter.finish(converted);
+        keepAlive(converted[0]);
+    } });
+
+    if (!wavBytes.isEmpty()) {
+        benchmarks.push_back({ "wav/parse_header", 1, 0, [&]() {
+            WavFormat format;
+            parseWavHeader(reinterpret_cast<const uchar *>(wavBytes.constData()), wavBytes.size(), format);
+            keepAlive(format.dataOffset);
+        } });
+        const QString wavPath = parser.value(testFilesOption) + "/test_audio.wav";
+        benchmarks.push_back({ "wav/mmap_open", 1, 0, [&, wavPath]() {
+            WavReader reader;
+            reader.open(wavPath);
+            keepAlive(reader.frameCount());
+        } });
+    }
+
+    benchmarks.push_back({ "vad/frame_energies", double(speech16kFloat.size()), double(speech16kFloat.size() * sizeof(float)), [&]() {
+        std::vector<float> energies;
+        computeFrameEnergies(speech16kFloat.data(), speech16kFloat.size(), WHISPER_SAMPLE_RATE / 50, energies);
+        keepAlive(energies[0]);
+    } });
+
+    benchmarks.push_back({ "transcript/merge_range", double(transcript.size()), 0, [&]() {
+        QVector<TranscriptSegment> merged = mergeTranscriptSegments(transcript, rangeSegments, rangeStart, rangeEnd);
+        keepAlive(merged.size());
+    } });
+    benchmarks.push_back({ "transcript/format", double(transcript.size()), 0, [&]() {
+        QString text = formatTranscript(transcript);
+        keepAlive(text.size());
+    } });
+
+    whisper_context *whisperCtx = nullptr;
+    const QString modelPath = parser.value(modelOption);
+    if (!modelPath.isEmpty()) {
+        whisper_context_params ctxParams = whisper_context_default_params();
+        whisperCtx = whisper_init_from_file_with_params(modelPath.toUtf8().constData(), ctxParams);
+    }
+    if (whisperCtx) {
+        // 梅尔频谱按30秒窗口计算，与识别时每次送入的音频长度一致
+        const int melSamples = int(std::min(speech16kFloat.size(), size_t(30 * WHISPER_SAMPLE_RATE)));
+        benchmarks.push_back({ "mel/pcm_to_mel_30s", double(melSamples), double(melSamples * sizeof(float)), [&, melSamples]() {
+            whisper_pcm_to_mel(whisperCtx, speech16kFloat.data(), melSamples, 1);
+        } });
+    }
+
+    QJsonArray results;
+    for (const Benchmark &benchmark : benchmarks) {
+        if (!filter.isEmpty() && !benchmark.name.contains(filter)) {
+            continue;
+        }
+        QJsonObject result = runBenchmark(benchmark);
+        QTextStream(stderr) << result["name"].toString() << ": "
+                            << result["ns_per_iter_median"].toDouble() / 1e6 << " ms/iter" << endl;
+        results.append(result);
+    }
+
+    QString melStatus = modelPath.isEmpty() ? QString("skipped (no --model)") : modelPath;
+    if (whisperCtx) {
+        whisper_free(whisperCtx);
+    } else if (!modelPath.isEmpty()) {
+        melStatus = "skipped (failed to load " + modelPath + ")";
+    }
+
+    QJsonObject context;
+    context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    context["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+    context["kernel"] = QSysInfo::kernelType() + " " + QSysInfo::kernelVersion();
+    context["input"] = inputSource;
+    context["input_sample_rate"] = inputRate;
+    context["input_seconds"] = seconds;
+    context["mel"] = melStatus;
+
+    QJsonObject report;
+    report["context"] = context;
+    report["benchmarks"] = results;
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    const QString outputPath = parser.value(outputOption);
+    if (outputPath.isEmpty()) {
+        QTextStream(stdout) << json;
+    } else {
+        QFile output(outputPath);
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "无法写入结果文件: " << outputPath << endl;
+            return 1;
+        }
+        output.write(json);
+    }
+    return 0;
+}
@@ -0,0 +1,330 @@
+// SpeechRecognizer端到端吞吐量和延迟基准测试
+//
+// 用法：pipeline_bench --models 模型1,模型2 [--threads 1,4,8] [--profiles greedy,beam]
+//                      [--synthetic 60,600] [--corpus 目录] [--language en] [--output 文件]
+//
+// 每个（模型, 线程数, 解码策略, 输入）组合在独立的子进程中运行一次完整识别，
+// 这样峰值RSS和CPU时间只属于这一次运行。合成输入由test_files/test_audio.wav循环拼接而成。
+// 结果以JSON输出：墙钟时间、实时率、首个片段延迟、峰值RSS和CPU利用率。
+
+#include "benchutil.h"
+#include "speechrecognizer.h"
+#include "wavreader.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+
+namespace {
+
+void appendLe16(QByteArray &out, quint16 value)
+{
+    out.append(char(value & 0xff)).append(char(value >> 8));
+}
+
+void appendLe32(QByteArray &out, quint32 value)
+{
+    appendLe16(out, quint16(value & 0xffff));
+    appendLe16(out, quint16(value >> 16));
+}
+
+/**
+ * @brief 把源WAV的样本循环拼接到指定时长，按源格式写出（保留原采样率，识别时走进程内重采样）
+ */
+bool writeLengthenedWav(const QString &sourcePath, int seconds, const QString &outputPath)
+{
+    WavReader reader;
+    if (!reader.open(sourcePath) || !reader.isPcm16() || reader.frameCount() == 0) {
+        return false;
+    }
+    const WavFormat &format = reader.format();
+    const qint64 sourceBytes = reader.frameCount() * format.blockAlign;
+    const qint64 dataBytes = qint64(seconds) * format.sampleRate * format.blockAlign;
+
+    QFile output(outputPath);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QByteArray header;
+    header.append("RIFF");
+    appendLe32(header, quint32(36 + dataBytes));
+    header.append("WAVEfmt ");
+    appendLe32(header, 16);
+    appendLe16(header, 1);
+    appendLe16(header, quint16(format.channels));
+    appendLe32(header, quint32(format.sampleRate));
+    appendLe32(header, quint32(format.sampleRate * format.blockAlign));
+    appendLe16(header, quint16(format.blockAlign));
+    appendLe16(header, 16);
+    header.append("data");
+    appendLe32(header, quint32(dataBytes));
+    output.write(header);
+
+    const char *source = reinterpret_cast<const char *>(reader.pcm16Data());
+    qint64 written = 0;
+    while (written < dataBytes) {
+        qint64 n = qMin(sourceBytes, dataBytes - written);
+        if (output.write(source, n) != n) {
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+/**
+ * @brief 子进程模式：加载模型并识别一个文件，把测量结果作为一行JSON写到标准输出
+ */
+int runOne(const QString &input, const QString &model, int threads, const QString &profile, const QString &language)
+{
+    QJsonObject result;
+    result["input"] = input;
+    result["model"] = QFileInfo(model).fileName();
+    result["threads"] = threads;
+    result["profile"] = profile;
+
+    SpeechRecognizer recognizer;
+    // 基准测试只测量本地whisper，不受用户“优先使用在线API”设置的影响
+    recognizer.setPreferOnlineAPI(false);
+
+    QElapsedTimer modelTimer;
+    modelTimer.start();
+    if (!recognizer.initialize(model)) {
+        result["error"] = "failed to load model";
+        QTextStream(stdout) << QJsonDocument(result).toJson(QJsonDocument::Compact) << endl;
+        return 1;
+    }
+    result["model_load_ms"] = modelTimer.elapsed();
+    result["rss_after_model_load_kb"] = currentUsage().peakRssKb;
+
+    recognizer.configure(language);
+    recognizer.setThreadCount(threads);
+    recognizer.setDecodingProfile(profile);
+
+    QElapsedTimer jobTimer;
+    qint64 firstSegmentMs = -1;
+    int segmentCount = 0;
+    int characterCount = 0;
+    QString error;
+
+    QObject::connect(&recognizer, &SpeechRecognizer::segmentsDecoded, [&](const QVector<TranscriptSegment> &segments) {
+        if (firstSegmentMs < 0 && !segments.isEmpty()) {
+            firstSegmentMs = jobTimer.elapsed();
+        }
+    });
+    QObject::connect(&recognizer, &SpeechRecognizer::segmentsRecognized,
+                     [&](const QString &, const QVector<TranscriptSegment> &segments, qint64, qint64) {
+        segmentCount = segments.size();
+        for (const TranscriptSegment &segment : segments) {
+            characterCount += segment.text.size();
+        }
+    });
+    QObject::connect(&recognizer, &SpeechRecognizer::recognitionFinished, [&](const QString &) {
+        QCoreApplication::quit();
+    });
+    QObject::connect(&recognizer, &SpeechRecognizer::recognitionError, [&](const QString &message) {
+        error = message;
+        QCoreApplication::quit();
+    });
+
+    const ResourceUsage before = currentUsage();
+    jobTimer.start();
+
+    // recognizeFile同步完成解码后才返回，返回时刻即解码阶段的结束
+    if (!recognizer.recognizeFile(input)) {
+        result["error"] = error.isEmpty() ? QString("failed to start recognition") : error;
+        QTextStream(stdout) << QJsonDocument(result).toJson(QJsonDocument::Compact) << endl;
+        return 1;
+    }
+    const qint64 decodeMs = jobTimer.elapsed();
+
+    QCoreApplication::exec();
+
+    const double wallSeconds = jobTimer.nsecsElapsed() / 1e9;
+    const ResourceUsage after = currentUsage();
+    const double audioSeconds = mediaDurationSeconds(input);
+    const double cpuSeconds = after.cpuSeconds - before.cpuSeconds;
+
+    if (!error.isEmpty()) {
+        result["error"] = error;
+    }
+    result["audio_seconds"] = audioSeconds;
+    result["wall_seconds"] = wallSeconds;
+    result["decode_ms"] = decodeMs;
+    result["time_to_first_segment_ms"] = firstSegmentMs;
+    result["real_time_factor"] = audioSeconds > 0 ? wallSeconds / audioSeconds : 0.0;
+    result["speed_x_realtime"] = wallSeconds > 0 ? audioSeconds / wallSeconds : 0.0;
+    result["peak_rss_kb"] = after.peakRssKb;
+    result["cpu_seconds"] = cpuSeconds;
+    result["cpu_utilization_cores"] = wallSeconds > 0 ? cpuSeconds / wallSeconds : 0.0;
+    result["cpu_utilization_percent_of_threads"] = wallSeconds > 0 && threads > 0 ? 100.0 * cpuSeconds / wallSeconds / threads : 0.0;
+    result["segments"] = segmentCount;
+    result["characters"] = characterCount;
+
+    QTextStream(stdout) << QJsonDocument(result).toJson(QJsonDocument::Compact) << endl;
+    return error.isEmpty() ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("pipeline_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("EnPlayer end-to-end recognition benchmark");
+    parser.addHelpOption();
+    QCommandLineOption modelsOption("models", "逗号分隔的whisper模型文件", "paths");
+    QCommandLineOption threadsOption("threads", "逗号分隔的线程数", "list", QString::number(qMin(8, QThread::idealThreadCount())));
+    QCommandLineOption profilesOption("profiles", "逗号分隔的解码策略（greedy, beam）", "list", "greedy");
+    QCommandLineOption syntheticOption("synthetic", "逗号分隔的合成输入时长（秒），为空表示不生成", "list", "60,300");
+    QCommandLineOption corpusOption("corpus", "额外的媒体文件目录", "dir");
+    QCommandLineOption testFilesOption("test-files", "测试音频目录", "dir", ENPLAYER_TEST_FILES_DIR);
+    QCommandLineOption languageOption("language", "识别语言", "code", "en");
+    QCommandLineOption repeatOption("repeat", "每个组合重复运行的次数", "count", "1");
+    QCommandLineOption outputOption("output", "JSON结果输出文件，默认输出到标准输出", "file");
+    QCommandLineOption runOneOption("run-one", "内部使用：在子进程中识别一个文件", "file");
+    parser.addOption(modelsOption);
+    parser.addOption(threadsOption);
+    parser.addOption(profilesOption);
+    parser.addOption(syntheticOption);
+    parser.addOption(corpusOption);
+    parser.addOption(testFilesOption);
+    parser.addOption(languageOption);
+    parser.addOption(repeatOption);
+    parser.addOption(outputOption);
+    parser.addOption(runOneOption);
+    parser.process(app);
+
+    const QString language = parser.value(languageOption);
+
+    if (parser.isSet(runOneOption)) {
+        return runOne(parser.value(runOneOption), parser.value(modelsOption),
+                      parser.value(threadsOption).toInt(), parser.value(profilesOption), language);
+    }
+
+    const QStringList models = splitList(parser.value(modelsOption));
+    if (models.isEmpty()) {
+        QTextStream(stderr) << "需要通过--models指定至少一个whisper模型" << endl;
+        return 2;
+    }
+
+    // 准备输入：合成的长音频和语料目录中的媒体文件
+    QTemporaryDir syntheticDir;
+    QStringList inputs;
+    const QString sourceWav = parser.value(testFilesOption) + "/test_audio.wav";
+    for (const QString &item : splitList(parser.value(syntheticOption))) {
+        const int seconds = item.toInt();
+        if (seconds <= 0) {
+            continue;
+        }
+        const QString path = syntheticDir.filePath(QString("synthetic_%1s.wav").arg(seconds));
+        if (!writeLengthenedWav(sourceWav, seconds, path)) {
+            QTextStream(stderr) << "无法生成合成输入: " << path << endl;
+            return 2;
+        }
+        inputs << path;
+    }
+    if (parser.isSet(corpusOption)) {
+        const QStringList filters = { "*.wav", "*.mp3", "*.m4a", "*.flac", "*.ogg", "*.opus", "*.mp4", "*.mkv", "*.webm", "*.mov" };
+        QDirIterator it(parser.value(corpusOption), filters, QDir::Files, QDirIterator::Subdirectories);
+        QStringList corpus;
+        while (it.hasNext()) {
+            corpus << it.next();
+        }
+        corpus.sort();
+        inputs << corpus;
+    }
+    if (inputs.isEmpty()) {
+        QTextStream(stderr) << "没有可用的输入" << endl;
+        return 2;
+    }
+
+    const int repeat = qMax(1, parser.value(repeatOption).toInt());
+    QJsonArray runs;
+    int failures = 0;
+
+    for (const QString &model : models) {
+        for (const QString &threads : splitList(parser.value(threadsOption))) {
+            for (const QString &profile : splitList(parser.value(profilesOption))) {
+                for (const QString &input : inputs) {
+                    for (int r = 0; r < repeat; ++r) {
+                        QStringList args;
+                        args << "--run-one" << input << "--models" << model << "--threads" << threads
+                             << "--profiles" << profile << "--language" << language;
+
+                        QTextStream(stderr) << QFileInfo(model).fileName() << " threads=" << threads << " profile=" << profile
+                                            << " input=" << QFileInfo(input).fileName() << " ... " << flush;
+
+                        QProcess child;
+                        child.setProcessChannelMode(QProcess::SeparateChannels);
+                        child.start(QCoreApplication::applicationFilePath(), args);
+                        child.waitForFinished(-1);
+
+                        const QList<QByteArray> lines = child.readAllStandardOutput().trimmed().split('\n');
+                        QJsonObject result = QJsonDocument::fromJson(lines.last()).object();
+                        if (result.isEmpty()) {
+                            result["input"] = input;
+                            result["model"] = QFileInfo(model).fileName();
+                            result["threads"] = threads.toInt();
+                            result["profile"] = profile;
+                            result["error"] = QString("child exited with code %1: %2").arg(child.exitCode())
+                                                  .arg(QString::fromLocal8Bit(child.readAllStandardError().right(500)));
+                        }
+                        result["input"] = QFileInfo(input).fileName();
+                        result["repetition"] = r;
+
+                        if (result.contains("error")) {
+                            ++failures;
+                            QTextStream(stderr) << "failed: " << result["error"].toString() << endl;
+                        } else {
+                            QTextStream(stderr) << QString::number(result["speed_x_realtime"].toDouble(), 'f', 2) << "x realtime" << endl;
+                        }
+                        runs.append(result);
+                    }
+                }
+            }
+        }
+    }
+
+    QJsonObject context;
+    context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    context["host"] = QSysInfo::machineHostName();
+    context["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+    context["kernel"] = QSysInfo::kernelType() + " " + QSysInfo::kernelVersion();
+    context["logical_cpus"] = QThread::idealThreadCount();
+    context["language"] = language;
+
+    QJsonObject report;
+    report["context"] = context;
+    report["runs"] = runs;
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    const QString outputPath = parser.value(outputOption);
+    if (outputPath.isEmpty()) {
+        QTextStream(stdout) << json;
+    } else {
+        QFile output(outputPath);
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "无法写入结果文件: " << outputPath << endl;
+            return 1;
+        }
+        output.write(json);
+    }
+    return failures == 0 ? 0 : 1;
+}
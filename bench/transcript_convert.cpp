@@ -0,0 +1,84 @@
+// 字幕格式转换工具
+//
+// 用法：transcript_convert 输入文件 输出文件 [--from 毫秒] [--to 毫秒]
+//
+// 格式按扩展名判断：.qet（二进制）、.srt、.vtt、.json。输入为.qet且指定了时间范围时，
+// 只读取映射文件中与范围重叠的片段，不加载整个文件。输出文件为"-"时以SRT格式写到标准输出。
+
+#include "mappedtranscript.h"
+#include "transcriptformats.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <limits>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("transcript_convert");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("在.qet、SRT、WebVTT和JSON字幕格式之间转换");
+    parser.addHelpOption();
+    QCommandLineOption fromOption("from", "只转换此时间（毫秒）之后的片段", "ms");
+    QCommandLineOption toOption("to", "只转换此时间（毫秒）之前的片段", "ms");
+    parser.addOption(fromOption);
+    parser.addOption(toOption);
+    parser.addPositionalArgument("input", "输入文件");
+    parser.addPositionalArgument("output", "输出文件，\"-\"表示标准输出");
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 2) {
+        parser.showHelp(1);
+    }
+
+    QTextStream err(stderr);
+    const qint64 fromMs = parser.isSet(fromOption) ? parser.value(fromOption).toLongLong() : 0;
+    const qint64 toMs = parser.isSet(toOption) ? parser.value(toOption).toLongLong() : std::numeric_limits<qint64>::max();
+    const bool ranged = parser.isSet(fromOption) || parser.isSet(toOption);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<TranscriptSegment> segments;
+    QString error;
+    if (transcriptFormatForPath(arguments.at(0)) == TranscriptFormat::Binary) {
+        MappedTranscript transcript;
+        if (!transcript.open(arguments.at(0), &error)) {
+            err << "无法打开 " << arguments.at(0) << ": " << error << "\n";
+            return 1;
+        }
+        segments = ranged ? transcript.segmentsInRange(fromMs, toMs) : transcript.toSegments();
+    } else {
+        if (!readTranscriptFile(arguments.at(0), segments, &error)) {
+            err << "无法读取 " << arguments.at(0) << ": " << error << "\n";
+            return 1;
+        }
+        if (ranged) {
+            QVector<TranscriptSegment> selected;
+            for (const TranscriptSegment &segment : segments) {
+                if (segment.endMs > fromMs && segment.startMs < toMs) {
+                    selected.append(segment);
+                }
+            }
+            segments = selected;
+        }
+    }
+    const qint64 readMs = timer.elapsed();
+
+    if (arguments.at(1) == "-") {
+        QTextStream out(stdout);
+        out.setCodec("UTF-8");
+        out << toSrt(segments);
+    } else if (!writeTranscriptFile(arguments.at(1), segments, &error)) {
+        err << "无法写入 " << arguments.at(1) << ": " << error << "\n";
+        return 1;
+    }
+
+    err << "片段: " << segments.size() << "，读取 " << readMs << " ms，总计 " << timer.elapsed() << " ms\n";
+    return 0;
+}
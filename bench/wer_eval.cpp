@@ -0,0 +1,272 @@
+// 准确度与速度的评估工具
+//
+// 用法：wer_eval --corpus 目录 --models 模型1,模型2 [--threads 4,8] [--profiles greedy,beam]
+//               [--language en] [--output 文件]
+//
+// 语料目录中每个媒体文件旁放一个同名的.txt参考文本（例如lecture.mp4和lecture.txt）。
+// 对每个（模型, 线程数, 解码策略）配置识别全部文件，计算整个语料的词错误率和实时率，
+// 输出按实时率排序的表格，并标出帕累托最优的配置（没有其他配置同时更快且更准）。
+
+#include "benchutil.h"
+#include "speechrecognizer.h"
+#include "wer.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+struct CorpusItem
+{
+    QString mediaPath;
+    QString referenceText;
+    double audioSeconds = 0;
+};
+
+struct ConfigResult
+{
+    QString model;
+    int threads = 0;
+    QString profile;
+    WerResult wer;
+    double wallSeconds = 0;
+    double audioSeconds = 0;
+    int failedFiles = 0;
+    bool pareto = false;
+
+    double realTimeFactor() const { return audioSeconds > 0 ? wallSeconds / audioSeconds : 0.0; }
+    QString name() const { return QString("%1 t=%2 %3").arg(model).arg(threads).arg(profile); }
+};
+
+std::vector<CorpusItem> loadCorpus(const QString &directory)
+{
+    const QStringList filters = { "*.wav", "*.mp3", "*.m4a", "*.flac", "*.ogg", "*.opus", "*.mp4", "*.mkv", "*.webm", "*.mov" };
+    QDirIterator it(directory, filters, QDir::Files, QDirIterator::Subdirectories);
+    QStringList mediaFiles;
+    while (it.hasNext()) {
+        mediaFiles << it.next();
+    }
+    mediaFiles.sort();
+
+    std::vector<CorpusItem> corpus;
+    for (const QString &mediaPath : mediaFiles) {
+        QFileInfo info(mediaPath);
+        QFile reference(info.path() + "/" + info.completeBaseName() + ".txt");
+        if (!reference.open(QIODevice::ReadOnly)) {
+            QTextStream(stderr) << "跳过没有参考文本的文件: " << mediaPath << endl;
+            continue;
+        }
+        CorpusItem item;
+        item.mediaPath = mediaPath;
+        item.referenceText = QString::fromUtf8(reference.readAll());
+        item.audioSeconds = mediaDurationSeconds(mediaPath);
+        corpus.push_back(item);
+    }
+    return corpus;
+}
+
+/**
+ * @brief 同步识别一个文件，返回拼接后的文本；失败时返回false
+ */
+bool transcribe(SpeechRecognizer &recognizer, const QString &mediaPath, QString &text)
+{
+    QEventLoop loop;
+    QString error;
+    QStringList parts;
+
+    QMetaObject::Connection segmentsConnection = QObject::connect(&recognizer, &SpeechRecognizer::segmentsRecognized,
+            [&](const QString &, const QVector<TranscriptSegment> &segments, qint64, qint64) {
+        for (const TranscriptSegment &segment : segments) {
+            parts << segment.text.trimmed();
+        }
+    });
+    QMetaObject::Connection finishedConnection = QObject::connect(&recognizer, &SpeechRecognizer::recognitionFinished,
+            &loop, &QEventLoop::quit);
+    QMetaObject::Connection errorConnection = QObject::connect(&recognizer, &SpeechRecognizer::recognitionError,
+            [&](const QString &message) {
+        error = message;
+        loop.quit();
+    });
+
+    bool started = recognizer.recognizeFile(mediaPath);
+    if (started) {
+        loop.exec();
+    }
+
+    QObject::disconnect(segmentsConnection);
+    QObject::disconnect(finishedConnection);
+    QObject::disconnect(errorConnection);
+
+    if (!started || !error.isEmpty()) {
+        QTextStream(stderr) << "识别失败: " << mediaPath << " " << error << endl;
+        return false;
+    }
+    text = parts.join(' ');
+    return true;
+}
+
+void markParetoFront(std::vector<ConfigResult> &results)
+{
+    for (ConfigResult &candidate : results) {
+        candidate.pareto = candidate.failedFiles == 0;
+        for (const ConfigResult &other : results) {
+            if (&other == &candidate || other.failedFiles > 0) {
+                continue;
+            }
+            const bool notWorse = other.wer.wer() <= candidate.wer.wer() && other.realTimeFactor() <= candidate.realTimeFactor();
+            const bool better = other.wer.wer() < candidate.wer.wer() || other.realTimeFactor() < candidate.realTimeFactor();
+            if (notWorse && better) {
+                candidate.pareto = false;
+                break;
+            }
+        }
+    }
+}
+
+void printTable(std::vector<ConfigResult> results)
+{
+    std::sort(results.begin(), results.end(), [](const ConfigResult &a, const ConfigResult &b) {
+        return a.realTimeFactor() < b.realTimeFactor();
+    });
+
+    QTextStream out(stdout);
+    out << QString("%1  %2  %3  %4  %5  %6\n")
+               .arg("configuration", -40).arg("WER%", 7).arg("RTF", 7).arg("xRT", 7).arg("S/D/I", 14).arg("pareto");
+    for (const ConfigResult &result : results) {
+        const QString sdi = QString("%1/%2/%3").arg(result.wer.substitutions).arg(result.wer.deletions).arg(result.wer.insertions);
+        out << QString("%1  %2  %3  %4  %5  %6\n")
+                   .arg(result.name(), -40)
+                   .arg(result.wer.wer() * 100.0, 7, 'f', 2)
+                   .arg(result.realTimeFactor(), 7, 'f', 3)
+                   .arg(result.wallSeconds > 0 ? result.audioSeconds / result.wallSeconds : 0.0, 7, 'f', 1)
+                   .arg(sdi, 14)
+                   .arg(result.failedFiles > 0 ? QString("failed(%1)").arg(result.failedFiles) : QString(result.pareto ? "*" : ""));
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("wer_eval");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("EnPlayer accuracy-vs-speed evaluation");
+    parser.addHelpOption();
+    QCommandLineOption corpusOption("corpus", "媒体文件和同名.txt参考文本所在目录", "dir");
+    QCommandLineOption modelsOption("models", "逗号分隔的whisper模型文件", "paths");
+    QCommandLineOption threadsOption("threads", "逗号分隔的线程数", "list", QString::number(qMin(8, QThread::idealThreadCount())));
+    QCommandLineOption profilesOption("profiles", "逗号分隔的解码策略（greedy, beam）", "list", "greedy,beam");
+    QCommandLineOption languageOption("language", "识别语言", "code", "en");
+    QCommandLineOption outputOption("output", "额外输出JSON结果的文件", "file");
+    parser.addOption(corpusOption);
+    parser.addOption(modelsOption);
+    parser.addOption(threadsOption);
+    parser.addOption(profilesOption);
+    parser.addOption(languageOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    const QStringList models = splitList(parser.value(modelsOption));
+    if (!parser.isSet(corpusOption) || models.isEmpty()) {
+        QTextStream(stderr) << "需要通过--corpus指定语料目录，并通过--models指定至少一个模型" << endl;
+        return 2;
+    }
+
+    const std::vector<CorpusItem> corpus = loadCorpus(parser.value(corpusOption));
+    if (corpus.empty()) {
+        QTextStream(stderr) << "语料目录中没有带参考文本的媒体文件" << endl;
+        return 2;
+    }
+
+    std::vector<ConfigResult> results;
+    for (const QString &model : models) {
+        // 同一模型的各个配置共用一次模型加载
+        SpeechRecognizer recognizer;
+        // 基准测试只测量本地whisper，不受用户“优先使用在线API”设置的影响
+        recognizer.setPreferOnlineAPI(false);
+        if (!recognizer.initialize(model)) {
+            QTextStream(stderr) << "无法加载模型: " << model << endl;
+            continue;
+        }
+        recognizer.configure(parser.value(languageOption));
+
+        for (const QString &threads : splitList(parser.value(threadsOption))) {
+            for (const QString &profile : splitList(parser.value(profilesOption))) {
+                recognizer.setThreadCount(threads.toInt());
+                recognizer.setDecodingProfile(profile);
+
+                ConfigResult result;
+                result.model = QFileInfo(model).fileName();
+                result.threads = threads.toInt();
+                result.profile = profile;
+
+                for (const CorpusItem &item : corpus) {
+                    QString hypothesis;
+                    QElapsedTimer timer;
+                    timer.start();
+                    if (!transcribe(recognizer, item.mediaPath, hypothesis)) {
+                        ++result.failedFiles;
+                        continue;
+                    }
+                    result.wallSeconds += timer.nsecsElapsed() / 1e9;
+                    result.audioSeconds += item.audioSeconds;
+                    result.wer += computeWordErrorRate(item.referenceText, hypothesis);
+                }
+
+                QTextStream(stderr) << result.name() << ": WER " << QString::number(result.wer.wer() * 100.0, 'f', 2)
+                                    << "%, RTF " << QString::number(result.realTimeFactor(), 'f', 3) << endl;
+                results.push_back(result);
+            }
+        }
+    }
+
+    if (results.empty()) {
+        return 1;
+    }
+
+    markParetoFront(results);
+    printTable(results);
+
+    if (parser.isSet(outputOption)) {
+        QJsonArray array;
+        for (const ConfigResult &result : results) {
+            QJsonObject object;
+            object["model"] = result.model;
+            object["threads"] = result.threads;
+            object["profile"] = result.profile;
+            object["wer"] = result.wer.wer();
+            object["substitutions"] = result.wer.substitutions;
+            object["deletions"] = result.wer.deletions;
+            object["insertions"] = result.wer.insertions;
+            object["reference_words"] = result.wer.referenceWords;
+            object["audio_seconds"] = result.audioSeconds;
+            object["wall_seconds"] = result.wallSeconds;
+            object["real_time_factor"] = result.realTimeFactor();
+            object["failed_files"] = result.failedFiles;
+            object["pareto"] = result.pareto;
+            array.append(object);
+        }
+        QFile output(parser.value(outputOption));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "无法写入结果文件: " << output.fileName() << endl;
+            return 1;
+        }
+        output.write(QJsonDocument(array).toJson(QJsonDocument::Indented));
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef ALIGNMENT_H
+#define ALIGNMENT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "transcript.h"
+
+/**
+ * @brief 把待对齐的文本拆分为词，按空白分隔，连续空白和换行都视为一个分隔
+ */
+QStringList splitAlignmentWords(const QString &text);
+
+/**
+ * @brief 由片段的起止时间和部分词的起点估计生成对齐后的片段
+ *
+ * 估计不递增或超出片段范围的被丢弃；没有估计的词在相邻两个已知时间点之间按字符数分配，
+ * 每个词的结束时间为下一个词的开始时间。
+ * @param words 片段中的词
+ * @param wordStartHints 各词起点的估计（绝对时间，毫秒），-1表示没有估计；可以为空
+ * @param startMs 片段开始时间（毫秒）
+ * @param endMs 片段结束时间（毫秒）
+ * @return 文本为以空格连接的词、带词级时间戳的片段
+ */
+TranscriptSegment buildAlignedSegment(const QStringList &words, const QVector<qint64> &wordStartHints,
+                                      qint64 startMs, qint64 endMs);
+
+#endif // ALIGNMENT_H
@@ -0,0 +1,166 @@
+#ifndef AUDIOSTREAMREADER_H
+#define AUDIOSTREAMREADER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "wavreader.h"
+
+class AudioConverter;
+class QThread;
+
+/**
+ * @brief 是否为网络流地址（http、https、rtsp、rtmp等），本地文件路径返回false
+ */
+bool isStreamUrl(const QString &source);
+
+/**
+ * @brief 解析ffmpeg输出的WAV流：先解析WAV头得到格式，之后每个数据块降混、重采样为16kHz单声道16位样本
+ */
+class WavStreamDecoder
+{
+public:
+    WavStreamDecoder();
+    ~WavStreamDecoder();
+
+    /**
+     * @brief 处理一块输出数据
+     * @param chunk 数据，可以在任意字节处切分
+     * @param output 转换出的样本（追加）
+     * @return 数据无效时返回false，之后的数据都被忽略
+     */
+    bool push(const QByteArray &chunk, std::vector<int16_t> &output);
+
+    /**
+     * @brief 输出结束，取出重采样器中剩余的样本
+     */
+    void finish(std::vector<int16_t> &output);
+
+    bool isInvalid() const { return m_invalid; }
+
+private:
+    QByteArray m_header;
+    WavFormat m_format;
+    std::unique_ptr<AudioConverter> m_converter;
+    bool m_invalid;
+};
+
+/**
+ * @brief 在后台线程中用ffmpeg持续读取一个音频源，解码为16kHz单声道样本放入有界队列
+ *
+ * 读取线程不等识别：识别期间的数据在队列中累积，ffmpeg和网络连接不会因为识别慢而阻塞。
+ * - FollowFile：跟随正在写入的本地文件，队列满时读取线程等待（文件不会丢数据），
+ *   文件超过空闲超时没有新数据时结束。
+ * - LiveStream：网络流（HLS、RTSP、RTMP等），队列满时丢弃最旧的音频，识别落后写入方的时间有上限；
+ *   超过空闲超时没有数据或ffmpeg异常退出时按退避间隔重连，断开期间的时间作为缺口报告。
+ *   ffmpeg正常退出（流已结束）时不再重连。
+ */
+class AudioStreamReader
+{
+public:
+    enum Mode
+    {
+        FollowFile,
+        LiveStream
+    };
+
+    AudioStreamReader(const QString &source, Mode mode);
+    ~AudioStreamReader();
+
+    /**
+     * @brief 队列最多保存的音频秒数，默认跟随文件60秒、网络流30秒
+     */
+    void setCapacitySeconds(int seconds);
+
+    /**
+     * @brief 多久没有数据认为文件已写完（FollowFile）或连接已断开（LiveStream），默认30秒和15秒
+     */
+    void setIdleTimeoutSeconds(int seconds);
+
+    /**
+     * @brief 网络流连续重连失败多少次后放弃，默认5次
+     */
+    void setMaxReconnects(int count);
+
+    /**
+     * @brief 启动读取线程
+     */
+    bool start(QString *error = nullptr);
+
+    /**
+     * @brief 停止读取并等待线程结束；已在队列中的样本仍可读出
+     */
+    void stop();
+
+    /**
+     * @brief 取出队列中连续的样本，队列为空时最多等待waitMs毫秒
+     * @param samples 输出的样本（替换原内容），直到下一个缺口为止
+     * @param gapSamples 这些样本之前丢弃或断开的样本数，时间轴要跳过这么多
+     * @param waitMs 最长等待时间
+     * @return 读取已结束且队列已空时返回false
+     */
+    bool read(std::vector<int16_t> &samples, qint64 &gapSamples, int waitMs);
+
+    /**
+     * @brief 读取结束的原因，正常结束时为空
+     */
+    QString errorString() const;
+
+    qint64 sourceBytes() const;
+    int reconnects() const;
+    qint64 droppedSamples() const;
+
+    /**
+     * @brief 给定源和模式时ffmpeg的命令行参数
+     */
+    static QStringList ffmpegArguments(const QString &source, Mode mode, int idleTimeoutSeconds);
+
+private:
+    enum SessionResult
+    {
+        SessionEnded,
+        SessionFailed,
+        SessionStopped
+    };
+
+    /**
+     * @brief 队列中的一段连续样本
+     */
+    struct Chunk
+    {
+        std::vector<int16_t> samples;
+        qint64 gapBefore = 0;     ///< 这段之前跳过的样本数
+    };
+
+    void run();
+    SessionResult runSession(bool &producedData, QString &error);
+    void push(std::vector<int16_t> &samples, qint64 gapSamples);
+    void finishReading(const QString &error);
+
+    const QString m_source;
+    const Mode m_mode;
+    int m_capacitySamples;
+    int m_idleTimeoutSeconds;
+    int m_maxReconnects;
+    QThread *m_thread;
+    std::atomic<bool> m_stopRequested;
+    QElapsedTimer m_lastData;                ///< 上次收到数据的时间，只在读取线程中使用，重连后据此计算断开的时长
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_changed;
+    std::deque<Chunk> m_chunks;
+    qint64 m_queuedSamples;
+    bool m_finished;
+    QString m_error;
+    qint64 m_sourceBytes;
+    int m_reconnects;
+    qint64 m_droppedSamples;
+};
+
+#endif // AUDIOSTREAMREADER_H
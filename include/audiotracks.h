@@ -0,0 +1,87 @@
+#ifndef AUDIOTRACKS_H
+#define AUDIOTRACKS_H
+
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+class PcmBuffer;
+
+/**
+ * @brief 媒体文件中的一条音轨
+ */
+struct AudioTrack
+{
+    int index = -1;          ///< ffmpeg中的流序号
+    QString codec;           ///< 编码，如aac、opus、ac3
+    QString language;        ///< 语言标签，如eng，没有时为空
+    QString title;           ///< 标题（如“同传”“解说”），没有时为空
+    int channels = 0;        ///< 声道数
+    int sampleRate = 0;      ///< 采样率
+    qint64 durationMs = -1;  ///< 音轨时长（毫秒），未知时为-1
+
+    /**
+     * @brief 用于列表和日志的说明，例如“#2 eng 同传 (aac, 2声道)”
+     */
+    QString label() const;
+};
+
+Q_DECLARE_METATYPE(AudioTrack)
+
+/**
+ * @brief 用ffprobe列出音轨，只读取容器头部
+ * @param mediaFilePath 媒体文件
+ * @param tracks 音轨，按流序号排列；没有单独时长的音轨使用容器时长
+ * @param error 失败时的原因
+ * @return ffprobe是否成功
+ */
+bool probeAudioTracks(const QString &mediaFilePath, QVector<AudioTrack> &tracks, QString *error = nullptr);
+
+/**
+ * @brief 一次解码多条音轨时ffmpeg的命令行参数
+ *
+ * 每条音轨由各自的解码器解码，在滤镜中降混、重采样为16kHz单声道后用amerge合并为一路多声道输出，
+ * 第k声道就是第k条音轨。amerge在最短的输入结束时结束，已知时长时把各音轨补齐到最长音轨的时长。
+ */
+QStringList audioTracksFfmpegArguments(const QString &mediaFilePath, const QVector<AudioTrack> &tracks);
+
+/**
+ * @brief 接收解码出的一段样本：track为音轨在tracks中的序号，返回false时停止解码
+ */
+typedef std::function<bool(int track, const int16_t *samples, size_t count)> TrackSampleSink;
+
+/**
+ * @brief 只读取一遍容器，同时解码多条音轨，边解码边把各音轨的样本交给sink
+ *
+ * 补齐的静音按各音轨自己的时长截掉。sink在调用线程中执行，可以阻塞以限制积压；
+ * 返回false时结束ffmpeg并以“解码已取消”失败。
+ * @param mediaFilePath 媒体文件
+ * @param tracks 要解码的音轨
+ * @param sink 样本的接收者
+ * @param sourceBytes ffmpeg输出的字节数，可为空
+ * @param error 失败时的原因
+ * @return 是否成功
+ */
+bool decodeAudioTracks(const QString &mediaFilePath, const QVector<AudioTrack> &tracks,
+                       const TrackSampleSink &sink, qint64 *sourceBytes = nullptr, QString *error = nullptr);
+
+/**
+ * @brief 只读取一遍容器，同时解码多条音轨
+ *
+ * 读取输出时按声道拆分到各音轨的缓冲区，补齐的静音按各音轨自己的时长截掉。
+ * 会启动ffmpeg子进程并阻塞到解码结束，应在工作线程中调用。
+ * @param mediaFilePath 媒体文件
+ * @param tracks 要解码的音轨
+ * @param outputs 与tracks一一对应的输出缓冲区（先清空，保留内存预算设置）
+ * @param sourceBytes ffmpeg输出的字节数，可为空
+ * @param error 失败时的原因
+ * @return 是否成功
+ */
+bool decodeAudioTracks(const QString &mediaFilePath, const QVector<AudioTrack> &tracks,
+                       const QVector<PcmBuffer *> &outputs, qint64 *sourceBytes = nullptr, QString *error = nullptr);
+
+#endif // AUDIOTRACKS_H
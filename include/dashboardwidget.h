@@ -0,0 +1,76 @@
+#ifndef DASHBOARDWIDGET_H
+#define DASHBOARDWIDGET_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <cstdint>
+
+class QLabel;
+class QTableWidget;
+class MetricHistogram;
+
+/**
+ * @brief 性能面板：进程内存、各线程CPU、实时率、阶段耗时、队列深度和缓存命中率
+ *
+ * 数据来自识别器更新的无锁指标和/proc，由定时器在主线程中采样，识别线程不做任何额外工作。
+ * 面板不可见时停止采样。
+ */
+class DashboardWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DashboardWidget(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    /**
+     * @brief 采样一次并刷新显示
+     */
+    void refresh();
+
+private:
+    /**
+     * @brief 直方图上一次采样的计数和总和，用于求最近一次的值
+     */
+    struct StageState
+    {
+        uint64_t count = 0;
+        double sum = 0;
+        double lastSeconds = -1;
+    };
+
+    QString formatStage(StageState &state, const MetricHistogram &histogram);
+    void refreshThreads(double intervalSeconds);
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_lastSampleNs;
+
+    QLabel *m_memoryLabel;
+    QLabel *m_cpuLabel;
+    QLabel *m_realTimeLabel;
+    QLabel *m_jobsLabel;
+    QLabel *m_queueLabel;
+    QLabel *m_throughputLabel;
+    QLabel *m_cacheLabel;
+    QLabel *m_decodeStageLabel;
+    QLabel *m_inferenceStageLabel;
+    QLabel *m_totalStageLabel;
+    QTableWidget *m_threadTable;
+
+    double m_lastProcessCpu;
+    qint64 m_lastPositionMs;
+    double m_smoothedRealTimeFactor;   ///< 当前任务的实时率（指数平滑），小于0表示尚无数据
+    QHash<qint64, double> m_lastThreadCpu;
+    StageState m_decodeState;
+    StageState m_inferenceState;
+    StageState m_totalState;
+};
+
+#endif // DASHBOARDWIDGET_H
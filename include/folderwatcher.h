@@ -0,0 +1,113 @@
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRegExp>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+class QSocketNotifier;
+
+/**
+ * @brief 用inotify监视目录（包括子目录），报告写完的新文件或修改过的文件
+ *
+ * 完全由内核事件驱动，不轮询文件系统：inotify描述符交给QSocketNotifier，只在有事件时读取。
+ * 一个文件的连续事件合并为一次：收到IN_CLOSE_WRITE或IN_MOVED_TO（写完并关闭、整体移入）后
+ * 短暂等待即报告；只有写入事件（写入方不关闭文件，或文件在网络共享上）时，要等到连续两个静默期内
+ * 都没有事件且大小和修改时间不变才报告。大小和修改时间与上次报告相同的文件不再重复报告。
+ *
+ * 只支持Linux，其他平台setFolders返回false。
+ */
+class FolderWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FolderWatcher(QObject *parent = nullptr);
+    ~FolderWatcher();
+
+    /**
+     * @brief 当前平台是否支持
+     */
+    static bool isSupported();
+
+    /**
+     * @brief 只报告匹配这些通配符的文件（不区分大小写），为空时报告全部文件
+     */
+    void setNameFilters(const QStringList &filters);
+
+    /**
+     * @brief 没有关闭事件时判断文件已写完所需的静默时间
+     */
+    void setQuietPeriod(int milliseconds);
+
+    /**
+     * @brief 替换监视的目录，包括其中已有的全部子目录；空列表停止监视
+     * @param folders 目录
+     * @param error 失败时的原因（部分子目录无法监视时仍返回true，原因写入error）
+     * @return 是否成功
+     */
+    bool setFolders(const QStringList &folders, QString *error = nullptr);
+
+    QStringList folders() const;
+
+    /**
+     * @brief 忘记已不存在或已不在监视目录中的文件的报告记录
+     *
+     * 只有文件删除或移出事件会去掉单个记录，整个目录被删除、移出或事件溢出时记录会留下，
+     * 应在重新扫描监视的目录后调用。
+     */
+    void pruneReported();
+
+signals:
+    /**
+     * @brief 文件已写完，可以处理
+     */
+    void fileReady(const QString &path);
+
+    /**
+     * @brief 内核事件队列溢出，可能漏掉了文件，应重新扫描监视的目录
+     */
+    void overflowed();
+
+private slots:
+    void readEvents();
+    void checkPending();
+
+private:
+    /**
+     * @brief 等待写完的文件
+     */
+    struct PendingFile
+    {
+        qint64 deadlineMs = 0;     ///< 何时检查（m_clock的毫秒数）
+        bool closed = false;       ///< 最后一个事件是关闭或移入
+        qint64 size = -1;          ///< 上次检查时的大小，还没检查过时为-1
+        qint64 modifiedMs = -1;    ///< 上次检查时的修改时间
+    };
+
+    void stop();
+    bool addWatch(const QString &directory, QString *error);
+    void addWatchTree(const QString &directory, bool reportExistingFiles, QString *error);
+    bool matchesFilters(const QString &fileName) const;
+    void fileEvent(const QString &path, bool closed);
+    void scheduleCheck(qint64 deadlineMs);
+
+    int m_fd;
+    QSocketNotifier *m_notifier;
+    QHash<int, QString> m_directories;         ///< watch描述符到目录
+    QStringList m_folders;
+    QVector<QRegExp> m_nameFilters;
+    int m_quietMs;
+
+    QHash<QString, PendingFile> m_pending;
+    QHash<QString, QPair<qint64, qint64>> m_reported; ///< 已报告文件的大小和修改时间
+    QTimer m_checkTimer;
+    qint64 m_checkDeadlineMs;
+    QElapsedTimer m_clock;
+};
+
+#endif // FOLDERWATCHER_H
@@ -3,6 +3,7 @@
 
 #include <QMainWindow>
 #include <QTimer>
+#include <QLabel>
 #include <QString>
 #include <QProcess>
 #include <QNetworkAccessManager>
@@ -12,9 +13,21 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include "speechrecognizer.h"
+#include "resourcemonitor.h"
+#include "metricsserver.h"
+#include "dashboardwidget.h"
+#include "transcriptmodel.h"
 #include "settingsmanager.h"
 #include "settingsdialog.h"
 #include "playbackwindow.h"
+#include "subtitleimport.h"
+#include "transcriptindex.h"
+#include "transcriptsearchwidget.h"
+#include "medialibrary.h"
+#include "medialibrarywidget.h"
+#include "folderwatcher.h"
+#include "transcriptionqueue.h"
+#include <QSharedPointer>
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -38,11 +51,50 @@ private slots:
     // 语音识别相关槽函数
     void startSpeechRecognition();
     void onRecognitionFinished(const QString &text);
+    void onSegmentsDecoded(const QVector<TranscriptSegment> &segments);
+    void onSegmentsRecognized(const QString &mediaFilePath, const QVector<TranscriptSegment> &segments,
+                              qint64 rangeStartMs, qint64 rangeEndMs);
     void onRecognitionError(const QString &errorMessage);
     void onRecognitionProgress(int progress);
     
     // 设置相关槽函数
     void on_actionSettings_triggered();
+    
+    // 导入、导出字幕文件（SRT、WebVTT、JSON、二进制.qet）
+    void on_actionImportSubtitles_triggered();
+    void on_actionExportSubtitles_triggered();
+    
+    // 按已知文本（剧本或没有时间戳的识别结果）强制对齐
+    void on_actionAlignText_triggered();
+    
+    // 跟随识别仍在写入的录制文件
+    void on_actionFollowRecording_triggered();
+    
+    // 识别网络流（HLS、RTSP、RTMP等）
+    void on_actionOpenStream_triggered();
+    
+    // 结束跟随识别（录制文件或网络流），识别已收到的音频后返回结果
+    void on_actionFinishFollowing_triggered();
+    
+    // 选择并同时识别当前文件的多条音轨
+    void on_actionRecognizeTracks_triggered();
+    
+    // 多音轨识别中每条音轨的结果，保存为单独的字幕文件
+    void onTrackSegmentsRecognized(const QString &mediaFilePath, const AudioTrack &track,
+                                   const QVector<TranscriptSegment> &segments);
+    
+    // 打开搜索结果所在的媒体文件并跳转到命中的片段
+    void onSearchHitActivated(const QString &mediaFilePath, qint64 startMs);
+    
+    // 打开媒体库中选择的文件
+    void onLibraryMediaActivated(const QString &mediaFilePath);
+    
+    // 监视的文件夹中有文件写完，加入后台识别队列
+    void onWatchedFileReady(const QString &mediaFilePath);
+    
+    // 后台识别队列的结果
+    void onBackgroundJobFinished(const QString &mediaFilePath, const QVector<TranscriptSegment> &segments);
+    void onBackgroundJobFailed(const QString &mediaFilePath, const QString &errorMessage);
     void onSettingsChanged(); // 新增：处理设置变更的槽函数
     
     // 日志相关槽函数
@@ -53,18 +105,91 @@ private slots:
     
     // 从播放界面返回
     void onPlaybackWindowClosed();
+    
+    // 播放界面请求识别选定区间
+    void onRangeRecognitionRequested(qint64 startMs, qint64 endMs);
+    
+    // 识别任务的资源统计
+    void onJobStatsReady(const RecognitionJobStats &stats);
+    
+    // 周期内存采样结果
+    void onMemorySampled(const ProcessMemory &memory, const QVector<ResourceMonitor::SubsystemUsage> &subsystems,
+                         const QString &summary);
 
 private:
     Ui::MainWindow *ui;
     QTimer *subtitleTimer;
     SpeechRecognizer *m_speechRecognizer; // 语音识别器
     QString currentAudioFile;             // 当前处理的视频文件路径
-    QString currentSubtitle;              // 当前识别的字幕内容
+    TranscriptModel *m_transcriptModel;   // 字幕列表模型，识别界面和播放界面共用
+    QVector<TranscriptSegment> currentSegments; // 当前文件带时间戳的字幕片段
     bool isRecognitionInProgress;         // 标记识别任务是否正在进行中
+    bool isRangeRecognition;              // 当前任务是否为区间识别
     PlaybackWindow *playbackWindow;       // 播放窗口指针
+    ResourceMonitor *m_resourceMonitor;   // 进程内存采样
+    QLabel *m_memoryLabel;                // 状态栏中的内存占用
+    MetricsServer *m_metricsServer;       // Prometheus指标服务
+    DashboardWidget *m_dashboard;         // 性能面板
+    bool m_hasImportedSubtitles;          // 当前字幕来自已有的字幕文件或字幕流
+    qint64 m_mediaDurationMs;             // 当前媒体时长（毫秒），未知时为-1
+    QVector<TranscriptGap> m_pendingGaps; // 已有字幕中尚未识别的空白
+    QString m_untimedTranscript;          // 在线API返回的没有时间戳的文本，可用于强制对齐
+    QSharedPointer<TranscriptIndex> m_transcriptIndex; // 媒体库字幕全文索引，索引线程持有引用
+    TranscriptSearchWidget *m_searchWidget; // 搜索标签页
+    QSharedPointer<MediaLibrary> m_mediaLibrary; // 媒体库数据库，扫描线程持有引用
+    MediaLibraryWidget *m_libraryWidget;  // 媒体库标签页
+    FolderWatcher *m_folderWatcher;       // 监视媒体库文件夹
+    TranscriptionQueue *m_transcriptionQueue; // 后台识别队列
+    QTimer *m_libraryRescanTimer;         // 合并监视事件触发的媒体库扫描
     
     void initSubtitleTimer();
     void initSpeechRecognition();
+    void initResourceMonitor();
+    void applyMetricsSettings();
+    void initTranscriptSearch();
+    void initMediaLibrary();
+    void initWatchFolders();
+    
+    // 按设置开始或停止监视媒体库的文件夹
+    void applyWatchFolders();
+    
+    // 更新媒体库中文件的字幕状态
+    void updateLibraryTranscriptStatus(const QString &mediaFile, TranscriptStatus status,
+                                       const QString &transcriptPath = QString());
+    
+    // 字幕缓存存在、不比媒体文件旧，且文件头记录的来源就是这个媒体文件
+    bool hasFreshTranscriptCache(const QString &mediaFile) const;
+    
+    // 写入字幕缓存，更新媒体库状态并加入全文索引
+    bool storeTranscript(const QString &mediaFile, const QVector<TranscriptSegment> &segments);
+    
+    // 在字幕目录下打开全文索引，目录变化时重新打开
+    void openTranscriptIndex();
+    
+    // 在后台把字幕加入全文索引
+    void indexTranscript(const QString &mediaFile, const QString &transcriptPath, const QVector<TranscriptSegment> &segments);
+    
+    // 切换到新的媒体文件，加载缓存的字幕或查找已有字幕
+    void openMediaFile(const QString &fileName);
+    
+    // 切换到网络流并开始识别
+    void startStreamRecognition(const QString &url);
+    
+    // 识别结果缓存在字幕目录中的二进制文件，再次打开同一媒体文件时直接加载；
+    // 文件名带媒体完整路径的散列，例如lecture.0123456789abcdef.qet
+    QString transcriptCachePath(const QString &mediaFile) const;
+    
+    // 多音轨识别时各音轨的字幕文件，例如lecture.0123456789abcdef.track2.qet
+    QString trackTranscriptPath(const QString &mediaFile, const AudioTrack &track) const;
+    bool loadCachedTranscript();
+    void saveTranscriptCache();
+    
+    // 在后台查找并导入媒体文件已有的字幕（同名字幕文件或内嵌字幕流）
+    void startSubtitleImport(const QString &mediaFile);
+    void onSubtitlesImported(const QString &mediaFile, const ImportedSubtitles &subtitles);
+    
+    // 逐段识别已有字幕中的空白，全部完成时返回false
+    bool recognizeNextGap();
     
     // FFmpeg可用性检查方法
     void checkFfmpegAvailability();
@@ -0,0 +1,92 @@
+#ifndef MAPPEDTRANSCRIPT_H
+#define MAPPEDTRANSCRIPT_H
+
+#include <QFile>
+#include "segmentstore.h"
+
+/**
+ * @brief 内存映射的二进制字幕文件（.qet）
+ *
+ * 文件内容就是SegmentStore::writeTo写出的数据，片段按开始时间排序。打开时只映射文件并检查文件头，
+ * 不解析片段；按时间查询时在映射的记录数组上二分查找，只有被访问的片段所在的页会读入内存。
+ * 因此几十万个片段的字幕也能立即打开，播放界面和命令行工具只取需要的时间段。
+ */
+class MappedTranscript
+{
+public:
+    MappedTranscript();
+    ~MappedTranscript();
+
+    /**
+     * @brief 映射文件
+     * @param filePath 文件路径
+     * @param error 失败时的原因
+     * @return 是否成功
+     */
+    bool open(const QString &filePath, QString *error = nullptr);
+
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    int size() const { return int(m_header.segmentCount); }
+
+    /**
+     * @brief 写入时记录的来源媒体标识，0表示未记录
+     */
+    quint64 sourceKey() const { return m_header.sourceKey; }
+
+    const SegmentRecord &record(int index) const { return m_records[index]; }
+
+    QString text(int index) const;
+    TranscriptWords words(int index) const;
+    TranscriptSegment segment(int index) const;
+
+    /**
+     * @brief 包含timeMs的片段，不在任何片段内时取其后的第一个片段
+     * @return 片段序号，没有时返回size()
+     */
+    int firstSegmentFrom(qint64 timeMs) const;
+
+    /**
+     * @brief 与[fromMs, toMs)重叠的片段
+     */
+    QVector<TranscriptSegment> segmentsInRange(qint64 fromMs, qint64 toMs) const;
+
+    /**
+     * @brief 全部片段
+     */
+    QVector<TranscriptSegment> toSegments() const;
+
+    /**
+     * @brief 把片段按开始时间排序后写入文件（先写临时文件，成功后再替换）
+     * @param filePath 文件路径
+     * @param segments 片段
+     * @param error 失败时的原因
+     * @param sourceKey 记入文件头的来源媒体标识，0表示不记录
+     * @return 是否成功
+     */
+    static bool write(const QString &filePath, const QVector<TranscriptSegment> &segments, QString *error = nullptr,
+                      quint64 sourceKey = 0);
+
+    /**
+     * @brief 媒体文件的标识：规范化的完整路径的SHA-1的前8字节，不会为0
+     *
+     * 字幕缓存以它命名并记在文件头中，不同目录下同名的文件、只有扩展名不同的文件不会共用缓存。
+     */
+    static quint64 sourceKeyFor(const QString &mediaFilePath);
+
+private:
+    Q_DISABLE_COPY(MappedTranscript)
+
+    QFile m_file;
+    SegmentStoreHeader m_header;
+    const uchar *m_data;
+    const SegmentRecord *m_records;
+    const qint32 *m_wordStartMs;
+    const qint32 *m_wordEndMs;
+    const qint32 *m_wordTextOffset;
+    const char *m_text;
+};
+
+#endif // MAPPEDTRANSCRIPT_H
@@ -0,0 +1,171 @@
+#ifndef MEDIALIBRARY_H
+#define MEDIALIBRARY_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief ffprobe读取的媒体信息
+ */
+struct MediaProbe
+{
+    qint64 durationMs = -1;   ///< 时长（毫秒），未知时为-1
+    QString container;        ///< 容器格式，如mov,mp4,m4a
+    QString videoCodec;       ///< 第一条视频流的编码，纯音频时为空
+    QString audioCodec;       ///< 第一条音频流的编码
+    int width = 0;            ///< 视频宽度
+    int height = 0;           ///< 视频高度
+    int sampleRate = 0;       ///< 音频采样率
+    int channels = 0;         ///< 音频声道数
+};
+
+/**
+ * @brief 用ffprobe读取媒体信息（只读取容器头部），应在工作线程中调用
+ * @param mediaFilePath 媒体文件
+ * @param probe 媒体信息
+ * @param error 失败时的原因
+ * @return 是否成功
+ */
+bool probeMedia(const QString &mediaFilePath, MediaProbe &probe, QString *error = nullptr);
+
+/**
+ * @brief 媒体文件的内容指纹：文件大小加上开头、中间、结尾各一块数据的SHA-1
+ *
+ * 不读取整个文件，几GB的视频也只读几百KB；用于识别内容是否变化以及被移动或改名的文件。
+ * @return 指纹，文件不可读时为空
+ */
+QByteArray mediaContentHash(const QString &mediaFilePath);
+
+/**
+ * @brief 字幕状态
+ */
+enum class TranscriptStatus
+{
+    None = 0,        ///< 还没有字幕
+    Transcribed = 1, ///< 已识别或导入，字幕缓存可用
+    Failed = 2       ///< 识别失败
+};
+
+/**
+ * @brief 媒体库中的一个文件
+ */
+struct MediaLibraryEntry
+{
+    qint64 id = 0;
+    QString path;             ///< 绝对路径
+    qint64 size = 0;          ///< 文件大小（字节）
+    qint64 modifiedMs = 0;    ///< 修改时间（Unix毫秒）
+    QByteArray contentHash;   ///< 内容指纹，见mediaContentHash
+    MediaProbe probe;         ///< 媒体信息，ffprobe失败时为默认值
+    TranscriptStatus transcriptStatus = TranscriptStatus::None;
+    QString transcriptPath;   ///< 字幕缓存文件，没有时为空
+};
+
+/**
+ * @brief 一次扫描的统计
+ */
+struct MediaScanStats
+{
+    int filesSeen = 0;      ///< 目录中的媒体文件数
+    int unchanged = 0;      ///< 大小和修改时间都没变，直接跳过
+    int touched = 0;        ///< 修改时间变了但内容指纹相同
+    int added = 0;          ///< 新文件
+    int updated = 0;        ///< 内容变化，重新读取了媒体信息
+    int moved = 0;          ///< 被移动或改名的已知文件，保留字幕状态
+    int removed = 0;        ///< 已不存在的文件
+    int probeFailures = 0;  ///< ffprobe失败的文件（仍然加入媒体库）
+    qint64 elapsedMs = 0;   ///< 扫描耗时
+};
+
+/**
+ * @brief 基于SQLite的媒体库：媒体信息、内容指纹、字幕状态和路径
+ *
+ * 扫描是增量的：大小和修改时间都没变的文件不读取内容；其余文件由多个线程并行计算内容指纹，
+ * 指纹不变的只更新修改时间，指纹与某个已消失文件相同的视为移动，只有内容真正变化的新文件才运行ffprobe。
+ * 所有写入在一个事务中提交。
+ *
+ * scan使用自己的数据库连接，可以在工作线程中调用；其他方法只能在调用open的线程中使用。
+ */
+class MediaLibrary
+{
+public:
+    /**
+     * @brief 扫描进度回调，参数为已处理和需要处理（计算指纹）的文件数，在扫描的工作线程中串行调用
+     */
+    typedef std::function<void(int done, int total)> ProgressCallback;
+
+    MediaLibrary();
+    ~MediaLibrary();
+
+    /**
+     * @brief 打开数据库文件，不存在时创建
+     * @param databasePath 数据库文件
+     * @param error 失败时的原因
+     * @return 是否成功
+     */
+    bool open(const QString &databasePath, QString *error = nullptr);
+
+    bool isOpen() const;
+    QString databasePath() const;
+
+    /**
+     * @brief 增量扫描一个目录（包括子目录），并把它加入媒体库的目录列表
+     * @param folder 目录
+     * @param stats 扫描统计
+     * @param error 失败时的原因
+     * @param progress 进度回调，可以为空
+     * @param cancelled 置为true时尽快停止，不写入任何结果并返回失败；可以为空
+     * @return 是否成功
+     */
+    bool scan(const QString &folder, MediaScanStats &stats, QString *error = nullptr,
+              const ProgressCallback &progress = ProgressCallback(), const std::atomic<bool> *cancelled = nullptr) const;
+
+    /**
+     * @brief 媒体库中的目录
+     */
+    QStringList folders() const;
+
+    /**
+     * @brief 从目录列表中删除一个目录及其中的文件
+     */
+    bool removeFolder(const QString &folder, QString *error = nullptr);
+
+    /**
+     * @brief 列出媒体库中的文件，按路径排序
+     * @param filter 只列出路径中包含该文本的文件（不区分大小写），为空时列出全部
+     */
+    QVector<MediaLibraryEntry> entries(const QString &filter = QString()) const;
+
+    /**
+     * @brief 按路径查找文件，找不到时返回false
+     */
+    bool entry(const QString &mediaFilePath, MediaLibraryEntry &result) const;
+
+    /**
+     * @brief 更新文件的字幕状态，文件不在媒体库中时什么都不做
+     */
+    bool setTranscriptStatus(const QString &mediaFilePath, TranscriptStatus status, const QString &transcriptPath,
+                             QString *error = nullptr);
+
+    /**
+     * @brief 媒体库中的文件数
+     */
+    int size() const;
+
+    /**
+     * @brief 媒体库识别的扩展名，如*.mp4
+     */
+    static QStringList mediaNameFilters();
+
+private:
+    Q_DISABLE_COPY(MediaLibrary)
+
+    QString m_databasePath;
+    QString m_connectionName;
+};
+
+#endif // MEDIALIBRARY_H
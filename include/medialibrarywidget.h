@@ -0,0 +1,84 @@
+#ifndef MEDIALIBRARYWIDGET_H
+#define MEDIALIBRARYWIDGET_H
+
+#include <QSharedPointer>
+#include <QWidget>
+#include <QTimer>
+#include <atomic>
+
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QThread;
+class QTreeWidget;
+class QTreeWidgetItem;
+class MediaLibrary;
+struct MediaScanStats;
+
+/**
+ * @brief 媒体库：添加和重新扫描目录，按路径过滤文件，双击打开
+ *
+ * 扫描在工作线程中进行（MediaLibrary::scan使用自己的数据库连接），列表在标签页显示时从数据库重新读取。
+ */
+class MediaLibraryWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MediaLibraryWidget(const QSharedPointer<MediaLibrary> &library, QWidget *parent = nullptr);
+
+    /**
+     * @brief 取消正在进行的扫描并等待扫描线程结束
+     */
+    ~MediaLibraryWidget() override;
+
+    bool isScanning() const;
+
+public slots:
+    /**
+     * @brief 在后台重新扫描媒体库中的全部目录
+     */
+    void rescanAll();
+
+    /**
+     * @brief 从数据库重新读取列表
+     */
+    void refresh();
+
+signals:
+    /**
+     * @brief 用户选择了一个文件
+     */
+    void mediaActivated(const QString &mediaFilePath);
+
+    /**
+     * @brief 一次扫描结束
+     * @param summary 结果说明
+     */
+    void scanFinished(const QString &summary);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
+private slots:
+    void addFolder();
+    void onItemActivated(QTreeWidgetItem *item, int column);
+
+private:
+    void startScan(const QStringList &folders);
+    void onScanProgress(int done, int total);
+    void onScanFinished(const MediaScanStats &stats, const QStringList &errors);
+
+    QSharedPointer<MediaLibrary> m_library;
+    QLineEdit *m_filterEdit;
+    QPushButton *m_addButton;
+    QPushButton *m_rescanButton;
+    QTreeWidget *m_fileTree;
+    QLabel *m_statusLabel;
+    QTimer m_filterTimer;
+    bool m_scanning;
+    QThread *m_scanThread;            ///< 正在运行的扫描线程，结束后置空
+    std::atomic<bool> m_cancelScan;
+};
+
+#endif // MEDIALIBRARYWIDGET_H
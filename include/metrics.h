@@ -0,0 +1,163 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// 每个指标的分片数，超过此数的线程会共享分片（仍然正确，只是可能争用）
+const unsigned kMetricShardCount = 16;
+
+/// 分片间距，相邻分片的原子变量落在不同缓存行（C++11没有对齐分配，用填充代替alignas）
+const size_t kMetricShardStride = 64;
+
+/**
+ * @brief 当前线程使用的分片编号，线程首次调用时按轮转分配
+ */
+unsigned currentMetricShard();
+
+/**
+ * @brief 单调递增的计数器
+ *
+ * 每个线程只用relaxed原子操作更新自己的分片（各占一个缓存行），导出时再汇总所有分片，
+ * 热路径上没有锁，也没有多个线程争用同一缓存行。
+ */
+class MetricCounter
+{
+public:
+    MetricCounter();
+
+    void increment(uint64_t amount = 1)
+    {
+        m_shards[currentMetricShard()].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 汇总所有分片
+     */
+    uint64_t value() const;
+
+private:
+    struct Shard
+    {
+        std::atomic<uint64_t> value;
+        char padding[kMetricShardStride - sizeof(std::atomic<uint64_t>)];
+    };
+    Shard m_shards[kMetricShardCount];
+};
+
+/**
+ * @brief 可增可减的仪表，用于正在运行的任务数等低频更新的量
+ */
+class MetricGauge
+{
+public:
+    MetricGauge() : m_value(0) {}
+
+    void set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    void add(int64_t delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> m_value;
+};
+
+/**
+ * @brief 固定桶边界的直方图，与MetricCounter一样按线程分片
+ */
+class MetricHistogram
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param upperBounds 升序的桶上界，末尾隐含+Inf桶
+     */
+    explicit MetricHistogram(const std::vector<double> &upperBounds);
+
+    void observe(double value);
+
+    const std::vector<double> &upperBounds() const { return m_upperBounds; }
+
+    /**
+     * @brief 汇总所有分片
+     * @param bucketCounts 输出每个桶（非累计）的计数，最后一项为+Inf桶
+     * @param sum 输出观测值之和
+     * @return 观测次数
+     */
+    uint64_t snapshot(std::vector<uint64_t> &bucketCounts, double &sum) const;
+
+    /**
+     * @brief 常用的时长桶（秒），从10毫秒到10分钟
+     */
+    static std::vector<double> durationBuckets();
+
+private:
+    struct Shard
+    {
+        std::unique_ptr<std::atomic<uint64_t>[]> counts; ///< 每个分片单独分配，桶计数不与其他分片共享缓存行
+        std::atomic<double> sum;
+        char padding[kMetricShardStride - sizeof(std::unique_ptr<std::atomic<uint64_t>[]>) - sizeof(std::atomic<double>)];
+    };
+
+    std::vector<double> m_upperBounds;
+    Shard m_shards[kMetricShardCount];
+};
+
+/**
+ * @brief 进程内的指标注册表，按Prometheus文本格式导出
+ *
+ * 指标名和标签组合唯一确定一个时间序列，同名的不同标签组合导出为同一个指标族。
+ * 标签按Prometheus语法给出，例如 stage="decode"。重复注册返回已有的对象；
+ * 以不同类型注册已有的指标族时输出错误，返回的对象可以使用但不会导出。
+ * 返回的引用在进程生命周期内有效，调用方可以缓存（例如保存在函数内的静态引用中）。
+ * 只有注册和导出时加锁。
+ */
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry &instance();
+
+    MetricCounter &counter(const std::string &name, const std::string &help, const std::string &labels = std::string());
+    MetricGauge &gauge(const std::string &name, const std::string &help, const std::string &labels = std::string());
+    MetricHistogram &histogram(const std::string &name, const std::string &help, const std::vector<double> &upperBounds,
+                               const std::string &labels = std::string());
+
+    /**
+     * @brief 注册在导出时求值的仪表，回调在导出线程中执行；重复注册时替换回调
+     */
+    void gaugeCallback(const std::string &name, const std::string &help, const std::function<double()> &callback,
+                       const std::string &labels = std::string());
+
+    /**
+     * @brief 按Prometheus文本格式（0.0.4）导出全部指标
+     */
+    std::string renderPrometheus() const;
+
+private:
+    enum class Type { Counter, Gauge, GaugeCallback, Histogram };
+
+    struct Series
+    {
+        std::string name;
+        std::string help;
+        std::string labels;
+        Type type;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+        std::unique_ptr<MetricHistogram> histogram;
+        std::function<double()> callback;
+    };
+
+    Series &findOrAdd(const std::string &name, const std::string &help, const std::string &labels, Type type);
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<Series>> m_series;
+    std::vector<std::unique_ptr<Series>> m_rejected;   ///< 类型与已注册的指标族冲突的序列，不导出
+};
+
+#endif // METRICS_H
@@ -0,0 +1,55 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+#include <QHostAddress>
+
+class QTcpServer;
+class QTcpSocket;
+
+/**
+ * @brief 以Prometheus文本格式提供MetricsRegistry中指标的最小HTTP服务
+ *
+ * 只响应GET /metrics，每个连接返回一次结果后关闭。默认只监听本机回环地址。
+ * 导出在主线程中进行，进程内存等按需求值的仪表因此也在主线程中求值。
+ */
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsServer(QObject *parent = nullptr);
+    ~MetricsServer();
+
+    /**
+     * @brief 开始监听
+     * @param port 端口
+     * @param address 监听地址
+     * @return 是否成功
+     */
+    bool start(quint16 port, const QHostAddress &address = QHostAddress::LocalHost);
+
+    void stop();
+
+    bool isListening() const;
+    quint16 port() const;
+
+private slots:
+    void handleNewConnection();
+    void handleReadyRead();
+
+private:
+    void respond(QTcpSocket *socket, const QByteArray &status, const QByteArray &contentType, const QByteArray &body);
+
+    QTcpServer *m_server;
+    QHash<QTcpSocket *, QByteArray> m_pendingRequests; ///< 尚未收到完整请求头的连接
+};
+
+/**
+ * @brief 注册进程级指标（内存、运行时间），由MetricsServer启动时调用，重复调用无副作用
+ */
+void registerProcessMetrics();
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,152 @@
+#ifndef PCMBUFFER_H
+#define PCMBUFFER_H
+
+#include <QSharedPointer>
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class WavReader;
+class QTemporaryFile;
+
+/**
+ * @brief 以16位整数保存的单声道解码音频
+ *
+ * 样本按固定大小的块存放，追加时不会像std::vector扩容那样产生整段拷贝和双倍峰值内存；
+ * 也可以直接引用内存映射的WAV文件，不做任何拷贝。识别时按窗口转换为浮点数。
+ * 设置内存预算后，超出预算的样本写入临时目录中的暂存文件，读取时只映射需要的窗口，
+ * 因此无论音频多长，常驻内存都保持在预算以内。
+ */
+class PcmBuffer
+{
+public:
+    PcmBuffer();
+    ~PcmBuffer();
+
+    /**
+     * @brief 释放所有样本和暂存文件（保留内存预算设置）
+     */
+    void clear();
+
+    /**
+     * @brief 设置内存预算，超过预算后样本写入暂存文件
+     * @param memoryBudgetBytes 内存中最多保存的样本字节数，小于等于0表示不限制
+     * @param scratchDirectory 暂存文件目录，为空时使用系统临时目录；可以指定tmpfs目录如/dev/shm
+     */
+    void setSpillPolicy(qint64 memoryBudgetBytes, const QString &scratchDirectory);
+
+    qint64 memoryBudgetBytes() const { return m_memoryBudgetBytes; }
+    QString scratchDirectory() const { return m_scratchDirectory; }
+
+    /**
+     * @brief 是否已有样本写入暂存文件
+     */
+    bool isSpilled() const { return m_spilledSamples > 0; }
+
+    /**
+     * @brief 追加16位样本
+     * @param samples 样本数据
+     * @param count 样本数
+     */
+    void append(const int16_t *samples, size_t count);
+
+    /**
+     * @brief 追加小端16位PCM字节流，可以在任意字节处切分
+     * @param bytes 字节数据
+     * @param size 字节数
+     */
+    void appendBytes(const char *bytes, size_t size);
+
+    /**
+     * @brief 追加另一个缓冲区的全部样本，暂存文件中的部分按范围映射后复制
+     * @param other 来源缓冲区
+     */
+    void append(const PcmBuffer &other);
+
+    /**
+     * @brief 直接引用内存映射的WAV文件中的一段样本，不拷贝数据
+     * @param reader 已打开的16位单声道WAV读取器
+     * @param firstFrame 起始帧
+     * @param frameCount 帧数
+     */
+    void setMappedWav(const QSharedPointer<WavReader> &reader, qint64 firstFrame, qint64 frameCount);
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    /**
+     * @brief 是否引用内存映射文件
+     */
+    bool isMapped() const { return m_mapped != nullptr; }
+
+    /**
+     * @brief 把[offset, offset + count)范围的样本转换为浮点数
+     * @param offset 起始样本
+     * @param count 样本数，超出范围的部分不写入
+     * @param output 输出缓冲区
+     * @return 实际转换的样本数
+     */
+    size_t toFloat(size_t offset, size_t count, float *output) const;
+
+    /**
+     * @brief 把[offset, offset + count)范围的样本复制为16位整数
+     * @param offset 起始样本
+     * @param count 样本数，超出范围的部分不写入
+     * @param output 输出缓冲区
+     * @return 实际复制的样本数
+     */
+    size_t toInt16(size_t offset, size_t count, int16_t *output) const;
+
+    /**
+     * @brief 样本占用的匿名内存字节数（不含映射文件和暂存文件）
+     */
+    qint64 residentBytes() const;
+
+    /**
+     * @brief 写入暂存文件的样本字节数
+     */
+    qint64 spilledBytes() const { return qint64(m_spilledSamples * sizeof(int16_t)); }
+
+    static const size_t kBlockSamples = size_t(1) << 20; ///< 每块样本数（约65秒16kHz音频）
+
+private:
+    Q_DISABLE_COPY(PcmBuffer)
+
+    /**
+     * @brief 把内存中已写满的块写入暂存文件，超出预算时调用
+     * @return 是否成功，失败时样本继续保存在内存中
+     */
+    bool spillFullBlocks();
+
+    /**
+     * @brief 依次访问[offset, offset + count)范围内连续存放的各段样本
+     *
+     * 映射的WAV和内存块直接给出原始数据；暂存文件只映射需要的范围，映射失败时分段读取，
+     * 读取失败的部分按静音给出。
+     * @param visit 每段调用一次，参数为样本、样本数和这一段在范围内的起点
+     * @return 实际访问的样本数
+     */
+    size_t forEachSpan(size_t offset, size_t count,
+                       const std::function<void(const int16_t *samples, size_t n, size_t done)> &visit) const;
+
+    // m_blocks[0]对应第m_spilledSamples个样本，之前的样本都在暂存文件中
+    std::vector<std::unique_ptr<int16_t[]>> m_blocks;
+    size_t m_size;
+
+    qint64 m_memoryBudgetBytes;
+    QString m_scratchDirectory;
+    std::unique_ptr<QTemporaryFile> m_scratchFile;
+    size_t m_spilledSamples;
+    bool m_spillFailed;
+
+    QSharedPointer<WavReader> m_wavReader;
+    const int16_t *m_mapped;
+
+    bool m_hasPendingByte;
+    char m_pendingByte;
+};
+
+#endif // PCMBUFFER_H
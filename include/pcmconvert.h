@@ -0,0 +1,36 @@
+#ifndef PCMCONVERT_H
+#define PCMCONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 将16位有符号PCM样本转换为[-1, 1)范围的浮点样本
+ *
+ * x86上使用SSE2，CPU支持时在运行时切换到AVX2；ARM上使用NEON；其他平台使用标量实现。
+ * 输入输出指针无对齐要求，但不能重叠。
+ * @param input 16位PCM样本
+ * @param output 输出的浮点样本，至少count个
+ * @param count 样本数
+ */
+void convertS16ToF32(const int16_t *input, float *output, size_t count);
+
+/**
+ * @brief convertS16ToF32的标量参考实现，用于校验和性能对比
+ */
+void convertS16ToF32Scalar(const int16_t *input, float *output, size_t count);
+
+/**
+ * @brief 将浮点样本四舍五入转换为16位有符号PCM，超出范围的样本饱和截断
+ * @param input 浮点样本，满幅为[-1, 1)
+ * @param output 输出的16位样本，至少count个
+ * @param count 样本数
+ */
+void convertF32ToS16(const float *input, int16_t *output, size_t count);
+
+/**
+ * @brief convertF32ToS16的标量参考实现
+ */
+void convertF32ToS16Scalar(const float *input, int16_t *output, size_t count);
+
+#endif // PCMCONVERT_H
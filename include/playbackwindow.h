@@ -5,6 +5,8 @@
 #include <QMediaPlayer>
 #include <QVideoWidget>
 
+class TranscriptModel;
+
 namespace Ui {
 class PlaybackWindow;
 }
@@ -20,12 +22,25 @@ public:
     // 设置要播放的文件路径
     void setMediaFilePath(const QString &filePath);
     
-    // 设置字幕内容
-    void setSubtitleContent(const QString &subtitle);
+    // 设置字幕模型（与识别界面共用）
+    void setTranscriptModel(TranscriptModel *model);
+    
+    // 区间识别进行中时禁用识别按钮
+    void setRangeRecognitionBusy(bool busy);
+    
+    // 跳转到指定时间并开始播放，媒体尚未加载完成时在加载后跳转
+    void seekTo(qint64 positionMs);
+
+protected:
+    // 处理字幕列表上的鼠标点击，跳转到点中的词
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 signals:
     // 当用户点击返回按钮时发出信号
     void backToRecognitionRequested();
+    
+    // 请求识别进度条上选定的区间（毫秒）
+    void rangeRecognitionRequested(qint64 startMs, qint64 endMs);
 
 private slots:
     // 播放控制槽函数
@@ -41,13 +56,39 @@ private slots:
     
     // 进度条拖动
     void on_positionSlider_sliderMoved(int position);
+    
+    // 在进度条上选择识别区间
+    void on_markRangeStartButton_clicked();
+    void on_markRangeEndButton_clicked();
+    void on_recognizeRangeButton_clicked();
+    
+    // 在字幕列表上按回车时跳转到该行开头
+    void on_subtitleListView_activated(const QModelIndex &index);
 
 private:
     Ui::PlaybackWindow *ui;
     QMediaPlayer *player;
     QVideoWidget *videoWidget;
     QString currentMediaFile;
-    QString currentSubtitle;
+    qint64 rangeStartMs;   // 选定区间起点，-1表示未选择
+    qint64 rangeEndMs;     // 选定区间终点，-1表示未选择
+    bool rangeRecognitionBusy;
+    TranscriptModel *transcriptModel;
+    int currentTranscriptRow;   // 当前播放位置所在的字幕行，-1表示没有
+    int currentWordIndex;       // 当前行中正在播放的词，-1表示没有
+    qint64 pendingSeekMs;       // 媒体加载完成后要跳转的时间，-1表示没有
+    
+    // 跳转到字幕列表中点击位置对应的时间
+    void seekToTranscriptPoint(const QPoint &position);
+    
+    // 高亮播放位置所在的字幕行，必要时滚动列表
+    void updateCurrentTranscriptRow(qint64 position);
+    
+    // 推进当前词并刷新逐词高亮
+    void updateCurrentWord(qint64 position, bool rowChanged);
+    
+    // 更新区间显示和识别按钮状态
+    void updateRangeControls();
     
     // 格式化时间显示
     QString formatTime(qint64 milliseconds);
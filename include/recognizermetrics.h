@@ -0,0 +1,41 @@
+#ifndef RECOGNIZERMETRICS_H
+#define RECOGNIZERMETRICS_H
+
+#include "metrics.h"
+
+/**
+ * @brief 识别流程的指标，由识别器在各阶段更新，由指标服务和性能面板读取
+ *
+ * 各字段引用MetricsRegistry中的对象，读写都不加锁。
+ */
+struct RecognizerMetrics
+{
+    MetricGauge &jobsQueued;          ///< 等待中的识别任务
+    MetricGauge &jobsRunning;         ///< 正在运行的识别任务
+    MetricCounter &jobsCompleted;
+    MetricCounter &jobsFailed;
+    MetricGauge &jobPositionMs;       ///< 当前任务已识别到的位置（相对任务起点的毫秒数）
+    MetricHistogram &decodeSeconds;
+    MetricHistogram &inferenceSeconds;
+    MetricHistogram &totalSeconds;
+    MetricHistogram &realTimeFactor;
+    MetricHistogram &modelLoadSeconds;
+    MetricCounter &sourceBytes;
+    MetricCounter &decodedBytes;
+    MetricCounter &tokens;
+    MetricCounter &loadsMapped;       ///< 直接映射16kHz单声道WAV的零拷贝快路径
+    MetricCounter &loadsConverted;    ///< 映射其他格式的WAV并在进程内转换
+    MetricCounter &loadsFfmpeg;       ///< 通过ffmpeg解码
+    MetricCounter &loadsFfmpegParallel; ///< 长文件分段后由多个ffmpeg并行解码
+    MetricCounter &streamReconnects;  ///< 网络流断开后重连的次数
+    MetricCounter &streamDroppedMs;   ///< 识别跟不上网络流时丢弃的音频（毫秒）
+
+    RecognizerMetrics();
+};
+
+/**
+ * @brief 进程内唯一的识别指标，首次调用时注册
+ */
+RecognizerMetrics &recognizerMetrics();
+
+#endif // RECOGNIZERMETRICS_H
@@ -0,0 +1,152 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 有理数比例的多相重采样器
+ *
+ * 原型滤波器为Kaiser窗sinc低通，截止频率取输入输出中较低奈奎斯特频率的90%，
+ * 每个输出样本只计算所在相位的一组系数（点积使用AVX2/FMA、SSE或NEON）。
+ * 44.1kHz和48kHz到16kHz的比例使用编译期常量的专用路径。
+ * 支持流式输入，分块处理的结果与一次性处理完全相同。
+ */
+class PolyphaseResampler
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param inputRate 输入采样率
+     * @param outputRate 输出采样率
+     * @param zeroCrossings 滤波器单侧的过零点数，越大过渡带越窄
+     */
+    PolyphaseResampler(int inputRate, int outputRate, int zeroCrossings = 24);
+
+    /**
+     * @brief 处理一段单声道输入，输出追加到output
+     * @param input 输入样本
+     * @param count 样本数
+     * @param output 输出缓冲区（追加）
+     */
+    void process(const float *input, size_t count, std::vector<float> &output);
+
+    /**
+     * @brief 输入结束，输出剩余样本（末尾补零）
+     * @param output 输出缓冲区（追加）
+     */
+    void flush(std::vector<float> &output);
+
+    /**
+     * @brief 清除内部状态，准备处理新的数据流
+     */
+    void reset();
+
+    int inputRate() const { return m_inputRate; }
+    int outputRate() const { return m_outputRate; }
+    int upFactor() const { return m_up; }
+    int downFactor() const { return m_down; }
+
+    /**
+     * @brief 每个相位的系数个数
+     */
+    int tapsPerPhase() const { return m_taps; }
+
+    /**
+     * @brief 相位phase（0 <= phase < upFactor）的系数，长度为tapsPerPhase
+     */
+    const float *phaseCoefficients(int phase) const { return &m_coefficients[size_t(phase) * m_taps]; }
+
+    /**
+     * @brief 计算原型滤波器在距离输出时刻x个输入样本处的权重（未归一化），用于参考实现
+     */
+    double kernel(double x) const;
+
+private:
+    template <class Ratio>
+    void produce(const Ratio &ratio, bool draining, std::vector<float> &output);
+
+    void run(bool draining, std::vector<float> &output);
+
+    int m_inputRate;
+    int m_outputRate;
+    int m_up;            // 插值因子L
+    int m_down;          // 抽取因子M
+    int m_taps;          // 每个相位的系数个数
+    double m_cutoff;     // 截止频率（周期/输入样本）
+    double m_beta;       // Kaiser窗参数
+    std::vector<float> m_coefficients;
+
+    std::vector<float> m_buffer;   // 尚未完全消耗的输入（包含历史样本）
+    int64_t m_bufferStart;         // m_buffer[0]对应的输入样本序号
+    int64_t m_inputCount;          // 已输入的样本总数
+    int64_t m_nextOutput;          // 下一个输出样本序号
+};
+
+/**
+ * @brief 将交错的16位多声道样本混合为单声道浮点样本
+ *
+ * 单声道、立体声和5.1声道使用模板专用实现，其余声道数取各声道平均值。
+ * 5.1先按ITU-R BS.775降为立体声（中置和环绕乘以0.707，忽略LFE）再取平均，并整体归一化防止削波。
+ * @param input 交错样本
+ * @param frames 帧数
+ * @param channels 声道数
+ * @param output 输出的单声道样本，至少frames个
+ */
+void downmixS16ToMono(const int16_t *input, size_t frames, int channels, float *output);
+
+/**
+ * @brief 解码输出到识别输入的转换链：降混为单声道、重采样并量化为16位
+ */
+class AudioConverter
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param inputRate 输入采样率
+     * @param channels 输入声道数
+     * @param outputRate 输出采样率
+     */
+    AudioConverter(int inputRate, int channels, int outputRate);
+
+    /**
+     * @brief 追加交错的16位小端PCM字节，可以在任意字节处切分
+     * @param bytes 字节数据
+     * @param size 字节数
+     * @param output 输出的16位单声道样本（追加）
+     */
+    void pushBytes(const char *bytes, size_t size, std::vector<int16_t> &output);
+
+    /**
+     * @brief 追加交错的16位样本帧
+     * @param frames 交错样本
+     * @param frameCount 帧数
+     * @param output 输出的16位单声道样本（追加）
+     */
+    void pushFrames(const int16_t *frames, size_t frameCount, std::vector<int16_t> &output);
+
+    /**
+     * @brief 输入结束，输出重采样器中剩余的样本
+     * @param output 输出的16位单声道样本（追加）
+     */
+    void finish(std::vector<int16_t> &output);
+
+    /**
+     * @brief 是否无需任何转换（单声道且采样率相同）
+     */
+    bool isPassthrough() const { return m_channels == 1 && m_inputRate == m_outputRate; }
+
+private:
+    void emitResampled(std::vector<int16_t> &output);
+
+    int m_inputRate;
+    int m_channels;
+    int m_outputRate;
+    PolyphaseResampler m_resampler;
+    std::vector<char> m_pendingBytes;
+    std::vector<float> m_mono;
+    std::vector<float> m_resampled;
+};
+
+#endif // RESAMPLER_H
@@ -0,0 +1,185 @@
+#ifndef RESOURCEMONITOR_H
+#define RESOURCEMONITOR_H
+
+#include <QObject>
+#include <QMetaType>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief 一次识别任务的资源消耗，随识别结果一起发出
+ */
+struct RecognitionJobStats
+{
+    QString mediaFilePath;       ///< 识别的媒体文件
+    qint64 wallMs = 0;           ///< 从开始解码到识别结束的墙钟时间
+    qint64 decodeMs = 0;         ///< 解码阶段耗时
+    qint64 inferenceMs = 0;      ///< 推理阶段耗时
+    double cpuSeconds = 0;       ///< 任务期间本进程及ffmpeg子进程消耗的CPU时间
+    qint64 peakRssDeltaKb = 0;   ///< 任务期间采样到的RSS峰值相对任务开始时的增长
+    qint64 sourceBytes = 0;      ///< 从解码器管道或映射文件读取的字节数
+    qint64 bytesDecoded = 0;     ///< 解码得到的16kHz 16位样本字节数
+    int tokensGenerated = 0;     ///< 生成的文本token数（不含特殊token）
+    int segments = 0;            ///< 识别出的片段数
+    double audioSeconds = 0;     ///< 识别的音频时长
+
+    /**
+     * @brief 格式化为一行摘要，用于日志和状态栏
+     */
+    QString summary() const;
+};
+
+Q_DECLARE_METATYPE(RecognitionJobStats)
+
+/**
+ * @brief 进程级内存信息（Linux读取/proc/self/status，其他平台为0）
+ */
+struct ProcessMemory
+{
+    qint64 rssBytes = 0;          ///< 当前常驻内存
+    qint64 peakRssBytes = 0;      ///< 峰值常驻内存
+    qint64 heapInUseBytes = -1;   ///< malloc中正在使用的字节数，-1表示不可用
+    qint64 heapFreeBytes = -1;    ///< malloc已向系统申请但空闲的字节数（碎片），-1表示不可用
+};
+
+/**
+ * @brief 读取当前进程的内存信息
+ */
+ProcessMemory readProcessMemory();
+
+/**
+ * @brief 单个线程累计消耗的CPU时间
+ */
+struct ThreadCpuTime
+{
+    qint64 threadId = 0;
+    QString name;              ///< 线程名（Linux下最多15个字符）
+    double cpuSeconds = 0;     ///< 用户态加内核态时间
+};
+
+/**
+ * @brief 读取本进程所有线程的CPU时间（Linux读取/proc/self/task，其他平台返回空）
+ */
+QVector<ThreadCpuTime> readThreadCpuTimes();
+
+/**
+ * @brief 读取当前常驻内存（Linux读取/proc/self/statm，比readProcessMemory开销小），不可用时为0
+ */
+qint64 readRssBytes();
+
+/**
+ * @brief 在一次任务期间周期性采样RSS，得到任务自己的峰值增长
+ *
+ * 不重置进程级的峰值RSS（VmHWM），同时运行的任务以及指标和面板中的峰值互不影响。
+ * 两次采样之间的短暂尖峰可能漏掉。
+ */
+class RssPeakSampler
+{
+public:
+    explicit RssPeakSampler(int intervalMs = 50);
+    ~RssPeakSampler();
+
+    /**
+     * @brief 以当前RSS为基准开始采样，正在采样时重新开始
+     */
+    void start();
+
+    /**
+     * @brief 停止采样
+     * @return 采样期间RSS相对基准的最大增长（字节）
+     */
+    qint64 stop();
+
+private:
+    Q_DISABLE_COPY(RssPeakSampler)
+
+    int m_intervalMs;
+    qint64 m_baselineBytes;
+    std::atomic<qint64> m_peakBytes;
+    bool m_stopping;                     ///< 由m_mutex保护
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    std::unique_ptr<QThread> m_thread;
+};
+
+/**
+ * @brief 进程（含已结束并回收的子进程）消耗的CPU时间（秒）
+ */
+double processCpuSeconds();
+
+/**
+ * @brief 周期性采样进程内存并按子系统拆分
+ *
+ * 各子系统注册一个返回自身占用字节数的函数，采样时在主线程中调用。
+ * RSS减去已登记子系统的部分记为“未归属”，其中包括whisper计算缓冲区、Qt网络栈和
+ * 分配器碎片等无法直接统计的内存；连续多次采样中未归属部分持续增长时输出警告。
+ */
+class ResourceMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 一个子系统的采样值
+     */
+    struct SubsystemUsage
+    {
+        QString name;
+        qint64 bytes;
+    };
+
+    explicit ResourceMonitor(QObject *parent = nullptr);
+
+    /**
+     * @brief 登记子系统
+     * @param name 子系统名称
+     * @param bytesProvider 返回子系统当前占用字节数的函数
+     */
+    void registerSubsystem(const QString &name, const std::function<qint64()> &bytesProvider);
+
+    /**
+     * @brief 开始周期采样
+     * @param intervalMs 采样间隔（毫秒）
+     */
+    void start(int intervalMs);
+
+    void stop();
+
+    /**
+     * @brief 立即采样一次并发出memorySampled
+     */
+    void sampleNow();
+
+signals:
+    /**
+     * @brief 采样完成
+     * @param memory 进程内存信息
+     * @param subsystems 各子系统占用，最后一项为“未归属”
+     * @param summary 一行摘要
+     */
+    void memorySampled(const ProcessMemory &memory, const QVector<ResourceMonitor::SubsystemUsage> &subsystems,
+                       const QString &summary);
+
+private:
+    struct Subsystem
+    {
+        QString name;
+        std::function<qint64()> bytesProvider;
+    };
+
+    QTimer m_timer;
+    QVector<Subsystem> m_subsystems;
+    qint64 m_lastUnattributed;
+    int m_growthStreak;    ///< 未归属内存连续增长的采样次数
+};
+
+Q_DECLARE_METATYPE(ProcessMemory)
+
+#endif // RESOURCEMONITOR_H
@@ -0,0 +1,58 @@
+#ifndef SEGMENTEDDECODE_H
+#define SEGMENTEDDECODE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class PcmBuffer;
+
+/**
+ * @brief 分段并行解码中的一段
+ *
+ * ffmpeg从startMs - leadInMs开始解码，前leadInMs毫秒只用于预热解码器和重采样器，输出时丢弃；
+ * 有界的段还会多解码一小段再截掉，重采样器在末尾的冲刷不会落在保留的样本中。
+ */
+struct DecodeRange
+{
+    qint64 startMs = 0;      ///< 保留的第一个样本的时间
+    qint64 durationMs = -1;  ///< 保留的时长，负数表示一直解码到文件末尾
+    qint64 leadInMs = 0;     ///< 起点之前预热的时长
+};
+
+/**
+ * @brief 把[startMs, startMs + totalMs)分成最多maxParts段，每段不短于minPartMs
+ *
+ * 各段边界与起点相差整秒：任何整数采样率下每段都是整数个样本，拼接处没有舍入误差。
+ * @param startMs 起点
+ * @param totalMs 总时长
+ * @param lastToEnd 最后一段是否一直解码到文件末尾（时长只是探测值时不截断）
+ * @param maxParts 最多分几段
+ * @param minPartMs 每段的最短时长
+ * @return 各段，按时间排列；不需要分段时只有一段
+ */
+QVector<DecodeRange> planDecodeRanges(qint64 startMs, qint64 totalMs, bool lastToEnd, int maxParts, qint64 minPartMs);
+
+/**
+ * @brief 解码一段时ffmpeg的命令行参数：-ss和-t作为输入选项，只读取这一段附近的数据
+ */
+QStringList decodeRangeFfmpegArguments(const QString &mediaFilePath, const DecodeRange &range);
+
+/**
+ * @brief 用多个ffmpeg同时解码各段，按顺序拼接为16kHz单声道样本
+ *
+ * 第一段直接写入samples，其余各段先写入各自的缓冲区，内存预算在各段之间平分。
+ * 除最后一段外，每段截取或补齐为正好durationMs的样本数，拼接后后面各段的时间不会偏移；
+ * 某段比预期短得多（探测的时长不准）时返回失败，调用方应改用单个ffmpeg。
+ * 会阻塞到所有段解码结束。
+ * @param mediaFilePath 媒体文件
+ * @param ranges 各段（来自planDecodeRanges）
+ * @param samples 输出（先清空，保留内存预算设置）
+ * @param sourceBytes 各ffmpeg输出的字节数之和，可为空
+ * @param error 失败时的原因
+ * @return 是否成功
+ */
+bool decodeRangesInParallel(const QString &mediaFilePath, const QVector<DecodeRange> &ranges, PcmBuffer &samples,
+                            qint64 *sourceBytes = nullptr, QString *error = nullptr);
+
+#endif // SEGMENTEDDECODE_H
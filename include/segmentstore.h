@@ -0,0 +1,158 @@
+#ifndef SEGMENTSTORE_H
+#define SEGMENTSTORE_H
+
+#include <QSharedDataPointer>
+#include <QMetaType>
+#include <QString>
+#include "transcript.h"
+
+class QIODevice;
+class SegmentStoreData;
+
+/**
+ * @brief 片段的定长记录
+ *
+ * 文本不在记录中，以字节偏移和长度指向存储区中的UTF-8文本；
+ * 词级时间戳以序号范围指向存储区中的词数组。记录可以直接按字节写入文件。
+ */
+struct SegmentRecord
+{
+    qint64 startMs;       ///< 片段开始时间（毫秒）
+    qint64 endMs;         ///< 片段结束时间（毫秒）
+    quint32 textOffset;   ///< 文本在文本区中的字节偏移
+    quint32 textBytes;    ///< 文本的字节数
+    quint32 firstWord;    ///< 第一个词在词数组中的序号
+    quint32 wordCount;    ///< 词数，没有词级时间戳时为0
+    float probability;    ///< 片段内token的平均概率，未知时为-1
+    quint32 reserved;     ///< 保留，始终为0
+};
+
+/**
+ * @brief 片段存储文件头
+ *
+ * 文件头之后依次为记录数组、词开始时间、词结束时间、词偏移和文本区，各部分之间没有填充，
+ * 按本机字节序存放。文件头40字节、记录40字节，映射到内存后各数组都自然对齐，可以直接访问。
+ */
+struct SegmentStoreHeader
+{
+    char magic[4];          ///< "QESS"
+    quint32 version;        ///< 格式版本
+    quint32 recordSize;     ///< sizeof(SegmentRecord)
+    quint32 byteOrder;      ///< 字节序标记
+    quint32 segmentCount;   ///< 片段数
+    quint32 wordCount;      ///< 词数
+    quint64 textBytes;      ///< 文本区字节数
+    quint64 sourceKey;      ///< 来源媒体文件的标识（见MappedTranscript::sourceKeyFor），0表示未记录
+
+    /**
+     * @brief 文件头之后数据部分的总字节数
+     */
+    quint64 payloadBytes() const;
+
+    /**
+     * @brief 检查文件头
+     * @param availableBytes 文件头之后可用的字节数，未知时传负数
+     * @param error 失败时的原因
+     */
+    bool isValid(qint64 availableBytes, QString *error = nullptr) const;
+};
+
+/**
+ * @brief 紧凑的片段存储
+ *
+ * 所有片段的文本连续存放在一块UTF-8文本区中，片段本身是定长记录，词级时间戳按结构数组存放，
+ * 十万个片段也只有几次（按容量倍增的）内存分配。QString只在需要显示时按需生成。
+ *
+ * 存储是隐式共享的：复制只增加引用计数，识别线程把结果交给界面线程时不复制数据；
+ * 只有在共享状态下修改时才会分离。文件格式与内存布局相同，写入和读取都是整块拷贝。
+ */
+class SegmentStore
+{
+public:
+    SegmentStore();
+    SegmentStore(const SegmentStore &other);
+    SegmentStore &operator=(const SegmentStore &other);
+    ~SegmentStore();
+
+    /**
+     * @brief 从片段列表构造
+     */
+    static SegmentStore fromSegments(const QVector<TranscriptSegment> &segments);
+
+    /**
+     * @brief 预留空间
+     * @param segments 片段数
+     * @param textBytes 文本总字节数
+     */
+    void reserve(int segments, qint64 textBytes);
+
+    /**
+     * @brief 追加一个片段
+     * @param startMs 开始时间（毫秒）
+     * @param endMs 结束时间（毫秒）
+     * @param utf8 UTF-8文本
+     * @param bytes 文本字节数
+     * @param probability token平均概率，未知时为-1
+     * @param words 词级时间戳
+     */
+    void append(qint64 startMs, qint64 endMs, const char *utf8, int bytes, float probability = -1.0f,
+                const TranscriptWords &words = TranscriptWords());
+
+    /**
+     * @brief 追加一个片段
+     */
+    void append(const TranscriptSegment &segment);
+
+    void clear();
+
+    int size() const;
+    bool isEmpty() const { return size() == 0; }
+
+    const SegmentRecord &record(int index) const;
+
+    /**
+     * @brief 片段文本的UTF-8字节，指向存储区内部，存储被修改后失效
+     */
+    const char *textData(int index) const;
+
+    QString text(int index) const;
+    TranscriptWords words(int index) const;
+    TranscriptSegment segment(int index) const;
+
+    /**
+     * @brief 转换为片段列表（每个片段生成一个QString）
+     */
+    QVector<TranscriptSegment> toSegments() const;
+
+    /**
+     * @brief 所有片段文本以空格连接，结果一次分配
+     */
+    QString joinedText() const;
+
+    /**
+     * @brief 占用的内存字节数（按容量计算）
+     */
+    qint64 memoryBytes() const;
+
+    /**
+     * @brief 写入设备，格式为文件头加记录数组、词数组和文本区
+     * @param sourceKey 记入文件头的来源媒体标识，0表示不记录
+     * @return 是否全部写入
+     */
+    bool writeTo(QIODevice *device, quint64 sourceKey = 0) const;
+
+    /**
+     * @brief 从设备读取writeTo写入的数据
+     * @param device 设备
+     * @param error 失败时的原因
+     * @return 读取成功时返回存储，失败时返回空存储
+     */
+    static SegmentStore readFrom(QIODevice *device, QString *error = nullptr);
+
+private:
+    QSharedDataPointer<SegmentStoreData> d;
+};
+
+Q_DECLARE_METATYPE(SegmentStore)
+
+#endif // SEGMENTSTORE_H
@@ -40,6 +40,11 @@ private slots:
      */
     void on_browseSubtitleDirButton_clicked();
     
+    /**
+     * @brief 浏览音频暂存目录按钮点击
+     */
+    void on_browseScratchDirButton_clicked();
+    
     /**
      * @brief 下载模型按钮点击
      */
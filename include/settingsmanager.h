@@ -100,6 +100,102 @@ public:
      */
     void setSubtitleSaveDirectory(const QString &directory);
     
+    /**
+     * @brief 获取解码音频的内存预算
+     * @return 内存预算（MB），0表示不限制
+     */
+    int getAudioMemoryBudgetMB() const;
+    
+    /**
+     * @brief 设置解码音频的内存预算，超出部分写入暂存文件
+     * @param megabytes 内存预算（MB），0表示不限制
+     */
+    void setAudioMemoryBudgetMB(int megabytes);
+    
+    /**
+     * @brief 获取音频暂存目录
+     * @return 暂存目录，为空表示使用系统临时目录
+     */
+    QString getScratchDirectory() const;
+    
+    /**
+     * @brief 设置音频暂存目录，建议使用tmpfs目录（如/dev/shm）
+     * @param directory 暂存目录
+     */
+    void setScratchDirectory(const QString &directory);
+    
+    /**
+     * @brief 获取识别使用的线程数
+     * @return 线程数，0表示自动（最多8个）
+     */
+    int getRecognitionThreads() const;
+    
+    /**
+     * @brief 设置识别使用的线程数
+     * @param threads 线程数，0表示自动
+     */
+    void setRecognitionThreads(int threads);
+    
+    /**
+     * @brief 获取解码策略
+     * @return "greedy"（贪心解码）或"beam"（束搜索）
+     */
+    QString getDecodingProfile() const;
+    
+    /**
+     * @brief 设置解码策略
+     * @param profile "greedy"或"beam"
+     */
+    void setDecodingProfile(const QString &profile);
+    
+    /**
+     * @brief 是否生成词级时间戳
+     * @return 是否启用
+     */
+    bool isWordTimestampsEnabled() const;
+    
+    /**
+     * @brief 设置是否生成词级时间戳（用于播放时逐词高亮，识别会稍慢）
+     * @param enabled 是否启用
+     */
+    void setWordTimestampsEnabled(bool enabled);
+    
+    /**
+     * @brief 是否启用Prometheus指标服务
+     * @return 是否启用
+     */
+    bool isMetricsEnabled() const;
+    
+    /**
+     * @brief 设置是否启用Prometheus指标服务
+     * @param enabled 是否启用
+     */
+    void setMetricsEnabled(bool enabled);
+    
+    /**
+     * @brief 获取指标服务端口（只监听本机回环地址）
+     * @return 端口
+     */
+    int getMetricsPort() const;
+    
+    /**
+     * @brief 设置指标服务端口
+     * @param port 端口
+     */
+    void setMetricsPort(int port);
+    
+    /**
+     * @brief 是否监视媒体库文件夹并自动识别新增或修改的文件
+     * @return 是否启用
+     */
+    bool isWatchFoldersEnabled() const;
+    
+    /**
+     * @brief 设置是否监视媒体库文件夹（仅Linux，识别在后台优先级进行）
+     * @param enabled 是否启用
+     */
+    void setWatchFoldersEnabled(bool enabled);
+    
     /**
      * @brief 重置所有设置为默认值
      */
@@ -143,6 +239,14 @@ private:
     bool m_preferOnlineAPI;        // 是否优先使用在线API
     QString m_apiUrl;              // 在线API地址
     QString m_subtitleSaveDirectory; // 字幕保存目录
+    int m_audioMemoryBudgetMB;     // 解码音频内存预算（MB）
+    QString m_scratchDirectory;    // 音频暂存目录
+    int m_recognitionThreads;      // 识别线程数，0表示自动
+    QString m_decodingProfile;     // 解码策略
+    bool m_wordTimestamps;         // 是否生成词级时间戳
+    bool m_metricsEnabled;         // 是否启用指标服务
+    int m_metricsPort;             // 指标服务端口
+    bool m_watchFolders;           // 是否监视媒体库文件夹
     
     /**
      * @brief 设置默认值
@@ -10,7 +10,16 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QThread>
+#include <QElapsedTimer>
+#include <atomic>
+#include <functional>
 #include "whisper.h"
+#include "transcript.h"
+#include "pcmbuffer.h"
+#include "resourcemonitor.h"
+#include "audiotracks.h"
+
+class SegmentStore;
 
 /**
  * @brief 语音识别器类
@@ -70,6 +79,73 @@ public:
      */
     bool recognizeFromVideo(const QString &videoFilePath, const QString &audioOutputPath = QString());
     
+    /**
+     * @brief 只识别媒体文件中的指定时间区间
+     * 
+     * ffmpeg在容器中直接定位到区间起点，只解码区间内的音频，
+     * 识别出的片段时间为媒体中的绝对时间，通过segmentsRecognized信号返回
+     * @param mediaFilePath 媒体文件路径
+     * @param startMs 区间起点（毫秒）
+     * @param endMs 区间终点（毫秒）
+     * @return 是否成功开始识别
+     */
+    bool recognizeRange(const QString &mediaFilePath, qint64 startMs, qint64 endMs);
+    
+    /**
+     * @brief 强制对齐：文本已知（剧本、无时间戳的识别结果）时只求片段和词的时间
+     * 
+     * 按文本的token强制解码，每一步只在下一个文本token、时间戳和结束token之间选择，
+     * 没有采样、温度回退和束搜索，解码步数不超过文本token数加上片段边界数。
+     * 结果与识别一样通过segmentsRecognized和recognitionFinished返回，片段文本取自给定文本。
+     * 只支持本地Whisper模型。
+     * @param mediaFilePath 媒体文件路径
+     * @param text 要对齐的文本
+     * @return 是否成功开始对齐
+     */
+    bool alignText(const QString &mediaFilePath, const QString &text);
+    
+    /**
+     * @brief 跟随识别正在写入的文件（例如录制中的直播）
+     * 
+     * ffmpeg以follow模式读取文件，读到末尾后继续等待追加的数据；每积累几秒新音频就识别一次，
+     * 带着之前的文本作为上下文，新片段通过segmentsDecoded实时发出，落后写入方几秒。
+     * 文件一段时间没有新数据或调用finishFollowing后，识别剩余音频并通过segmentsRecognized和
+     * recognitionFinished返回全部片段。只支持本地Whisper模型，容器要能边写边读（MKV、FLV、TS、WAV，
+     * 不支持未完成的MP4）。
+     * @param mediaFilePath 媒体文件路径
+     * @return 是否成功开始识别
+     */
+    bool followFile(const QString &mediaFilePath);
+    
+    /**
+     * @brief 识别网络流（HLS、RTSP、RTMP等），方式与followFile相同
+     * 
+     * 读取线程不等识别，识别跟不上时丢弃最旧的音频，落后时间有上限；连接断开时自动重连，
+     * 断开期间的时间计入片段时间。流结束、重连多次失败或调用finishFollowing后返回全部片段。
+     * 片段时间从开始接收算起。
+     * @param url 流地址
+     * @return 是否成功开始识别
+     */
+    bool recognizeStream(const QString &url);
+    
+    /**
+     * @brief 识别媒体文件中的多条音轨（如原声、同传、解说）
+     * 
+     * ffmpeg只读取一遍容器，各音轨由各自的解码器解码后拆分到各自的队列，边解码边识别；每条音轨在独立的
+     * whisper状态上并行识别，共享已加载的模型，识别线程数在音轨之间平分。每条音轨的结果通过
+     * trackSegmentsRecognized返回，第一条音轨同时通过segmentsDecoded、segmentsRecognized和
+     * recognitionFinished返回，与识别整个文件相同。只支持本地Whisper模型。
+     * @param mediaFilePath 媒体文件路径
+     * @param tracks 要识别的音轨（来自probeAudioTracks）
+     * @return 是否成功开始识别
+     */
+    bool recognizeTracks(const QString &mediaFilePath, const QVector<AudioTrack> &tracks);
+    
+    /**
+     * @brief 结束跟随识别：停止读取，已收到的音频识别完后照常返回结果
+     */
+    void finishFollowing();
+    
     /**
      * @brief 停止当前的识别任务
      */
@@ -88,10 +164,38 @@ public:
     bool isFfmpegAvailable();
     
     /**
-     * @brief 设置是否优先使用在线API
+     * @brief 设置是否优先使用在线API，之后不再跟随用户设置
      * @param prefer 为true时优先使用在线API，否则优先使用本地模型
      */
     void setPreferOnlineAPI(bool prefer);
+    
+    /**
+     * @brief 设置识别使用的线程数
+     * @param threads 线程数，0表示自动（最多8个）
+     */
+    void setThreadCount(int threads);
+    
+    /**
+     * @brief 设置解码策略
+     * @param profile "greedy"为贪心解码，"beam"为束搜索
+     */
+    void setDecodingProfile(const QString &profile);
+    
+    /**
+     * @brief 设置是否生成词级时间戳
+     * @param enabled 启用后每个片段带有各词的时间
+     */
+    void setWordTimestamps(bool enabled);
+    
+    /**
+     * @brief 已加载模型的文件大小（不是模型实际占用的内存），未加载时为0
+     */
+    qint64 modelFileBytes() const;
+    
+    /**
+     * @brief 当前音频样本占用的内存字节数（不含暂存文件和内存映射）
+     */
+    qint64 audioResidentBytes() const;
 
 signals:
     /**
@@ -100,6 +204,37 @@ signals:
      */
     void recognitionFinished(const QString &text);
     
+    /**
+     * @brief 带时间戳的识别片段信号，在recognitionFinished之前发出
+     * @param mediaFilePath 识别的媒体文件
+     * @param segments 识别出的片段（绝对时间）
+     * @param rangeStartMs 本次识别的区间起点，整个文件识别时为-1
+     * @param rangeEndMs 本次识别的区间终点，整个文件识别时为-1
+     */
+    void segmentsRecognized(const QString &mediaFilePath, const QVector<TranscriptSegment> &segments,
+                            qint64 rangeStartMs, qint64 rangeEndMs);
+    
+    /**
+     * @brief 多音轨识别时每条音轨的结果，在segmentsRecognized之前发出
+     * @param mediaFilePath 识别的媒体文件
+     * @param track 音轨
+     * @param segments 该音轨识别出的片段
+     */
+    void trackSegmentsRecognized(const QString &mediaFilePath, const AudioTrack &track,
+                                 const QVector<TranscriptSegment> &segments);
+    
+    /**
+     * @brief 识别过程中每解码出新片段时发出，时间为绝对时间
+     * @param segments 新解码的片段
+     */
+    void segmentsDecoded(const QVector<TranscriptSegment> &segments);
+    
+    /**
+     * @brief 本地模型识别完成时发出本次任务的资源消耗，在segmentsRecognized之前发出
+     * @param stats 资源统计
+     */
+    void jobStatsReady(const RecognitionJobStats &stats);
+    
     /**
      * @brief 识别出错信号
      * @param errorMessage 错误信息
@@ -164,17 +299,88 @@ private:
     /**
      * @brief 加载音频文件到内存
      * @param audioFilePath 音频文件路径
-     * @param samples 输出的音频样本
+     * @param samples 输出的16位单声道音频样本
      * @param sampleRate 输出的采样率
+     * @param startMs 开始解码的位置（毫秒），ffmpeg在容器中定位到此处
+     * @param durationMs 解码时长（毫秒），负数表示一直解码到文件末尾
      * @return 是否加载成功
      */
-    bool loadAudioFile(const QString &audioFilePath, std::vector<float> &samples, int &sampleRate);
+    bool loadAudioFile(const QString &audioFilePath, PcmBuffer &samples, int &sampleRate,
+                       qint64 startMs = 0, qint64 durationMs = -1);
     
     /**
      * @brief 异步执行语音识别的方法
      */
     void recognizeAudioAsync();
     
+    /**
+     * @brief 在识别线程中把m_alignmentWords强制对齐到已加载的音频
+     */
+    void alignAudioAsync();
+    
+    /**
+     * @brief followFile和recognizeStream的公共部分
+     */
+    bool startFollowing(const QString &source);
+    
+    /**
+     * @brief 在识别线程中跟随m_currentAudioFile（文件或网络流），边读取新的音频边识别
+     */
+    void followAudioAsync();
+    
+    /**
+     * @brief 为每条音轨启动一个识别线程，再在识别线程中一次解码tracks，解码出的样本随即交给各音轨的识别线程
+     */
+    void recognizeTracksAsync(const QVector<AudioTrack> &tracks);
+    
+    /**
+     * @brief 按当前设置生成whisper参数
+     * @param language 语言代码的UTF-8字节，whisper_full执行期间必须保持有效
+     */
+    whisper_full_params recognitionParams(const QByteArray &language);
+    
+    /**
+     * @brief 把whisper最近一次识别的片段追加到store中
+     * @param state 识别使用的状态，为空时读取上下文自带的状态
+     * @param offsetMs 窗口起点的绝对时间
+     * @return 生成的文本token数
+     */
+    int collectWindowSegments(whisper_state *state, qint64 offsetMs, SegmentStore &store);
+    
+    /**
+     * @brief 已有任务在进行时拒绝新的请求，发出的错误不计入失败的任务
+     */
+    void rejectWhileBusy();
+    
+    /**
+     * @brief 开始统计一个任务的资源消耗，此后发出的recognitionError计为任务失败
+     */
+    void beginJobStats(const QString &mediaFilePath);
+    
+    /**
+     * @brief 标记为识别中并在新线程中执行work
+     * @param threadName 线程名，whisper的工作线程继承此名称
+     */
+    void startRecognitionThread(const QString &threadName, const std::function<void()> &work);
+    
+    /**
+     * @brief 补全本次任务的资源统计并记录到识别指标中，在识别线程结束前调用
+     * @param inferenceMs 推理耗时（毫秒）
+     * @param tokens 生成或强制解码的文本token数
+     * @param segments 片段数
+     */
+    RecognitionJobStats finishJobStats(qint64 inferenceMs, int tokens, int segments);
+    
+    /**
+     * @brief whisper每解码出新片段时的回调，在识别线程中执行
+     */
+    static void handleNewSegments(whisper_context *ctx, whisper_state *state, int newSegments, void *userData);
+    
+    /**
+     * @brief whisper的中止回调，返回true时whisper_full尽快返回；userData为识别器
+     */
+    static bool shouldAbort(void *userData);
+    
     // 成员变量
     QProcess *m_whisperProcess;              ///< 旧的Whisper进程（用于兼容）
     QNetworkAccessManager *m_networkManager; ///< 网络访问管理器
@@ -183,16 +389,36 @@ private:
     QString m_modelSize;                     ///< 模型大小
     QString m_apiUrl;                        ///< 在线API地址
     bool m_preferOnlineAPI;                  ///< 是否优先使用在线API
+    bool m_preferOnlineAPIFixed;             ///< 由setPreferOnlineAPI指定，applySettings不再覆盖
     QString m_currentAudioFile;              ///< 当前处理的音频文件
     QString m_tempAudioFile;                 ///< 临时音频文件（如果使用）
+    int m_audioMemoryBudgetMB;               ///< 解码音频内存预算（MB），0表示不限制
+    QString m_scratchDirectory;              ///< 超出预算时的音频暂存目录
+    int m_threadCount;                       ///< 识别线程数，0表示自动
+    QString m_decodingProfile;               ///< 解码策略
+    bool m_wordTimestamps;                   ///< 是否生成词级时间戳
+    QStringList m_alignmentWords;            ///< 强制对齐的文本，为空时进行普通识别
     
     // whisper.cpp相关成员
     whisper_context *m_whisperCtx;           ///< Whisper上下文
     QThread *m_recognitionThread;            ///< 识别线程
     bool m_isRecognizing;                    ///< 是否正在识别
-    std::vector<float> m_audioSamples;       ///< 音频样本数据
+    PcmBuffer m_audioSamples;                ///< 16位音频样本数据，识别时按窗口转换为浮点数
     int m_audioSampleRate;                   ///< 音频采样率
-    bool m_shouldStop;                       ///< 是否应该停止识别
+    std::atomic<bool> m_shouldStop;          ///< 是否应该停止识别（界面线程设置，识别线程轮询）
+    std::atomic<bool> m_finishFollowing;     ///< 跟随识别时是否应该停止读取并返回结果（界面线程设置）
+    std::atomic<qint64> m_rangeStartMs;      ///< 当前识别区间起点，-1表示整个文件（识别线程和新片段回调读取）
+    std::atomic<qint64> m_rangeEndMs;        ///< 当前识别区间终点，-1表示整个文件
+    std::atomic<qint64> m_windowOffsetMs;    ///< 当前窗口起点的绝对时间，供新片段回调换算时间（识别线程写入）
+    qint64 m_loadedSourceBytes;              ///< 最近一次加载音频读取的源数据字节数
+    std::atomic<qint64> m_trackResidentBytes; ///< 多音轨识别时各音轨样本占用的内存字节数
+    
+    // 当前任务的资源统计
+    RecognitionJobStats m_jobStats;          ///< 识别线程结束时补全并发出
+    QElapsedTimer m_jobTimer;                ///< 任务开始计时
+    double m_jobCpuStart;                    ///< 任务开始时的进程CPU时间
+    RssPeakSampler m_jobRssSampler;          ///< 任务期间采样RSS峰值
+    std::atomic<bool> m_jobActive;           ///< 任务已经开始且还没有完成、失败或停止
 };
 
 #endif // SPEECHRECOGNIZER_H
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef SUBTITLEIMPORT_H
+#define SUBTITLEIMPORT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "transcript.h"
+
+/**
+ * @brief 媒体文件中的一条字幕流
+ */
+struct EmbeddedSubtitleStream
+{
+    int index = -1;      ///< ffmpeg中的流序号
+    QString codec;       ///< 编码，如subrip、ass、mov_text、hdmv_pgs_subtitle
+    QString language;    ///< 语言标签，如eng，没有时为空
+    QString title;       ///< 标题，没有时为空
+    bool isText = false; ///< 是否为文本字幕（图形字幕无法导入）
+};
+
+/**
+ * @brief 查找与媒体文件同名的字幕文件，例如lecture.srt、lecture.en.vtt
+ * @param mediaFilePath 媒体文件
+ * @return 字幕文件路径，完全同名的排在前面
+ */
+QStringList findSidecarSubtitles(const QString &mediaFilePath);
+
+/**
+ * @brief 用ffprobe列出字幕流并读取媒体时长
+ * @param mediaFilePath 媒体文件
+ * @param streams 字幕流
+ * @param durationMs 媒体时长（毫秒），未知时为-1
+ * @param error 失败时的原因
+ * @return ffprobe是否成功
+ */
+bool probeSubtitleStreams(const QString &mediaFilePath, QVector<EmbeddedSubtitleStream> &streams, qint64 &durationMs,
+                          QString *error = nullptr);
+
+/**
+ * @brief 用ffmpeg把一条文本字幕流转换为SRT，边读取管道边解析
+ * @param mediaFilePath 媒体文件
+ * @param streamIndex 流序号
+ * @param segments 解析出的片段
+ * @param error 失败时的原因
+ * @return 是否成功
+ */
+bool extractEmbeddedSubtitles(const QString &mediaFilePath, int streamIndex, QVector<TranscriptSegment> &segments,
+                              QString *error = nullptr);
+
+/**
+ * @brief 导入的已有字幕
+ */
+struct ImportedSubtitles
+{
+    QString source;                       ///< 来源说明（文件名或字幕流）
+    QVector<TranscriptSegment> segments;  ///< 字幕片段
+    qint64 durationMs = -1;               ///< 媒体时长（毫秒），未知时为-1
+};
+
+/**
+ * @brief 查找并导入媒体文件已有的字幕：优先同名字幕文件，其次内嵌文本字幕流
+ *
+ * 有多个候选时优先选择语言与preferredLanguage相同的。会启动ffprobe/ffmpeg子进程，
+ * 应在工作线程中调用。
+ * @param mediaFilePath 媒体文件
+ * @param preferredLanguage 首选语言（如en，auto表示不限）
+ * @param result 导入结果
+ * @return 是否找到并导入了字幕
+ */
+bool importExistingSubtitles(const QString &mediaFilePath, const QString &preferredLanguage, ImportedSubtitles &result);
+
+#endif // SUBTITLEIMPORT_H
@@ -0,0 +1,101 @@
+#ifndef TRANSCRIPT_H
+#define TRANSCRIPT_H
+
+#include <QString>
+#include <QVector>
+#include <QMetaType>
+
+/**
+ * @brief 片段内各词的时间，按结构数组存放
+ *
+ * 时间是相对片段开始时间的毫秒数，偏移是词在片段文本（去掉首尾空白后）中的字符位置，
+ * 三个数组按词的顺序一一对应。没有启用词级时间戳时都为空，不占用额外内存。
+ */
+struct TranscriptWords
+{
+    QVector<qint32> startMs;      ///< 词开始时间（相对片段开始，毫秒）
+    QVector<qint32> endMs;        ///< 词结束时间（相对片段开始，毫秒）
+    QVector<qint32> textOffset;   ///< 词在片段文本中的起始字符位置
+
+    int size() const { return startMs.size(); }
+    bool isEmpty() const { return startMs.isEmpty(); }
+
+    /**
+     * @brief 查找相对时间所在的词：开始时间不晚于该时间的最后一个词
+     * @param relativeMs 相对片段开始的时间（毫秒）
+     * @return 词序号，早于第一个词时返回-1
+     */
+    int wordAt(qint32 relativeMs) const;
+
+    bool operator==(const TranscriptWords &other) const
+    {
+        return startMs == other.startMs && endMs == other.endMs && textOffset == other.textOffset;
+    }
+};
+
+/**
+ * @brief 带时间戳的识别片段
+ *
+ * 时间均为媒体文件中的绝对时间（毫秒），区间识别的结果也已换算到绝对时间
+ */
+struct TranscriptSegment
+{
+    qint64 startMs = 0;   ///< 片段开始时间（毫秒）
+    qint64 endMs = 0;     ///< 片段结束时间（毫秒）
+    QString text;         ///< 片段文本
+    TranscriptWords words; ///< 词级时间戳，未启用时为空
+};
+
+Q_DECLARE_METATYPE(TranscriptSegment)
+Q_DECLARE_METATYPE(QVector<TranscriptSegment>)
+
+/**
+ * @brief 将新识别的片段合并到已有字幕中
+ *
+ * 已有字幕中与[rangeStartMs, rangeEndMs)重叠的部分会被新片段替换，其余片段保留；
+ * 跨过区间边界的片段只截掉区间内的部分：有词级时间戳时按词截取，没有时按时间比例估计截断位置。
+ * 结果按开始时间排序。rangeStartMs为负数时表示整个文件，直接以新片段替换全部内容。
+ * @param existing 已有片段
+ * @param incoming 新识别的片段
+ * @param rangeStartMs 新片段覆盖的区间起点（毫秒）
+ * @param rangeEndMs 新片段覆盖的区间终点（毫秒）
+ * @return 合并后的片段
+ */
+QVector<TranscriptSegment> mergeTranscriptSegments(const QVector<TranscriptSegment> &existing,
+                                                   const QVector<TranscriptSegment> &incoming,
+                                                   qint64 rangeStartMs, qint64 rangeEndMs);
+
+/**
+ * @brief 字幕中没有片段覆盖的时间段
+ */
+struct TranscriptGap
+{
+    qint64 startMs;
+    qint64 endMs;
+};
+
+/**
+ * @brief 找出字幕中长于minimumGapMs的空白，包括第一个片段之前和最后一个片段到结尾之间
+ * @param segments 按开始时间排序的片段
+ * @param durationMs 媒体时长（毫秒），未知时传负数，此时不计结尾的空白
+ * @param minimumGapMs 最短空白（毫秒），台词之间的短暂停顿不算空白
+ * @return 按时间排序的空白
+ */
+QVector<TranscriptGap> findTranscriptGaps(const QVector<TranscriptSegment> &segments, qint64 durationMs,
+                                          qint64 minimumGapMs);
+
+/**
+ * @brief 格式化时间戳为 HH:MM:SS.mmm
+ * @param milliseconds 毫秒数
+ * @return 格式化后的字符串
+ */
+QString formatTranscriptTimestamp(qint64 milliseconds);
+
+/**
+ * @brief 将片段列表格式化为每行一个片段的文本
+ * @param segments 片段列表
+ * @return 形如"[00:40:00.000 --> 00:40:04.500] text"的多行文本
+ */
+QString formatTranscript(const QVector<TranscriptSegment> &segments);
+
+#endif // TRANSCRIPT_H
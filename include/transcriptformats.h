@@ -0,0 +1,111 @@
+#ifndef TRANSCRIPTFORMATS_H
+#define TRANSCRIPTFORMATS_H
+
+#include <QString>
+#include <QVector>
+#include "transcript.h"
+
+/**
+ * @brief 字幕文件格式
+ */
+enum class TranscriptFormat
+{
+    Unknown,
+    Binary,   ///< 内存映射的二进制格式（.qet），见MappedTranscript
+    Srt,
+    Vtt,
+    Json      ///< 本程序的JSON格式，读取时也接受whisper.cpp -oj的输出
+};
+
+/**
+ * @brief 按扩展名判断格式
+ */
+TranscriptFormat transcriptFormatForPath(const QString &filePath);
+
+/**
+ * @brief 格式化为SRT
+ */
+QString toSrt(const QVector<TranscriptSegment> &segments);
+
+/**
+ * @brief 格式化为WebVTT
+ */
+QString toVtt(const QVector<TranscriptSegment> &segments);
+
+/**
+ * @brief 格式化为JSON，带词级时间戳（绝对时间）
+ */
+QByteArray toTranscriptJson(const QVector<TranscriptSegment> &segments);
+
+/**
+ * @brief SRT和WebVTT的流式解析器
+ *
+ * 直接在UTF-8字节上逐行解析，可以分块输入（例如ffmpeg管道的输出），也可以一次输入整个映射的文件。
+ * 只有跨块的不完整行会被暂存；时间戳直接从字节中解析，每个条目的文本只在结束时转换一次QString。
+ * 样式标签（<i>、<v 说话人>、{\an8}等）、WebVTT文件头和NOTE/STYLE/REGION块被忽略。
+ */
+class SubtitleCueParser
+{
+public:
+    SubtitleCueParser();
+
+    /**
+     * @brief 输入一段数据
+     */
+    void feed(const char *data, qint64 size);
+
+    /**
+     * @brief 输入结束，处理最后一个条目并按开始时间排序
+     */
+    void finish();
+
+    const QVector<TranscriptSegment> &segments() const { return m_segments; }
+
+private:
+    enum class State
+    {
+        Idle,      ///< 条目之间
+        Cue,       ///< 时间行之后，读取文本
+        Skip       ///< 注释或样式块，跳到下一个空行
+    };
+
+    void processLine(const char *line, int length);
+    void finishCue();
+
+    State m_state;
+    bool m_firstLine;
+    QByteArray m_pending;   ///< 上一块末尾不完整的行
+    QByteArray m_cueText;   ///< 当前条目的文本（UTF-8）
+    TranscriptSegment m_cue;
+    QVector<TranscriptSegment> m_segments;
+};
+
+/**
+ * @brief 解析SRT或WebVTT（两者的时间行格式只在毫秒分隔符上不同），忽略样式标签和注释块
+ * @param content 文件内容
+ * @param segments 解析出的片段，按开始时间排序
+ * @param error 失败时的原因
+ * @return 是否至少解析出一个片段
+ */
+bool parseSubtitleCues(const QString &content, QVector<TranscriptSegment> &segments, QString *error = nullptr);
+
+/**
+ * @brief 解析toTranscriptJson的输出或whisper.cpp的JSON输出
+ */
+bool parseTranscriptJson(const QByteArray &content, QVector<TranscriptSegment> &segments, QString *error = nullptr);
+
+/**
+ * @brief 按扩展名读取字幕文件
+ * @param filePath 文件路径
+ * @param segments 读取的片段
+ * @param error 失败时的原因
+ * @return 是否成功
+ */
+bool readTranscriptFile(const QString &filePath, QVector<TranscriptSegment> &segments, QString *error = nullptr);
+
+/**
+ * @brief 按扩展名写入字幕文件
+ */
+bool writeTranscriptFile(const QString &filePath, const QVector<TranscriptSegment> &segments, QString *error = nullptr);
+
+#endif // TRANSCRIPTFORMATS_H
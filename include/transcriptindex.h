@@ -0,0 +1,111 @@
+#ifndef TRANSCRIPTINDEX_H
+#define TRANSCRIPTINDEX_H
+
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "transcript.h"
+
+class TranscriptIndexRun;
+
+/**
+ * @brief 一条搜索结果
+ */
+struct TranscriptSearchHit
+{
+    QString mediaFilePath;    ///< 媒体文件
+    QString transcriptPath;   ///< 字幕缓存文件（.qet）
+    qint64 startMs = 0;       ///< 片段开始时间（毫秒）
+    qint64 endMs = -1;        ///< 片段结束时间（毫秒），字幕缓存不可读时为-1
+    QString text;             ///< 片段文本，字幕缓存不可读时为空
+};
+
+/**
+ * @brief 媒体库字幕的全文索引（倒排索引），保存在磁盘上
+ *
+ * 词项到（文档, 片段开始时间）的倒排表。每次addDocument把一个字幕写成一个不可变的索引段文件，
+ * 较新的小索引段按对数策略与前一个合并，索引段数量保持在O(log n)；合并时丢弃已删除或被重新索引的文档。
+ * 索引段文件用内存映射访问：查询时在每个索引段的有序词典中二分查找，倒排表按文档和时间排序，
+ * 多个词在片段级求交集，只有被访问的页会读入内存。片段文本不存入索引，命中后从字幕缓存（.qet）中读取。
+ *
+ * 查询和写入可以在不同线程中进行：写入（包括合并）在写锁下串行执行，新索引段写好后才替换到查询使用的列表中。
+ */
+class TranscriptIndex
+{
+public:
+    TranscriptIndex();
+    ~TranscriptIndex();
+
+    /**
+     * @brief 打开索引目录，不存在时创建
+     * @param directory 索引目录
+     * @param error 失败时的原因
+     * @return 是否成功
+     */
+    bool open(const QString &directory, QString *error = nullptr);
+
+    QString directory() const;
+
+    /**
+     * @brief 索引一个媒体文件的字幕，已索引过的同一媒体文件被替换
+     * @param mediaFilePath 媒体文件
+     * @param transcriptPath 字幕缓存文件，命中时从中读取片段文本
+     * @param segments 字幕片段
+     * @param error 失败时的原因
+     * @return 是否成功
+     */
+    bool addDocument(const QString &mediaFilePath, const QString &transcriptPath,
+                     const QVector<TranscriptSegment> &segments, QString *error = nullptr);
+
+    /**
+     * @brief 从索引中删除一个媒体文件，倒排表中的条目在下次合并时清除
+     */
+    bool removeDocument(const QString &mediaFilePath, QString *error = nullptr);
+
+    /**
+     * @brief 搜索包含全部查询词的片段
+     *
+     * 查询不以空白结尾时最后一个词按前缀匹配，便于边输入边搜索。
+     * 结果按文档从新到旧、文档内按时间排序。
+     * @param query 查询
+     * @param maxHits 最多返回的结果数
+     * @return 搜索结果
+     */
+    QVector<TranscriptSearchHit> search(const QString &query, int maxHits = 200) const;
+
+    int documentCount() const;
+    int runCount() const;
+
+    /**
+     * @brief 把文本拆分为索引词：按字母和数字切分并统一大小写，中日韩文字每个字单独成词
+     */
+    static QStringList tokenize(const QString &text);
+
+private:
+    Q_DISABLE_COPY(TranscriptIndex)
+
+    struct Document
+    {
+        QString mediaFilePath;
+        QString transcriptPath;
+    };
+
+    bool saveManifest(const QVector<QSharedPointer<TranscriptIndexRun>> &runs,
+                      const QHash<quint32, Document> &documents, QString *error);
+    bool mergeTail(QString *error);
+    QString nextRunPath();
+
+    QString m_directory;
+    mutable QMutex m_stateMutex;                        ///< 保护下面三个成员，查询时持有
+    QVector<QSharedPointer<TranscriptIndexRun>> m_runs; ///< 索引段，按文档编号从小到大
+    QHash<quint32, Document> m_documents;               ///< 当前有效的文档
+    QHash<QString, quint32> m_documentByMedia;          ///< 媒体文件到文档编号
+    QMutex m_writeMutex;                                ///< 串行化写入和合并
+    quint32 m_nextDocument;
+    quint32 m_nextRun;
+};
+
+#endif // TRANSCRIPTINDEX_H
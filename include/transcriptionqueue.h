@@ -0,0 +1,77 @@
+#ifndef TRANSCRIPTIONQUEUE_H
+#define TRANSCRIPTIONQUEUE_H
+
+#include <QObject>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include "transcript.h"
+#include "resourcemonitor.h"
+
+class SpeechRecognizer;
+
+/**
+ * @brief 后台识别队列：按顺序识别自动发现的媒体文件，不影响界面中正在处理的文件
+ *
+ * 队列使用独立的识别器，识别器在以QThread::IdlePriority启动的工作线程中运行（Linux下为SCHED_IDLE），
+ * 它创建的识别线程、whisper工作线程和ffmpeg子进程都继承这一调度策略，CPU只在空闲时才分给后台任务。
+ * 模型在第一个任务开始时加载，队列空闲一段时间后释放。等待中的任务数记录在jobsQueued指标中。
+ */
+class TranscriptionQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TranscriptionQueue(QObject *parent = nullptr);
+    ~TranscriptionQueue();
+
+    /**
+     * @brief 加入队列；已在队列中的文件不重复加入，正在识别的文件在当前任务结束后重新识别
+     * @return 是否加入了队列
+     */
+    bool enqueue(const QString &mediaFilePath);
+
+    /**
+     * @brief 从队列中删除一个等待中的文件
+     */
+    void remove(const QString &mediaFilePath);
+
+    int pendingCount() const;
+
+    /**
+     * @brief 正在识别的文件，空闲时为空
+     */
+    QString currentFile() const;
+
+    /**
+     * @brief 设置已更改：当前任务结束后用新设置重新创建识别器（例如模型路径变化）
+     */
+    void reloadSettings();
+
+signals:
+    void jobStarted(const QString &mediaFilePath);
+    void jobFinished(const QString &mediaFilePath, const QVector<TranscriptSegment> &segments);
+    void jobFailed(const QString &mediaFilePath, const QString &errorMessage);
+    void jobStatsReady(const RecognitionJobStats &stats);
+
+private:
+    void startNext();
+    void finishJob();
+    void releaseRecognizer();
+    void updateQueuedMetric();
+    void onSegmentsRecognized(const QString &mediaFilePath, const QVector<TranscriptSegment> &segments);
+    void onRecognitionFinished();
+    void onRecognitionError(const QString &errorMessage);
+
+    QThread m_workerThread;
+    SpeechRecognizer *m_recognizer;          ///< 在工作线程中运行，只通过invokeMethod调用
+    QStringList m_pending;
+    QString m_current;
+    QVector<TranscriptSegment> m_currentSegments;
+    bool m_rerunCurrent;                     ///< 识别期间文件又被修改
+    bool m_recognizerStale;                  ///< 设置已更改，下一个任务前重新创建识别器
+    QTimer m_idleTimer;                      ///< 空闲一段时间后释放模型
+};
+
+#endif // TRANSCRIPTIONQUEUE_H
@@ -0,0 +1,121 @@
+#ifndef TRANSCRIPTMODEL_H
+#define TRANSCRIPTMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include "transcript.h"
+
+/**
+ * @brief 字幕片段列表模型，每行一个片段
+ *
+ * 只保存片段本身，显示文本在视图请求可见行时才生成，不会把整份字幕拼成一个字符串。
+ * 更新时只对变化的行发出插入/删除通知：流式追加、区间替换以及识别结束后用最终结果
+ * 覆盖流式结果（通常完全相同）都不会触发整个列表的重置和重新布局。
+ * 配合setUniformItemSizes(true)的QListView使用，几十万行也只布局可见的几十行。
+ *
+ * 另外维护两个前缀数组：各行的开始时间和各行文本在全文（每行之间一个换行符）中的起始偏移，
+ * 时间与行、全文偏移与行之间的换算都是二分查找，行到时间和偏移是O(1)。
+ */
+class TranscriptModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        StartMsRole = Qt::UserRole + 1, ///< 片段开始时间（毫秒），没有时间戳的行为-1
+        EndMsRole,                      ///< 片段结束时间（毫秒），没有时间戳的行为-1
+        TextRole                        ///< 片段文本
+    };
+
+    explicit TranscriptModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    /**
+     * @brief 用新的片段列表替换全部内容，只通知与原内容不同的部分
+     * @param segments 按开始时间排序的片段
+     */
+    void setSegments(const QVector<TranscriptSegment> &segments);
+
+    /**
+     * @brief 插入识别过程中流式解码出的片段，按开始时间放到对应位置
+     * @param segments 按开始时间排序的新片段
+     */
+    void insertSegments(const QVector<TranscriptSegment> &segments);
+
+    /**
+     * @brief 用区间识别的结果替换区间内的片段，规则与mergeTranscriptSegments相同
+     * @param segments 新识别的片段
+     * @param rangeStartMs 区间起点（毫秒），负数表示整个文件
+     * @param rangeEndMs 区间终点（毫秒）
+     */
+    void replaceRange(const QVector<TranscriptSegment> &segments, qint64 rangeStartMs, qint64 rangeEndMs);
+
+    /**
+     * @brief 显示没有时间戳的纯文本（在线API的结果），每行文本一行
+     * @param text 文本
+     */
+    void setUntimedText(const QString &text);
+
+    void clear();
+
+    const QVector<TranscriptSegment> &segments() const { return m_segments; }
+
+    /**
+     * @brief 查找time所在的行：开始时间不晚于time的最后一行
+     * @param timeMs 媒体时间（毫秒）
+     * @return 行号，time早于第一行或没有带时间戳的行时返回-1
+     */
+    int rowAtTime(qint64 timeMs) const;
+
+    /**
+     * @brief 行内字符对应的媒体时间
+     *
+     * 有词级时间戳时取字符所在词的开始时间，否则按字符位置在片段时长内线性插值
+     * @param row 行号
+     * @param characterIndex 字符在片段文本中的位置
+     * @return 媒体时间（毫秒），没有时间戳时返回-1
+     */
+    qint64 timeAtCharacter(int row, int characterIndex) const;
+
+    /**
+     * @brief 行文本在全文中的起始偏移
+     */
+    qint64 textOffsetOfRow(int row) const { return m_textOffsets.value(row, -1); }
+
+    /**
+     * @brief 全文偏移所在的行
+     * @return 行号，越界时返回-1
+     */
+    int rowAtTextOffset(qint64 offset) const;
+
+    /**
+     * @brief 全文偏移对应的媒体时间
+     */
+    qint64 timeAtTextOffset(qint64 offset) const;
+
+    /**
+     * @brief 媒体时间对应的全文偏移（所在行内按时长插值）
+     * @return 偏移，没有对应行时返回-1
+     */
+    qint64 textOffsetAtTime(qint64 timeMs) const;
+
+    /**
+     * @brief 片段占用的内存字节数（近似）
+     */
+    qint64 memoryBytes() const;
+
+private:
+    /**
+     * @brief 从firstRow开始重建前缀数组
+     */
+    void rebuildIndex(int firstRow);
+
+    QVector<TranscriptSegment> m_segments;
+    QVector<qint64> m_startTimes;   ///< 各行开始时间，与m_segments一一对应，二分查找时连续访问
+    QVector<qint64> m_textOffsets;  ///< 各行在全文中的起始偏移，多一项为全文长度
+};
+
+#endif // TRANSCRIPTMODEL_H
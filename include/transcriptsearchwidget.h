@@ -0,0 +1,45 @@
+#ifndef TRANSCRIPTSEARCHWIDGET_H
+#define TRANSCRIPTSEARCHWIDGET_H
+
+#include <QWidget>
+#include <QTimer>
+
+class QLabel;
+class QLineEdit;
+class QTreeWidget;
+class QTreeWidgetItem;
+class TranscriptIndex;
+
+/**
+ * @brief 媒体库字幕搜索：输入查询，列出命中的片段，双击跳转到播放位置
+ *
+ * 输入停顿后在界面线程中直接查询索引（索引查询只做二分查找和倒排表求交，不需要工作线程）。
+ */
+class TranscriptSearchWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TranscriptSearchWidget(TranscriptIndex *index, QWidget *parent = nullptr);
+
+signals:
+    /**
+     * @brief 用户选择了一条结果
+     * @param mediaFilePath 媒体文件
+     * @param startMs 片段开始时间（毫秒）
+     */
+    void hitActivated(const QString &mediaFilePath, qint64 startMs);
+
+private slots:
+    void runSearch();
+    void onItemActivated(QTreeWidgetItem *item, int column);
+
+private:
+    TranscriptIndex *m_index;
+    QLineEdit *m_queryEdit;
+    QTreeWidget *m_resultTree;
+    QLabel *m_statusLabel;
+    QTimer m_debounceTimer;
+};
+
+#endif // TRANSCRIPTSEARCHWIDGET_H
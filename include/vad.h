@@ -0,0 +1,16 @@
+#ifndef VAD_H
+#define VAD_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief 计算每帧的均方能量
+ * @param samples 浮点样本
+ * @param count 样本数
+ * @param frameSamples 帧长，末尾不足一帧的样本忽略
+ * @param energies 输出的每帧能量
+ */
+void computeFrameEnergies(const float *samples, size_t count, size_t frameSamples, std::vector<float> &energies);
+
+#endif // VAD_H
@@ -0,0 +1,99 @@
+#ifndef WAVREADER_H
+#define WAVREADER_H
+
+#include <QFile>
+#include <QString>
+#include <cstdint>
+
+/**
+ * @brief WAV文件格式信息
+ */
+struct WavFormat
+{
+    int audioFormat = 0;      ///< 编码格式，1为PCM（WAVE_FORMAT_EXTENSIBLE已换算为子格式）
+    int channels = 0;         ///< 声道数
+    int sampleRate = 0;       ///< 采样率
+    int bitsPerSample = 0;    ///< 每个样本的位数
+    int blockAlign = 0;       ///< 每帧字节数
+    quint64 dataOffset = 0;   ///< data块数据在文件中的偏移
+    quint64 dataSize = 0;     ///< data块声明的字节数，流式输出时可能为0或0xFFFFFFFF
+};
+
+/**
+ * @brief WAV头解析结果
+ */
+enum WavParseResult
+{
+    WavParseOk,            ///< 已找到fmt和data块
+    WavParseNeedMoreData,  ///< 数据不足，需要更多字节才能判断
+    WavParseInvalid        ///< 不是有效的RIFF/WAVE数据
+};
+
+/**
+ * @brief 解析RIFF/WAVE头，跳过LIST等无关块直到data块
+ * @param data 文件或数据流开头的字节
+ * @param size 可用字节数
+ * @param format 输出的格式信息
+ * @param errorMessage 解析失败时的错误信息，可为空
+ * @return 解析结果
+ */
+WavParseResult parseWavHeader(const uchar *data, qint64 size, WavFormat &format, QString *errorMessage = nullptr);
+
+/**
+ * @brief 基于内存映射的WAV读取器
+ *
+ * 整个文件通过QFile::map映射到内存，样本按需由操作系统分页读入，不产生整文件拷贝。
+ */
+class WavReader
+{
+public:
+    WavReader();
+    ~WavReader();
+
+    /**
+     * @brief 打开并映射WAV文件，校验文件头
+     * @param filePath 文件路径
+     * @return 是否成功
+     */
+    bool open(const QString &filePath);
+
+    /**
+     * @brief 取消映射并关闭文件
+     */
+    void close();
+
+    bool isOpen() const { return m_map != nullptr; }
+    const WavFormat &format() const { return m_format; }
+    QString errorString() const { return m_errorString; }
+
+    /**
+     * @brief 是否为16位PCM
+     */
+    bool isPcm16() const;
+
+    /**
+     * @brief 是否可以直接用于识别（16kHz单声道16位PCM）
+     */
+    bool isRecognizerCompatible() const;
+
+    /**
+     * @brief 映射后的16位PCM数据（按声道交错），仅在isPcm16()时有效
+     */
+    const int16_t *pcm16Data() const;
+
+    /**
+     * @brief 文件中完整的音频帧数
+     */
+    qint64 frameCount() const;
+
+private:
+    Q_DISABLE_COPY(WavReader)
+
+    QFile m_file;
+    uchar *m_map;
+    qint64 m_mapSize;
+    WavFormat m_format;
+    QString m_errorString;
+};
+
+#endif // WAVREADER_H
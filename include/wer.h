@@ -0,0 +1,52 @@
+#ifndef WER_H
+#define WER_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief 词错误率的统计结果
+ *
+ * 多个文件的结果可以累加，累加后的wer()即整个语料的词错误率。
+ */
+struct WerResult
+{
+    int substitutions = 0;   ///< 替换的词数
+    int deletions = 0;       ///< 漏识别的词数
+    int insertions = 0;      ///< 多识别的词数
+    int referenceWords = 0;  ///< 参考文本的词数
+
+    int errors() const { return substitutions + deletions + insertions; }
+
+    /**
+     * @brief 词错误率，参考文本为空时若识别结果也为空返回0，否则返回1
+     */
+    double wer() const;
+
+    WerResult &operator+=(const WerResult &other);
+};
+
+/**
+ * @brief 把文本规范化并切分为用于比较的词
+ *
+ * 转为小写，去掉标点（保留词内的撇号），按空白切分；
+ * 中日韩文字没有空格分隔，每个字单独作为一个词（即字错误率）。
+ * @param text 原始文本
+ * @return 词列表
+ */
+QStringList tokenizeForWer(const QString &text);
+
+/**
+ * @brief 用编辑距离对齐参考和识别结果，统计替换、删除和插入
+ * @param reference 参考词列表
+ * @param hypothesis 识别结果词列表
+ * @return 统计结果
+ */
+WerResult computeWordErrorRate(const QStringList &reference, const QStringList &hypothesis);
+
+/**
+ * @brief 对两段原始文本计算词错误率
+ */
+WerResult computeWordErrorRate(const QString &referenceText, const QString &hypothesisText);
+
+#endif // WER_H
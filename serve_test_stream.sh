@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# 在本机发布一个直播HLS流，用于测试“识别网络流”，不需要访问外网
+# 用法：./serve_test_stream.sh [音频文件] [端口]，Ctrl+C结束
+# 在EnPlayer中选择“文件 > 识别网络流...”，输入脚本打印的地址
+
+AUDIO="${1:-test_files/test_audio.wav}"
+PORT="${2:-8089}"
+
+if [ ! -f "$AUDIO" ]; then
+    echo "错误: 音频文件不存在: $AUDIO（可以先运行test_recognition.sh生成）"
+    exit 1
+fi
+
+STREAM_DIR=$(mktemp -d)
+trap 'kill $FFMPEG_PID $SERVER_PID 2>/dev/null; rm -rf "$STREAM_DIR"' EXIT
+
+# 按实际速度循环播放音频，切成2秒的分片，播放列表只保留最近的分片，与真实直播相同
+ffmpeg -hide_banner -loglevel error -re -stream_loop -1 -i "$AUDIO" -vn -c:a aac -ar 44100 \
+    -f hls -hls_time 2 -hls_list_size 5 -hls_flags delete_segments \
+    "$STREAM_DIR/live.m3u8" &
+FFMPEG_PID=$!
+
+# 只监听本机
+python3 -m http.server "$PORT" --bind 127.0.0.1 --directory "$STREAM_DIR" > /dev/null 2>&1 &
+SERVER_PID=$!
+
+echo "直播地址: http://127.0.0.1:$PORT/live.m3u8"
+echo "测试断线重连：另开终端执行 kill -STOP $SERVER_PID，几秒后 kill -CONT $SERVER_PID"
+wait $FFMPEG_PID
@@ -0,0 +1,65 @@
+#include "alignment.h"
+
+QStringList splitAlignmentWords(const QString &text)
+{
+    return text.simplified().split(' ', QString::SkipEmptyParts);
+}
+
+TranscriptSegment buildAlignedSegment(const QStringList &words, const QVector<qint64> &wordStartHints,
+                                      qint64 startMs, qint64 endMs)
+{
+    TranscriptSegment segment;
+    segment.startMs = startMs;
+    segment.endMs = qMax(startMs, endMs);
+    segment.text = words.join(' ');
+
+    const int count = words.size();
+    if (count == 0) {
+        return segment;
+    }
+
+    // 已知时间点：第一个词从片段开始，之后只接受严格递增且在片段内的估计，末尾以片段结束收尾
+    QVector<int> anchorWords;
+    QVector<qint64> anchorTimes;
+    anchorWords << 0;
+    anchorTimes << segment.startMs;
+    for (int i = 1; i < count && i < wordStartHints.size(); ++i) {
+        const qint64 hint = wordStartHints[i];
+        if (hint > anchorTimes.last() && hint < segment.endMs) {
+            anchorWords << i;
+            anchorTimes << hint;
+        }
+    }
+    anchorWords << count;
+    anchorTimes << segment.endMs;
+
+    // 两个已知时间点之间的词按字符数（至少为1）分配时间
+    QVector<qint64> starts(count);
+    for (int a = 0; a + 1 < anchorWords.size(); ++a) {
+        const int first = anchorWords[a];
+        const int last = anchorWords[a + 1];
+        qint64 totalWeight = 0;
+        for (int i = first; i < last; ++i) {
+            totalWeight += qMax(1, words[i].size());
+        }
+        const qint64 span = anchorTimes[a + 1] - anchorTimes[a];
+        qint64 weight = 0;
+        for (int i = first; i < last; ++i) {
+            starts[i] = anchorTimes[a] + span * weight / totalWeight;
+            weight += qMax(1, words[i].size());
+        }
+    }
+
+    segment.words.startMs.reserve(count);
+    segment.words.endMs.reserve(count);
+    segment.words.textOffset.reserve(count);
+    int offset = 0;
+    for (int i = 0; i < count; ++i) {
+        const qint64 end = (i + 1 < count) ? starts[i + 1] : segment.endMs;
+        segment.words.startMs.append(qint32(starts[i] - segment.startMs));
+        segment.words.endMs.append(qint32(end - segment.startMs));
+        segment.words.textOffset.append(offset);
+        offset += words[i].size() + 1;
+    }
+    return segment;
+}
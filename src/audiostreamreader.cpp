@@ -0,0 +1,422 @@
+#include "audiostreamreader.h"
+#include "recognizermetrics.h"
+#include "resampler.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QThread>
+#include <QUrl>
+
+namespace {
+
+// 识别器使用的采样率
+const int kSampleRate = 16000;
+
+const int kDefaultFollowCapacitySeconds = 60;
+const int kDefaultLiveCapacitySeconds = 30;
+const int kDefaultFollowIdleSeconds = 30;
+const int kDefaultLiveIdleSeconds = 15;
+const int kDefaultMaxReconnects = 5;
+
+// 重连退避：1秒起每次加倍，最多10秒
+const int kReconnectBaseDelayMs = 1000;
+const int kReconnectMaxDelayMs = 10000;
+
+// 等待ffmpeg输出的间隔，也是响应停止请求的最长时间
+const int kReadPollMs = 200;
+
+bool failWith(QString *error, const QString &reason)
+{
+    if (error) {
+        *error = reason;
+    }
+    return false;
+}
+
+} // namespace
+
+bool isStreamUrl(const QString &source)
+{
+    // Windows盘符（C:/）的scheme只有一个字母，不是网络地址
+    const QString scheme = QUrl(source).scheme().toLower();
+    static const QStringList schemes = QStringList() << "http" << "https" << "rtsp" << "rtsps" << "rtmp" << "rtmps"
+                                                     << "srt" << "udp" << "rtp" << "tcp";
+    return schemes.contains(scheme);
+}
+
+WavStreamDecoder::WavStreamDecoder() : m_invalid(false)
+{
+}
+
+WavStreamDecoder::~WavStreamDecoder()
+{
+}
+
+bool WavStreamDecoder::push(const QByteArray &chunk, std::vector<int16_t> &output)
+{
+    if (m_invalid || chunk.isEmpty()) {
+        return !m_invalid;
+    }
+
+    const char *data = chunk.constData();
+    qint64 size = chunk.size();
+
+    if (!m_converter) {
+        m_header.append(chunk);
+        QString error;
+        WavParseResult result = parseWavHeader(reinterpret_cast<const uchar *>(m_header.constData()),
+                                               m_header.size(), m_format, &error);
+        if (result == WavParseNeedMoreData) {
+            return true;
+        }
+        if (result == WavParseInvalid || m_format.bitsPerSample != 16 || m_format.channels <= 0) {
+            qCritical() << "[WavStreamDecoder] 错误: 无法解析ffmpeg输出的WAV头:" << error;
+            m_invalid = true;
+            return false;
+        }
+
+        qCritical() << "[WavStreamDecoder] 解码格式:" << m_format.sampleRate << "Hz," << m_format.channels << "声道";
+        m_converter.reset(new AudioConverter(m_format.sampleRate, m_format.channels, kSampleRate));
+        data = m_header.constData() + m_format.dataOffset;
+        size = m_header.size() - qint64(m_format.dataOffset);
+    }
+
+    m_converter->pushBytes(data, size_t(size), output);
+    m_header.clear();
+    return true;
+}
+
+void WavStreamDecoder::finish(std::vector<int16_t> &output)
+{
+    if (m_converter) {
+        m_converter->finish(output);
+    }
+}
+
+AudioStreamReader::AudioStreamReader(const QString &source, Mode mode) : m_source(source),
+                                                                         m_mode(mode),
+                                                                         m_thread(nullptr),
+                                                                         m_stopRequested(false),
+                                                                         m_queuedSamples(0),
+                                                                         m_finished(false),
+                                                                         m_sourceBytes(0),
+                                                                         m_reconnects(0),
+                                                                         m_droppedSamples(0)
+{
+    const bool live = (mode == LiveStream);
+    m_capacitySamples = (live ? kDefaultLiveCapacitySeconds : kDefaultFollowCapacitySeconds) * kSampleRate;
+    m_idleTimeoutSeconds = live ? kDefaultLiveIdleSeconds : kDefaultFollowIdleSeconds;
+    m_maxReconnects = kDefaultMaxReconnects;
+}
+
+AudioStreamReader::~AudioStreamReader()
+{
+    stop();
+}
+
+void AudioStreamReader::setCapacitySeconds(int seconds)
+{
+    m_capacitySamples = qMax(1, seconds) * kSampleRate;
+}
+
+void AudioStreamReader::setIdleTimeoutSeconds(int seconds)
+{
+    m_idleTimeoutSeconds = qMax(1, seconds);
+}
+
+void AudioStreamReader::setMaxReconnects(int count)
+{
+    m_maxReconnects = qMax(0, count);
+}
+
+QStringList AudioStreamReader::ffmpegArguments(const QString &source, Mode mode, int idleTimeoutSeconds)
+{
+    // 只输出错误信息：长时间运行时进度行会在标准错误的缓冲区中不断累积
+    QStringList args;
+    args << "-hide_banner" << "-nostats" << "-loglevel" << "error";
+
+    if (mode == FollowFile) {
+        // file协议读到末尾后继续等待追加的数据，超过rw_timeout（微秒）没有新数据才结束
+        args << "-follow" << "1"
+             << "-rw_timeout" << QString::number(qint64(idleTimeoutSeconds) * 1000000);
+    } else {
+        // 不在输入端缓存数据，收到就解码；协议相关的选项只对对应协议传入，否则ffmpeg报错退出
+        args << "-fflags" << "nobuffer";
+        const QString scheme = QUrl(source).scheme().toLower();
+        if (scheme == "http" || scheme == "https") {
+            // HLS的播放列表和分片请求也使用这些选项，单个请求断开时ffmpeg自己先重试
+            args << "-reconnect" << "1" << "-reconnect_streamed" << "1" << "-reconnect_delay_max" << "5";
+        } else if (scheme == "rtsp" || scheme == "rtsps") {
+            // UDP传输在识别占满CPU时容易丢包
+            args << "-rtsp_transport" << "tcp";
+        }
+    }
+
+    args << "-i" << source
+         << "-vn"
+         << "-f" << "wav"
+         << "-acodec" << "pcm_s16le"
+         << "-";
+    return args;
+}
+
+bool AudioStreamReader::start(QString *error)
+{
+    if (m_thread) {
+        return failWith(error, "读取已经开始");
+    }
+    if (m_source.isEmpty()) {
+        return failWith(error, "音频源为空");
+    }
+
+    m_stopRequested = false;
+    m_thread = QThread::create([this]() {
+        run();
+    });
+    m_thread->setObjectName(m_mode == LiveStream ? "EnStreamReader" : "EnFileFollower");
+    m_thread->start();
+    return true;
+}
+
+void AudioStreamReader::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+    m_stopRequested = true;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_changed.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+bool AudioStreamReader::read(std::vector<int16_t> &samples, qint64 &gapSamples, int waitMs)
+{
+    samples.clear();
+    gapSamples = 0;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_chunks.empty() && !m_finished) {
+        m_changed.wait(&m_mutex, (unsigned long)qMax(0, waitMs));
+    }
+    if (m_chunks.empty()) {
+        return !m_finished;
+    }
+
+    // 取到下一个缺口为止，缺口前后的样本在时间轴上不连续
+    gapSamples = m_chunks.front().gapBefore;
+    samples.swap(m_chunks.front().samples);
+    m_chunks.pop_front();
+    while (!m_chunks.empty() && m_chunks.front().gapBefore == 0) {
+        const std::vector<int16_t> &next = m_chunks.front().samples;
+        samples.insert(samples.end(), next.begin(), next.end());
+        m_chunks.pop_front();
+    }
+    m_queuedSamples = 0;
+    for (const Chunk &chunk : m_chunks) {
+        m_queuedSamples += qint64(chunk.samples.size());
+    }
+
+    // 跟随文件时读取线程可能在等队列腾出空间
+    m_changed.wakeAll();
+    return true;
+}
+
+QString AudioStreamReader::errorString() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_error;
+}
+
+qint64 AudioStreamReader::sourceBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sourceBytes;
+}
+
+int AudioStreamReader::reconnects() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_reconnects;
+}
+
+qint64 AudioStreamReader::droppedSamples() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_droppedSamples;
+}
+
+void AudioStreamReader::push(std::vector<int16_t> &samples, qint64 gapSamples)
+{
+    if (samples.empty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_mode == FollowFile) {
+        // 文件不会丢数据，等识别取走一部分再继续读
+        while (m_queuedSamples >= m_capacitySamples && !m_stopRequested) {
+            m_changed.wait(&m_mutex, kReadPollMs);
+        }
+    }
+
+    Chunk chunk;
+    chunk.samples.swap(samples);
+    chunk.gapBefore = gapSamples;
+    m_queuedSamples += qint64(chunk.samples.size());
+    m_chunks.push_back(std::move(chunk));
+
+    // 直播不能让连接等待识别，超出容量时丢弃最旧的音频，丢弃的长度并入下一段之前的缺口
+    if (m_mode == LiveStream) {
+        qint64 dropped = 0;
+        while (m_queuedSamples > m_capacitySamples && m_chunks.size() > 1) {
+            Chunk &oldest = m_chunks.front();
+            const qint64 size = qint64(oldest.samples.size());
+            m_queuedSamples -= size;
+            m_chunks[1].gapBefore += oldest.gapBefore + size;
+            dropped += size;
+            m_chunks.pop_front();
+        }
+        if (dropped > 0) {
+            m_droppedSamples += dropped;
+            recognizerMetrics().streamDroppedMs.increment(uint64_t(dropped * 1000 / kSampleRate));
+            qWarning() << "[AudioStreamReader] 识别跟不上，丢弃了" << dropped * 1000 / kSampleRate << "毫秒音频";
+        }
+    }
+    m_changed.wakeAll();
+}
+
+void AudioStreamReader::finishReading(const QString &error)
+{
+    QMutexLocker locker(&m_mutex);
+    m_finished = true;
+    m_error = error;
+    m_changed.wakeAll();
+}
+
+void AudioStreamReader::run()
+{
+    int failures = 0;
+    QString error;
+
+    for (;;) {
+        bool producedData = false;
+        const SessionResult result = runSession(producedData, error);
+        if (result == SessionStopped || result == SessionEnded) {
+            finishReading(QString());
+            return;
+        }
+
+        // 跟随文件时rw_timeout到期ffmpeg以错误退出，这正是文件写完的信号
+        if (m_mode == FollowFile) {
+            finishReading(producedData ? QString() : error);
+            return;
+        }
+
+        failures = producedData ? 1 : failures + 1;
+        if (failures > m_maxReconnects) {
+            finishReading(QString("连续%1次连接失败: %2").arg(failures).arg(error));
+            return;
+        }
+
+        const int delayMs = qMin(kReconnectMaxDelayMs, kReconnectBaseDelayMs << qMin(failures - 1, 4));
+        qWarning() << "[AudioStreamReader] 流已断开:" << error << "，" << delayMs << "毫秒后重连";
+        QElapsedTimer delay;
+        delay.start();
+        while (delay.elapsed() < delayMs) {
+            if (m_stopRequested) {
+                finishReading(QString());
+                return;
+            }
+            QThread::msleep(50);
+        }
+
+        {
+            QMutexLocker locker(&m_mutex);
+            ++m_reconnects;
+        }
+        recognizerMetrics().streamReconnects.increment();
+    }
+}
+
+AudioStreamReader::SessionResult AudioStreamReader::runSession(bool &producedData, QString &error)
+{
+    QProcess ffmpegProcess;
+    const QStringList args = ffmpegArguments(m_source, m_mode, m_idleTimeoutSeconds);
+    qCritical() << "[AudioStreamReader] 执行ffmpeg命令: ffmpeg" << args.join(" ");
+    ffmpegProcess.start("ffmpeg", args);
+    if (!ffmpegProcess.waitForStarted(2000)) {
+        error = "无法启动ffmpeg进程，请安装FFmpeg并确保其在系统PATH中";
+        return SessionFailed;
+    }
+
+    WavStreamDecoder decoder;
+    std::vector<int16_t> converted;
+    QElapsedTimer idle;
+    idle.start();
+
+    auto deliver = [&]() {
+        if (converted.empty()) {
+            return;
+        }
+        // 重连后的第一段数据之前是断开期间的缺口
+        qint64 gapSamples = 0;
+        if (!producedData && m_mode == LiveStream && m_lastData.isValid()) {
+            gapSamples = m_lastData.elapsed() * kSampleRate / 1000;
+        }
+        producedData = true;
+        m_lastData.start();
+        push(converted, gapSamples);
+        converted.clear();
+    };
+
+    for (;;) {
+        if (m_stopRequested) {
+            ffmpegProcess.kill();
+            ffmpegProcess.waitForFinished(1000);
+            return SessionStopped;
+        }
+
+        if (ffmpegProcess.waitForReadyRead(kReadPollMs)) {
+            const QByteArray chunk = ffmpegProcess.readAll();
+            {
+                QMutexLocker locker(&m_mutex);
+                m_sourceBytes += chunk.size();
+            }
+            decoder.push(chunk, converted);
+            deliver();
+            idle.restart();
+        } else if (m_mode == LiveStream && idle.elapsed() > qint64(m_idleTimeoutSeconds) * 1000) {
+            // 有的协议在连接卡住时不会报错，自己判断超时
+            ffmpegProcess.kill();
+            ffmpegProcess.waitForFinished(1000);
+            error = QString("%1秒没有收到数据").arg(m_idleTimeoutSeconds);
+            return SessionFailed;
+        }
+
+        if (decoder.isInvalid()) {
+            ffmpegProcess.kill();
+            ffmpegProcess.waitForFinished(1000);
+            error = "无法解析ffmpeg输出的音频数据";
+            return SessionFailed;
+        }
+
+        if (ffmpegProcess.state() != QProcess::Running) {
+            const QByteArray remaining = ffmpegProcess.readAll();
+            decoder.push(remaining, converted);
+            decoder.finish(converted);
+            deliver();
+
+            if (ffmpegProcess.exitStatus() == QProcess::NormalExit && ffmpegProcess.exitCode() == 0) {
+                return SessionEnded;
+            }
+            error = QString("ffmpeg退出码%1: %2").arg(ffmpegProcess.exitCode())
+                    .arg(QString::fromLocal8Bit(ffmpegProcess.readAllStandardError()).trimmed().right(200));
+            return SessionFailed;
+        }
+    }
+}
@@ -0,0 +1,312 @@
+#include "audiotracks.h"
+#include "pcmbuffer.h"
+#include "wavreader.h"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// 识别使用的采样率
+const int kSampleRate = 16000;
+
+// ffprobe只读取容器头部，很快返回
+const int kProbeTimeoutMs = 15000;
+
+// 解码要读完整个容器，超时按连续无输出的时间计算
+const int kDecodeIdleTimeoutMs = 30000;
+
+// amerge最多合并64路输入，实际使用时每条音轨还要各自的whisper状态，限制得更低
+const int kMaxMergedTracks = 8;
+
+bool failWith(QString *error, const QString &reason)
+{
+    if (error) {
+        *error = reason;
+    }
+    return false;
+}
+
+/**
+ * @brief 解析时长：ffprobe的duration字段为秒数，MKV的DURATION标签为“00:45:12.345000000”
+ */
+qint64 parseDurationMs(const QString &text)
+{
+    bool ok = false;
+    const double seconds = text.toDouble(&ok);
+    if (ok) {
+        return seconds >= 0 ? qint64(seconds * 1000.0) : -1;
+    }
+    const QStringList parts = text.split(':');
+    if (parts.size() != 3) {
+        return -1;
+    }
+    bool hoursOk = false;
+    bool minutesOk = false;
+    bool secondsOk = false;
+    const qint64 hours = parts.at(0).toLongLong(&hoursOk);
+    const qint64 minutes = parts.at(1).toLongLong(&minutesOk);
+    const double rest = parts.at(2).toDouble(&secondsOk);
+    if (!hoursOk || !minutesOk || !secondsOk) {
+        return -1;
+    }
+    return (hours * 3600 + minutes * 60) * 1000 + qint64(rest * 1000.0);
+}
+
+/**
+ * @brief 音轨的时长：优先流的duration，其次MKV的DURATION标签（可能带语言后缀）
+ */
+qint64 streamDurationMs(const QJsonObject &stream)
+{
+    const qint64 durationMs = parseDurationMs(stream.value("duration").toString());
+    if (durationMs > 0) {
+        return durationMs;
+    }
+    const QJsonObject tags = stream.value("tags").toObject();
+    for (auto it = tags.begin(); it != tags.end(); ++it) {
+        if (it.key().startsWith("DURATION", Qt::CaseInsensitive)) {
+            return parseDurationMs(it.value().toString());
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+QString AudioTrack::label() const
+{
+    QStringList parts;
+    parts << QString("#%1").arg(index);
+    if (!language.isEmpty()) {
+        parts << language;
+    }
+    if (!title.isEmpty()) {
+        parts << title;
+    }
+    QString details = codec;
+    if (channels > 0) {
+        details += QString(", %1声道").arg(channels);
+    }
+    if (!details.isEmpty()) {
+        parts << "(" + details + ")";
+    }
+    return parts.join(' ');
+}
+
+bool probeAudioTracks(const QString &mediaFilePath, QVector<AudioTrack> &tracks, QString *error)
+{
+    tracks.clear();
+
+    QProcess ffprobe;
+    ffprobe.start("ffprobe", QStringList() << "-v" << "error" << "-select_streams" << "a"
+                  << "-show_entries" << "format=duration:stream=index,codec_name,channels,sample_rate,duration:stream_tags"
+                  << "-of" << "json" << mediaFilePath);
+    if (!ffprobe.waitForStarted(2000)) {
+        return failWith(error, "无法启动ffprobe");
+    }
+    if (!ffprobe.waitForFinished(kProbeTimeoutMs)) {
+        ffprobe.kill();
+        ffprobe.waitForFinished(1000);
+        return failWith(error, "ffprobe超时");
+    }
+    if (ffprobe.exitStatus() != QProcess::NormalExit || ffprobe.exitCode() != 0) {
+        return failWith(error, QString("ffprobe失败: %1").arg(QString::fromUtf8(ffprobe.readAllStandardError()).left(200)));
+    }
+
+    const QJsonObject root = QJsonDocument::fromJson(ffprobe.readAllStandardOutput()).object();
+    const qint64 containerDurationMs = parseDurationMs(root.value("format").toObject().value("duration").toString());
+
+    for (const QJsonValue &value : root.value("streams").toArray()) {
+        const QJsonObject object = value.toObject();
+        const QJsonObject tags = object.value("tags").toObject();
+        AudioTrack track;
+        track.index = object.value("index").toInt(-1);
+        track.codec = object.value("codec_name").toString();
+        track.language = tags.value("language").toString();
+        track.title = tags.value("title").toString();
+        track.channels = object.value("channels").toInt();
+        track.sampleRate = object.value("sample_rate").toString().toInt();
+        track.durationMs = streamDurationMs(object);
+        if (track.durationMs <= 0) {
+            track.durationMs = containerDurationMs;
+        }
+        tracks.append(track);
+    }
+    return true;
+}
+
+QStringList audioTracksFfmpegArguments(const QString &mediaFilePath, const QVector<AudioTrack> &tracks)
+{
+    // 有音轨时长未知时不补齐，输出在最短的音轨结束时结束
+    qint64 longestMs = 0;
+    bool durationsKnown = tracks.size() > 1;
+    for (const AudioTrack &track : tracks) {
+        durationsKnown = durationsKnown && track.durationMs > 0;
+        longestMs = qMax(longestMs, track.durationMs);
+    }
+
+    // amerge要求各输入的采样率相同，因此降混和重采样放在滤镜中，而不是像单音轨那样在进程内完成
+    QStringList chains;
+    QString mergeInputs;
+    for (int k = 0; k < tracks.size(); ++k) {
+        const QString output = tracks.size() > 1 ? QString("t%1").arg(k) : QString("out");
+        chains << QString("[0:%1]aresample=%2,aformat=sample_fmts=s16:channel_layouts=mono%3[%4]")
+                  .arg(tracks.at(k).index).arg(kSampleRate).arg(durationsKnown ? ",apad" : "").arg(output);
+        mergeInputs += "[" + output + "]";
+    }
+    if (tracks.size() > 1) {
+        chains << QString("%1amerge=inputs=%2[out]").arg(mergeInputs).arg(tracks.size());
+    }
+
+    QStringList args;
+    args << "-hide_banner" << "-nostdin" << "-nostats" << "-v" << "error"
+         << "-i" << mediaFilePath
+         << "-filter_complex" << chains.join(';')
+         << "-map" << "[out]";
+    if (durationsKnown) {
+        args << "-t" << QString::number(longestMs / 1000.0, 'f', 3);
+    }
+    args << "-f" << "wav" << "-acodec" << "pcm_s16le" << "-";
+    return args;
+}
+
+bool decodeAudioTracks(const QString &mediaFilePath, const QVector<AudioTrack> &tracks,
+                       const TrackSampleSink &sink, qint64 *sourceBytes, QString *error)
+{
+    if (tracks.isEmpty() || !sink) {
+        return failWith(error, "没有要解码的音轨");
+    }
+    if (tracks.size() > kMaxMergedTracks) {
+        return failWith(error, QString("一次最多解码%1条音轨").arg(kMaxMergedTracks));
+    }
+
+    const int trackCount = tracks.size();
+    std::vector<size_t> limits(size_t(trackCount), std::numeric_limits<size_t>::max());
+    std::vector<size_t> delivered(size_t(trackCount), 0);
+    for (int k = 0; k < trackCount; ++k) {
+        if (tracks.at(k).durationMs > 0) {
+            limits[size_t(k)] = size_t(tracks.at(k).durationMs * kSampleRate / 1000);
+        }
+    }
+
+    const QStringList args = audioTracksFfmpegArguments(mediaFilePath, tracks);
+    qCritical() << "[AudioTracks] 一次解码" << trackCount << "条音轨: ffmpeg" << args.join(" ");
+
+    QProcess ffmpeg;
+    ffmpeg.start("ffmpeg", args);
+    if (!ffmpeg.waitForStarted(2000)) {
+        return failWith(error, "无法启动ffmpeg");
+    }
+
+    // 先解析WAV头，之后按帧拆分声道；不完整的帧留到下一块数据
+    QByteArray pending;
+    WavFormat format;
+    bool headerParsed = false;
+    bool invalid = false;
+    bool cancelled = false;
+    std::vector<int16_t> plane;
+    qint64 totalBytes = 0;
+
+    auto consume = [&](const QByteArray &chunk) {
+        if (invalid || cancelled || chunk.isEmpty()) {
+            return;
+        }
+        pending.append(chunk);
+        totalBytes += chunk.size();
+        if (!headerParsed) {
+            QString headerError;
+            const WavParseResult result = parseWavHeader(reinterpret_cast<const uchar *>(pending.constData()),
+                                                         pending.size(), format, &headerError);
+            if (result == WavParseNeedMoreData) {
+                return;
+            }
+            if (result == WavParseInvalid || format.bitsPerSample != 16 || format.channels != trackCount
+                    || format.sampleRate != kSampleRate) {
+                qCritical() << "[AudioTracks] 错误: ffmpeg输出的格式不符合预期:" << headerError
+                            << format.channels << "声道" << format.sampleRate << "Hz";
+                invalid = true;
+                return;
+            }
+            pending.remove(0, int(format.dataOffset));
+            headerParsed = true;
+        }
+
+        const int frameBytes = trackCount * int(sizeof(int16_t));
+        const size_t frames = size_t(pending.size() / frameBytes);
+        if (frames == 0) {
+            return;
+        }
+        const int16_t *interleaved = reinterpret_cast<const int16_t *>(pending.constData());
+        plane.resize(frames);
+        for (int k = 0; k < trackCount && !cancelled; ++k) {
+            const size_t wanted = std::min(frames, limits[size_t(k)] - std::min(limits[size_t(k)], delivered[size_t(k)]));
+            if (wanted == 0) {
+                continue;
+            }
+            for (size_t i = 0; i < wanted; ++i) {
+                plane[i] = interleaved[i * size_t(trackCount) + size_t(k)];
+            }
+            delivered[size_t(k)] += wanted;
+            cancelled = !sink(k, plane.data(), wanted);
+        }
+        pending.remove(0, int(frames) * frameBytes);
+    };
+
+    for (;;) {
+        if (cancelled) {
+            ffmpeg.kill();
+            ffmpeg.waitForFinished(1000);
+            return failWith(error, "解码已取消");
+        }
+        if (ffmpeg.waitForReadyRead(kDecodeIdleTimeoutMs)) {
+            consume(ffmpeg.readAllStandardOutput());
+        } else if (ffmpeg.state() == QProcess::Running) {
+            ffmpeg.kill();
+            ffmpeg.waitForFinished(1000);
+            return failWith(error, "ffmpeg解码音轨超时");
+        } else {
+            break;
+        }
+    }
+    ffmpeg.waitForFinished(1000);
+    consume(ffmpeg.readAllStandardOutput());
+    if (cancelled) {
+        return failWith(error, "解码已取消");
+    }
+
+    if (ffmpeg.exitStatus() != QProcess::NormalExit || ffmpeg.exitCode() != 0) {
+        return failWith(error, QString("ffmpeg解码音轨失败: %1").arg(QString::fromUtf8(ffmpeg.readAllStandardError()).left(200)));
+    }
+    if (invalid || !headerParsed) {
+        return failWith(error, "无法解析ffmpeg输出的音频");
+    }
+    if (sourceBytes) {
+        *sourceBytes = totalBytes;
+    }
+
+    for (int k = 0; k < trackCount; ++k) {
+        qCritical() << "[AudioTracks] 音轨" << tracks.at(k).label() << "样本数:" << delivered[size_t(k)];
+    }
+    return true;
+}
+
+bool decodeAudioTracks(const QString &mediaFilePath, const QVector<AudioTrack> &tracks,
+                       const QVector<PcmBuffer *> &outputs, qint64 *sourceBytes, QString *error)
+{
+    if (tracks.isEmpty() || tracks.size() != outputs.size()) {
+        return failWith(error, "没有要解码的音轨");
+    }
+    for (PcmBuffer *output : outputs) {
+        output->clear();
+    }
+    return decodeAudioTracks(mediaFilePath, tracks, [&outputs](int track, const int16_t *samples, size_t count) {
+        outputs.at(track)->append(samples, count);
+        return true;
+    }, sourceBytes, error);
+}
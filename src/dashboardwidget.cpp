@@ -0,0 +1,213 @@
+#include "dashboardwidget.h"
+#include "recognizermetrics.h"
+#include "resourcemonitor.h"
+
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// 采样间隔
+const int kRefreshIntervalMs = 1000;
+
+// 实时率的指数平滑系数
+const double kRealTimeSmoothing = 0.3;
+
+QString formatMegabytes(double bytes)
+{
+    return QString::number(bytes / (1024.0 * 1024.0), 'f', 1) + " MB";
+}
+
+QLabel *addRow(QFormLayout *layout, const QString &title)
+{
+    QLabel *label = new QLabel("—");
+    label->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    layout->addRow(title, label);
+    return label;
+}
+
+} // namespace
+
+DashboardWidget::DashboardWidget(QWidget *parent) : QWidget(parent),
+                                                    m_lastSampleNs(0),
+                                                    m_lastProcessCpu(0),
+                                                    m_lastPositionMs(0),
+                                                    m_smoothedRealTimeFactor(-1)
+{
+    QGroupBox *overviewGroup = new QGroupBox(tr("概览"));
+    QFormLayout *overviewLayout = new QFormLayout(overviewGroup);
+    m_memoryLabel = addRow(overviewLayout, tr("内存："));
+    m_cpuLabel = addRow(overviewLayout, tr("进程CPU："));
+    m_realTimeLabel = addRow(overviewLayout, tr("当前实时率："));
+    m_jobsLabel = addRow(overviewLayout, tr("任务："));
+    m_queueLabel = addRow(overviewLayout, tr("队列深度："));
+    m_throughputLabel = addRow(overviewLayout, tr("解码吞吐："));
+    m_cacheLabel = addRow(overviewLayout, tr("WAV直接映射命中率："));
+
+    QGroupBox *stageGroup = new QGroupBox(tr("阶段耗时（最近一次 / 平均）"));
+    QFormLayout *stageLayout = new QFormLayout(stageGroup);
+    m_decodeStageLabel = addRow(stageLayout, tr("解码："));
+    m_inferenceStageLabel = addRow(stageLayout, tr("推理："));
+    m_totalStageLabel = addRow(stageLayout, tr("总计："));
+
+    QGroupBox *threadGroup = new QGroupBox(tr("线程CPU"));
+    QVBoxLayout *threadLayout = new QVBoxLayout(threadGroup);
+    m_threadTable = new QTableWidget(0, 3);
+    m_threadTable->setHorizontalHeaderLabels(QStringList() << tr("线程") << tr("ID") << tr("CPU"));
+    m_threadTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_threadTable->verticalHeader()->setVisible(false);
+    m_threadTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_threadTable->setSelectionMode(QAbstractItemView::NoSelection);
+    threadLayout->addWidget(m_threadTable);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(overviewGroup);
+    layout->addWidget(stageGroup);
+    layout->addWidget(threadGroup, 1);
+
+    connect(&m_timer, &QTimer::timeout, this, &DashboardWidget::refresh);
+    m_clock.start();
+}
+
+void DashboardWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    refresh();
+    m_timer.start(kRefreshIntervalMs);
+}
+
+void DashboardWidget::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    m_timer.stop();
+    
+    // 重新显示时的第一次采样只作为基准，避免把隐藏期间的平均值当作当前值
+    m_lastSampleNs = 0;
+}
+
+void DashboardWidget::refresh()
+{
+    const qint64 nowNs = m_clock.nsecsElapsed();
+    const double interval = m_lastSampleNs > 0 ? (nowNs - m_lastSampleNs) / 1e9 : 0.0;
+    m_lastSampleNs = nowNs;
+
+    RecognizerMetrics &metrics = recognizerMetrics();
+
+    const ProcessMemory memory = readProcessMemory();
+    m_memoryLabel->setText(tr("RSS %1，峰值 %2").arg(formatMegabytes(memory.rssBytes)).arg(formatMegabytes(memory.peakRssBytes)));
+
+    const double processCpu = processCpuSeconds();
+    if (interval > 0) {
+        m_cpuLabel->setText(QString("%1%").arg((processCpu - m_lastProcessCpu) * 100.0 / interval, 0, 'f', 0));
+    }
+    m_lastProcessCpu = processCpu;
+
+    // 实时率 = 墙钟时间 / 识别推进的音频时长，只在有任务运行时计算
+    const int64_t running = metrics.jobsRunning.value();
+    const qint64 positionMs = metrics.jobPositionMs.value();
+    if (running <= 0) {
+        m_smoothedRealTimeFactor = -1;
+        m_realTimeLabel->setText("—");
+    } else if (interval > 0 && positionMs > m_lastPositionMs) {
+        const double factor = interval * 1000.0 / double(positionMs - m_lastPositionMs);
+        m_smoothedRealTimeFactor = m_smoothedRealTimeFactor < 0
+                ? factor : m_smoothedRealTimeFactor + kRealTimeSmoothing * (factor - m_smoothedRealTimeFactor);
+        m_realTimeLabel->setText(QString("%1（%2倍速）").arg(m_smoothedRealTimeFactor, 0, 'f', 3)
+                                 .arg(1.0 / m_smoothedRealTimeFactor, 0, 'f', 1));
+    }
+    m_lastPositionMs = positionMs;
+
+    m_jobsLabel->setText(tr("运行 %1，完成 %2，失败 %3").arg(running)
+                         .arg(metrics.jobsCompleted.value()).arg(metrics.jobsFailed.value()));
+    m_queueLabel->setText(QString::number(metrics.jobsQueued.value()));
+
+    std::vector<uint64_t> buckets;
+    double decodeSum = 0;
+    metrics.decodeSeconds.snapshot(buckets, decodeSum);
+    if (decodeSum > 0) {
+        m_throughputLabel->setText(tr("%1/s（读取），%2/s（输出，平均）")
+                                   .arg(formatMegabytes(metrics.sourceBytes.value() / decodeSum))
+                                   .arg(formatMegabytes(metrics.decodedBytes.value() / decodeSum)));
+    }
+
+    const uint64_t mapped = metrics.loadsMapped.value();
+    const uint64_t loads = mapped + metrics.loadsConverted.value() + metrics.loadsFfmpeg.value()
+                           + metrics.loadsFfmpegParallel.value();
+    if (loads > 0) {
+        m_cacheLabel->setText(QString("%1%（%2/%3）").arg(mapped * 100.0 / loads, 0, 'f', 0).arg(mapped).arg(loads));
+    }
+
+    m_decodeStageLabel->setText(formatStage(m_decodeState, metrics.decodeSeconds));
+    m_inferenceStageLabel->setText(formatStage(m_inferenceState, metrics.inferenceSeconds));
+    m_totalStageLabel->setText(formatStage(m_totalState, metrics.totalSeconds));
+
+    refreshThreads(interval);
+}
+
+QString DashboardWidget::formatStage(StageState &state, const MetricHistogram &histogram)
+{
+    std::vector<uint64_t> buckets;
+    double sum = 0;
+    const uint64_t count = histogram.snapshot(buckets, sum);
+    if (count == 0) {
+        return "—";
+    }
+
+    // 两次采样之间可能完成了多个任务，这时“最近一次”取它们的平均值
+    if (count > state.count) {
+        state.lastSeconds = (sum - state.sum) / double(count - state.count);
+        state.count = count;
+        state.sum = sum;
+    }
+    return QString("%1 s / %2 s（%3次）").arg(state.lastSeconds, 0, 'f', 2).arg(sum / count, 0, 'f', 2).arg(count);
+}
+
+void DashboardWidget::refreshThreads(double intervalSeconds)
+{
+    QVector<ThreadCpuTime> threads = readThreadCpuTimes();
+
+    struct Row
+    {
+        ThreadCpuTime thread;
+        double percent;
+    };
+    std::vector<Row> rows;
+    rows.reserve(threads.size());
+
+    QHash<qint64, double> currentCpu;
+    for (const ThreadCpuTime &thread : threads) {
+        currentCpu.insert(thread.threadId, thread.cpuSeconds);
+        const double previous = m_lastThreadCpu.value(thread.threadId, thread.cpuSeconds);
+        Row row;
+        row.thread = thread;
+        row.percent = intervalSeconds > 0 ? (thread.cpuSeconds - previous) * 100.0 / intervalSeconds : 0.0;
+        rows.push_back(row);
+    }
+    m_lastThreadCpu.swap(currentCpu);
+
+    // 最忙的线程排在前面
+    std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) {
+        return a.percent != b.percent ? a.percent > b.percent : a.thread.threadId < b.thread.threadId;
+    });
+
+    m_threadTable->setRowCount(int(rows.size()));
+    for (int i = 0; i < int(rows.size()); ++i) {
+        const Row &row = rows[size_t(i)];
+        const QString cells[] = { row.thread.name, QString::number(row.thread.threadId),
+                                  QString("%1%").arg(row.percent, 0, 'f', 0) };
+        for (int column = 0; column < 3; ++column) {
+            QTableWidgetItem *item = m_threadTable->item(i, column);
+            if (!item) {
+                item = new QTableWidgetItem;
+                m_threadTable->setItem(i, column, item);
+            }
+            item->setText(cells[column]);
+        }
+    }
+}
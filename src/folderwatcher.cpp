@@ -0,0 +1,343 @@
+#include "folderwatcher.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 收到关闭或移入事件后再等多久：写入方有时关闭后马上重新打开追加，或者紧接着改名
+const int kCloseSettleMs = 1000;
+
+// 默认静默期
+const int kDefaultQuietMs = 10000;
+
+#ifdef Q_OS_LINUX
+// 监视目录时关心的事件；IN_EXCL_UNLINK避免已删除但仍被打开的文件继续产生事件
+const uint32_t kWatchMask = IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE
+                            | IN_ONLYDIR | IN_EXCL_UNLINK;
+#endif
+
+bool failWith(QString *error, const QString &reason)
+{
+    if (error) {
+        *error = reason;
+    }
+    return false;
+}
+
+} // namespace
+
+FolderWatcher::FolderWatcher(QObject *parent) : QObject(parent),
+                                                m_fd(-1),
+                                                m_notifier(nullptr),
+                                                m_quietMs(kDefaultQuietMs),
+                                                m_checkDeadlineMs(0)
+{
+    m_checkTimer.setSingleShot(true);
+    connect(&m_checkTimer, &QTimer::timeout, this, &FolderWatcher::checkPending);
+    m_clock.start();
+}
+
+FolderWatcher::~FolderWatcher()
+{
+    stop();
+}
+
+bool FolderWatcher::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FolderWatcher::setNameFilters(const QStringList &filters)
+{
+    m_nameFilters.clear();
+    for (const QString &filter : filters) {
+        m_nameFilters.append(QRegExp(filter, Qt::CaseInsensitive, QRegExp::Wildcard));
+    }
+}
+
+void FolderWatcher::setQuietPeriod(int milliseconds)
+{
+    m_quietMs = qMax(0, milliseconds);
+}
+
+QStringList FolderWatcher::folders() const
+{
+    return m_folders;
+}
+
+bool FolderWatcher::setFolders(const QStringList &folders, QString *error)
+{
+    stop();
+    if (folders.isEmpty()) {
+        return true;
+    }
+
+#ifdef Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        return failWith(error, QString("inotify_init1失败: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+    }
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &FolderWatcher::readEvents);
+
+    QString firstError;
+    for (const QString &folder : folders) {
+        const QString directory = QDir::cleanPath(QFileInfo(folder).absoluteFilePath());
+        if (!QFileInfo(directory).isDir()) {
+            if (firstError.isEmpty()) {
+                firstError = "目录不存在: " + directory;
+            }
+            continue;
+        }
+        addWatchTree(directory, false, firstError.isEmpty() ? &firstError : nullptr);
+        m_folders << directory;
+    }
+    if (error) {
+        *error = firstError;
+    }
+    if (m_folders.isEmpty()) {
+        stop();
+        return false;
+    }
+    return true;
+#else
+    return failWith(error, "监视文件夹只支持Linux（inotify）");
+#endif
+}
+
+void FolderWatcher::pruneReported()
+{
+    for (auto it = m_reported.begin(); it != m_reported.end();) {
+        const QString &path = it.key();
+        bool watched = false;
+        for (const QString &folder : m_folders) {
+            if (path.startsWith(folder + '/')) {
+                watched = true;
+                break;
+            }
+        }
+        if (watched && QFileInfo(path).isFile()) {
+            ++it;
+        } else {
+            it = m_reported.erase(it);
+        }
+    }
+}
+
+void FolderWatcher::stop()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+#endif
+    m_fd = -1;
+    m_directories.clear();
+    m_folders.clear();
+    m_pending.clear();
+    m_reported.clear();
+    m_checkTimer.stop();
+}
+
+bool FolderWatcher::addWatch(const QString &directory, QString *error)
+{
+#ifdef Q_OS_LINUX
+    const int wd = inotify_add_watch(m_fd, QFile::encodeName(directory).constData(), kWatchMask);
+    if (wd < 0) {
+        // ENOSPC：超出fs.inotify.max_user_watches
+        return failWith(error, QString("无法监视 %1: %2").arg(directory).arg(QString::fromLocal8Bit(strerror(errno))));
+    }
+    m_directories.insert(wd, directory);
+    return true;
+#else
+    Q_UNUSED(directory);
+    return failWith(error, "监视文件夹只支持Linux（inotify）");
+#endif
+}
+
+void FolderWatcher::addWatchTree(const QString &directory, bool reportExistingFiles, QString *error)
+{
+    if (!addWatch(directory, error)) {
+        error = nullptr; // 只保留第一个错误
+    }
+    QDirIterator subdirectories(directory, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks,
+                                QDirIterator::Subdirectories);
+    while (subdirectories.hasNext()) {
+        if (!addWatch(subdirectories.next(), error)) {
+            error = nullptr;
+        }
+    }
+
+    // 新建或移入的目录在添加监视之前可能已经有文件写入
+    if (reportExistingFiles) {
+        QDirIterator files(directory, QDir::Files, QDirIterator::Subdirectories);
+        while (files.hasNext()) {
+            fileEvent(files.next(), false);
+        }
+    }
+}
+
+bool FolderWatcher::matchesFilters(const QString &fileName) const
+{
+    if (m_nameFilters.isEmpty()) {
+        return true;
+    }
+    for (const QRegExp &filter : m_nameFilters) {
+        if (filter.exactMatch(fileName)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FolderWatcher::readEvents()
+{
+#ifdef Q_OS_LINUX
+    bool overflow = false;
+    alignas(inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        const ssize_t length = ::read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break; // EAGAIN：事件已读完
+        }
+        for (const char *p = buffer; p < buffer + length;) {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                m_directories.remove(event->wd);
+                continue;
+            }
+            const QString directory = m_directories.value(event->wd);
+            if (directory.isEmpty() || event->len == 0) {
+                continue;
+            }
+            const QString path = directory + '/' + QFile::decodeName(event->name);
+
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    addWatchTree(path, true, nullptr);
+                } else if (event->mask & IN_MOVED_FROM) {
+                    // 移出的目录树不再属于监视范围；删除的目录由内核发送IN_IGNORED
+                    const QString prefix = path + '/';
+                    for (auto it = m_directories.begin(); it != m_directories.end();) {
+                        if (it.value() == path || it.value().startsWith(prefix)) {
+                            inotify_rm_watch(m_fd, it.key());
+                            it = m_directories.erase(it);
+                        } else {
+                            ++it;
+                        }
+                    }
+                }
+                continue;
+            }
+
+            if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                m_pending.remove(path);
+                m_reported.remove(path);
+            } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                fileEvent(path, true);
+            } else if (event->mask & (IN_CREATE | IN_MODIFY)) {
+                fileEvent(path, false);
+            }
+        }
+    }
+    if (overflow) {
+        qWarning() << "[FolderWatcher] inotify事件队列溢出";
+        emit overflowed();
+    }
+#endif
+}
+
+void FolderWatcher::fileEvent(const QString &path, bool closed)
+{
+    if (!matchesFilters(QFileInfo(path).fileName())) {
+        return;
+    }
+    // 同一文件的连续事件只推迟检查时间
+    PendingFile &pending = m_pending[path];
+    pending.closed = closed;
+    pending.deadlineMs = m_clock.elapsed() + (closed ? kCloseSettleMs : m_quietMs);
+    scheduleCheck(pending.deadlineMs);
+}
+
+void FolderWatcher::scheduleCheck(qint64 deadlineMs)
+{
+    if (m_checkTimer.isActive() && m_checkDeadlineMs <= deadlineMs) {
+        return;
+    }
+    m_checkDeadlineMs = deadlineMs;
+    m_checkTimer.start(int(qMax<qint64>(0, deadlineMs - m_clock.elapsed())));
+}
+
+void FolderWatcher::checkPending()
+{
+    const qint64 now = m_clock.elapsed();
+    qint64 nextDeadlineMs = -1;
+    QStringList ready;
+
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        PendingFile &pending = it.value();
+        if (pending.deadlineMs > now) {
+            nextDeadlineMs = nextDeadlineMs < 0 ? pending.deadlineMs : qMin(nextDeadlineMs, pending.deadlineMs);
+            ++it;
+            continue;
+        }
+        const QFileInfo info(it.key());
+        if (!info.isFile() || info.size() == 0) {
+            it = m_pending.erase(it);
+            continue;
+        }
+        const qint64 size = info.size();
+        const qint64 modifiedMs = info.lastModified().toMSecsSinceEpoch();
+
+        // 没有关闭事件时，要再过一个静默期大小和修改时间都不变才算写完
+        if (!pending.closed && (size != pending.size || modifiedMs != pending.modifiedMs)) {
+            pending.size = size;
+            pending.modifiedMs = modifiedMs;
+            pending.deadlineMs = now + m_quietMs;
+            nextDeadlineMs = nextDeadlineMs < 0 ? pending.deadlineMs : qMin(nextDeadlineMs, pending.deadlineMs);
+            ++it;
+            continue;
+        }
+
+        // 只是打开后关闭、内容没变时不重复报告
+        const QPair<qint64, qint64> state(size, modifiedMs);
+        const auto reported = m_reported.constFind(it.key());
+        if (reported == m_reported.constEnd() || reported.value() != state) {
+            m_reported.insert(it.key(), state);
+            ready << it.key();
+        }
+        it = m_pending.erase(it);
+    }
+
+    if (nextDeadlineMs >= 0) {
+        scheduleCheck(nextDeadlineMs);
+    }
+    for (const QString &path : ready) {
+        emit fileReady(path);
+    }
+}
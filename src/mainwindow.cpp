@@ -4,6 +4,16 @@
 #include "../include/settingsmanager.h"
 #include "../include/settingsdialog.h"
 #include "../include/playbackwindow.h"
+#include "../include/transcriptformats.h"
+#include "../include/mappedtranscript.h"
+#include "../include/transcriptindex.h"
+#include "../include/transcriptsearchwidget.h"
+#include "../include/medialibrary.h"
+#include "../include/medialibrarywidget.h"
+#include "../include/folderwatcher.h"
+#include "../include/transcriptionqueue.h"
+#include "../include/audiostreamreader.h"
+#include "../include/audiotracks.h"
 #include <QApplication>
 #include <QMainWindow>
 #include <QFile>
@@ -12,13 +22,44 @@
 #include <QDebug>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QListWidget>
+#include <QVBoxLayout>
 #include <QProcess>
 #include <QTimer>
+#include <QThread>
+#include <QStandardPaths>
 #include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSharedPointer>
 #include <QUrl>
 #include <QDateTime>
 #include <QMutex>
 #include <QTextCodec>
+#include <QStatusBar>
+#include <QTextDocument>
+#include <QScrollBar>
+
+namespace {
+
+// 进程内存采样间隔
+const int kMemorySampleIntervalMs = 60 * 1000;
+
+// 已有字幕中短于此时长的空白视为台词之间的停顿，不做识别
+const qint64 kMinimumTranscriptGapMs = 30 * 1000;
+
+/**
+ * @brief 字幕缓存来自导入时旁边的标记文件
+ */
+QString importMarkerPath(const QString &cachePath)
+{
+    return cachePath + ".import";
+}
+
+} // namespace
 
 // 全局消息处理器回调函数，将控制台输出重定向到UI
 static void customMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
@@ -98,15 +139,30 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent),
                                           subtitleTimer(nullptr),
                                           m_speechRecognizer(nullptr),
                                           playbackWindow(nullptr),
+                                          m_resourceMonitor(nullptr),
+                                          m_memoryLabel(nullptr),
+                                          m_metricsServer(nullptr),
+                                          m_dashboard(nullptr),
                                           currentAudioFile(""),
-                                          currentSubtitle(""),
-                                          isRecognitionInProgress(false)
+                                          m_transcriptModel(nullptr),
+                                          isRecognitionInProgress(false),
+                                          isRangeRecognition(false),
+                                          m_hasImportedSubtitles(false),
+                                          m_mediaDurationMs(-1),
+                                          m_searchWidget(nullptr),
+                                          m_libraryWidget(nullptr),
+                                          m_folderWatcher(nullptr),
+                                          m_transcriptionQueue(nullptr),
+                                          m_libraryRescanTimer(nullptr)
 {
     // 安装自定义消息处理器，拦截所有qDebug、qInfo、qWarning、qCritical、qFatal输出
     qInstallMessageHandler(customMessageHandler);
     
     ui->setupUi(this);
     
+    m_transcriptModel = new TranscriptModel(this);
+    ui->subtitleListView->setModel(m_transcriptModel);
+    
     // 应用程序启动日志
     logMessage("EnPlayer启动成功", "SUCCESS");
     logMessage("欢迎使用EnPlayer语音识别", "INFO");
@@ -117,6 +173,11 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent),
     
     initSubtitleTimer();
     initSpeechRecognition();
+    initResourceMonitor();
+    applyMetricsSettings();
+    initTranscriptSearch();
+    initMediaLibrary();
+    initWatchFolders();
 
     // 连接设置变更信号
     connect(SettingsManager::instance(), &SettingsManager::settingsChanged, this, &MainWindow::onSettingsChanged);
@@ -159,9 +220,13 @@ void MainWindow::initSpeechRecognition()
     m_speechRecognizer = new SpeechRecognizer(this);
 
     // 连接语音识别器的所有信号
+    connect(m_speechRecognizer, &SpeechRecognizer::segmentsDecoded, this, &MainWindow::onSegmentsDecoded);
+    connect(m_speechRecognizer, &SpeechRecognizer::segmentsRecognized, this, &MainWindow::onSegmentsRecognized);
+    connect(m_speechRecognizer, &SpeechRecognizer::trackSegmentsRecognized, this, &MainWindow::onTrackSegmentsRecognized);
     connect(m_speechRecognizer, &SpeechRecognizer::recognitionFinished, this, &MainWindow::onRecognitionFinished);
     connect(m_speechRecognizer, &SpeechRecognizer::recognitionError, this, &MainWindow::onRecognitionError);
     connect(m_speechRecognizer, &SpeechRecognizer::recognitionProgress, this, &MainWindow::onRecognitionProgress);
+    connect(m_speechRecognizer, &SpeechRecognizer::jobStatsReady, this, &MainWindow::onJobStatsReady);
 
     // 初始化语音识别器
     bool initialized = m_speechRecognizer->initialize();
@@ -228,6 +293,10 @@ void MainWindow::onSettingsChanged()
         m_speechRecognizer = nullptr;
     }
     initSpeechRecognition();
+    applyMetricsSettings();
+    openTranscriptIndex();
+    m_transcriptionQueue->reloadSettings();
+    applyWatchFolders();
     logMessage("设置已更新，语音识别器已重新初始化", "INFO");
 }
 
@@ -239,19 +308,7 @@ void MainWindow::on_openButton_clicked()
     if (!fileName.isEmpty())
     {
         logMessage(QString("选择媒体文件: %1").arg(fileName), "INFO");
-        
-        // 保存当前媒体文件路径
-        currentAudioFile = fileName;
-        
-        // 更新UI显示
-        QFileInfo fileInfo(fileName);
-        ui->currentFileLabel->setText(tr("当前文件: %1").arg(fileInfo.fileName()));
-        ui->statusLabel->setText(tr("文件已加载，准备进行语音识别"));
-        
-        logMessage("媒体文件加载成功，准备进行语音识别", "SUCCESS");
-        
-        // 启用语音识别按钮
-        ui->startRecognitionButton->setEnabled(true);
+        openMediaFile(fileName);
     }
     else
     {
@@ -259,9 +316,43 @@ void MainWindow::on_openButton_clicked()
     }
 }
 
+void MainWindow::openMediaFile(const QString &fileName)
+{
+    // 保存当前媒体文件路径，新文件的字幕从空开始
+    currentAudioFile = fileName;
+    currentSegments.clear();
+    m_transcriptModel->clear();
+    m_hasImportedSubtitles = false;
+    m_mediaDurationMs = -1;
+    m_pendingGaps.clear();
+    m_untimedTranscript.clear();
+    
+    // 之前识别过的文件直接显示缓存的字幕，否则查找已有的字幕
+    if (loadCachedTranscript()) {
+        ui->goToPlaybackButton->setEnabled(true);
+    } else {
+        startSubtitleImport(fileName);
+    }
+    
+    // 更新UI显示
+    QFileInfo fileInfo(fileName);
+    ui->currentFileLabel->setText(tr("当前文件: %1").arg(fileInfo.fileName()));
+    ui->statusLabel->setText(tr("文件已加载，准备进行语音识别"));
+    
+    logMessage("媒体文件加载成功，准备进行语音识别", "SUCCESS");
+    
+    // 启用语音识别按钮
+    ui->startRecognitionButton->setEnabled(true);
+}
+
 void MainWindow::on_startRecognitionButton_clicked()
 {
-    if (!currentAudioFile.isEmpty() && !isRecognitionInProgress)
+    if (!currentAudioFile.isEmpty() && !isRecognitionInProgress && isStreamUrl(currentAudioFile))
+    {
+        // 网络流重新开始接收
+        startStreamRecognition(currentAudioFile);
+    }
+    else if (!currentAudioFile.isEmpty() && !isRecognitionInProgress)
     {
         // 直接调用startSpeechRecognition方法进行语音识别
         startSpeechRecognition();
@@ -291,12 +382,13 @@ void MainWindow::on_goToPlaybackButton_clicked()
     if (!playbackWindow) {
         playbackWindow = new PlaybackWindow(this);
         connect(playbackWindow, &PlaybackWindow::backToRecognitionRequested, this, &MainWindow::onPlaybackWindowClosed);
+        connect(playbackWindow, &PlaybackWindow::rangeRecognitionRequested, this, &MainWindow::onRangeRecognitionRequested);
         connect(playbackWindow, &QMainWindow::destroyed, this, &MainWindow::onPlaybackWindowClosed);
     }
     
     // 设置媒体文件路径
     playbackWindow->setMediaFilePath(currentAudioFile);
-    playbackWindow->setSubtitleContent(currentSubtitle);
+    playbackWindow->setTranscriptModel(m_transcriptModel);
     
     // 隐藏主窗口，显示播放窗口
     this->hide();
@@ -316,15 +408,783 @@ void MainWindow::onPlaybackWindowClosed()
     }
 }
 
-// 删除不再需要的formatTime方法和processAudioForSubtitles方法
+// 播放界面请求识别选定区间
+void MainWindow::onRangeRecognitionRequested(qint64 startMs, qint64 endMs)
+{
+    if (currentAudioFile.isEmpty()) {
+        logMessage("请先选择音频文件", "ERROR");
+        return;
+    }
+    
+    if (isRecognitionInProgress) {
+        logMessage("识别任务已在进行中，请等待完成", "WARNING");
+        return;
+    }
+    
+    logMessage(QString("开始识别区间: %1 - %2").arg(formatTranscriptTimestamp(startMs)).arg(formatTranscriptTimestamp(endMs)), "INFO");
+    
+    isRecognitionInProgress = true;
+    isRangeRecognition = true;
+    ui->startRecognitionButton->setEnabled(false);
+    if (playbackWindow) {
+        playbackWindow->setRangeRecognitionBusy(true);
+    }
+    
+    // 区间内的旧片段先移除，流式解码出的新片段插入到这里
+    m_transcriptModel->replaceRange(QVector<TranscriptSegment>(), startMs, endMs);
+    
+    if (!m_speechRecognizer->recognizeRange(currentAudioFile, startMs, endMs)) {
+        isRecognitionInProgress = false;
+        isRangeRecognition = false;
+        ui->startRecognitionButton->setEnabled(true);
+        if (playbackWindow) {
+            playbackWindow->setRangeRecognitionBusy(false);
+        }
+    }
+}
+void MainWindow::initResourceMonitor()
+{
+    m_memoryLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(m_memoryLabel);
+    
+    // 性能面板放在字幕和日志标签页之后，只在可见时采样
+    m_dashboard = new DashboardWidget(this);
+    ui->tabWidget->addTab(m_dashboard, tr("性能"));
+    
+    // 登记能直接统计的子系统，其余（whisper计算缓冲区、网络栈、分配器碎片）计入未归属
+    m_resourceMonitor = new ResourceMonitor(this);
+    m_resourceMonitor->registerSubsystem("模型文件", [this]() {
+        return m_speechRecognizer ? m_speechRecognizer->modelFileBytes() : 0;
+    });
+    m_resourceMonitor->registerSubsystem("音频", [this]() {
+        return m_speechRecognizer ? m_speechRecognizer->audioResidentBytes() : 0;
+    });
+    m_resourceMonitor->registerSubsystem("日志", [this]() {
+        return qint64(ui->logTextEdit->document()->characterCount()) * qint64(sizeof(QChar));
+    });
+    m_resourceMonitor->registerSubsystem("字幕", [this]() {
+        return m_transcriptModel->memoryBytes();
+    });
+    
+    connect(m_resourceMonitor, &ResourceMonitor::memorySampled, this, &MainWindow::onMemorySampled);
+    m_resourceMonitor->start(kMemorySampleIntervalMs);
+    m_resourceMonitor->sampleNow();
+}
+
+void MainWindow::applyMetricsSettings()
+{
+    SettingsManager *settings = SettingsManager::instance();
+    if (!settings->isMetricsEnabled()) {
+        if (m_metricsServer && m_metricsServer->isListening()) {
+            m_metricsServer->stop();
+            logMessage("指标服务已停止", "INFO");
+        }
+        return;
+    }
+    
+    if (!m_metricsServer) {
+        m_metricsServer = new MetricsServer(this);
+    }
+    const quint16 port = quint16(settings->getMetricsPort());
+    if (m_metricsServer->isListening() && m_metricsServer->port() == port) {
+        return;
+    }
+    if (!m_metricsServer->start(port)) {
+        logMessage(QString("无法在端口%1启动指标服务").arg(port), "WARNING");
+    }
+}
+
+void MainWindow::onJobStatsReady(const RecognitionJobStats &stats)
+{
+    logMessage(QString("识别资源统计: %1").arg(stats.summary()), "INFO");
+    ui->statusLabel->setToolTip(stats.summary());
+    
+    // 任务结束后立即采样一次，便于对比任务前后的内存
+    if (m_resourceMonitor) {
+        m_resourceMonitor->sampleNow();
+    }
+}
+
+void MainWindow::onMemorySampled(const ProcessMemory &memory, const QVector<ResourceMonitor::SubsystemUsage> &subsystems,
+                                 const QString &summary)
+{
+    Q_UNUSED(subsystems);
+    // 摘要已由ResourceMonitor写入日志，这里只更新状态栏
+    m_memoryLabel->setText(QString("内存: %1 MB").arg(memory.rssBytes / (1024 * 1024)));
+    m_memoryLabel->setToolTip(summary);
+}
+
+void MainWindow::onSegmentsDecoded(const QVector<TranscriptSegment> &segments)
+{
+    if (!isRecognitionInProgress) {
+        return;
+    }
+    
+    // 整个文件识别时，列表停在末尾就跟随新片段滚动；用户向上翻看时不打扰
+    QScrollBar *scrollBar = ui->subtitleListView->verticalScrollBar();
+    const bool followTail = !isRangeRecognition && scrollBar->value() == scrollBar->maximum();
+    m_transcriptModel->insertSegments(segments);
+    if (followTail) {
+        ui->subtitleListView->scrollToBottom();
+    }
+}
+
+void MainWindow::onSegmentsRecognized(const QString &mediaFilePath, const QVector<TranscriptSegment> &segments,
+                                      qint64 rangeStartMs, qint64 rangeEndMs)
+{
+    // 用户已切换到其他文件时丢弃结果
+    if (mediaFilePath != currentAudioFile) {
+        return;
+    }
+    
+    // 区间识别结果合并到已有字幕中，整个文件的识别结果直接替换
+    // 最终结果通常与流式插入的片段相同，模型只通知有差异的行
+    currentSegments = mergeTranscriptSegments(currentSegments, segments, rangeStartMs, rangeEndMs);
+    m_transcriptModel->setSegments(currentSegments);
+    logMessage(QString("收到%1个字幕片段，当前共%2个").arg(segments.size()).arg(currentSegments.size()), "INFO");
+    saveTranscriptCache();
+}
+
+QString MainWindow::transcriptCachePath(const QString &mediaFile) const
+{
+    return QDir(SettingsManager::instance()->getSubtitleSaveDirectory())
+            .filePath(QString("%1.%2.qet").arg(QFileInfo(mediaFile).completeBaseName())
+                      .arg(MappedTranscript::sourceKeyFor(mediaFile), 16, 16, QChar('0')));
+}
+
+QString MainWindow::trackTranscriptPath(const QString &mediaFile, const AudioTrack &track) const
+{
+    return QDir(SettingsManager::instance()->getSubtitleSaveDirectory())
+            .filePath(QString("%1.%2.track%3.qet").arg(QFileInfo(mediaFile).completeBaseName())
+                      .arg(MappedTranscript::sourceKeyFor(mediaFile), 16, 16, QChar('0')).arg(track.index));
+}
+
+bool MainWindow::loadCachedTranscript()
+{
+    // 媒体文件比缓存新时说明内容已变化，缓存作废
+    if (!hasFreshTranscriptCache(currentAudioFile)) {
+        return false;
+    }
+    const QFileInfo cacheInfo(transcriptCachePath(currentAudioFile));
+
+    MappedTranscript transcript;
+    QString error;
+    if (!transcript.open(cacheInfo.filePath(), &error)) {
+        logMessage(QString("无法读取字幕缓存 %1: %2").arg(cacheInfo.filePath()).arg(error), "WARNING");
+        return false;
+    }
+    const QVector<TranscriptSegment> segments = transcript.toSegments();
+
+    currentSegments = segments;
+    m_transcriptModel->setSegments(currentSegments);
+    updateLibraryTranscriptStatus(currentAudioFile, TranscriptStatus::Transcribed, cacheInfo.filePath());
+
+    // 缓存来自导入的字幕时，识别仍然只处理空白
+    QFile importMarker(importMarkerPath(cacheInfo.filePath()));
+    if (importMarker.open(QIODevice::ReadOnly)) {
+        m_hasImportedSubtitles = true;
+        m_mediaDurationMs = qint64(QJsonDocument::fromJson(importMarker.readAll()).object().value("durationMs").toDouble(-1));
+    }
+    logMessage(QString("已加载字幕缓存: %1（%2个片段）").arg(cacheInfo.filePath()).arg(segments.size()), "INFO");
+    return true;
+}
+
+void MainWindow::saveTranscriptCache()
+{
+    // 网络流的字幕不缓存，需要时导出
+    if (currentAudioFile.isEmpty() || currentSegments.isEmpty() || isStreamUrl(currentAudioFile)) {
+        return;
+    }
+    if (!storeTranscript(currentAudioFile, currentSegments)) {
+        return;
+    }
+
+    // 导入的字幕在缓存旁边记下媒体时长，重新打开时不会对已有字幕的部分再做完整识别
+    const QString markerPath = importMarkerPath(transcriptCachePath(currentAudioFile));
+    if (m_hasImportedSubtitles) {
+        QJsonObject marker;
+        marker["durationMs"] = double(m_mediaDurationMs);
+        QFile markerFile(markerPath);
+        if (!markerFile.open(QIODevice::WriteOnly | QIODevice::Truncate)
+                || markerFile.write(QJsonDocument(marker).toJson(QJsonDocument::Compact)) < 0) {
+            logMessage(QString("无法写入字幕导入标记 %1").arg(markerPath), "WARNING");
+        }
+    } else {
+        QFile::remove(markerPath);
+    }
+}
+
+bool MainWindow::hasFreshTranscriptCache(const QString &mediaFile) const
+{
+    // 媒体文件比缓存新时说明内容已变化，缓存作废；文件头中的标识不同说明缓存属于另一个文件
+    const QFileInfo cacheInfo(transcriptCachePath(mediaFile));
+    if (!cacheInfo.exists() || cacheInfo.lastModified() < QFileInfo(mediaFile).lastModified()) {
+        return false;
+    }
+    MappedTranscript transcript;
+    return transcript.open(cacheInfo.filePath()) && transcript.sourceKey() == MappedTranscript::sourceKeyFor(mediaFile);
+}
+
+bool MainWindow::storeTranscript(const QString &mediaFile, const QVector<TranscriptSegment> &segments)
+{
+    QString error;
+    const QString path = transcriptCachePath(mediaFile);
+    if (!MappedTranscript::write(path, segments, &error, MappedTranscript::sourceKeyFor(mediaFile))) {
+        logMessage(QString("无法写入字幕缓存 %1: %2").arg(path).arg(error), "WARNING");
+        return false;
+    }
+    updateLibraryTranscriptStatus(mediaFile, TranscriptStatus::Transcribed, path);
+    indexTranscript(mediaFile, path, segments);
+    return true;
+}
+
+void MainWindow::initMediaLibrary()
+{
+    // 数据库放在应用数据目录中，与字幕目录的设置无关
+    const QString databasePath = QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("library.db");
+    m_mediaLibrary.reset(new MediaLibrary);
+    QString error;
+    if (!m_mediaLibrary->open(databasePath, &error)) {
+        logMessage(QString("无法打开媒体库 %1: %2").arg(databasePath).arg(error), "WARNING");
+    } else {
+        logMessage(QString("媒体库: %1（%2个文件）").arg(databasePath).arg(m_mediaLibrary->size()), "INFO");
+    }
+
+    m_libraryWidget = new MediaLibraryWidget(m_mediaLibrary, this);
+    ui->tabWidget->addTab(m_libraryWidget, tr("媒体库"));
+    connect(m_libraryWidget, &MediaLibraryWidget::mediaActivated, this, &MainWindow::onLibraryMediaActivated);
+    connect(m_libraryWidget, &MediaLibraryWidget::scanFinished, this, [this](const QString &summary) {
+        logMessage(summary, "INFO");
+    });
+
+    // 启动时增量扫描：未变化的文件只比较大小和修改时间
+    if (m_mediaLibrary->isOpen()) {
+        m_libraryWidget->rescanAll();
+    }
+}
+
+void MainWindow::initWatchFolders()
+{
+    m_transcriptionQueue = new TranscriptionQueue(this);
+    connect(m_transcriptionQueue, &TranscriptionQueue::jobStarted, this, [this](const QString &mediaFilePath) {
+        logMessage(QString("后台识别开始: %1（队列中还有%2个）").arg(mediaFilePath).arg(m_transcriptionQueue->pendingCount()), "INFO");
+    });
+    connect(m_transcriptionQueue, &TranscriptionQueue::jobFinished, this, &MainWindow::onBackgroundJobFinished);
+    connect(m_transcriptionQueue, &TranscriptionQueue::jobFailed, this, &MainWindow::onBackgroundJobFailed);
+    connect(m_transcriptionQueue, &TranscriptionQueue::jobStatsReady, this, &MainWindow::onJobStatsReady);
+
+    m_folderWatcher = new FolderWatcher(this);
+    m_folderWatcher->setNameFilters(MediaLibrary::mediaNameFilters());
+    connect(m_folderWatcher, &FolderWatcher::fileReady, this, &MainWindow::onWatchedFileReady);
+    connect(m_folderWatcher, &FolderWatcher::overflowed, this, [this]() {
+        logMessage("文件夹监视事件溢出，重新扫描媒体库", "WARNING");
+        m_libraryWidget->rescanAll();
+    });
+
+    // 一批文件写完时只扫描一次媒体库
+    m_libraryRescanTimer = new QTimer(this);
+    m_libraryRescanTimer->setSingleShot(true);
+    m_libraryRescanTimer->setInterval(5000);
+    connect(m_libraryRescanTimer, &QTimer::timeout, this, [this]() {
+        if (m_libraryWidget->isScanning()) {
+            m_libraryRescanTimer->start();
+        } else {
+            m_libraryWidget->rescanAll();
+        }
+    });
+
+    // 在媒体库中添加文件夹后监视范围随之更新
+    connect(m_libraryWidget, &MediaLibraryWidget::scanFinished, this, &MainWindow::applyWatchFolders);
+    connect(m_libraryWidget, &MediaLibraryWidget::scanFinished, m_folderWatcher, &FolderWatcher::pruneReported);
+    applyWatchFolders();
+}
+
+void MainWindow::applyWatchFolders()
+{
+    QStringList folders;
+    if (SettingsManager::instance()->isWatchFoldersEnabled() && m_mediaLibrary->isOpen()) {
+        folders = m_mediaLibrary->folders();
+    }
+    if (folders == m_folderWatcher->folders()) {
+        return;
+    }
+
+    QString error;
+    if (!m_folderWatcher->setFolders(folders, &error)) {
+        logMessage(QString("无法监视媒体库文件夹: %1").arg(error), "WARNING");
+        return;
+    }
+    if (!error.isEmpty()) {
+        logMessage(QString("部分文件夹无法监视: %1").arg(error), "WARNING");
+    }
+    if (folders.isEmpty()) {
+        logMessage("已停止监视媒体库文件夹", "INFO");
+    } else {
+        logMessage(QString("正在监视%1个媒体库文件夹").arg(m_folderWatcher->folders().size()), "INFO");
+    }
+}
+
+void MainWindow::onWatchedFileReady(const QString &mediaFilePath)
+{
+    m_libraryRescanTimer->start();
+
+    // 已有不比媒体文件旧的字幕，或者界面正在识别这个文件
+    if (hasFreshTranscriptCache(mediaFilePath)) {
+        return;
+    }
+    if (mediaFilePath == currentAudioFile && isRecognitionInProgress) {
+        return;
+    }
+    if (m_transcriptionQueue->enqueue(mediaFilePath)) {
+        logMessage(QString("发现新的媒体文件，加入后台识别队列: %1").arg(mediaFilePath), "INFO");
+    }
+}
+
+void MainWindow::onBackgroundJobFinished(const QString &mediaFilePath, const QVector<TranscriptSegment> &segments)
+{
+    // 在线API只返回没有时间戳的文本，无法生成字幕缓存
+    if (segments.isEmpty()) {
+        logMessage(QString("后台识别没有得到带时间戳的字幕: %1").arg(mediaFilePath), "WARNING");
+        updateLibraryTranscriptStatus(mediaFilePath, TranscriptStatus::Failed);
+        return;
+    }
+    if (!storeTranscript(mediaFilePath, segments)) {
+        return;
+    }
+    logMessage(QString("后台识别完成: %1（%2个片段）").arg(mediaFilePath).arg(segments.size()), "SUCCESS");
+
+    // 界面中打开的正是这个文件且还没有字幕时直接显示
+    if (mediaFilePath == currentAudioFile && !isRecognitionInProgress && currentSegments.isEmpty()) {
+        currentSegments = segments;
+        m_transcriptModel->setSegments(currentSegments);
+        ui->goToPlaybackButton->setEnabled(true);
+    }
+}
+
+void MainWindow::onBackgroundJobFailed(const QString &mediaFilePath, const QString &errorMessage)
+{
+    logMessage(QString("后台识别失败 %1: %2").arg(mediaFilePath).arg(errorMessage), "WARNING");
+    updateLibraryTranscriptStatus(mediaFilePath, TranscriptStatus::Failed);
+}
+
+void MainWindow::updateLibraryTranscriptStatus(const QString &mediaFile, TranscriptStatus status,
+                                               const QString &transcriptPath)
+{
+    if (!m_mediaLibrary || !m_mediaLibrary->isOpen() || mediaFile.isEmpty()) {
+        return;
+    }
+    QString error;
+    if (!m_mediaLibrary->setTranscriptStatus(mediaFile, status, transcriptPath, &error)) {
+        logMessage(QString("无法更新媒体库: %1").arg(error), "WARNING");
+    }
+}
+
+void MainWindow::onLibraryMediaActivated(const QString &mediaFilePath)
+{
+    if (!QFileInfo::exists(mediaFilePath)) {
+        logMessage(QString("媒体文件不存在: %1").arg(mediaFilePath), "WARNING");
+        QMessageBox::warning(this, tr("媒体库"), tr("媒体文件不存在：%1\n请重新扫描媒体库。").arg(mediaFilePath));
+        return;
+    }
+    if (isRecognitionInProgress) {
+        logMessage("识别任务进行中，不能切换文件", "WARNING");
+        return;
+    }
+    logMessage(QString("从媒体库打开: %1").arg(mediaFilePath), "INFO");
+    openMediaFile(mediaFilePath);
+    ui->tabWidget->setCurrentIndex(0);
+}
+
+void MainWindow::initTranscriptSearch()
+{
+    m_transcriptIndex.reset(new TranscriptIndex);
+    openTranscriptIndex();
+    
+    m_searchWidget = new TranscriptSearchWidget(m_transcriptIndex.data(), this);
+    ui->tabWidget->addTab(m_searchWidget, tr("搜索"));
+    connect(m_searchWidget, &TranscriptSearchWidget::hitActivated, this, &MainWindow::onSearchHitActivated);
+}
+
+void MainWindow::openTranscriptIndex()
+{
+    const QString directory = QDir(QDir(SettingsManager::instance()->getSubtitleSaveDirectory()).filePath("index")).absolutePath();
+    if (directory == m_transcriptIndex->directory()) {
+        return;
+    }
+    QString error;
+    if (!m_transcriptIndex->open(directory, &error)) {
+        logMessage(QString("无法打开字幕索引 %1: %2").arg(directory).arg(error), "WARNING");
+        return;
+    }
+    logMessage(QString("字幕索引: %1（%2个文件）").arg(directory).arg(m_transcriptIndex->documentCount()), "INFO");
+}
+
+void MainWindow::indexTranscript(const QString &mediaFile, const QString &transcriptPath,
+                                 const QVector<TranscriptSegment> &segments)
+{
+    // 线程持有索引的引用，窗口先关闭也不会访问已释放的索引；多个索引线程在索引的写锁上排队
+    const QSharedPointer<TranscriptIndex> index = m_transcriptIndex;
+    QThread *thread = QThread::create([index, mediaFile, transcriptPath, segments]() {
+        QString error;
+        if (!index->addDocument(mediaFile, transcriptPath, segments, &error)) {
+            qWarning() << "[TranscriptIndex] 无法索引" << mediaFile << ":" << error;
+        }
+    });
+    thread->setObjectName("TranscriptIndex");
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
+}
+
+void MainWindow::onSearchHitActivated(const QString &mediaFilePath, qint64 startMs)
+{
+    if (!QFileInfo::exists(mediaFilePath)) {
+        logMessage(QString("媒体文件不存在: %1").arg(mediaFilePath), "WARNING");
+        QMessageBox::warning(this, tr("搜索"), tr("媒体文件不存在：%1").arg(mediaFilePath));
+        return;
+    }
+    if (mediaFilePath != currentAudioFile) {
+        if (isRecognitionInProgress) {
+            logMessage("识别任务进行中，不能切换文件", "WARNING");
+            return;
+        }
+        openMediaFile(mediaFilePath);
+    }
+    on_goToPlaybackButton_clicked();
+    if (playbackWindow) {
+        playbackWindow->seekTo(startMs);
+    }
+}
+
+void MainWindow::startSubtitleImport(const QString &mediaFile)
+{
+    // ffprobe和提取内嵌字幕都要等待子进程，在工作线程中进行
+    const QString language = SettingsManager::instance()->getRecognitionLanguage();
+    // 结果通过以窗口为上下文的finished连接交回界面线程，窗口先销毁时连接自动断开，不会访问已释放的窗口
+    QSharedPointer<ImportedSubtitles> subtitles(new ImportedSubtitles);
+    QThread *thread = QThread::create([mediaFile, language, subtitles]() {
+        importExistingSubtitles(mediaFile, language, *subtitles);
+    });
+    thread->setObjectName("SubtitleImport");
+    connect(thread, &QThread::finished, this, [this, mediaFile, subtitles]() {
+        onSubtitlesImported(mediaFile, *subtitles);
+    });
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
+}
+
+void MainWindow::onSubtitlesImported(const QString &mediaFile, const ImportedSubtitles &subtitles)
+{
+    // 用户已切换文件、已开始识别或已导入其他字幕时丢弃结果
+    if (mediaFile != currentAudioFile || isRecognitionInProgress || !currentSegments.isEmpty()) {
+        return;
+    }
+    m_mediaDurationMs = subtitles.durationMs;
+    if (subtitles.segments.isEmpty()) {
+        return;
+    }
+
+    currentSegments = subtitles.segments;
+    m_hasImportedSubtitles = true;
+    m_transcriptModel->setSegments(currentSegments);
+    ui->goToPlaybackButton->setEnabled(true);
+    saveTranscriptCache();
+
+    const QVector<TranscriptGap> gaps = findTranscriptGaps(currentSegments, m_mediaDurationMs, kMinimumTranscriptGapMs);
+    qint64 gapMs = 0;
+    for (const TranscriptGap &gap : gaps) {
+        gapMs += gap.endMs - gap.startMs;
+    }
+    logMessage(QString("已导入已有字幕: %1（%2个片段）").arg(subtitles.source).arg(currentSegments.size()), "SUCCESS");
+    if (gaps.isEmpty()) {
+        ui->statusLabel->setText(tr("已导入字幕（%1），无需语音识别").arg(subtitles.source));
+    } else {
+        ui->statusLabel->setText(tr("已导入字幕（%1），识别时只处理%2段空白（共%3）")
+                                 .arg(subtitles.source).arg(gaps.size()).arg(formatTranscriptTimestamp(gapMs)));
+    }
+}
+
+bool MainWindow::recognizeNextGap()
+{
+    if (m_pendingGaps.isEmpty()) {
+        return false;
+    }
+    const TranscriptGap gap = m_pendingGaps.takeFirst();
+    logMessage(QString("识别字幕空白: %1 - %2（剩余%3段）").arg(formatTranscriptTimestamp(gap.startMs))
+               .arg(formatTranscriptTimestamp(gap.endMs)).arg(m_pendingGaps.size()), "INFO");
+    onRangeRecognitionRequested(gap.startMs, gap.endMs);
+    return true;
+}
+
+void MainWindow::on_actionImportSubtitles_triggered()
+{
+    if (isRecognitionInProgress) {
+        logMessage("识别任务进行中，无法导入字幕", "WARNING");
+        return;
+    }
+
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("导入字幕"), SettingsManager::instance()->getSubtitleSaveDirectory(),
+                        tr("字幕文件 (*.srt *.vtt *.json *.qet)") + ";;" + tr("所有文件 (*)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QVector<TranscriptSegment> segments;
+    QString error;
+    if (!readTranscriptFile(fileName, segments, &error)) {
+        logMessage(QString("导入字幕失败: %1").arg(error), "ERROR");
+        QMessageBox::warning(this, tr("导入字幕"), tr("无法导入字幕：%1").arg(error));
+        return;
+    }
+
+    currentSegments = segments;
+    m_hasImportedSubtitles = true;
+    m_pendingGaps.clear();
+    m_transcriptModel->setSegments(currentSegments);
+    saveTranscriptCache();
+    if (!currentAudioFile.isEmpty()) {
+        ui->goToPlaybackButton->setEnabled(true);
+    }
+    logMessage(QString("已导入字幕: %1（%2个片段）").arg(fileName).arg(segments.size()), "SUCCESS");
+}
+
+void MainWindow::on_actionExportSubtitles_triggered()
+{
+    if (currentSegments.isEmpty()) {
+        logMessage("没有可导出的字幕", "WARNING");
+        return;
+    }
+
+    const QString defaultPath = QDir(SettingsManager::instance()->getSubtitleSaveDirectory())
+            .filePath(QFileInfo(currentAudioFile).completeBaseName() + ".srt");
+    QString fileName = QFileDialog::getSaveFileName(this, tr("导出字幕"), defaultPath,
+                        tr("SRT字幕 (*.srt)") + ";;" + tr("WebVTT字幕 (*.vtt)") + ";;"
+                        + tr("JSON (*.json)") + ";;" + tr("二进制字幕 (*.qet)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (transcriptFormatForPath(fileName) == TranscriptFormat::Unknown) {
+        fileName += ".srt";
+    }
+
+    QString error;
+    if (!writeTranscriptFile(fileName, currentSegments, &error)) {
+        logMessage(QString("导出字幕失败: %1").arg(error), "ERROR");
+        QMessageBox::warning(this, tr("导出字幕"), tr("无法导出字幕：%1").arg(error));
+        return;
+    }
+    logMessage(QString("字幕已导出: %1").arg(fileName), "SUCCESS");
+}
+
+void MainWindow::on_actionAlignText_triggered()
+{
+    if (currentAudioFile.isEmpty()) {
+        logMessage("请先选择一个音频文件", "ERROR");
+        return;
+    }
+    if (isRecognitionInProgress) {
+        logMessage("识别任务已在进行中，请等待完成", "WARNING");
+        return;
+    }
+
+    // 有没有时间戳的识别结果时可以直接对齐它，否则从文本文件读取
+    QString text;
+    if (!m_untimedTranscript.isEmpty()
+        && QMessageBox::question(this, tr("按文本对齐"), tr("对齐当前没有时间戳的识别结果？\n选择“否”将从文本文件读取。"))
+           == QMessageBox::Yes) {
+        text = m_untimedTranscript;
+    } else {
+        const QString fileName = QFileDialog::getOpenFileName(this, tr("选择要对齐的文本"),
+                                    QFileInfo(currentAudioFile).absolutePath(),
+                                    tr("文本文件 (*.txt)") + ";;" + tr("所有文件 (*)"));
+        if (fileName.isEmpty()) {
+            return;
+        }
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            logMessage(QString("无法读取文本文件: %1").arg(fileName), "ERROR");
+            return;
+        }
+        text = QString::fromUtf8(file.readAll());
+    }
+
+    isRecognitionInProgress = true;
+    ui->startRecognitionButton->setEnabled(false);
+    ui->recognitionProgressBar->setValue(0);
+    ui->statusLabel->setText(tr("正在按文本对齐，请稍候..."));
+    logMessage("开始强制对齐...", "INFO");
+
+    // 对齐结果与整个文件的识别一样通过onSegmentsRecognized替换全部字幕
+    m_speechRecognizer->alignText(currentAudioFile, text);
+}
+
+void MainWindow::on_actionFollowRecording_triggered()
+{
+    if (currentAudioFile.isEmpty()) {
+        logMessage("请先选择一个音频文件", "ERROR");
+        return;
+    }
+    if (isRecognitionInProgress) {
+        logMessage("识别任务已在进行中，请等待完成", "WARNING");
+        return;
+    }
+
+    // 新片段实时插入列表，录制结束后由onSegmentsRecognized替换为最终结果
+    currentSegments.clear();
+    m_transcriptModel->clear();
+    m_pendingGaps.clear();
+    isRecognitionInProgress = true;
+    ui->startRecognitionButton->setEnabled(false);
+    ui->recognitionProgressBar->setValue(0);
+    ui->statusLabel->setText(tr("正在跟随录制识别，文件停止增长或选择“结束跟随识别”后结束..."));
+    logMessage(QString("开始跟随识别: %1").arg(currentAudioFile), "INFO");
+
+    m_speechRecognizer->followFile(currentAudioFile);
+}
+
+void MainWindow::on_actionOpenStream_triggered()
+{
+    if (isRecognitionInProgress) {
+        logMessage("识别任务已在进行中，请等待完成", "WARNING");
+        return;
+    }
+
+    bool accepted = false;
+    const QString url = QInputDialog::getText(this, tr("识别网络流"), tr("流地址（HLS、RTSP、RTMP等）："),
+                                              QLineEdit::Normal,
+                                              isStreamUrl(currentAudioFile) ? currentAudioFile : QString(),
+                                              &accepted).trimmed();
+    if (!accepted || url.isEmpty()) {
+        return;
+    }
+    if (!isStreamUrl(url)) {
+        QMessageBox::warning(this, tr("识别网络流"), tr("不支持的地址：%1").arg(url));
+        return;
+    }
+    startStreamRecognition(url);
+}
+
+void MainWindow::startStreamRecognition(const QString &url)
+{
+    // 网络流没有缓存和已有字幕，每次从空开始
+    currentAudioFile = url;
+    currentSegments.clear();
+    m_transcriptModel->clear();
+    m_hasImportedSubtitles = false;
+    m_mediaDurationMs = -1;
+    m_pendingGaps.clear();
+    m_untimedTranscript.clear();
+    ui->currentFileLabel->setText(tr("当前网络流: %1").arg(url));
+
+    isRecognitionInProgress = true;
+    ui->startRecognitionButton->setEnabled(false);
+    ui->recognitionProgressBar->setValue(0);
+    ui->statusLabel->setText(tr("正在识别网络流，选择“结束跟随识别”停止..."));
+    logMessage(QString("开始识别网络流: %1").arg(url), "INFO");
+
+    m_speechRecognizer->recognizeStream(url);
+}
+
+void MainWindow::on_actionFinishFollowing_triggered()
+{
+    if (!isRecognitionInProgress) {
+        logMessage("没有正在进行的跟随识别", "INFO");
+        return;
+    }
+    // 普通识别不受影响；跟随识别停止读取，已收到的音频识别完后照常返回结果
+    m_speechRecognizer->finishFollowing();
+    logMessage("正在结束跟随识别，识别剩余的音频...", "INFO");
+}
+
+void MainWindow::on_actionRecognizeTracks_triggered()
+{
+    if (currentAudioFile.isEmpty() || isStreamUrl(currentAudioFile)) {
+        logMessage("请先选择一个媒体文件", "ERROR");
+        return;
+    }
+    if (isRecognitionInProgress) {
+        logMessage("识别任务已在进行中，请等待完成", "WARNING");
+        return;
+    }
+
+    // ffprobe只读取容器头部，很快返回
+    QVector<AudioTrack> tracks;
+    QString error;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    const bool probed = probeAudioTracks(currentAudioFile, tracks, &error);
+    QApplication::restoreOverrideCursor();
+    if (!probed) {
+        logMessage(QString("无法读取音轨: %1").arg(error), "ERROR");
+        return;
+    }
+    if (tracks.isEmpty()) {
+        QMessageBox::information(this, tr("识别多条音轨"), tr("当前文件中没有音轨"));
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("识别多条音轨"));
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    layout->addWidget(new QLabel(tr("选择要识别的音轨。文件只读取一遍，各音轨同时识别；\n"
+                                    "第一条选中的音轨显示在字幕列表中，每条音轨另存为单独的字幕文件。"), &dialog));
+    QListWidget *trackList = new QListWidget(&dialog);
+    for (const AudioTrack &track : tracks) {
+        QListWidgetItem *item = new QListWidgetItem(track.label(), trackList);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Checked);
+    }
+    layout->addWidget(trackList);
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addWidget(buttons);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    QVector<AudioTrack> selected;
+    for (int i = 0; i < trackList->count(); ++i) {
+        if (trackList->item(i)->checkState() == Qt::Checked) {
+            selected.append(tracks.at(i));
+        }
+    }
+    if (selected.isEmpty()) {
+        return;
+    }
+
+    // 第一条音轨的片段实时插入列表，结束后由onSegmentsRecognized替换为最终结果
+    currentSegments.clear();
+    m_transcriptModel->clear();
+    m_pendingGaps.clear();
+    isRecognitionInProgress = true;
+    ui->startRecognitionButton->setEnabled(false);
+    ui->recognitionProgressBar->setValue(0);
+    ui->statusLabel->setText(tr("正在识别%1条音轨...").arg(selected.size()));
+    logMessage(QString("开始识别%1条音轨: %2").arg(selected.size()).arg(currentAudioFile), "INFO");
+
+    m_speechRecognizer->recognizeTracks(currentAudioFile, selected);
+}
+
+void MainWindow::onTrackSegmentsRecognized(const QString &mediaFilePath, const AudioTrack &track,
+                                           const QVector<TranscriptSegment> &segments)
+{
+    // 与当前显示的文件无关，用户切换文件后仍然保存
+    const QString path = trackTranscriptPath(mediaFilePath, track);
+    QString error;
+    if (!MappedTranscript::write(path, segments, &error, MappedTranscript::sourceKeyFor(mediaFilePath))) {
+        logMessage(QString("无法写入音轨字幕 %1: %2").arg(path).arg(error), "WARNING");
+        return;
+    }
+    logMessage(QString("音轨%1识别完成（%2个片段）: %3").arg(track.label()).arg(segments.size()).arg(path), "SUCCESS");
+}
 
 void MainWindow::onRecognitionFinished(const QString &text)
 {
-    // 保存识别结果
-    currentSubtitle = text;
+    // 有时间戳的片段已在onSegmentsRecognized中合并，在线API只返回纯文本
+    if (currentSegments.isEmpty()) {
+        m_transcriptModel->setUntimedText(text);
+    }
+    m_untimedTranscript = currentSegments.isEmpty() ? text : QString();
     
-    // 显示识别结果
-    ui->subtitleTextEdit->setText(text);
     ui->statusLabel->setText(tr("语音识别完成！"));
     
     // 添加日志记录
@@ -332,12 +1192,26 @@ void MainWindow::onRecognitionFinished(const QString &text)
     logMessage(QString("识别文本长度: %1 字符").arg(text.length()), "INFO");
     
     // 识别完成，恢复状态标记
+    bool wasRangeRecognition = isRangeRecognition;
     isRecognitionInProgress = false;
+    isRangeRecognition = false;
     ui->startRecognitionButton->setEnabled(true);
     
     // 启用跳转到播放界面的按钮
     ui->goToPlaybackButton->setEnabled(true);
     
+    // 已有字幕的空白逐段识别，等识别线程退出后开始下一段
+    if (wasRangeRecognition && !m_pendingGaps.isEmpty()) {
+        QTimer::singleShot(0, this, [this]() { recognizeNextGap(); });
+        return;
+    }
+    
+    // 区间识别由播放界面发起，播放界面与这里共用字幕模型，已经显示了新结果
+    if (wasRangeRecognition && playbackWindow) {
+        playbackWindow->setRangeRecognitionBusy(false);
+        return;
+    }
+    
     // 显示提示信息
     showRecognitionCompletePrompt();
 }
@@ -346,24 +1220,33 @@ void MainWindow::onRecognitionError(const QString &errorMessage)
 {
     qDebug() << "语音识别错误:" << errorMessage;
     
-    // 清空字幕显示
-    ui->subtitleTextEdit->clear();
+    // 丢弃流式解码出的部分结果，恢复到上一次完整识别的字幕
+    m_transcriptModel->setSegments(currentSegments);
     
     // 检查是否是Whisper未安装的情况
     if (errorMessage.contains("Whisper executable not found")) {
-        ui->subtitleTextEdit->setPlaceholderText(tr("未找到Whisper可执行文件。请安装Whisper并在设置中配置路径。"));
         ui->statusLabel->setText(tr("未找到Whisper可执行文件"));
+        ui->statusLabel->setToolTip(tr("请安装Whisper并在设置中配置路径。"));
         qWarning() << "Whisper not found. Please install Whisper using: pip install openai-whisper";
         logMessage("未找到Whisper可执行文件", "ERROR");
     } else {
-        ui->subtitleTextEdit->setPlaceholderText(tr("语音识别失败，请检查Whisper配置"));
         ui->statusLabel->setText(tr("语音识别失败"));
+        ui->statusLabel->setToolTip(errorMessage);
         logMessage(QString("识别错误: %1").arg(errorMessage), "ERROR");
     }
     
-    // 识别出错，恢复状态标记
+    if (currentSegments.isEmpty()) {
+        updateLibraryTranscriptStatus(currentAudioFile, TranscriptStatus::Failed);
+    }
+    
+    // 识别出错，恢复状态标记，剩余的空白不再识别
     isRecognitionInProgress = false;
+    isRangeRecognition = false;
+    m_pendingGaps.clear();
     ui->startRecognitionButton->setEnabled(true);
+    if (playbackWindow) {
+        playbackWindow->setRangeRecognitionBusy(false);
+    }
 }
 
 void MainWindow::logMessage(const QString &message, const QString &level)
@@ -418,12 +1301,28 @@ void MainWindow::startSpeechRecognition()
         return;
     }
     
+    // 已有字幕时只识别字幕没有覆盖的空白，字幕完整时完全跳过识别
+    if (m_hasImportedSubtitles) {
+        m_pendingGaps = findTranscriptGaps(currentSegments, m_mediaDurationMs, kMinimumTranscriptGapMs);
+        if (m_pendingGaps.isEmpty()) {
+            logMessage("已有字幕覆盖了整个文件，跳过语音识别", "INFO");
+            ui->statusLabel->setText(tr("已有字幕覆盖了整个文件，无需语音识别"));
+            return;
+        }
+        ui->recognitionProgressBar->setValue(0);
+        recognizeNextGap();
+        return;
+    }
+    
     isRecognitionInProgress = true;
     ui->startRecognitionButton->setEnabled(false);
     ui->openButton->setEnabled(false);
     ui->recognitionProgressBar->setValue(0);
     ui->statusLabel->setText(tr("正在进行语音识别，请稍候..."));
     
+    // 整个文件的识别结果会替换全部字幕，清空列表以接收流式解码的片段
+    m_transcriptModel->clear();
+    
     logMessage("开始语音识别处理...", "INFO");
     
     // 调用语音识别器进行识别
@@ -0,0 +1,201 @@
+#include "mappedtranscript.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+
+MappedTranscript::MappedTranscript() : m_data(nullptr),
+                                       m_records(nullptr),
+                                       m_wordStartMs(nullptr),
+                                       m_wordEndMs(nullptr),
+                                       m_wordTextOffset(nullptr),
+                                       m_text(nullptr)
+{
+    std::memset(&m_header, 0, sizeof(m_header));
+}
+
+MappedTranscript::~MappedTranscript()
+{
+    close();
+}
+
+bool MappedTranscript::open(const QString &filePath, QString *error)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = m_file.errorString();
+        }
+        return false;
+    }
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize < qint64(sizeof(SegmentStoreHeader))) {
+        if (error) {
+            *error = "文件头不完整";
+        }
+        m_file.close();
+        return false;
+    }
+
+    const uchar *data = m_file.map(0, fileSize);
+    if (!data) {
+        if (error) {
+            *error = m_file.errorString();
+        }
+        m_file.close();
+        return false;
+    }
+
+    std::memcpy(&m_header, data, sizeof(m_header));
+    if (!m_header.isValid(fileSize - qint64(sizeof(m_header)), error)) {
+        m_file.unmap(const_cast<uchar *>(data));
+        m_file.close();
+        std::memset(&m_header, 0, sizeof(m_header));
+        return false;
+    }
+
+    // 各部分紧接着排列，文件头和记录的大小都是8的倍数，映射后直接按数组访问
+    const uchar *cursor = data + sizeof(m_header);
+    m_records = reinterpret_cast<const SegmentRecord *>(cursor);
+    cursor += size_t(m_header.segmentCount) * sizeof(SegmentRecord);
+    m_wordStartMs = reinterpret_cast<const qint32 *>(cursor);
+    cursor += size_t(m_header.wordCount) * sizeof(qint32);
+    m_wordEndMs = reinterpret_cast<const qint32 *>(cursor);
+    cursor += size_t(m_header.wordCount) * sizeof(qint32);
+    m_wordTextOffset = reinterpret_cast<const qint32 *>(cursor);
+    cursor += size_t(m_header.wordCount) * sizeof(qint32);
+    m_text = reinterpret_cast<const char *>(cursor);
+    m_data = data;
+    return true;
+}
+
+void MappedTranscript::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_data = nullptr;
+    m_records = nullptr;
+    m_wordStartMs = nullptr;
+    m_wordEndMs = nullptr;
+    m_wordTextOffset = nullptr;
+    m_text = nullptr;
+    std::memset(&m_header, 0, sizeof(m_header));
+}
+
+QString MappedTranscript::text(int index) const
+{
+    // 记录只在访问时检查，打开文件时不扫描全部记录
+    const SegmentRecord &segmentRecord = m_records[index];
+    if (quint64(segmentRecord.textOffset) + segmentRecord.textBytes > m_header.textBytes) {
+        return QString();
+    }
+    return QString::fromUtf8(m_text + segmentRecord.textOffset, int(segmentRecord.textBytes));
+}
+
+TranscriptWords MappedTranscript::words(int index) const
+{
+    const SegmentRecord &segmentRecord = m_records[index];
+    TranscriptWords result;
+    if (segmentRecord.wordCount == 0 || quint64(segmentRecord.firstWord) + segmentRecord.wordCount > m_header.wordCount) {
+        return result;
+    }
+    const int count = int(segmentRecord.wordCount);
+    const size_t first = segmentRecord.firstWord;
+    result.startMs.resize(count);
+    result.endMs.resize(count);
+    result.textOffset.resize(count);
+    std::memcpy(result.startMs.data(), m_wordStartMs + first, size_t(count) * sizeof(qint32));
+    std::memcpy(result.endMs.data(), m_wordEndMs + first, size_t(count) * sizeof(qint32));
+    std::memcpy(result.textOffset.data(), m_wordTextOffset + first, size_t(count) * sizeof(qint32));
+    return result;
+}
+
+TranscriptSegment MappedTranscript::segment(int index) const
+{
+    TranscriptSegment result;
+    result.startMs = m_records[index].startMs;
+    result.endMs = m_records[index].endMs;
+    result.text = text(index);
+    result.words = words(index);
+    return result;
+}
+
+int MappedTranscript::firstSegmentFrom(qint64 timeMs) const
+{
+    const SegmentRecord *end = m_records + size();
+    const SegmentRecord *after = std::upper_bound(m_records, end, timeMs, [](qint64 time, const SegmentRecord &record) {
+        return time < record.startMs;
+    });
+    int index = int(after - m_records);
+    if (index > 0 && m_records[index - 1].endMs > timeMs) {
+        --index;
+    }
+    return index;
+}
+
+QVector<TranscriptSegment> MappedTranscript::segmentsInRange(qint64 fromMs, qint64 toMs) const
+{
+    QVector<TranscriptSegment> segments;
+    for (int i = firstSegmentFrom(fromMs); i < size() && m_records[i].startMs < toMs; ++i) {
+        segments.append(segment(i));
+    }
+    return segments;
+}
+
+QVector<TranscriptSegment> MappedTranscript::toSegments() const
+{
+    QVector<TranscriptSegment> segments;
+    segments.reserve(size());
+    for (int i = 0; i < size(); ++i) {
+        segments.append(segment(i));
+    }
+    return segments;
+}
+
+bool MappedTranscript::write(const QString &filePath, const QVector<TranscriptSegment> &segments, QString *error,
+                             quint64 sourceKey)
+{
+    QVector<TranscriptSegment> sorted = segments;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const TranscriptSegment &a, const TranscriptSegment &b) {
+        return a.startMs < b.startMs;
+    });
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    if (!SegmentStore::fromSegments(sorted).writeTo(&file, sourceKey) || !file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+quint64 MappedTranscript::sourceKeyFor(const QString &mediaFilePath)
+{
+    // 文件不存在时canonicalFilePath为空，退回到绝对路径
+    const QFileInfo info(mediaFilePath);
+    const QString path = info.canonicalFilePath().isEmpty() ? QDir::cleanPath(info.absoluteFilePath())
+                                                            : info.canonicalFilePath();
+    const QByteArray digest = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Sha1);
+    quint64 key = 0;
+    for (int i = 0; i < 8; ++i) {
+        key = (key << 8) | quint8(digest.at(i));
+    }
+    return key != 0 ? key : 1;
+}
@@ -0,0 +1,771 @@
+#include "medialibrary.h"
+
+#include <QAtomicInt>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QtEndian>
+#include <atomic>
+#include <vector>
+
+namespace {
+
+// ffprobe只读取容器头部，很快返回
+const int kProbeTimeoutMs = 15000;
+
+// 内容指纹在文件开头、中间、结尾各读取的字节数
+const qint64 kHashChunkBytes = 64 * 1024;
+
+// 计算指纹的线程数上限：主要是磁盘读取和ffprobe子进程，线程再多也快不了
+const int kMaxScanThreads = 8;
+
+const int kSchemaVersion = 1;
+
+const char *const kMediaExtensions[] = { "mp4", "mkv", "webm", "mov", "avi", "m4v", "wmv", "flv", "ts",
+                                         "mp3", "m4a", "aac", "wav", "flac", "ogg", "opus", "wma" };
+
+// entries和entry读取的列，顺序与readEntry一致
+const char kEntryColumns[] = "id, path, size, modified_ms, content_hash, duration_ms, container, video_codec, "
+                             "audio_codec, width, height, sample_rate, channels, transcript_status, transcript_path";
+
+QAtomicInt g_connectionSerial;
+
+bool failWith(QString *error, const QString &reason)
+{
+    if (error) {
+        *error = reason;
+    }
+    return false;
+}
+
+bool failWith(QString *error, const QSqlError &sqlError)
+{
+    return failWith(error, sqlError.text());
+}
+
+/**
+ * @brief 目录下所有路径的范围[lower, upper)：SQLite按字节比较文本，'0'紧跟在'/'之后，可以用上path的唯一索引
+ */
+void folderRange(const QString &folder, QString &lower, QString &upper)
+{
+    QString prefix = QDir::cleanPath(folder);
+    if (!prefix.endsWith('/')) {
+        prefix += '/';
+    }
+    lower = prefix;
+    upper = prefix;
+    upper[upper.size() - 1] = QLatin1Char('0');
+}
+
+bool isUnder(const QString &path, const QString &folder)
+{
+    QString lower;
+    QString upper;
+    folderRange(folder, lower, upper);
+    return path.startsWith(lower);
+}
+
+QString newConnectionName()
+{
+    return QString("medialibrary-%1").arg(g_connectionSerial.fetchAndAddRelaxed(1));
+}
+
+bool openConnection(const QString &connectionName, const QString &databasePath, QString *error)
+{
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(databasePath);
+        // 扫描线程提交事务时界面线程的写入等待而不是失败
+        database.setConnectOptions("QSQLITE_BUSY_TIMEOUT=10000");
+        if (database.open()) {
+            QSqlQuery query(database);
+            query.exec("PRAGMA journal_mode=WAL");
+            query.exec("PRAGMA synchronous=NORMAL");
+            return true;
+        }
+        failWith(error, database.lastError());
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return false;
+}
+
+void closeConnection(const QString &connectionName)
+{
+    {
+        QSqlDatabase database = QSqlDatabase::database(connectionName, false);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+/**
+ * @brief 扫描期间使用的独立连接，离开作用域时关闭
+ */
+class ScopedConnection
+{
+public:
+    ScopedConnection() : m_name(newConnectionName()), m_open(false) {}
+    ~ScopedConnection()
+    {
+        if (m_open) {
+            closeConnection(m_name);
+        }
+    }
+
+    bool open(const QString &databasePath, QString *error)
+    {
+        m_open = openConnection(m_name, databasePath, error);
+        return m_open;
+    }
+
+    QSqlDatabase database() const { return QSqlDatabase::database(m_name, false); }
+
+private:
+    QString m_name;
+    bool m_open;
+};
+
+bool createSchema(QSqlDatabase database, QString *error)
+{
+    const char *const statements[] = {
+        "CREATE TABLE IF NOT EXISTS media ("
+        " id INTEGER PRIMARY KEY,"
+        " path TEXT NOT NULL UNIQUE,"
+        " size INTEGER NOT NULL,"
+        " modified_ms INTEGER NOT NULL,"
+        " content_hash BLOB,"
+        " duration_ms INTEGER NOT NULL DEFAULT -1,"
+        " container TEXT,"
+        " video_codec TEXT,"
+        " audio_codec TEXT,"
+        " width INTEGER NOT NULL DEFAULT 0,"
+        " height INTEGER NOT NULL DEFAULT 0,"
+        " sample_rate INTEGER NOT NULL DEFAULT 0,"
+        " channels INTEGER NOT NULL DEFAULT 0,"
+        " transcript_status INTEGER NOT NULL DEFAULT 0,"
+        " transcript_path TEXT,"
+        " scanned_at INTEGER NOT NULL DEFAULT 0)",
+        "CREATE INDEX IF NOT EXISTS media_content_hash ON media(content_hash)",
+        "CREATE TABLE IF NOT EXISTS folders (path TEXT PRIMARY KEY, last_scan INTEGER NOT NULL DEFAULT 0)",
+    };
+    QSqlQuery query(database);
+    if (!query.exec("PRAGMA user_version") || !query.next()) {
+        return failWith(error, query.lastError());
+    }
+    const int version = query.value(0).toInt();
+    if (version > kSchemaVersion) {
+        return failWith(error, QString("媒体库数据库版本%1高于程序支持的版本%2").arg(version).arg(kSchemaVersion));
+    }
+    for (const char *statement : statements) {
+        if (!query.exec(statement)) {
+            return failWith(error, query.lastError());
+        }
+    }
+    if (!query.exec(QString("PRAGMA user_version = %1").arg(kSchemaVersion))) {
+        return failWith(error, query.lastError());
+    }
+    return true;
+}
+
+MediaLibraryEntry readEntry(const QSqlQuery &query)
+{
+    MediaLibraryEntry entry;
+    entry.id = query.value(0).toLongLong();
+    entry.path = query.value(1).toString();
+    entry.size = query.value(2).toLongLong();
+    entry.modifiedMs = query.value(3).toLongLong();
+    entry.contentHash = query.value(4).toByteArray();
+    entry.probe.durationMs = query.value(5).toLongLong();
+    entry.probe.container = query.value(6).toString();
+    entry.probe.videoCodec = query.value(7).toString();
+    entry.probe.audioCodec = query.value(8).toString();
+    entry.probe.width = query.value(9).toInt();
+    entry.probe.height = query.value(10).toInt();
+    entry.probe.sampleRate = query.value(11).toInt();
+    entry.probe.channels = query.value(12).toInt();
+    entry.transcriptStatus = TranscriptStatus(query.value(13).toInt());
+    entry.transcriptPath = query.value(14).toString();
+    return entry;
+}
+
+void bindProbe(QSqlQuery &query, const MediaProbe &probe)
+{
+    query.bindValue(":duration_ms", probe.durationMs);
+    query.bindValue(":container", probe.container);
+    query.bindValue(":video_codec", probe.videoCodec);
+    query.bindValue(":audio_codec", probe.audioCodec);
+    query.bindValue(":width", probe.width);
+    query.bindValue(":height", probe.height);
+    query.bindValue(":sample_rate", probe.sampleRate);
+    query.bindValue(":channels", probe.channels);
+}
+
+/**
+ * @brief 目录中的一个媒体文件
+ */
+struct FileState
+{
+    QString path;
+    qint64 size = 0;
+    qint64 modifiedMs = 0;
+};
+
+/**
+ * @brief 媒体库中已有的一行
+ */
+struct KnownFile
+{
+    qint64 id = 0;
+    qint64 size = 0;
+    qint64 modifiedMs = 0;
+    QByteArray contentHash;
+};
+
+/**
+ * @brief 需要计算指纹的文件及其处理结果
+ */
+struct ScanWork
+{
+    enum Outcome { Touched, Moved, Changed };
+
+    FileState file;
+    qint64 knownId = 0;           ///< 同一路径已有的行，新文件为0
+    QByteArray knownHash;
+    QByteArray contentHash;
+    Outcome outcome = Changed;
+    bool probed = false;
+    bool probeOk = false;
+    MediaProbe probe;
+};
+
+} // namespace
+
+bool probeMedia(const QString &mediaFilePath, MediaProbe &probe, QString *error)
+{
+    probe = MediaProbe();
+
+    QProcess ffprobe;
+    ffprobe.start("ffprobe", QStringList() << "-v" << "error"
+                  << "-show_entries" << "format=duration,format_name:stream=codec_type,codec_name,width,height,sample_rate,channels"
+                  << "-of" << "json" << mediaFilePath);
+    if (!ffprobe.waitForStarted(2000)) {
+        return failWith(error, "无法启动ffprobe");
+    }
+    if (!ffprobe.waitForFinished(kProbeTimeoutMs)) {
+        ffprobe.kill();
+        ffprobe.waitForFinished(1000);
+        return failWith(error, "ffprobe超时");
+    }
+    if (ffprobe.exitStatus() != QProcess::NormalExit || ffprobe.exitCode() != 0) {
+        return failWith(error, QString("ffprobe失败: %1").arg(QString::fromUtf8(ffprobe.readAllStandardError()).left(200)));
+    }
+
+    const QJsonObject root = QJsonDocument::fromJson(ffprobe.readAllStandardOutput()).object();
+    const QJsonObject format = root.value("format").toObject();
+    bool ok = false;
+    const double seconds = format.value("duration").toString().toDouble(&ok);
+    if (ok) {
+        probe.durationMs = qint64(seconds * 1000.0);
+    }
+    probe.container = format.value("format_name").toString();
+
+    for (const QJsonValue &value : root.value("streams").toArray()) {
+        const QJsonObject stream = value.toObject();
+        const QString type = stream.value("codec_type").toString();
+        if (type == "video" && probe.videoCodec.isEmpty()) {
+            probe.videoCodec = stream.value("codec_name").toString();
+            probe.width = stream.value("width").toInt();
+            probe.height = stream.value("height").toInt();
+        } else if (type == "audio" && probe.audioCodec.isEmpty()) {
+            probe.audioCodec = stream.value("codec_name").toString();
+            probe.sampleRate = stream.value("sample_rate").toString().toInt();
+            probe.channels = stream.value("channels").toInt();
+        }
+    }
+    return true;
+}
+
+QByteArray mediaContentHash(const QString &mediaFilePath)
+{
+    QFile file(mediaFilePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    const qint64 size = file.size();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    uchar sizeBytes[8];
+    qToLittleEndian<quint64>(quint64(size), sizeBytes);
+    hash.addData(reinterpret_cast<const char *>(sizeBytes), sizeof(sizeBytes));
+
+    if (size <= 3 * kHashChunkBytes) {
+        if (!hash.addData(&file)) {
+            return QByteArray();
+        }
+        return hash.result();
+    }
+    const qint64 offsets[] = { 0, size / 2 - kHashChunkBytes / 2, size - kHashChunkBytes };
+    for (qint64 offset : offsets) {
+        if (!file.seek(offset)) {
+            return QByteArray();
+        }
+        const QByteArray chunk = file.read(kHashChunkBytes);
+        if (chunk.size() != kHashChunkBytes) {
+            return QByteArray();
+        }
+        hash.addData(chunk);
+    }
+    return hash.result();
+}
+
+MediaLibrary::MediaLibrary()
+{
+}
+
+MediaLibrary::~MediaLibrary()
+{
+    if (!m_connectionName.isEmpty()) {
+        closeConnection(m_connectionName);
+    }
+}
+
+bool MediaLibrary::open(const QString &databasePath, QString *error)
+{
+    if (!m_connectionName.isEmpty()) {
+        closeConnection(m_connectionName);
+        m_connectionName.clear();
+        m_databasePath.clear();
+    }
+
+    const QFileInfo info(databasePath);
+    if (!QDir().mkpath(info.absolutePath())) {
+        return failWith(error, "无法创建目录: " + info.absolutePath());
+    }
+    const QString connectionName = newConnectionName();
+    if (!openConnection(connectionName, info.absoluteFilePath(), error)) {
+        return false;
+    }
+    if (!createSchema(QSqlDatabase::database(connectionName, false), error)) {
+        closeConnection(connectionName);
+        return false;
+    }
+    m_connectionName = connectionName;
+    m_databasePath = info.absoluteFilePath();
+    return true;
+}
+
+bool MediaLibrary::isOpen() const
+{
+    return !m_connectionName.isEmpty();
+}
+
+QString MediaLibrary::databasePath() const
+{
+    return m_databasePath;
+}
+
+bool MediaLibrary::scan(const QString &folder, MediaScanStats &stats, QString *error,
+                        const ProgressCallback &progress, const std::atomic<bool> *cancelled) const
+{
+    stats = MediaScanStats();
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!isOpen()) {
+        return failWith(error, "媒体库未打开");
+    }
+    const QString root = QDir::cleanPath(QFileInfo(folder).absoluteFilePath());
+    if (!QFileInfo(root).isDir()) {
+        // 目录不存在（例如移动硬盘未连接）时不能把其中的文件当作已删除
+        return failWith(error, "目录不存在: " + root);
+    }
+
+    ScopedConnection connection;
+    if (!connection.open(m_databasePath, error)) {
+        return false;
+    }
+    QSqlDatabase database = connection.database();
+
+    // 1. 列出目录中的媒体文件，只读取目录项的大小和修改时间
+    std::vector<FileState> files;
+    QDirIterator dirIterator(root, mediaNameFilters(), QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+    while (dirIterator.hasNext()) {
+        if (cancelled && *cancelled) {
+            return failWith(error, "扫描已取消");
+        }
+        dirIterator.next();
+        const QFileInfo info = dirIterator.fileInfo();
+        FileState file;
+        file.path = info.absoluteFilePath();
+        file.size = info.size();
+        file.modifiedMs = info.lastModified().toMSecsSinceEpoch();
+        files.push_back(file);
+    }
+    stats.filesSeen = int(files.size());
+
+    // 2. 媒体库中该目录下已有的文件
+    QString lower;
+    QString upper;
+    folderRange(root, lower, upper);
+    QHash<QString, KnownFile> known;
+    {
+        QSqlQuery query(database);
+        query.prepare("SELECT id, path, size, modified_ms, content_hash FROM media WHERE path >= ? AND path < ?");
+        query.addBindValue(lower);
+        query.addBindValue(upper);
+        if (!query.exec()) {
+            return failWith(error, query.lastError());
+        }
+        while (query.next()) {
+            KnownFile row;
+            row.id = query.value(0).toLongLong();
+            row.size = query.value(2).toLongLong();
+            row.modifiedMs = query.value(3).toLongLong();
+            row.contentHash = query.value(4).toByteArray();
+            known.insert(query.value(1).toString(), row);
+        }
+    }
+
+    // 3. 大小和修改时间都没变的文件直接跳过，其余的需要计算指纹；剩下的已知文件在目录中消失了
+    std::vector<ScanWork> work;
+    for (const FileState &file : files) {
+        const auto found = known.find(file.path);
+        if (found != known.end()) {
+            const KnownFile row = found.value();
+            known.erase(found);
+            if (row.size == file.size && row.modifiedMs == file.modifiedMs) {
+                ++stats.unchanged;
+                continue;
+            }
+            ScanWork item;
+            item.file = file;
+            item.knownId = row.id;
+            item.knownHash = row.contentHash;
+            work.push_back(item);
+        } else {
+            ScanWork item;
+            item.file = file;
+            work.push_back(item);
+        }
+    }
+    files.clear();
+    QHash<QByteArray, QString> vanishedByHash;
+    for (auto it = known.cbegin(); it != known.cend(); ++it) {
+        if (!it.value().contentHash.isEmpty()) {
+            vanishedByHash.insert(it.value().contentHash, it.key());
+        }
+    }
+
+    // 4. 多个线程并行计算指纹，内容变化的新文件再运行ffprobe
+    const int total = int(work.size());
+    std::atomic<int> next(0);
+    std::atomic<int> done(0);
+    QMutex progressMutex;
+    const auto worker = [&]() {
+        for (int i = next++; i < total; i = next++) {
+            if (cancelled && *cancelled) {
+                break;
+            }
+            ScanWork &item = work[size_t(i)];
+            item.contentHash = mediaContentHash(item.file.path);
+            if (item.knownId != 0 && !item.contentHash.isEmpty() && item.contentHash == item.knownHash) {
+                item.outcome = ScanWork::Touched;
+            } else if (item.knownId == 0 && vanishedByHash.contains(item.contentHash)) {
+                item.outcome = ScanWork::Moved;
+            } else {
+                item.outcome = ScanWork::Changed;
+                item.probed = true;
+                item.probeOk = probeMedia(item.file.path, item.probe);
+            }
+            const int finished = ++done;
+            if (progress) {
+                QMutexLocker locker(&progressMutex);
+                progress(finished, total);
+            }
+        }
+    };
+    const int threadCount = qBound(1, qMin(QThread::idealThreadCount(), kMaxScanThreads), qMax(1, total));
+    QVector<QThread *> threads;
+    for (int i = 1; i < threadCount; ++i) {
+        QThread *thread = QThread::create(worker);
+        thread->setObjectName("MediaScan");
+        thread->start();
+        threads.append(thread);
+    }
+    worker();
+    for (QThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+    if (cancelled && *cancelled) {
+        return failWith(error, "扫描已取消");
+    }
+
+    // 5. 在一个事务中写入结果
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (!database.transaction()) {
+        return failWith(error, database.lastError());
+    }
+    QSqlQuery touch(database);
+    QSqlQuery move(database);
+    QSqlQuery change(database);
+    QSqlQuery insert(database);
+    QSqlQuery remove(database);
+    touch.prepare("UPDATE media SET size = :size, modified_ms = :modified_ms, scanned_at = :scanned_at WHERE id = :id");
+    move.prepare("UPDATE media SET path = :path, size = :size, modified_ms = :modified_ms, scanned_at = :scanned_at "
+                 "WHERE id = :id");
+    // 内容变了，旧字幕不再对应这个文件
+    change.prepare("UPDATE media SET size = :size, modified_ms = :modified_ms, content_hash = :content_hash, "
+                   "duration_ms = :duration_ms, container = :container, video_codec = :video_codec, "
+                   "audio_codec = :audio_codec, width = :width, height = :height, sample_rate = :sample_rate, "
+                   "channels = :channels, transcript_status = 0, transcript_path = NULL, scanned_at = :scanned_at "
+                   "WHERE id = :id");
+    insert.prepare("INSERT INTO media (path, size, modified_ms, content_hash, duration_ms, container, video_codec, "
+                   "audio_codec, width, height, sample_rate, channels, scanned_at) VALUES (:path, :size, :modified_ms, "
+                   ":content_hash, :duration_ms, :container, :video_codec, :audio_codec, :width, :height, "
+                   ":sample_rate, :channels, :scanned_at)");
+    remove.prepare("DELETE FROM media WHERE id = ?");
+
+    bool ok = true;
+    for (ScanWork &item : work) {
+        if (!ok) {
+            break;
+        }
+        if (item.outcome == ScanWork::Moved) {
+            // 同一内容的多个副本只有第一个继承消失文件的记录，其余的作为新文件
+            const QString movedFrom = vanishedByHash.take(item.contentHash);
+            if (!movedFrom.isEmpty()) {
+                move.bindValue(":path", item.file.path);
+                move.bindValue(":size", item.file.size);
+                move.bindValue(":modified_ms", item.file.modifiedMs);
+                move.bindValue(":scanned_at", now);
+                move.bindValue(":id", known.take(movedFrom).id);
+                ok = move.exec();
+                ++stats.moved;
+                continue;
+            }
+            item.probed = true;
+            item.probeOk = probeMedia(item.file.path, item.probe);
+        }
+        if (item.outcome == ScanWork::Touched) {
+            touch.bindValue(":size", item.file.size);
+            touch.bindValue(":modified_ms", item.file.modifiedMs);
+            touch.bindValue(":scanned_at", now);
+            touch.bindValue(":id", item.knownId);
+            ok = touch.exec();
+            ++stats.touched;
+            continue;
+        }
+        if (item.probed && !item.probeOk) {
+            ++stats.probeFailures;
+        }
+        QSqlQuery &query = item.knownId != 0 ? change : insert;
+        if (item.knownId != 0) {
+            query.bindValue(":id", item.knownId);
+            ++stats.updated;
+        } else {
+            query.bindValue(":path", item.file.path);
+            ++stats.added;
+        }
+        query.bindValue(":size", item.file.size);
+        query.bindValue(":modified_ms", item.file.modifiedMs);
+        query.bindValue(":content_hash", item.contentHash);
+        query.bindValue(":scanned_at", now);
+        bindProbe(query, item.probe);
+        ok = query.exec();
+    }
+    for (auto it = known.cbegin(); ok && it != known.cend(); ++it) {
+        remove.bindValue(0, it.value().id);
+        ok = remove.exec();
+        ++stats.removed;
+    }
+    QSqlQuery folderQuery(database);
+    if (ok) {
+        folderQuery.prepare("INSERT OR REPLACE INTO folders (path, last_scan) VALUES (?, ?)");
+        folderQuery.addBindValue(root);
+        folderQuery.addBindValue(now);
+        ok = folderQuery.exec();
+    }
+    if (!ok) {
+        QString reason;
+        for (const QSqlQuery *query : { &touch, &move, &change, &insert, &remove, &folderQuery }) {
+            if (query->lastError().isValid()) {
+                reason = query->lastError().text();
+            }
+        }
+        database.rollback();
+        return failWith(error, reason);
+    }
+    if (!database.commit()) {
+        return failWith(error, database.lastError());
+    }
+
+    stats.elapsedMs = timer.elapsed();
+    return true;
+}
+
+QStringList MediaLibrary::folders() const
+{
+    QStringList result;
+    if (!isOpen()) {
+        return result;
+    }
+    QSqlQuery query("SELECT path FROM folders ORDER BY path", QSqlDatabase::database(m_connectionName, false));
+    while (query.next()) {
+        result << query.value(0).toString();
+    }
+    return result;
+}
+
+bool MediaLibrary::removeFolder(const QString &folder, QString *error)
+{
+    if (!isOpen()) {
+        return failWith(error, "媒体库未打开");
+    }
+    const QString root = QDir::cleanPath(QFileInfo(folder).absoluteFilePath());
+    QSqlDatabase database = QSqlDatabase::database(m_connectionName, false);
+
+    // 仍在其他目录下的文件保留：祖先目录还在时一个都不删，子目录中的文件不删
+    QStringList keptFolders;
+    for (const QString &other : folders()) {
+        if (other == root) {
+            continue;
+        }
+        if (isUnder(root, other)) {
+            keptFolders.clear();
+            keptFolders << other;
+            break;
+        }
+        if (isUnder(other, root)) {
+            keptFolders << other;
+        }
+    }
+    const bool ancestorKept = keptFolders.size() == 1 && isUnder(root, keptFolders.first());
+
+    if (!database.transaction()) {
+        return failWith(error, database.lastError());
+    }
+    QSqlQuery query(database);
+    query.prepare("DELETE FROM folders WHERE path = ?");
+    query.addBindValue(root);
+    bool ok = query.exec();
+    if (ok && !ancestorKept) {
+        QString sql = "DELETE FROM media WHERE path >= ? AND path < ?";
+        for (int i = 0; i < keptFolders.size(); ++i) {
+            sql += " AND NOT (path >= ? AND path < ?)";
+        }
+        query.prepare(sql);
+        QString lower;
+        QString upper;
+        folderRange(root, lower, upper);
+        query.addBindValue(lower);
+        query.addBindValue(upper);
+        for (const QString &kept : keptFolders) {
+            folderRange(kept, lower, upper);
+            query.addBindValue(lower);
+            query.addBindValue(upper);
+        }
+        ok = query.exec();
+    }
+    if (!ok) {
+        const QSqlError sqlError = query.lastError();
+        database.rollback();
+        return failWith(error, sqlError);
+    }
+    if (!database.commit()) {
+        return failWith(error, database.lastError());
+    }
+    return true;
+}
+
+QVector<MediaLibraryEntry> MediaLibrary::entries(const QString &filter) const
+{
+    QVector<MediaLibraryEntry> result;
+    if (!isOpen()) {
+        return result;
+    }
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    if (filter.isEmpty()) {
+        query.prepare(QString("SELECT %1 FROM media ORDER BY path").arg(kEntryColumns));
+    } else {
+        QString pattern = filter;
+        pattern.replace('\\', "\\\\").replace('%', "\\%").replace('_', "\\_");
+        query.prepare(QString("SELECT %1 FROM media WHERE path LIKE ? ESCAPE '\\' ORDER BY path").arg(kEntryColumns));
+        query.addBindValue('%' + pattern + '%');
+    }
+    if (!query.exec()) {
+        qWarning() << "[MediaLibrary] 查询失败:" << query.lastError().text();
+        return result;
+    }
+    while (query.next()) {
+        result.append(readEntry(query));
+    }
+    return result;
+}
+
+bool MediaLibrary::entry(const QString &mediaFilePath, MediaLibraryEntry &result) const
+{
+    if (!isOpen()) {
+        return false;
+    }
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.prepare(QString("SELECT %1 FROM media WHERE path = ?").arg(kEntryColumns));
+    query.addBindValue(QFileInfo(mediaFilePath).absoluteFilePath());
+    if (!query.exec() || !query.next()) {
+        return false;
+    }
+    result = readEntry(query);
+    return true;
+}
+
+bool MediaLibrary::setTranscriptStatus(const QString &mediaFilePath, TranscriptStatus status,
+                                       const QString &transcriptPath, QString *error)
+{
+    if (!isOpen()) {
+        return failWith(error, "媒体库未打开");
+    }
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.prepare("UPDATE media SET transcript_status = ?, transcript_path = ? WHERE path = ?");
+    query.addBindValue(int(status));
+    query.addBindValue(transcriptPath.isEmpty() ? QVariant(QVariant::String) : QVariant(transcriptPath));
+    query.addBindValue(QFileInfo(mediaFilePath).absoluteFilePath());
+    if (!query.exec()) {
+        return failWith(error, query.lastError());
+    }
+    return true;
+}
+
+int MediaLibrary::size() const
+{
+    if (!isOpen()) {
+        return 0;
+    }
+    QSqlQuery query("SELECT COUNT(*) FROM media", QSqlDatabase::database(m_connectionName, false));
+    return query.next() ? query.value(0).toInt() : 0;
+}
+
+QStringList MediaLibrary::mediaNameFilters()
+{
+    QStringList filters;
+    for (const char *extension : kMediaExtensions) {
+        filters << QString("*.%1").arg(QLatin1String(extension));
+    }
+    return filters;
+}
@@ -0,0 +1,249 @@
+#include "medialibrarywidget.h"
+#include "medialibrary.h"
+#include "transcript.h"
+
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QThread>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+// 过滤输入停顿多久后刷新列表
+const int kFilterDelayMs = 200;
+
+// 每处理多少个文件向界面报告一次进度
+const int kProgressStep = 25;
+
+// 结果项中保存媒体文件路径的数据角色
+const int kMediaFileRole = Qt::UserRole;
+
+QString formatSize(qint64 bytes)
+{
+    if (bytes >= 1024LL * 1024 * 1024) {
+        return QString::number(bytes / (1024.0 * 1024.0 * 1024.0), 'f', 2) + " GB";
+    }
+    return QString::number(bytes / (1024.0 * 1024.0), 'f', 1) + " MB";
+}
+
+QString transcriptStatusText(TranscriptStatus status)
+{
+    switch (status) {
+    case TranscriptStatus::Transcribed:
+        return QObject::tr("已识别");
+    case TranscriptStatus::Failed:
+        return QObject::tr("识别失败");
+    case TranscriptStatus::None:
+        break;
+    }
+    return QObject::tr("未识别");
+}
+
+void accumulate(MediaScanStats &total, const MediaScanStats &stats)
+{
+    total.filesSeen += stats.filesSeen;
+    total.unchanged += stats.unchanged;
+    total.touched += stats.touched;
+    total.added += stats.added;
+    total.updated += stats.updated;
+    total.moved += stats.moved;
+    total.removed += stats.removed;
+    total.probeFailures += stats.probeFailures;
+}
+
+} // namespace
+
+MediaLibraryWidget::MediaLibraryWidget(const QSharedPointer<MediaLibrary> &library, QWidget *parent) : QWidget(parent),
+                                                                                                    m_library(library),
+                                                                                                    m_scanning(false),
+                                                                                                    m_scanThread(nullptr),
+                                                                                                    m_cancelScan(false)
+{
+    m_filterEdit = new QLineEdit;
+    m_filterEdit->setPlaceholderText(tr("按文件名或路径过滤"));
+    m_filterEdit->setClearButtonEnabled(true);
+    m_addButton = new QPushButton(tr("添加文件夹..."));
+    m_rescanButton = new QPushButton(tr("重新扫描"));
+
+    QHBoxLayout *toolLayout = new QHBoxLayout;
+    toolLayout->addWidget(m_filterEdit, 1);
+    toolLayout->addWidget(m_addButton);
+    toolLayout->addWidget(m_rescanButton);
+
+    m_fileTree = new QTreeWidget;
+    m_fileTree->setColumnCount(5);
+    m_fileTree->setHeaderLabels(QStringList() << tr("文件") << tr("时长") << tr("大小") << tr("字幕") << tr("目录"));
+    m_fileTree->setRootIsDecorated(false);
+    m_fileTree->setUniformRowHeights(true);
+    m_fileTree->header()->setSectionResizeMode(4, QHeaderView::Stretch);
+
+    m_statusLabel = new QLabel;
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(toolLayout);
+    layout->addWidget(m_fileTree, 1);
+    layout->addWidget(m_statusLabel);
+
+    m_filterTimer.setSingleShot(true);
+    m_filterTimer.setInterval(kFilterDelayMs);
+    connect(&m_filterTimer, &QTimer::timeout, this, &MediaLibraryWidget::refresh);
+    connect(m_filterEdit, &QLineEdit::textChanged, &m_filterTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_addButton, &QPushButton::clicked, this, &MediaLibraryWidget::addFolder);
+    connect(m_rescanButton, &QPushButton::clicked, this, &MediaLibraryWidget::rescanAll);
+    connect(m_fileTree, &QTreeWidget::itemActivated, this, &MediaLibraryWidget::onItemActivated);
+}
+
+MediaLibraryWidget::~MediaLibraryWidget()
+{
+    // 扫描线程通过invokeMethod向本对象投递进度，必须在对象销毁前结束；取消后不写入数据库，很快返回
+    if (m_scanThread) {
+        m_cancelScan = true;
+        m_scanThread->wait();
+        delete m_scanThread;
+    }
+}
+
+bool MediaLibraryWidget::isScanning() const
+{
+    return m_scanning;
+}
+
+void MediaLibraryWidget::rescanAll()
+{
+    const QStringList folders = m_library->folders();
+    if (!folders.isEmpty()) {
+        startScan(folders);
+    }
+}
+
+void MediaLibraryWidget::refresh()
+{
+    m_filterTimer.stop();
+    const QVector<MediaLibraryEntry> entries = m_library->entries(m_filterEdit->text().trimmed());
+
+    QList<QTreeWidgetItem *> items;
+    items.reserve(entries.size());
+    for (const MediaLibraryEntry &entry : entries) {
+        const QFileInfo info(entry.path);
+        QTreeWidgetItem *item = new QTreeWidgetItem;
+        item->setText(0, info.fileName());
+        item->setToolTip(0, entry.path);
+        item->setText(1, entry.probe.durationMs >= 0 ? formatTranscriptTimestamp(entry.probe.durationMs) : QString("—"));
+        item->setText(2, formatSize(entry.size));
+        item->setText(3, transcriptStatusText(entry.transcriptStatus));
+        item->setText(4, QDir::toNativeSeparators(info.path()));
+        item->setData(0, kMediaFileRole, entry.path);
+        items.append(item);
+    }
+    m_fileTree->clear();
+    m_fileTree->addTopLevelItems(items);
+    m_fileTree->resizeColumnToContents(0);
+
+    if (!m_scanning) {
+        m_statusLabel->setText(tr("%1个文件，%2个目录").arg(entries.size()).arg(m_library->folders().size()));
+    }
+}
+
+void MediaLibraryWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    // 字幕状态由主窗口在识别完成时更新，显示时重新读取
+    refresh();
+}
+
+void MediaLibraryWidget::addFolder()
+{
+    const QString folder = QFileDialog::getExistingDirectory(this, tr("添加媒体文件夹"));
+    if (!folder.isEmpty()) {
+        startScan(QStringList() << folder);
+    }
+}
+
+void MediaLibraryWidget::onItemActivated(QTreeWidgetItem *item, int column)
+{
+    Q_UNUSED(column);
+    emit mediaActivated(item->data(0, kMediaFileRole).toString());
+}
+
+void MediaLibraryWidget::startScan(const QStringList &folders)
+{
+    if (m_scanning) {
+        return;
+    }
+    m_scanning = true;
+    m_addButton->setEnabled(false);
+    m_rescanButton->setEnabled(false);
+    m_statusLabel->setText(tr("正在扫描..."));
+
+    // 线程持有媒体库的引用；进度按步长报告，避免几万个文件时事件队列被进度消息占满。
+    // 析构函数取消并等待扫描线程，线程投递给本对象的事件不会在对象销毁后执行
+    const QSharedPointer<MediaLibrary> library = m_library;
+    struct ScanResult
+    {
+        MediaScanStats total;
+        QStringList errors;
+    };
+    QSharedPointer<ScanResult> result(new ScanResult);
+    m_cancelScan = false;
+    m_scanThread = QThread::create([this, library, folders, result]() {
+        for (const QString &folder : folders) {
+            if (m_cancelScan) {
+                break;
+            }
+            MediaScanStats stats;
+            QString error;
+            const bool ok = library->scan(folder, stats, &error, [this](int done, int count) {
+                if (done == count || done % kProgressStep == 0) {
+                    QMetaObject::invokeMethod(this, [this, done, count]() { onScanProgress(done, count); });
+                }
+            }, &m_cancelScan);
+            if (!ok) {
+                result->errors << QString("%1: %2").arg(folder).arg(error);
+                continue;
+            }
+            accumulate(result->total, stats);
+            result->total.elapsedMs += stats.elapsedMs;
+        }
+    });
+    m_scanThread->setObjectName("MediaLibraryScan");
+    connect(m_scanThread, &QThread::finished, this, [this, result]() {
+        m_scanThread->deleteLater();
+        m_scanThread = nullptr;
+        onScanFinished(result->total, result->errors);
+    });
+    m_scanThread->start();
+}
+
+void MediaLibraryWidget::onScanProgress(int done, int total)
+{
+    if (m_scanning) {
+        m_statusLabel->setText(tr("正在扫描：%1/%2个新的或已修改的文件").arg(done).arg(total));
+    }
+}
+
+void MediaLibraryWidget::onScanFinished(const MediaScanStats &stats, const QStringList &errors)
+{
+    m_scanning = false;
+    m_addButton->setEnabled(true);
+    m_rescanButton->setEnabled(true);
+
+    QString summary = tr("扫描完成：%1个文件，%2个未变化，%3个新增，%4个更新，%5个移动，%6个删除，耗时%7秒")
+            .arg(stats.filesSeen).arg(stats.unchanged + stats.touched).arg(stats.added).arg(stats.updated)
+            .arg(stats.moved).arg(stats.removed).arg(stats.elapsedMs / 1000.0, 0, 'f', 1);
+    if (stats.probeFailures > 0) {
+        summary += tr("（%1个文件无法读取媒体信息）").arg(stats.probeFailures);
+    }
+    if (!errors.isEmpty()) {
+        summary += tr("；失败：%1").arg(errors.join("; "));
+    }
+    refresh();
+    m_statusLabel->setText(summary);
+    emit scanFinished(summary);
+}
@@ -0,0 +1,243 @@
+#include "metrics.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+std::atomic<unsigned> g_nextShard(0);
+
+std::string formatValue(double value)
+{
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.10g", value);
+    return buffer;
+}
+
+std::string seriesName(const std::string &name, const std::string &labels, const std::string &extraLabel = std::string())
+{
+    if (labels.empty() && extraLabel.empty()) {
+        return name;
+    }
+    std::string result = name + "{" + labels;
+    if (!labels.empty() && !extraLabel.empty()) {
+        result += ",";
+    }
+    return result + extraLabel + "}";
+}
+
+const char *typeName(int type)
+{
+    // 与MetricsRegistry::Type的顺序一致
+    static const char *const names[] = { "counter", "gauge", "gauge", "histogram" };
+    return names[type];
+}
+
+} // namespace
+
+unsigned currentMetricShard()
+{
+    static thread_local unsigned shard = g_nextShard.fetch_add(1, std::memory_order_relaxed) % kMetricShardCount;
+    return shard;
+}
+
+MetricCounter::MetricCounter()
+{
+    for (Shard &shard : m_shards) {
+        shard.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t MetricCounter::value() const
+{
+    uint64_t total = 0;
+    for (const Shard &shard : m_shards) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+MetricHistogram::MetricHistogram(const std::vector<double> &upperBounds) : m_upperBounds(upperBounds)
+{
+    std::sort(m_upperBounds.begin(), m_upperBounds.end());
+    const size_t buckets = m_upperBounds.size() + 1;
+    for (Shard &shard : m_shards) {
+        // 多分配一个缓存行，避免相邻分片的计数数组落在同一缓存行
+        shard.counts.reset(new std::atomic<uint64_t>[buckets + kMetricShardStride / sizeof(uint64_t)]);
+        for (size_t i = 0; i < buckets; ++i) {
+            shard.counts[i].store(0, std::memory_order_relaxed);
+        }
+        shard.sum.store(0.0, std::memory_order_relaxed);
+    }
+}
+
+void MetricHistogram::observe(double value)
+{
+    const size_t bucket = size_t(std::lower_bound(m_upperBounds.begin(), m_upperBounds.end(), value) - m_upperBounds.begin());
+    Shard &shard = m_shards[currentMetricShard()];
+    shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    // 原子double没有fetch_add，分片很少被其他线程共享，比较交换几乎总是一次成功
+    double expected = shard.sum.load(std::memory_order_relaxed);
+    while (!shard.sum.compare_exchange_weak(expected, expected + value, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t MetricHistogram::snapshot(std::vector<uint64_t> &bucketCounts, double &sum) const
+{
+    const size_t buckets = m_upperBounds.size() + 1;
+    bucketCounts.assign(buckets, 0);
+    sum = 0;
+    uint64_t total = 0;
+    for (const Shard &shard : m_shards) {
+        for (size_t i = 0; i < buckets; ++i) {
+            const uint64_t count = shard.counts[i].load(std::memory_order_relaxed);
+            bucketCounts[i] += count;
+            total += count;
+        }
+        sum += shard.sum.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::vector<double> MetricHistogram::durationBuckets()
+{
+    return { 0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 120, 300, 600 };
+}
+
+MetricsRegistry &MetricsRegistry::instance()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Series &MetricsRegistry::findOrAdd(const std::string &name, const std::string &help,
+                                                    const std::string &labels, Type type)
+{
+    for (const std::unique_ptr<Series> &series : m_series) {
+        if (series->name != name) {
+            continue;
+        }
+        // 同一指标族只能有一种类型，否则导出的TYPE与部分序列不符；注册为不导出的序列，返回的对象仍然可用
+        const bool familyMismatch = std::string(typeName(int(series->type))) != typeName(int(type));
+        if (familyMismatch || (series->labels == labels && series->type != type)) {
+            qWarning().noquote() << QString("[Metrics] 指标%1{%2}的类型与已注册的不同，不会导出")
+                                        .arg(QString::fromStdString(name), QString::fromStdString(labels));
+            m_rejected.emplace_back(new Series);
+            m_rejected.back()->name = name;
+            m_rejected.back()->type = type;
+            return *m_rejected.back();
+        }
+        if (series->labels == labels) {
+            return *series;
+        }
+    }
+
+    // 同一指标族的序列放在一起，导出时HELP和TYPE只输出一次
+    std::vector<std::unique_ptr<Series>>::iterator position = m_series.end();
+    for (std::vector<std::unique_ptr<Series>>::iterator it = m_series.begin(); it != m_series.end(); ++it) {
+        if ((*it)->name == name) {
+            position = it + 1;
+        }
+    }
+
+    std::unique_ptr<Series> series(new Series);
+    series->name = name;
+    series->help = help;
+    series->labels = labels;
+    series->type = type;
+    return **m_series.insert(position, std::move(series));
+}
+
+MetricCounter &MetricsRegistry::counter(const std::string &name, const std::string &help, const std::string &labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Series &series = findOrAdd(name, help, labels, Type::Counter);
+    if (!series.counter) {
+        series.counter.reset(new MetricCounter);
+    }
+    return *series.counter;
+}
+
+MetricGauge &MetricsRegistry::gauge(const std::string &name, const std::string &help, const std::string &labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Series &series = findOrAdd(name, help, labels, Type::Gauge);
+    if (!series.gauge) {
+        series.gauge.reset(new MetricGauge);
+    }
+    return *series.gauge;
+}
+
+MetricHistogram &MetricsRegistry::histogram(const std::string &name, const std::string &help,
+                                            const std::vector<double> &upperBounds, const std::string &labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Series &series = findOrAdd(name, help, labels, Type::Histogram);
+    if (!series.histogram) {
+        series.histogram.reset(new MetricHistogram(upperBounds));
+    }
+    return *series.histogram;
+}
+
+void MetricsRegistry::gaugeCallback(const std::string &name, const std::string &help,
+                                    const std::function<double()> &callback, const std::string &labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    findOrAdd(name, help, labels, Type::GaugeCallback).callback = callback;
+}
+
+std::string MetricsRegistry::renderPrometheus() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::string out;
+    std::vector<uint64_t> buckets;
+    const std::string *previousName = nullptr;
+
+    for (const std::unique_ptr<Series> &seriesPtr : m_series) {
+        const Series &series = *seriesPtr;
+        if (!previousName || *previousName != series.name) {
+            out += "# HELP " + series.name + " " + series.help + "\n";
+            out += "# TYPE " + series.name + " " + typeName(int(series.type)) + "\n";
+            previousName = &series.name;
+        }
+
+        switch (series.type) {
+        case Type::Counter:
+            out += seriesName(series.name, series.labels) + " " + std::to_string(series.counter->value()) + "\n";
+            break;
+        case Type::Gauge:
+            out += seriesName(series.name, series.labels) + " " + std::to_string(series.gauge->value()) + "\n";
+            break;
+        case Type::GaugeCallback:
+            out += seriesName(series.name, series.labels) + " "
+                 + formatValue(series.callback ? series.callback() : 0.0) + "\n";
+            break;
+        case Type::Histogram: {
+            double sum = 0;
+            const uint64_t count = series.histogram->snapshot(buckets, sum);
+            const std::vector<double> &bounds = series.histogram->upperBounds();
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                cumulative += buckets[i];
+                const double bound = i < bounds.size() ? bounds[i] : INFINITY;
+                out += seriesName(series.name + "_bucket", series.labels, "le=\"" + formatValue(bound) + "\"")
+                     + " " + std::to_string(cumulative) + "\n";
+            }
+            out += seriesName(series.name + "_sum", series.labels) + " " + formatValue(sum) + "\n";
+            out += seriesName(series.name + "_count", series.labels) + " " + std::to_string(count) + "\n";
+            break;
+        }
+        }
+    }
+    return out;
+}
@@ -0,0 +1,135 @@
+#include "metricsserver.h"
+#include "metrics.h"
+#include "resourcemonitor.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+namespace {
+
+// 请求头超过此长度时直接拒绝
+const int kMaxRequestBytes = 8192;
+
+} // namespace
+
+void registerProcessMetrics()
+{
+    MetricsRegistry &registry = MetricsRegistry::instance();
+    static const qint64 startTime = QDateTime::currentMSecsSinceEpoch();
+
+    registry.gaugeCallback("enplayer_process_start_time_seconds", "Start time of the process since unix epoch in seconds.",
+                           []() { return startTime / 1000.0; });
+    registry.gaugeCallback("enplayer_resident_memory_bytes", "Resident set size in bytes.",
+                           []() { return double(readProcessMemory().rssBytes); });
+    registry.gaugeCallback("enplayer_peak_resident_memory_bytes", "Peak resident set size in bytes.",
+                           []() { return double(readProcessMemory().peakRssBytes); });
+    registry.gaugeCallback("enplayer_heap_free_bytes", "Bytes held by malloc but not in use (-1 if unavailable).",
+                           []() { return double(readProcessMemory().heapFreeBytes); });
+    registry.gaugeCallback("enplayer_cpu_seconds", "User and system CPU time of the process and its reaped children.",
+                           []() { return processCpuSeconds(); });
+}
+
+MetricsServer::MetricsServer(QObject *parent) : QObject(parent),
+                                                m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &MetricsServer::handleNewConnection);
+}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+bool MetricsServer::start(quint16 port, const QHostAddress &address)
+{
+    stop();
+    registerProcessMetrics();
+
+    if (!m_server->listen(address, port)) {
+        qWarning() << "[MetricsServer] 无法监听" << address.toString() << port << ":" << m_server->errorString();
+        return false;
+    }
+    qInfo() << "[MetricsServer] 指标地址: http://" + address.toString() + ":" + QString::number(m_server->serverPort()) + "/metrics";
+    return true;
+}
+
+void MetricsServer::stop()
+{
+    if (m_server->isListening()) {
+        m_server->close();
+    }
+    for (QTcpSocket *socket : m_pendingRequests.keys()) {
+        socket->abort();
+        socket->deleteLater();
+    }
+    m_pendingRequests.clear();
+}
+
+bool MetricsServer::isListening() const
+{
+    return m_server->isListening();
+}
+
+quint16 MetricsServer::port() const
+{
+    return m_server->serverPort();
+}
+
+void MetricsServer::handleNewConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        m_pendingRequests.insert(socket, QByteArray());
+        connect(socket, &QTcpSocket::readyRead, this, &MetricsServer::handleReadyRead);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_pendingRequests.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MetricsServer::handleReadyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket || !m_pendingRequests.contains(socket)) {
+        return;
+    }
+
+    QByteArray &request = m_pendingRequests[socket];
+    request.append(socket->readAll());
+    if (!request.contains("\r\n\r\n")) {
+        if (request.size() > kMaxRequestBytes) {
+            respond(socket, "431 Request Header Fields Too Large", "text/plain", "request too large\n");
+        }
+        return;
+    }
+
+    // 只关心请求行，例如"GET /metrics HTTP/1.1"
+    const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+    const QByteArray method = requestLine.value(0);
+    const QByteArray path = requestLine.value(1).split('?').first();
+
+    if (method != "GET") {
+        respond(socket, "405 Method Not Allowed", "text/plain", "only GET is supported\n");
+    } else if (path == "/metrics") {
+        const std::string body = MetricsRegistry::instance().renderPrometheus();
+        respond(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8", QByteArray(body.data(), int(body.size())));
+    } else {
+        respond(socket, "404 Not Found", "text/plain", "see /metrics\n");
+    }
+}
+
+void MetricsServer::respond(QTcpSocket *socket, const QByteArray &status, const QByteArray &contentType, const QByteArray &body)
+{
+    m_pendingRequests.remove(socket);
+    disconnect(socket, &QTcpSocket::readyRead, this, &MetricsServer::handleReadyRead);
+
+    QByteArray response = "HTTP/1.1 " + status + "\r\n"
+                          "Content-Type: " + contentType + "\r\n"
+                          "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                          "Connection: close\r\n\r\n";
+    response += body;
+    socket->write(response);
+    socket->disconnectFromHost();
+}
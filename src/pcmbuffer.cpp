@@ -0,0 +1,247 @@
+#include "pcmbuffer.h"
+#include "pcmconvert.h"
+#include "wavreader.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QTemporaryFile>
+#include <algorithm>
+#include <cstring>
+
+const size_t PcmBuffer::kBlockSamples;
+
+PcmBuffer::PcmBuffer() : m_size(0),
+                         m_memoryBudgetBytes(0),
+                         m_spilledSamples(0),
+                         m_spillFailed(false),
+                         m_mapped(nullptr),
+                         m_hasPendingByte(false),
+                         m_pendingByte(0)
+{
+}
+
+PcmBuffer::~PcmBuffer()
+{
+}
+
+void PcmBuffer::clear()
+{
+    m_blocks.clear();
+    m_size = 0;
+    m_scratchFile.reset();  // QTemporaryFile析构时自动删除暂存文件
+    m_spilledSamples = 0;
+    m_spillFailed = false;
+    m_wavReader.reset();
+    m_mapped = nullptr;
+    m_hasPendingByte = false;
+}
+
+void PcmBuffer::setSpillPolicy(qint64 memoryBudgetBytes, const QString &scratchDirectory)
+{
+    m_memoryBudgetBytes = memoryBudgetBytes;
+    m_scratchDirectory = scratchDirectory;
+}
+
+void PcmBuffer::append(const int16_t *samples, size_t count)
+{
+    // 映射模式下的数据只读，追加前先切换回块存储
+    if (m_mapped) {
+        clear();
+    }
+
+    while (count > 0) {
+        size_t used = m_size % kBlockSamples;
+        if (used == 0 && (m_size - m_spilledSamples) / kBlockSamples == m_blocks.size()) {
+            // 此时内存中的块都已写满，再分配一块会超出预算时先把它们写入暂存文件
+            const qint64 blockBytes = qint64(kBlockSamples * sizeof(int16_t));
+            if (m_memoryBudgetBytes > 0 && !m_spillFailed && !m_blocks.empty()
+                    && qint64(m_blocks.size() + 1) * blockBytes > m_memoryBudgetBytes) {
+                spillFullBlocks();
+            }
+            m_blocks.push_back(std::unique_ptr<int16_t[]>(new int16_t[kBlockSamples]));
+        }
+
+        size_t n = std::min(count, kBlockSamples - used);
+        memcpy(m_blocks.back().get() + used, samples, n * sizeof(int16_t));
+        samples += n;
+        count -= n;
+        m_size += n;
+    }
+}
+
+void PcmBuffer::appendBytes(const char *bytes, size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+
+    // 上一次剩下的半个样本先和本次第一个字节拼成完整样本
+    if (m_hasPendingByte) {
+        char pair[2] = { m_pendingByte, bytes[0] };
+        int16_t sample;
+        memcpy(&sample, pair, sizeof(sample));
+        append(&sample, 1);
+        m_hasPendingByte = false;
+        ++bytes;
+        --size;
+    }
+
+    size_t count = size / sizeof(int16_t);
+    size_t offset = 0;
+    int16_t staging[4096];
+    // 管道读到的数据不保证2字节对齐，经过小缓冲区拷贝后再追加
+    while (offset < count) {
+        size_t n = std::min(count - offset, sizeof(staging) / sizeof(staging[0]));
+        memcpy(staging, bytes + offset * sizeof(int16_t), n * sizeof(int16_t));
+        append(staging, n);
+        offset += n;
+    }
+
+    if (size % sizeof(int16_t)) {
+        m_pendingByte = bytes[size - 1];
+        m_hasPendingByte = true;
+    }
+}
+
+void PcmBuffer::append(const PcmBuffer &other)
+{
+    // 按块大小分批复制，来源的暂存部分每次只映射一块
+    std::unique_ptr<int16_t[]> staging(new int16_t[kBlockSamples]);
+    size_t offset = 0;
+    while (offset < other.size()) {
+        const size_t n = other.toInt16(offset, kBlockSamples, staging.get());
+        append(staging.get(), n);
+        offset += n;
+    }
+}
+
+void PcmBuffer::setMappedWav(const QSharedPointer<WavReader> &reader, qint64 firstFrame, qint64 frameCount)
+{
+    clear();
+    if (!reader || !reader->isPcm16() || reader->format().channels != 1 || firstFrame < 0 || frameCount <= 0) {
+        return;
+    }
+
+    m_wavReader = reader;
+    m_mapped = reader->pcm16Data() + firstFrame;
+    m_size = size_t(frameCount);
+}
+
+bool PcmBuffer::spillFullBlocks()
+{
+    if (!m_scratchFile) {
+        QString directory = m_scratchDirectory.isEmpty() ? QDir::tempPath() : m_scratchDirectory;
+        QDir().mkpath(directory);
+
+        m_scratchFile.reset(new QTemporaryFile(QDir(directory).filePath("enplayer_pcm_XXXXXX.raw")));
+        if (!m_scratchFile->open()) {
+            qWarning() << "[PcmBuffer] 无法创建暂存文件，音频继续保存在内存中:" << directory << m_scratchFile->errorString();
+            m_scratchFile.reset();
+            m_spillFailed = true;
+            return false;
+        }
+        qInfo() << "[PcmBuffer] 解码音频超出内存预算，写入暂存文件:" << m_scratchFile->fileName();
+    }
+
+    const qint64 blockBytes = qint64(kBlockSamples * sizeof(int16_t));
+    const qint64 fileEnd = qint64(m_spilledSamples * sizeof(int16_t));
+    m_scratchFile->seek(fileEnd);
+
+    for (size_t i = 0; i < m_blocks.size(); ++i) {
+        const char *bytes = reinterpret_cast<const char *>(m_blocks[i].get());
+        if (m_scratchFile->write(bytes, blockBytes) != blockBytes) {
+            // 磁盘空间不足等情况下回退写入的部分，之后不再尝试写入
+            qWarning() << "[PcmBuffer] 写入暂存文件失败，音频继续保存在内存中:" << m_scratchFile->errorString();
+            m_scratchFile->resize(fileEnd);
+            m_spillFailed = true;
+            return false;
+        }
+    }
+
+    if (!m_scratchFile->flush()) {
+        qWarning() << "[PcmBuffer] 刷新暂存文件失败:" << m_scratchFile->errorString();
+        m_scratchFile->resize(fileEnd);
+        m_spillFailed = true;
+        return false;
+    }
+
+    m_spilledSamples += m_blocks.size() * kBlockSamples;
+    m_blocks.clear();
+    return true;
+}
+
+size_t PcmBuffer::forEachSpan(size_t offset, size_t count,
+                              const std::function<void(const int16_t *samples, size_t n, size_t done)> &visit) const
+{
+    if (offset >= m_size) {
+        return 0;
+    }
+    count = std::min(count, m_size - offset);
+
+    if (m_mapped) {
+        visit(m_mapped + offset, count, 0);
+        return count;
+    }
+
+    size_t done = 0;
+
+    // 暂存文件中的部分：只映射本次需要的范围，用完立即解除映射，暂存文件的页面不会累积在常驻内存中
+    if (offset < m_spilledSamples) {
+        const size_t spilled = std::min(count, m_spilledSamples - offset);
+        const qint64 byteOffset = qint64(offset * sizeof(int16_t));
+        uchar *mapped = m_scratchFile->map(byteOffset, qint64(spilled * sizeof(int16_t)));
+        if (mapped) {
+            visit(reinterpret_cast<const int16_t *>(mapped), spilled, 0);
+            m_scratchFile->unmap(mapped);
+        } else {
+            // 映射失败时退回到分段读取
+            int16_t staging[4096];
+            bool readFailed = false;
+            m_scratchFile->seek(byteOffset);
+            while (done < spilled) {
+                const size_t n = std::min(spilled - done, sizeof(staging) / sizeof(staging[0]));
+                const qint64 bytes = qint64(n * sizeof(int16_t));
+                if (!readFailed && m_scratchFile->read(reinterpret_cast<char *>(staging), bytes) != bytes) {
+                    qWarning() << "[PcmBuffer] 读取暂存文件失败:" << m_scratchFile->errorString();
+                    readFailed = true;
+                }
+                if (readFailed) {
+                    std::fill(staging, staging + n, int16_t(0));
+                }
+                visit(staging, n, done);
+                done += n;
+            }
+        }
+        done = spilled;
+    }
+
+    // 内存块中的部分，m_spilledSamples总是块大小的整数倍
+    while (done < count) {
+        const size_t position = offset + done;
+        const size_t block = (position - m_spilledSamples) / kBlockSamples;
+        const size_t inBlock = position % kBlockSamples;
+        const size_t n = std::min(count - done, kBlockSamples - inBlock);
+        visit(m_blocks[block].get() + inBlock, n, done);
+        done += n;
+    }
+    return count;
+}
+
+size_t PcmBuffer::toFloat(size_t offset, size_t count, float *output) const
+{
+    return forEachSpan(offset, count, [output](const int16_t *samples, size_t n, size_t done) {
+        convertS16ToF32(samples, output + done, n);
+    });
+}
+
+size_t PcmBuffer::toInt16(size_t offset, size_t count, int16_t *output) const
+{
+    return forEachSpan(offset, count, [output](const int16_t *samples, size_t n, size_t done) {
+        memcpy(output + done, samples, n * sizeof(int16_t));
+    });
+}
+
+qint64 PcmBuffer::residentBytes() const
+{
+    return qint64(m_blocks.size()) * qint64(kBlockSamples * sizeof(int16_t));
+}
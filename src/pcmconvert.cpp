@@ -0,0 +1,180 @@
+#include "pcmconvert.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define PCMCONVERT_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define PCMCONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+const float kS16Scale = 1.0f / 32768.0f;
+
+#if defined(PCMCONVERT_X86)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PCMCONVERT_HAS_AVX2_DISPATCH 1
+
+// 每次处理16个样本：符号扩展为32位整数后转换为浮点并缩放
+__attribute__((target("avx2")))
+void convertAvx2(const int16_t *input, float *output, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(kS16Scale);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i s16 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+        __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(s16));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(s16, 1));
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(output + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+    for (; i < count; ++i) {
+        output[i] = input[i] * kS16Scale;
+    }
+}
+
+__attribute__((target("avx2")))
+void convertToS16Avx2(const float *input, int16_t *output, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(32768.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i lo = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(input + i), scale));
+        __m256i hi = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(input + i + 8), scale));
+        // packs按128位通道交错，重新排列为顺序输出
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i), packed);
+    }
+    convertF32ToS16Scalar(input + i, output + i, count - i);
+}
+
+bool cpuHasAvx2()
+{
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    return hasAvx2;
+}
+#endif
+
+// SSE2在x86-64上总是可用：高16位用符号位填充后右移得到32位整数
+void convertSse2(const int16_t *input, float *output, size_t count)
+{
+    const __m128 scale = _mm_set1_ps(kS16Scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16);
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    for (; i < count; ++i) {
+        output[i] = input[i] * kS16Scale;
+    }
+}
+
+// cvtps使用默认的就近舍入，packs饱和到int16范围
+void convertToS16Sse2(const float *input, int16_t *output, size_t count)
+{
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(input + i), scale));
+        __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(input + i + 4), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), _mm_packs_epi32(lo, hi));
+    }
+    convertF32ToS16Scalar(input + i, output + i, count - i);
+}
+
+#elif defined(PCMCONVERT_NEON)
+
+void convertNeon(const int16_t *input, float *output, size_t count)
+{
+    const float32x4_t scale = vdupq_n_f32(kS16Scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t s16 = vld1q_s16(input + i);
+        int32x4_t lo = vmovl_s16(vget_low_s16(s16));
+        int32x4_t hi = vmovl_s16(vget_high_s16(s16));
+        vst1q_f32(output + i, vmulq_f32(vcvtq_f32_s32(lo), scale));
+        vst1q_f32(output + i + 4, vmulq_f32(vcvtq_f32_s32(hi), scale));
+    }
+    for (; i < count; ++i) {
+        output[i] = input[i] * kS16Scale;
+    }
+}
+
+#if defined(__aarch64__)
+void convertToS16Neon(const float *input, int16_t *output, size_t count)
+{
+    const float32x4_t scale = vdupq_n_f32(32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int32x4_t lo = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(input + i), scale));
+        int32x4_t hi = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(input + i + 4), scale));
+        vst1q_s16(output + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+    convertF32ToS16Scalar(input + i, output + i, count - i);
+}
+#endif
+
+#endif
+
+} // namespace
+
+void convertS16ToF32Scalar(const int16_t *input, float *output, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        output[i] = input[i] * kS16Scale;
+    }
+}
+
+void convertF32ToS16Scalar(const float *input, int16_t *output, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        float value = std::nearbyint(input[i] * 32768.0f);
+        if (value > 32767.0f) {
+            value = 32767.0f;
+        } else if (value < -32768.0f) {
+            value = -32768.0f;
+        }
+        output[i] = int16_t(value);
+    }
+}
+
+void convertF32ToS16(const float *input, int16_t *output, size_t count)
+{
+#if defined(PCMCONVERT_X86)
+#if defined(PCMCONVERT_HAS_AVX2_DISPATCH)
+    if (cpuHasAvx2()) {
+        convertToS16Avx2(input, output, count);
+        return;
+    }
+#endif
+    convertToS16Sse2(input, output, count);
+#elif defined(PCMCONVERT_NEON) && defined(__aarch64__)
+    convertToS16Neon(input, output, count);
+#else
+    convertF32ToS16Scalar(input, output, count);
+#endif
+}
+
+void convertS16ToF32(const int16_t *input, float *output, size_t count)
+{
+#if defined(PCMCONVERT_X86)
+#if defined(PCMCONVERT_HAS_AVX2_DISPATCH)
+    if (cpuHasAvx2()) {
+        convertAvx2(input, output, count);
+        return;
+    }
+#endif
+    convertSse2(input, output, count);
+#elif defined(PCMCONVERT_NEON)
+    convertNeon(input, output, count);
+#else
+    convertS16ToF32Scalar(input, output, count);
+#endif
+}
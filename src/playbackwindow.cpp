@@ -1,14 +1,24 @@
 #include "playbackwindow.h"
+#include "transcriptmodel.h"
 #include <QVideoWidget>
 #include <QDateTime>
 #include <QDebug>
 #include <QMessageBox>
+#include <QMouseEvent>
+#include <QStyle>
 #include "../forms/ui_playbackwindow.h"
 
 PlaybackWindow::PlaybackWindow(QWidget *parent) : QMainWindow(parent),
                                                   ui(new Ui::PlaybackWindow),
                                                   player(nullptr),
-                                                  videoWidget(nullptr)
+                                                  videoWidget(nullptr),
+                                                  rangeStartMs(-1),
+                                                  rangeEndMs(-1),
+                                                  rangeRecognitionBusy(false),
+                                                  transcriptModel(nullptr),
+                                                  currentTranscriptRow(-1),
+                                                  currentWordIndex(-1),
+                                                  pendingSeekMs(-1)
 {
     ui->setupUi(this);
 
@@ -27,9 +37,19 @@ PlaybackWindow::PlaybackWindow(QWidget *parent) : QMainWindow(parent),
     connect(player, &QMediaPlayer::positionChanged, this, &PlaybackWindow::on_positionChanged);
     connect(player, &QMediaPlayer::durationChanged, this, &PlaybackWindow::on_durationChanged);
     connect(player, &QMediaPlayer::stateChanged, this, &PlaybackWindow::on_stateChanged);
+    connect(player, &QMediaPlayer::mediaStatusChanged, this, [this](QMediaPlayer::MediaStatus status) {
+        if (pendingSeekMs >= 0 && (status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::BufferedMedia)) {
+            const qint64 positionMs = pendingSeekMs;
+            pendingSeekMs = -1;
+            seekTo(positionMs);
+        }
+    });
     connect(player, QOverload<QMediaPlayer::Error>::of(&QMediaPlayer::error), [this](QMediaPlayer::Error error)
             { logMessage(QString("媒体播放错误: %1").arg(player->errorString()), "ERROR"); });
 
+    // 点击字幕跳转播放位置
+    ui->subtitleListView->viewport()->installEventFilter(this);
+
     // 初始禁用播放控制按钮
     ui->playButton->setEnabled(false);
     ui->pauseButton->setEnabled(false);
@@ -56,13 +76,39 @@ void PlaybackWindow::setMediaFilePath(const QString &filePath)
     ui->playButton->setEnabled(true);
 }
 
-void PlaybackWindow::setSubtitleContent(const QString &subtitle)
+void PlaybackWindow::setTranscriptModel(TranscriptModel *model)
 {
-    currentSubtitle = subtitle;
-    ui->subtitleTextEdit->setText(subtitle);
+    if (ui->subtitleListView->model() == model) {
+        return;
+    }
+    ui->subtitleListView->setModel(model);
+    transcriptModel = model;
+    currentTranscriptRow = -1;
+    currentWordIndex = -1;
+    if (player->state() != QMediaPlayer::StoppedState) {
+        updateCurrentTranscriptRow(player->position());
+    }
     logMessage("字幕内容已更新", "INFO");
 }
 
+void PlaybackWindow::setRangeRecognitionBusy(bool busy)
+{
+    rangeRecognitionBusy = busy;
+    updateRangeControls();
+}
+
+void PlaybackWindow::seekTo(qint64 positionMs)
+{
+    const QMediaPlayer::MediaStatus status = player->mediaStatus();
+    if (status == QMediaPlayer::LoadingMedia || status == QMediaPlayer::NoMedia) {
+        pendingSeekMs = positionMs;
+        return;
+    }
+    player->setPosition(positionMs);
+    player->play();
+    updateCurrentTranscriptRow(positionMs);
+}
+
 void PlaybackWindow::on_playButton_clicked()
 {
     player->play();
@@ -85,6 +131,7 @@ void PlaybackWindow::on_positionChanged(qint64 position)
 {
     ui->positionSlider->setValue(position);
     ui->timeLabel->setText(QString("%1 / %2").arg(formatTime(position)).arg(formatTime(player->duration())));
+    updateCurrentTranscriptRow(position);
 }
 
 void PlaybackWindow::on_durationChanged(qint64 duration)
@@ -132,6 +179,219 @@ void PlaybackWindow::on_positionSlider_sliderMoved(int position)
     logMessage(QString("进度调整至: %1").arg(formatTime(position)), "INFO");
 }
 
+void PlaybackWindow::on_markRangeStartButton_clicked()
+{
+    rangeStartMs = ui->positionSlider->value();
+    // 起点越过终点时清除终点，重新选择
+    if (rangeEndMs >= 0 && rangeEndMs <= rangeStartMs) {
+        rangeEndMs = -1;
+    }
+    updateRangeControls();
+    logMessage(QString("区间起点: %1").arg(formatTime(rangeStartMs)), "INFO");
+}
+
+void PlaybackWindow::on_markRangeEndButton_clicked()
+{
+    rangeEndMs = ui->positionSlider->value();
+    if (rangeStartMs < 0) {
+        rangeStartMs = 0;
+    }
+    if (rangeEndMs <= rangeStartMs) {
+        logMessage("区间终点必须晚于起点", "WARNING");
+        rangeEndMs = -1;
+    }
+    updateRangeControls();
+    if (rangeEndMs >= 0) {
+        logMessage(QString("区间终点: %1").arg(formatTime(rangeEndMs)), "INFO");
+    }
+}
+
+void PlaybackWindow::on_recognizeRangeButton_clicked()
+{
+    if (rangeStartMs < 0 || rangeEndMs <= rangeStartMs) {
+        logMessage("请先在进度条上选择识别区间", "WARNING");
+        return;
+    }
+
+    logMessage(QString("请求识别区间: %1 - %2").arg(formatTime(rangeStartMs)).arg(formatTime(rangeEndMs)), "INFO");
+    emit rangeRecognitionRequested(rangeStartMs, rangeEndMs);
+}
+
+void PlaybackWindow::on_subtitleListView_activated(const QModelIndex &index)
+{
+    const qint64 startMs = index.data(TranscriptModel::StartMsRole).toLongLong();
+    if (startMs < 0 || currentMediaFile.isEmpty()) {
+        return;
+    }
+    player->setPosition(startMs);
+}
+
+bool PlaybackWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == ui->subtitleListView->viewport() && event->type() == QEvent::MouseButtonRelease) {
+        QMouseEvent *mouseEvent = static_cast<QMouseEvent *>(event);
+        // 带修饰键的点击用于多选复制，不跳转
+        if (mouseEvent->button() == Qt::LeftButton && mouseEvent->modifiers() == Qt::NoModifier) {
+            seekToTranscriptPoint(mouseEvent->pos());
+        }
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+void PlaybackWindow::seekToTranscriptPoint(const QPoint &position)
+{
+    QListView *view = ui->subtitleListView;
+    const QModelIndex index = view->indexAt(position);
+    if (!transcriptModel || !index.isValid() || currentMediaFile.isEmpty()) {
+        return;
+    }
+    const int row = index.row();
+    const TranscriptSegment &segment = transcriptModel->segments().at(row);
+    if (segment.startMs < 0) {
+        return;
+    }
+
+    // 显示文本为“[开始 --> 结束] 文本”，先去掉时间戳部分的宽度，再找点中的字符
+    const QString display = index.data(Qt::DisplayRole).toString();
+    const QString text = index.data(TranscriptModel::TextRole).toString();
+    const QFontMetrics metrics = view->fontMetrics();
+    const int margin = view->style()->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, view) + 1;
+    const int textLeft = view->visualRect(index).left() + margin
+            + metrics.horizontalAdvance(display.left(display.size() - text.size()));
+    const int x = position.x() - textLeft;
+
+    // 前缀宽度随字符数单调增加，二分查找点中的字符
+    int low = 0;
+    int high = text.size();
+    while (low < high) {
+        const int middle = (low + high + 1) / 2;
+        if (metrics.horizontalAdvance(text.left(middle)) <= x) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    // 退到所在词的开头
+    while (low > 0 && !text.at(low - 1).isSpace()) {
+        --low;
+    }
+
+    const qint64 target = transcriptModel->timeAtCharacter(row, low);
+    player->setPosition(target);
+    logMessage(QString("跳转到字幕: %1").arg(formatTime(target)), "INFO");
+}
+
+void PlaybackWindow::updateCurrentTranscriptRow(qint64 position)
+{
+    if (!transcriptModel) {
+        return;
+    }
+
+    // 正常播放时位置仍在当前行内，直接比较相邻两行的开始时间，不需要查找
+    const QVector<TranscriptSegment> &segments = transcriptModel->segments();
+    const int row = currentTranscriptRow;
+    if (row >= 0 && row < segments.size() && segments.at(row).startMs >= 0
+        && segments.at(row).startMs <= position
+        && (row + 1 == segments.size() || position < segments.at(row + 1).startMs)) {
+        updateCurrentWord(position, false);
+        return;
+    }
+
+    const int newRow = transcriptModel->rowAtTime(position);
+    if (newRow == currentTranscriptRow) {
+        updateCurrentWord(position, false);
+        return;
+    }
+
+    QListView *view = ui->subtitleListView;
+    // 用户把当前行滚出可见区域时不再自动滚动，直到当前行回到视野内
+    const bool follow = currentTranscriptRow < 0 || currentTranscriptRow >= segments.size()
+            || view->viewport()->rect().intersects(view->visualRect(transcriptModel->index(currentTranscriptRow)));
+    currentTranscriptRow = newRow;
+    updateCurrentWord(position, true);
+    if (newRow < 0) {
+        view->clearSelection();
+        return;
+    }
+
+    const QModelIndex index = transcriptModel->index(newRow);
+    view->selectionModel()->setCurrentIndex(index, QItemSelectionModel::ClearAndSelect);
+    if (follow) {
+        view->scrollTo(index, QAbstractItemView::PositionAtCenter);
+    }
+}
+
+void PlaybackWindow::updateCurrentWord(qint64 position, bool rowChanged)
+{
+    const QVector<TranscriptSegment> &segments = transcriptModel->segments();
+    if (currentTranscriptRow < 0 || currentTranscriptRow >= segments.size()) {
+        currentWordIndex = -1;
+        ui->currentLineLabel->clear();
+        return;
+    }
+
+    const TranscriptSegment &segment = segments.at(currentTranscriptRow);
+    const TranscriptWords &words = segment.words;
+    const qint32 relativeMs = qint32(position - segment.startMs);
+
+    // 顺序播放时游标每次最多前进一两个词；只有往回跳转时才在本行内二分查找
+    int word = rowChanged ? -1 : currentWordIndex;
+    if (word >= 0 && word < words.size() && words.startMs.at(word) <= relativeMs) {
+        while (word + 1 < words.size() && words.startMs.at(word + 1) <= relativeMs) {
+            ++word;
+        }
+    } else {
+        word = words.wordAt(relativeMs);
+    }
+    if (!rowChanged && word == currentWordIndex) {
+        return;
+    }
+    currentWordIndex = word;
+
+    // 已播放的词正常显示，当前词加底色，尚未播放的词淡色显示
+    const QString text = segment.text.trimmed();
+    if (words.isEmpty()) {
+        ui->currentLineLabel->setText(text.toHtmlEscaped());
+        ui->currentLineLabel->setVisible(true);
+        return;
+    }
+
+    const QString highlight = palette().color(QPalette::Highlight).name();
+    const QString highlightedText = palette().color(QPalette::HighlightedText).name();
+    const QString upcoming = palette().color(QPalette::Disabled, QPalette::Text).name();
+    QString html;
+    if (words.textOffset.first() > 0) {
+        html += text.left(words.textOffset.first()).toHtmlEscaped();
+    }
+    for (int i = 0; i < words.size(); ++i) {
+        const int begin = qMin(words.textOffset.at(i), text.size());
+        const int end = i + 1 < words.size() ? qMin(words.textOffset.at(i + 1), text.size()) : text.size();
+        const QString piece = text.mid(begin, end - begin).toHtmlEscaped();
+        if (i == word) {
+            html += QString("<span style=\"background-color:%1; color:%2;\">%3</span>").arg(highlight, highlightedText, piece);
+        } else if (i > word) {
+            html += QString("<span style=\"color:%1;\">%2</span>").arg(upcoming, piece);
+        } else {
+            html += piece;
+        }
+    }
+    ui->currentLineLabel->setText(html);
+    ui->currentLineLabel->setVisible(true);
+}
+
+void PlaybackWindow::updateRangeControls()
+{
+    QString startText = rangeStartMs >= 0 ? formatTime(rangeStartMs) : QString("--:--");
+    QString endText = rangeEndMs >= 0 ? formatTime(rangeEndMs) : QString("--:--");
+    if (rangeStartMs < 0 && rangeEndMs < 0) {
+        ui->rangeLabel->setText("识别区间: 未选择");
+    } else {
+        ui->rangeLabel->setText(QString("识别区间: %1 - %2").arg(startText).arg(endText));
+    }
+
+    ui->recognizeRangeButton->setEnabled(!rangeRecognitionBusy && rangeStartMs >= 0 && rangeEndMs > rangeStartMs);
+}
+
 QString PlaybackWindow::formatTime(qint64 milliseconds)
 {
     qint64 seconds = milliseconds / 1000;
@@ -0,0 +1,54 @@
+#include "recognizermetrics.h"
+
+namespace {
+
+MetricHistogram &stageHistogram(const char *stage)
+{
+    return MetricsRegistry::instance().histogram("enplayer_stage_duration_seconds", "Duration of recognition stages.",
+                                                 MetricHistogram::durationBuckets(), std::string("stage=\"") + stage + "\"");
+}
+
+// 直接映射是零拷贝快路径，其命中率即mapped占全部加载的比例
+MetricCounter &audioLoadCounter(const char *path)
+{
+    return MetricsRegistry::instance().counter("enplayer_audio_loads_total", "Audio loads by path taken.",
+                                               std::string("path=\"") + path + "\"");
+}
+
+} // namespace
+
+RecognizerMetrics::RecognizerMetrics()
+    : jobsQueued(MetricsRegistry::instance().gauge("enplayer_jobs_queued", "Recognition jobs waiting to run."))
+    , jobsRunning(MetricsRegistry::instance().gauge("enplayer_jobs_running", "Recognition jobs currently running."))
+    , jobsCompleted(MetricsRegistry::instance().counter("enplayer_jobs_completed_total", "Recognition jobs completed."))
+    , jobsFailed(MetricsRegistry::instance().counter("enplayer_jobs_failed_total", "Recognition jobs that reported an error."))
+    , jobPositionMs(MetricsRegistry::instance().gauge("enplayer_job_position_milliseconds",
+            "Audio position reached by the running job, relative to its start."))
+    , decodeSeconds(stageHistogram("decode"))
+    , inferenceSeconds(stageHistogram("inference"))
+    , totalSeconds(stageHistogram("total"))
+    , realTimeFactor(MetricsRegistry::instance().histogram("enplayer_real_time_factor",
+            "Processing time divided by audio duration per job.", { 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1, 2, 5 }))
+    , modelLoadSeconds(MetricsRegistry::instance().histogram("enplayer_model_load_seconds",
+            "Time to load a whisper model.", MetricHistogram::durationBuckets()))
+    , sourceBytes(MetricsRegistry::instance().counter("enplayer_audio_source_bytes_total",
+            "Bytes read from the decoder pipe or mapped file."))
+    , decodedBytes(MetricsRegistry::instance().counter("enplayer_audio_decoded_bytes_total",
+            "Bytes of 16 kHz mono PCM produced by decoding."))
+    , tokens(MetricsRegistry::instance().counter("enplayer_tokens_generated_total", "Text tokens generated by whisper."))
+    , loadsMapped(audioLoadCounter("mapped"))
+    , loadsConverted(audioLoadCounter("converted"))
+    , loadsFfmpeg(audioLoadCounter("ffmpeg"))
+    , loadsFfmpegParallel(audioLoadCounter("ffmpeg_parallel"))
+    , streamReconnects(MetricsRegistry::instance().counter("enplayer_stream_reconnects_total",
+            "Reconnects after a network stream input failed."))
+    , streamDroppedMs(MetricsRegistry::instance().counter("enplayer_stream_dropped_milliseconds_total",
+            "Stream audio dropped because recognition fell behind."))
+{
+}
+
+RecognizerMetrics &recognizerMetrics()
+{
+    static RecognizerMetrics metrics;
+    return metrics;
+}
@@ -0,0 +1,520 @@
+#include "resampler.h"
+#include "pcmconvert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define RESAMPLER_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define RESAMPLER_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+// 截止频率相对于较低奈奎斯特频率的比例，剩下的部分留给过渡带
+const double kCutoffRatio = 0.9;
+
+// Kaiser窗参数，对应约86dB的阻带衰减
+const double kKaiserBeta = 8.6;
+
+int greatestCommonDivisor(int a, int b)
+{
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// 第一类零阶修正贝塞尔函数，级数展开
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    const double halfX = x / 2.0;
+    for (int k = 1; k < 64; ++k) {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+        if (term < sum * 1e-17) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// ---------------------------------------------------------------------------
+// 点积：系数个数总是8的整数倍，尾部循环只为安全起见保留
+
+typedef float (*DotProductFn)(const float *, const float *, int);
+
+#if defined(RESAMPLER_X86)
+
+float dotProductSse(const float *a, const float *b, int count)
+{
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    float sum = _mm_cvtss_f32(acc);
+    for (; i < count; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RESAMPLER_HAS_AVX2_DISPATCH 1
+
+__attribute__((target("avx2,fma")))
+float dotProductAvx2(const float *a, const float *b, int count)
+{
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    __m256 acc8 = _mm256_add_ps(acc0, acc1);
+    __m128 acc = _mm_add_ps(_mm256_castps256_ps128(acc8), _mm256_extractf128_ps(acc8, 1));
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    float sum = _mm_cvtss_f32(acc);
+    for (; i < count; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+#endif
+
+#elif defined(RESAMPLER_NEON)
+
+float dotProductNeon(const float *a, const float *b, int count)
+{
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+    float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    float sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+    for (; i < count; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#else
+
+float dotProductScalar(const float *a, const float *b, int count)
+{
+    float sum = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#endif
+
+DotProductFn selectDotProduct()
+{
+#if defined(RESAMPLER_X86)
+#if defined(RESAMPLER_HAS_AVX2_DISPATCH)
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return dotProductAvx2;
+    }
+#endif
+    return dotProductSse;
+#elif defined(RESAMPLER_NEON)
+    return dotProductNeon;
+#else
+    return dotProductScalar;
+#endif
+}
+
+DotProductFn dotProduct()
+{
+    static const DotProductFn fn = selectDotProduct();
+    return fn;
+}
+
+// ---------------------------------------------------------------------------
+// 比例描述：常用比例用编译期常量，除法和取模可以被编译器优化为乘法和移位
+
+template <int Up, int Down>
+struct FixedRatio
+{
+    int up() const { return Up; }
+    int down() const { return Down; }
+};
+
+struct RuntimeRatio
+{
+    RuntimeRatio(int up, int down) : m_up(up), m_down(down) {}
+    int up() const { return m_up; }
+    int down() const { return m_down; }
+    int m_up;
+    int m_down;
+};
+
+// ---------------------------------------------------------------------------
+// 降混
+
+const float kS16Scale = 1.0f / 32768.0f;
+
+// 常用声道数的专用实现，其他声道数使用downmixGeneric
+template <int Channels>
+struct Downmixer;
+
+template <>
+struct Downmixer<1>
+{
+    static void run(const int16_t *input, size_t frames, float *output)
+    {
+        convertS16ToF32(input, output, frames);
+    }
+};
+
+template <>
+struct Downmixer<2>
+{
+    static void run(const int16_t *input, size_t frames, float *output)
+    {
+        const float scale = kS16Scale * 0.5f;
+        size_t i = 0;
+#if defined(RESAMPLER_X86)
+        // madd与全1相乘，相邻的左右声道样本相加为32位整数
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128 scaleVector = _mm_set1_ps(scale);
+        for (; i + 8 <= frames; i += 8) {
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i * 2));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i * 2 + 8));
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_madd_epi16(lo, ones)), scaleVector));
+            _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_madd_epi16(hi, ones)), scaleVector));
+        }
+#elif defined(RESAMPLER_NEON)
+        const float32x4_t scaleVector = vdupq_n_f32(scale);
+        for (; i + 8 <= frames; i += 8) {
+            int32x4_t lo = vpaddlq_s16(vld1q_s16(input + i * 2));
+            int32x4_t hi = vpaddlq_s16(vld1q_s16(input + i * 2 + 8));
+            vst1q_f32(output + i, vmulq_f32(vcvtq_f32_s32(lo), scaleVector));
+            vst1q_f32(output + i + 4, vmulq_f32(vcvtq_f32_s32(hi), scaleVector));
+        }
+#endif
+        for (; i < frames; ++i) {
+            output[i] = (int(input[i * 2]) + int(input[i * 2 + 1])) * scale;
+        }
+    }
+};
+
+// 5.1声道（FL FR FC LFE BL BR）：先按ITU-R BS.775降为立体声再取平均，
+// 即 0.5*(L+R) + 0.707*C + 0.354*(BL+BR)，再除以系数之和防止削波
+template <>
+struct Downmixer<6>
+{
+    static void run(const int16_t *input, size_t frames, float *output)
+    {
+        const float center = 0.70710678f;
+        const float norm = kS16Scale / (1.0f + 2.0f * center);
+        const float front = 0.5f * norm;
+        const float centerWeight = center * norm;
+        const float surround = 0.5f * center * norm;
+        for (size_t i = 0; i < frames; ++i) {
+            const int16_t *frame = input + i * 6;
+            output[i] = (frame[0] + frame[1]) * front
+                      + frame[2] * centerWeight
+                      + (frame[4] + frame[5]) * surround;
+        }
+    }
+};
+
+void downmixGeneric(const int16_t *input, size_t frames, int channels, float *output)
+{
+    const float scale = kS16Scale / channels;
+    for (size_t i = 0; i < frames; ++i) {
+        int sum = 0;
+        for (int c = 0; c < channels; ++c) {
+            sum += input[i * channels + c];
+        }
+        output[i] = sum * scale;
+    }
+}
+
+// 解码输出按块转换，避免为整段输入分配中间缓冲区
+const size_t kConvertChunkFrames = 4096;
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+
+PolyphaseResampler::PolyphaseResampler(int inputRate, int outputRate, int zeroCrossings)
+    : m_inputRate(inputRate),
+      m_outputRate(outputRate),
+      m_up(1),
+      m_down(1),
+      m_taps(8),
+      m_cutoff(0.5),
+      m_beta(kKaiserBeta),
+      m_bufferStart(0),
+      m_inputCount(0),
+      m_nextOutput(0)
+{
+    if (inputRate > 0 && outputRate > 0) {
+        int divisor = greatestCommonDivisor(inputRate, outputRate);
+        m_up = outputRate / divisor;
+        m_down = inputRate / divisor;
+    }
+
+    // 截止频率以输入样本为单位，降采样时取输出奈奎斯特频率
+    m_cutoff = 0.5 * std::min(1.0, double(m_up) / m_down) * kCutoffRatio;
+
+    // 单侧长度覆盖zeroCrossings个sinc过零点，总长度取8的整数倍以便SIMD
+    int halfLength = int(std::ceil(zeroCrossings / (2.0 * m_cutoff)));
+    m_taps = (2 * halfLength + 7) / 8 * 8;
+
+    // 第p个相位对应输出时刻落在输入样本之间的p/L处，第j个系数乘以输入x[q - T/2 + 1 + j]
+    m_coefficients.resize(size_t(m_up) * m_taps);
+    for (int p = 0; p < m_up; ++p) {
+        float *phase = &m_coefficients[size_t(p) * m_taps];
+        double sum = 0.0;
+        for (int j = 0; j < m_taps; ++j) {
+            double x = double(p) / m_up + m_taps / 2 - 1 - j;
+            double w = kernel(x);
+            phase[j] = float(w);
+            sum += w;
+        }
+        // 每个相位单独归一化直流增益，消除相位间的增益纹波
+        for (int j = 0; j < m_taps; ++j) {
+            phase[j] = float(phase[j] / sum);
+        }
+    }
+
+    reset();
+}
+
+double PolyphaseResampler::kernel(double x) const
+{
+    const double halfWidth = m_taps / 2.0;
+    if (std::fabs(x) >= halfWidth) {
+        return 0.0;
+    }
+
+    double arg = 2.0 * m_cutoff * x;
+    double sinc = std::fabs(arg) < 1e-12 ? 1.0 : std::sin(kPi * arg) / (kPi * arg);
+
+    double r = x / halfWidth;
+    double window = besselI0(m_beta * std::sqrt(1.0 - r * r)) / besselI0(m_beta);
+    return 2.0 * m_cutoff * sinc * window;
+}
+
+void PolyphaseResampler::reset()
+{
+    // 开头补T/2-1个零，使第一个输出样本对齐第一个输入样本，整体没有延迟
+    const int history = m_taps / 2 - 1;
+    m_buffer.assign(size_t(history), 0.0f);
+    m_bufferStart = -history;
+    m_inputCount = 0;
+    m_nextOutput = 0;
+}
+
+void PolyphaseResampler::process(const float *input, size_t count, std::vector<float> &output)
+{
+    if (count == 0) {
+        return;
+    }
+    m_buffer.insert(m_buffer.end(), input, input + count);
+    m_inputCount += int64_t(count);
+    run(false, output);
+}
+
+void PolyphaseResampler::flush(std::vector<float> &output)
+{
+    // 末尾补零，输出到最后一个输入样本对应的时刻为止
+    m_buffer.insert(m_buffer.end(), size_t(m_taps / 2), 0.0f);
+    run(true, output);
+    reset();
+}
+
+void PolyphaseResampler::run(bool draining, std::vector<float> &output)
+{
+    if (m_up == 1 && m_down == 3) {
+        produce(FixedRatio<1, 3>(), draining, output);          // 48kHz -> 16kHz
+    } else if (m_up == 160 && m_down == 441) {
+        produce(FixedRatio<160, 441>(), draining, output);      // 44.1kHz -> 16kHz
+    } else if (m_up == 1 && m_down == 2) {
+        produce(FixedRatio<1, 2>(), draining, output);          // 32kHz -> 16kHz
+    } else {
+        produce(RuntimeRatio(m_up, m_down), draining, output);
+    }
+}
+
+template <class Ratio>
+void PolyphaseResampler::produce(const Ratio &ratio, bool draining, std::vector<float> &output)
+{
+    const int up = ratio.up();
+    const int down = ratio.down();
+    const int halfTaps = m_taps / 2;
+    const DotProductFn dot = dotProduct();
+
+    // 正常处理时需要q + T/2个输入都已到达；结束时输出ceil(输入数 * L / M)个样本
+    const int64_t outputEnd = draining ? (m_inputCount * up + down - 1) / down : std::numeric_limits<int64_t>::max();
+    const int64_t available = m_bufferStart + int64_t(m_buffer.size());
+
+    int64_t n = m_nextOutput;
+    for (; n < outputEnd; ++n) {
+        const int64_t position = n * down;
+        const int64_t q = position / up;
+        const int phase = int(position % up);
+        if (q + halfTaps >= available) {
+            break;
+        }
+        const float *window = &m_buffer[size_t(q - halfTaps + 1 - m_bufferStart)];
+        output.push_back(dot(window, &m_coefficients[size_t(phase) * m_taps], m_taps));
+    }
+    m_nextOutput = n;
+
+    // 丢弃之后不再用到的输入
+    const int64_t keepFrom = (m_nextOutput * down) / up - halfTaps + 1;
+    if (keepFrom > m_bufferStart) {
+        size_t drop = size_t(std::min<int64_t>(keepFrom - m_bufferStart, int64_t(m_buffer.size())));
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + drop);
+        m_bufferStart += int64_t(drop);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+void downmixS16ToMono(const int16_t *input, size_t frames, int channels, float *output)
+{
+    switch (channels) {
+    case 1:
+        Downmixer<1>::run(input, frames, output);
+        break;
+    case 2:
+        Downmixer<2>::run(input, frames, output);
+        break;
+    case 6:
+        Downmixer<6>::run(input, frames, output);
+        break;
+    default:
+        downmixGeneric(input, frames, channels, output);
+        break;
+    }
+}
+
+AudioConverter::AudioConverter(int inputRate, int channels, int outputRate)
+    : m_inputRate(inputRate),
+      m_channels(std::max(1, channels)),
+      m_outputRate(outputRate),
+      m_resampler(inputRate, outputRate)
+{
+}
+
+void AudioConverter::pushBytes(const char *bytes, size_t size, std::vector<int16_t> &output)
+{
+    const size_t frameBytes = size_t(m_channels) * sizeof(int16_t);
+
+    // 先用本次的数据补齐上次剩下的不完整帧
+    if (!m_pendingBytes.empty()) {
+        size_t need = std::min(frameBytes - m_pendingBytes.size(), size);
+        m_pendingBytes.insert(m_pendingBytes.end(), bytes, bytes + need);
+        bytes += need;
+        size -= need;
+        if (m_pendingBytes.size() < frameBytes) {
+            return;
+        }
+        int16_t frame[16];
+        std::vector<int16_t> wideFrame;
+        int16_t *target = frame;
+        if (m_channels > 16) {
+            wideFrame.resize(size_t(m_channels));
+            target = wideFrame.data();
+        }
+        memcpy(target, m_pendingBytes.data(), frameBytes);
+        m_pendingBytes.clear();
+        pushFrames(target, 1, output);
+    }
+
+    // 管道数据不保证对齐，经过小缓冲区拷贝后再转换
+    std::vector<int16_t> staging(kConvertChunkFrames * size_t(m_channels));
+    size_t frames = size / frameBytes;
+    size_t done = 0;
+    while (done < frames) {
+        size_t n = std::min(frames - done, kConvertChunkFrames);
+        memcpy(staging.data(), bytes + done * frameBytes, n * frameBytes);
+        pushFrames(staging.data(), n, output);
+        done += n;
+    }
+
+    size_t rest = size - frames * frameBytes;
+    if (rest > 0) {
+        m_pendingBytes.assign(bytes + frames * frameBytes, bytes + size);
+    }
+}
+
+void AudioConverter::pushFrames(const int16_t *frames, size_t frameCount, std::vector<int16_t> &output)
+{
+    if (isPassthrough()) {
+        output.insert(output.end(), frames, frames + frameCount);
+        return;
+    }
+
+    while (frameCount > 0) {
+        size_t n = std::min(frameCount, kConvertChunkFrames);
+        m_mono.resize(n);
+        downmixS16ToMono(frames, n, m_channels, m_mono.data());
+
+        if (m_inputRate == m_outputRate) {
+            size_t offset = output.size();
+            output.resize(offset + n);
+            convertF32ToS16(m_mono.data(), output.data() + offset, n);
+        } else {
+            m_resampler.process(m_mono.data(), n, m_resampled);
+            emitResampled(output);
+        }
+
+        frames += n * size_t(m_channels);
+        frameCount -= n;
+    }
+}
+
+void AudioConverter::finish(std::vector<int16_t> &output)
+{
+    m_pendingBytes.clear();
+    if (m_inputRate != m_outputRate) {
+        m_resampler.flush(m_resampled);
+        emitResampled(output);
+    }
+}
+
+void AudioConverter::emitResampled(std::vector<int16_t> &output)
+{
+    if (m_resampled.empty()) {
+        return;
+    }
+    size_t offset = output.size();
+    output.resize(offset + m_resampled.size());
+    convertF32ToS16(m_resampled.data(), output.data() + offset, m_resampled.size());
+    m_resampled.clear();
+}
@@ -0,0 +1,275 @@
+#include "resourcemonitor.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+
+// 未归属内存连续增长多少次采样后发出警告
+const int kGrowthWarningSamples = 5;
+
+// 小于此值的增长视为波动
+const qint64 kGrowthThresholdBytes = 4 * 1024 * 1024;
+
+QString formatMegabytes(qint64 bytes)
+{
+    return QString::number(double(bytes) / (1024.0 * 1024.0), 'f', 1) + " MB";
+}
+
+} // namespace
+
+QString RecognitionJobStats::summary() const
+{
+    const double speed = wallMs > 0 ? audioSeconds * 1000.0 / wallMs : 0.0;
+    return QString("音频%1秒，耗时%2秒（解码%3秒，推理%4秒，%5倍实时），CPU %6秒，峰值内存增长%7，"
+                   "读取%8，解码%9，%10个片段，%11个token")
+            .arg(audioSeconds, 0, 'f', 1)
+            .arg(wallMs / 1000.0, 0, 'f', 1)
+            .arg(decodeMs / 1000.0, 0, 'f', 1)
+            .arg(inferenceMs / 1000.0, 0, 'f', 1)
+            .arg(speed, 0, 'f', 1)
+            .arg(cpuSeconds, 0, 'f', 1)
+            .arg(formatMegabytes(peakRssDeltaKb * 1024))
+            .arg(formatMegabytes(sourceBytes))
+            .arg(formatMegabytes(bytesDecoded))
+            .arg(segments)
+            .arg(tokensGenerated);
+}
+
+ProcessMemory readProcessMemory()
+{
+    ProcessMemory memory;
+
+#if defined(Q_OS_LINUX)
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly)) {
+        // 形如"VmRSS:     123456 kB"
+        for (const QByteArray &line : status.readAll().split('\n')) {
+            if (line.startsWith("VmRSS:")) {
+                memory.rssBytes = line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+            } else if (line.startsWith("VmHWM:")) {
+                memory.peakRssBytes = line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+            }
+        }
+    }
+#elif defined(Q_OS_UNIX)
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+#if defined(Q_OS_MACOS)
+        memory.peakRssBytes = ru.ru_maxrss;
+#else
+        memory.peakRssBytes = qint64(ru.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    memory.heapInUseBytes = qint64(info.uordblks + info.hblkhd);
+    memory.heapFreeBytes = qint64(info.fordblks);
+#endif
+
+    return memory;
+}
+
+QVector<ThreadCpuTime> readThreadCpuTimes()
+{
+    QVector<ThreadCpuTime> threads;
+
+#if defined(Q_OS_LINUX)
+    static const double ticksPerSecond = double(sysconf(_SC_CLK_TCK));
+    const QStringList taskIds = QDir("/proc/self/task").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    threads.reserve(taskIds.size());
+    for (const QString &taskId : taskIds) {
+        QFile stat("/proc/self/task/" + taskId + "/stat");
+        if (!stat.open(QIODevice::ReadOnly)) {
+            continue; // 线程可能已经退出
+        }
+        
+        // 格式为"tid (comm) state ppid ..."，线程名可能含空格和括号，以最后一个右括号为界；
+        // 右括号之后第12、13个字段是utime和stime（单位为时钟滴答）
+        const QByteArray line = stat.readAll();
+        const int open = line.indexOf('(');
+        const int close = line.lastIndexOf(')');
+        if (open < 0 || close < open) {
+            continue;
+        }
+        const QList<QByteArray> fields = line.mid(close + 2).split(' ');
+        if (fields.size() < 13) {
+            continue;
+        }
+        
+        ThreadCpuTime thread;
+        thread.threadId = taskId.toLongLong();
+        thread.name = QString::fromUtf8(line.mid(open + 1, close - open - 1));
+        thread.cpuSeconds = (fields.at(11).toLongLong() + fields.at(12).toLongLong()) / ticksPerSecond;
+        threads.append(thread);
+    }
+#endif
+
+    return threads;
+}
+
+qint64 readRssBytes()
+{
+#if defined(Q_OS_LINUX)
+    // 形如"size resident shared ..."，单位为页
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() >= 2) {
+            return fields.at(1).toLongLong() * qint64(sysconf(_SC_PAGESIZE));
+        }
+    }
+#endif
+    return 0;
+}
+
+RssPeakSampler::RssPeakSampler(int intervalMs) : m_intervalMs(qMax(1, intervalMs)),
+                                                 m_baselineBytes(0),
+                                                 m_peakBytes(0),
+                                                 m_stopping(false)
+{
+}
+
+RssPeakSampler::~RssPeakSampler()
+{
+    stop();
+}
+
+void RssPeakSampler::start()
+{
+    stop();
+    m_baselineBytes = readRssBytes();
+    m_peakBytes = m_baselineBytes;
+    m_stopping = false;
+    m_thread.reset(QThread::create([this]() {
+        QMutexLocker locker(&m_mutex);
+        while (!m_stopping) {
+            const qint64 rss = readRssBytes();
+            if (rss > m_peakBytes) {
+                m_peakBytes = rss;
+            }
+            m_wake.wait(&m_mutex, ulong(m_intervalMs));
+        }
+    }));
+    m_thread->setObjectName("EnRssSampler");
+    m_thread->start();
+}
+
+qint64 RssPeakSampler::stop()
+{
+    if (!m_thread) {
+        return 0;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    m_thread->wait();
+    m_thread.reset();
+
+    // 结束时再采样一次，包括最后一个间隔内的增长
+    const qint64 peak = qMax(m_peakBytes.load(), readRssBytes());
+    return qMax<qint64>(0, peak - m_baselineBytes);
+}
+
+double processCpuSeconds()
+{
+    double seconds = 0;
+#if defined(Q_OS_UNIX)
+    const int who[] = { RUSAGE_SELF, RUSAGE_CHILDREN };
+    for (int w : who) {
+        struct rusage ru;
+        if (getrusage(w, &ru) == 0) {
+            seconds += ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6
+                     + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+        }
+    }
+#endif
+    return seconds;
+}
+
+ResourceMonitor::ResourceMonitor(QObject *parent) : QObject(parent),
+                                                    m_lastUnattributed(-1),
+                                                    m_growthStreak(0)
+{
+    qRegisterMetaType<ProcessMemory>("ProcessMemory");
+    connect(&m_timer, &QTimer::timeout, this, &ResourceMonitor::sampleNow);
+}
+
+void ResourceMonitor::registerSubsystem(const QString &name, const std::function<qint64()> &bytesProvider)
+{
+    Subsystem subsystem;
+    subsystem.name = name;
+    subsystem.bytesProvider = bytesProvider;
+    m_subsystems.append(subsystem);
+}
+
+void ResourceMonitor::start(int intervalMs)
+{
+    m_timer.start(intervalMs);
+}
+
+void ResourceMonitor::stop()
+{
+    m_timer.stop();
+}
+
+void ResourceMonitor::sampleNow()
+{
+    const ProcessMemory memory = readProcessMemory();
+
+    QVector<SubsystemUsage> usages;
+    qint64 attributed = 0;
+    for (const Subsystem &subsystem : m_subsystems) {
+        SubsystemUsage usage;
+        usage.name = subsystem.name;
+        usage.bytes = subsystem.bytesProvider ? subsystem.bytesProvider() : 0;
+        attributed += usage.bytes;
+        usages.append(usage);
+    }
+
+    SubsystemUsage unattributed;
+    unattributed.name = "未归属";
+    unattributed.bytes = qMax<qint64>(0, memory.rssBytes - attributed);
+    usages.append(unattributed);
+
+    QStringList parts;
+    for (const SubsystemUsage &usage : usages) {
+        parts << QString("%1 %2").arg(usage.name).arg(formatMegabytes(usage.bytes));
+    }
+    QString summary = QString("RSS %1（峰值%2）：%3").arg(formatMegabytes(memory.rssBytes))
+                          .arg(formatMegabytes(memory.peakRssBytes)).arg(parts.join("，"));
+    if (memory.heapFreeBytes >= 0) {
+        summary += QString("；堆使用%1，空闲%2").arg(formatMegabytes(memory.heapInUseBytes))
+                       .arg(formatMegabytes(memory.heapFreeBytes));
+    }
+
+    // 未归属部分持续增长通常意味着泄漏或缓存无限增长
+    if (m_lastUnattributed >= 0 && unattributed.bytes > m_lastUnattributed + kGrowthThresholdBytes) {
+        ++m_growthStreak;
+    } else if (m_lastUnattributed >= 0 && unattributed.bytes < m_lastUnattributed) {
+        m_growthStreak = 0;
+    }
+    m_lastUnattributed = unattributed.bytes;
+
+    qInfo().noquote() << "[ResourceMonitor]" << summary;
+    if (m_growthStreak >= kGrowthWarningSamples) {
+        qWarning().noquote() << "[ResourceMonitor] 未归属内存已连续" << m_growthStreak << "次采样增长，当前"
+                             << formatMegabytes(unattributed.bytes) << "，可能存在泄漏";
+    }
+
+    emit memorySampled(memory, usages, summary);
+}
@@ -0,0 +1,212 @@
+#include "segmenteddecode.h"
+#include "audiostreamreader.h"
+#include "pcmbuffer.h"
+
+#include <QDebug>
+#include <QProcess>
+#include <QThread>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// 识别使用的采样率
+const int kSampleRate = 16000;
+
+// 每段之前预热的时长：seek后的第一帧缺少前一帧的重叠数据，重采样器也要先积累历史样本
+const qint64 kLeadInMs = 1000;
+
+// 有界的段多解码的时长，重采样器在末尾冲刷时的边缘效应落在截掉的部分
+const qint64 kLeadOutMs = 1000;
+
+// 中间的段最多允许比预期短这么多（最后一帧的补齐），再短说明探测的时长不准
+const size_t kMaxShortfallSamples = kSampleRate / 10;
+
+// 解码超时按连续无输出的时间计算
+const int kDecodeIdleTimeoutMs = 30000;
+
+bool failWith(QString *error, const QString &reason)
+{
+    if (error) {
+        *error = reason;
+    }
+    return false;
+}
+
+/**
+ * @brief 各段解码线程的结果
+ */
+struct PartResult
+{
+    bool ok = false;
+    qint64 sourceBytes = 0;
+    QString error;
+};
+
+/**
+ * @brief 用一个ffmpeg解码一段：丢弃预热部分，有界的段最多保留durationMs的样本
+ * @param padToDuration 样本不足durationMs时是否补静音（最后一段不补）
+ */
+bool decodeRange(const QString &mediaFilePath, const DecodeRange &range, bool padToDuration, PcmBuffer &output,
+                 PartResult &result)
+{
+    QProcess ffmpeg;
+    ffmpeg.start("ffmpeg", decodeRangeFfmpegArguments(mediaFilePath, range));
+    if (!ffmpeg.waitForStarted(2000)) {
+        return failWith(&result.error, "无法启动ffmpeg");
+    }
+
+    size_t skip = size_t(range.leadInMs * kSampleRate / 1000);
+    const size_t limit = range.durationMs >= 0 ? size_t(range.durationMs * kSampleRate / 1000)
+                                               : std::numeric_limits<size_t>::max();
+    WavStreamDecoder decoder;
+    std::vector<int16_t> converted;
+    auto keep = [&]() {
+        const size_t skipped = std::min(skip, converted.size());
+        skip -= skipped;
+        const size_t room = limit - std::min(limit, output.size());
+        output.append(converted.data() + skipped, std::min(converted.size() - skipped, room));
+        converted.clear();
+    };
+
+    int idleMs = 0;
+    while (ffmpeg.state() == QProcess::Running) {
+        if (ffmpeg.waitForReadyRead(1000)) {
+            const QByteArray chunk = ffmpeg.readAllStandardOutput();
+            result.sourceBytes += chunk.size();
+            decoder.push(chunk, converted);
+            keep();
+            idleMs = 0;
+        } else if ((idleMs += 1000) >= kDecodeIdleTimeoutMs) {
+            ffmpeg.kill();
+            ffmpeg.waitForFinished(1000);
+            return failWith(&result.error, "ffmpeg解码超时");
+        }
+    }
+    const QByteArray remaining = ffmpeg.readAllStandardOutput();
+    result.sourceBytes += remaining.size();
+    decoder.push(remaining, converted);
+    decoder.finish(converted);
+    keep();
+
+    if (ffmpeg.exitStatus() != QProcess::NormalExit || ffmpeg.exitCode() != 0) {
+        return failWith(&result.error, QString("ffmpeg失败: %1").arg(QString::fromUtf8(ffmpeg.readAllStandardError()).left(200)));
+    }
+    if (decoder.isInvalid()) {
+        return failWith(&result.error, "无法解析ffmpeg输出的WAV");
+    }
+
+    // 中间的段差几个样本时补静音，保证后面各段从正确的时间开始
+    if (padToDuration && output.size() < limit) {
+        const size_t missing = limit - output.size();
+        if (missing > kMaxShortfallSamples) {
+            return failWith(&result.error, QString("解码的音频比预期短%1毫秒").arg(qint64(missing) * 1000 / kSampleRate));
+        }
+        const std::vector<int16_t> silence(missing, 0);
+        output.append(silence.data(), silence.size());
+    }
+    return true;
+}
+
+} // namespace
+
+QVector<DecodeRange> planDecodeRanges(qint64 startMs, qint64 totalMs, bool lastToEnd, int maxParts, qint64 minPartMs)
+{
+    QVector<DecodeRange> ranges;
+    if (totalMs <= 0) {
+        return ranges;
+    }
+
+    const qint64 parts = qBound<qint64>(1, totalMs / qMax<qint64>(1, minPartMs), qMax(1, maxParts));
+    const qint64 partMs = (totalMs / parts + 999) / 1000 * 1000;
+    for (qint64 offsetMs = 0; offsetMs < totalMs; offsetMs += partMs) {
+        DecodeRange range;
+        range.startMs = startMs + offsetMs;
+        range.leadInMs = offsetMs > 0 ? qMin(kLeadInMs, range.startMs) : 0;
+        const bool last = offsetMs + partMs >= totalMs;
+        range.durationMs = last ? (lastToEnd ? -1 : totalMs - offsetMs) : partMs;
+        ranges.append(range);
+    }
+    return ranges;
+}
+
+QStringList decodeRangeFfmpegArguments(const QString &mediaFilePath, const DecodeRange &range)
+{
+    // 与单个ffmpeg解码时一样不指定音轨，各段选择的是同一条默认音轨
+    QStringList args;
+    args << "-hide_banner" << "-nostdin" << "-nostats" << "-v" << "error";
+    const qint64 seekMs = range.startMs - range.leadInMs;
+    if (seekMs > 0) {
+        args << "-ss" << QString::number(seekMs / 1000.0, 'f', 3);
+    }
+    if (range.durationMs >= 0) {
+        args << "-t" << QString::number((range.leadInMs + range.durationMs + kLeadOutMs) / 1000.0, 'f', 3);
+    }
+    args << "-i" << mediaFilePath
+         << "-vn"
+         << "-f" << "wav"
+         << "-acodec" << "pcm_s16le"
+         << "-";
+    return args;
+}
+
+bool decodeRangesInParallel(const QString &mediaFilePath, const QVector<DecodeRange> &ranges, PcmBuffer &samples,
+                            qint64 *sourceBytes, QString *error)
+{
+    if (ranges.isEmpty()) {
+        return failWith(error, "没有要解码的区间");
+    }
+
+    // 解码期间各段平分内存预算，拼接时恢复samples原来的预算
+    const int partCount = ranges.size();
+    const qint64 memoryBudgetBytes = samples.memoryBudgetBytes();
+    samples.clear();
+    samples.setSpillPolicy(memoryBudgetBytes / partCount, samples.scratchDirectory());
+    std::vector<std::unique_ptr<PcmBuffer>> parts;
+    std::vector<PcmBuffer *> outputs;
+    outputs.push_back(&samples);
+    for (int k = 1; k < partCount; ++k) {
+        parts.emplace_back(new PcmBuffer);
+        parts.back()->setSpillPolicy(memoryBudgetBytes / partCount, samples.scratchDirectory());
+        outputs.push_back(parts.back().get());
+    }
+
+    qCritical() << "[SegmentedDecode] 分" << partCount << "段并行解码:" << mediaFilePath;
+    std::vector<PartResult> results(size_t(partCount));
+    std::vector<std::unique_ptr<QThread>> workers;
+    for (int k = 0; k < partCount; ++k) {
+        const bool padToDuration = (k < partCount - 1);
+        workers.emplace_back(QThread::create([&, k, padToDuration]() {
+            PartResult &result = results[size_t(k)];
+            result.ok = decodeRange(mediaFilePath, ranges.at(k), padToDuration, *outputs[size_t(k)], result);
+        }));
+        workers.back()->setObjectName(QString("EnDecode%1").arg(k));
+        workers.back()->start();
+    }
+    for (const std::unique_ptr<QThread> &worker : workers) {
+        worker->wait();
+    }
+    samples.setSpillPolicy(memoryBudgetBytes, samples.scratchDirectory());
+
+    qint64 totalBytes = 0;
+    for (int k = 0; k < partCount; ++k) {
+        const PartResult &result = results[size_t(k)];
+        if (!result.ok) {
+            samples.clear();
+            return failWith(error, QString("第%1段（%2毫秒起）: %3").arg(k + 1).arg(ranges.at(k).startMs).arg(result.error));
+        }
+        totalBytes += result.sourceBytes;
+    }
+
+    // 按顺序拼接，拼接完的段立即释放
+    for (const std::unique_ptr<PcmBuffer> &part : parts) {
+        samples.append(*part);
+        part->clear();
+    }
+    if (sourceBytes) {
+        *sourceBytes = totalBytes;
+    }
+    return true;
+}
@@ -0,0 +1,272 @@
+#include "segmentstore.h"
+
+#include <QIODevice>
+#include <cstring>
+
+namespace {
+
+const char kStoreMagic[4] = { 'Q', 'E', 'S', 'S' };
+const quint32 kStoreVersion = 2;
+
+// 写入时的字节序标记，读取时不一致说明文件来自字节序不同的机器
+const quint32 kByteOrderMark = 0x01020304;
+
+static_assert(sizeof(SegmentRecord) == 40, "SegmentRecord is written to disk as is");
+static_assert(sizeof(SegmentStoreHeader) == 40, "SegmentStoreHeader is written to disk as is");
+
+template <typename T>
+bool writeArray(QIODevice *device, const std::vector<T> &values)
+{
+    const qint64 bytes = qint64(values.size() * sizeof(T));
+    return bytes == 0 || device->write(reinterpret_cast<const char *>(values.data()), bytes) == bytes;
+}
+
+template <typename T>
+bool readArray(QIODevice *device, std::vector<T> &values, size_t count)
+{
+    values.resize(count);
+    const qint64 bytes = qint64(count * sizeof(T));
+    return bytes == 0 || device->read(reinterpret_cast<char *>(values.data()), bytes) == bytes;
+}
+
+} // namespace
+
+quint64 SegmentStoreHeader::payloadBytes() const
+{
+    return quint64(segmentCount) * sizeof(SegmentRecord) + quint64(wordCount) * 3 * sizeof(qint32) + textBytes;
+}
+
+bool SegmentStoreHeader::isValid(qint64 availableBytes, QString *error) const
+{
+    QString reason;
+    if (std::memcmp(magic, kStoreMagic, sizeof(magic)) != 0) {
+        reason = "不是片段存储文件";
+    } else if (version != kStoreVersion || recordSize != sizeof(SegmentRecord)) {
+        reason = QString("不支持的版本: %1").arg(version);
+    } else if (byteOrder != kByteOrderMark) {
+        reason = "文件的字节序与本机不同";
+    } else if (availableBytes >= 0 && payloadBytes() > quint64(availableBytes)) {
+        // 先检查剩余字节，避免按损坏的计数分配大块内存
+        reason = "文件被截断";
+    }
+
+    if (!reason.isEmpty() && error) {
+        *error = reason;
+    }
+    return reason.isEmpty();
+}
+
+class SegmentStoreData : public QSharedData
+{
+public:
+    std::vector<SegmentRecord> records;
+    std::vector<qint32> wordStartMs;
+    std::vector<qint32> wordEndMs;
+    std::vector<qint32> wordTextOffset;
+    std::vector<char> text;   ///< 所有片段的UTF-8文本，首尾相接，不含结束符
+};
+
+SegmentStore::SegmentStore() : d(new SegmentStoreData)
+{
+}
+
+SegmentStore::SegmentStore(const SegmentStore &other) = default;
+SegmentStore &SegmentStore::operator=(const SegmentStore &other) = default;
+SegmentStore::~SegmentStore() = default;
+
+SegmentStore SegmentStore::fromSegments(const QVector<TranscriptSegment> &segments)
+{
+    SegmentStore store;
+    qint64 textBytes = 0;
+    for (const TranscriptSegment &segment : segments) {
+        // UTF-16转UTF-8最多3倍，这里只是预估
+        textBytes += segment.text.size();
+    }
+    store.reserve(segments.size(), textBytes);
+    for (const TranscriptSegment &segment : segments) {
+        store.append(segment);
+    }
+    return store;
+}
+
+void SegmentStore::reserve(int segments, qint64 textBytes)
+{
+    d->records.reserve(size_t(qMax(0, segments)));
+    d->text.reserve(size_t(qMax<qint64>(0, textBytes)));
+}
+
+void SegmentStore::append(qint64 startMs, qint64 endMs, const char *utf8, int bytes, float probability,
+                          const TranscriptWords &words)
+{
+    SegmentStoreData *data = d.data();
+
+    SegmentRecord record;
+    record.startMs = startMs;
+    record.endMs = endMs;
+    record.textOffset = quint32(data->text.size());
+    record.textBytes = quint32(qMax(0, bytes));
+    record.firstWord = quint32(data->wordStartMs.size());
+    record.wordCount = quint32(words.size());
+    record.probability = probability;
+    record.reserved = 0;
+    data->records.push_back(record);
+
+    if (bytes > 0) {
+        data->text.insert(data->text.end(), utf8, utf8 + bytes);
+    }
+    data->wordStartMs.insert(data->wordStartMs.end(), words.startMs.constBegin(), words.startMs.constEnd());
+    data->wordEndMs.insert(data->wordEndMs.end(), words.endMs.constBegin(), words.endMs.constEnd());
+    data->wordTextOffset.insert(data->wordTextOffset.end(), words.textOffset.constBegin(), words.textOffset.constEnd());
+}
+
+void SegmentStore::append(const TranscriptSegment &segment)
+{
+    const QByteArray utf8 = segment.text.toUtf8();
+    append(segment.startMs, segment.endMs, utf8.constData(), utf8.size(), -1.0f, segment.words);
+}
+
+void SegmentStore::clear()
+{
+    d = new SegmentStoreData;
+}
+
+int SegmentStore::size() const
+{
+    return int(d->records.size());
+}
+
+const SegmentRecord &SegmentStore::record(int index) const
+{
+    return d->records[size_t(index)];
+}
+
+const char *SegmentStore::textData(int index) const
+{
+    return d->text.data() + d->records[size_t(index)].textOffset;
+}
+
+QString SegmentStore::text(int index) const
+{
+    const SegmentRecord &segmentRecord = record(index);
+    return QString::fromUtf8(textData(index), int(segmentRecord.textBytes));
+}
+
+TranscriptWords SegmentStore::words(int index) const
+{
+    const SegmentRecord &segmentRecord = record(index);
+    TranscriptWords result;
+    if (segmentRecord.wordCount == 0) {
+        return result;
+    }
+    const int count = int(segmentRecord.wordCount);
+    const size_t first = segmentRecord.firstWord;
+    result.startMs.resize(count);
+    result.endMs.resize(count);
+    result.textOffset.resize(count);
+    std::memcpy(result.startMs.data(), d->wordStartMs.data() + first, size_t(count) * sizeof(qint32));
+    std::memcpy(result.endMs.data(), d->wordEndMs.data() + first, size_t(count) * sizeof(qint32));
+    std::memcpy(result.textOffset.data(), d->wordTextOffset.data() + first, size_t(count) * sizeof(qint32));
+    return result;
+}
+
+TranscriptSegment SegmentStore::segment(int index) const
+{
+    const SegmentRecord &segmentRecord = record(index);
+    TranscriptSegment result;
+    result.startMs = segmentRecord.startMs;
+    result.endMs = segmentRecord.endMs;
+    result.text = text(index);
+    result.words = words(index);
+    return result;
+}
+
+QVector<TranscriptSegment> SegmentStore::toSegments() const
+{
+    QVector<TranscriptSegment> segments;
+    segments.reserve(size());
+    for (int i = 0; i < size(); ++i) {
+        segments.append(segment(i));
+    }
+    return segments;
+}
+
+QString SegmentStore::joinedText() const
+{
+    // 先在文本区上拼出UTF-8，再一次转换
+    std::vector<char> joined;
+    joined.reserve(d->text.size() + d->records.size());
+    for (const SegmentRecord &segmentRecord : d->records) {
+        if (!joined.empty()) {
+            joined.push_back(' ');
+        }
+        const char *begin = d->text.data() + segmentRecord.textOffset;
+        joined.insert(joined.end(), begin, begin + segmentRecord.textBytes);
+    }
+    return QString::fromUtf8(joined.data(), int(joined.size()));
+}
+
+qint64 SegmentStore::memoryBytes() const
+{
+    return qint64(d->records.capacity() * sizeof(SegmentRecord))
+            + qint64((d->wordStartMs.capacity() + d->wordEndMs.capacity() + d->wordTextOffset.capacity()) * sizeof(qint32))
+            + qint64(d->text.capacity());
+}
+
+bool SegmentStore::writeTo(QIODevice *device, quint64 sourceKey) const
+{
+    SegmentStoreHeader header;
+    std::memcpy(header.magic, kStoreMagic, sizeof(header.magic));
+    header.version = kStoreVersion;
+    header.recordSize = sizeof(SegmentRecord);
+    header.byteOrder = kByteOrderMark;
+    header.segmentCount = quint32(d->records.size());
+    header.wordCount = quint32(d->wordStartMs.size());
+    header.textBytes = quint64(d->text.size());
+    header.sourceKey = sourceKey;
+
+    if (device->write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))) {
+        return false;
+    }
+    return writeArray(device, d->records)
+            && writeArray(device, d->wordStartMs)
+            && writeArray(device, d->wordEndMs)
+            && writeArray(device, d->wordTextOffset)
+            && writeArray(device, d->text);
+}
+
+SegmentStore SegmentStore::readFrom(QIODevice *device, QString *error)
+{
+    auto fail = [error](const QString &reason) {
+        if (error) {
+            *error = reason;
+        }
+        return SegmentStore();
+    };
+
+    SegmentStoreHeader header;
+    if (device->read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header))) {
+        return fail("文件头不完整");
+    }
+    QString reason;
+    if (!header.isValid(device->isSequential() ? -1 : device->size() - device->pos(), &reason)) {
+        return fail(reason);
+    }
+
+    SegmentStore store;
+    SegmentStoreData *data = store.d.data();
+    if (!readArray(device, data->records, header.segmentCount)
+        || !readArray(device, data->wordStartMs, header.wordCount)
+        || !readArray(device, data->wordEndMs, header.wordCount)
+        || !readArray(device, data->wordTextOffset, header.wordCount)
+        || !readArray(device, data->text, size_t(header.textBytes))) {
+        return fail("文件被截断");
+    }
+
+    for (const SegmentRecord &segmentRecord : data->records) {
+        if (quint64(segmentRecord.textOffset) + segmentRecord.textBytes > header.textBytes
+            || quint64(segmentRecord.firstWord) + segmentRecord.wordCount > header.wordCount) {
+            return fail("片段记录超出范围");
+        }
+    }
+    return store;
+}
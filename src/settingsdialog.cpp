@@ -44,6 +44,16 @@ void SettingsDialog::loadSettingsToUI()
     
     // 加载字幕设置
     ui->subtitleDirLineEdit->setText(m_settingsManager->getSubtitleSaveDirectory());
+    ui->wordTimestampsCheckBox->setChecked(m_settingsManager->isWordTimestampsEnabled());
+    
+    // 加载性能设置
+    ui->audioMemoryBudgetSpinBox->setValue(m_settingsManager->getAudioMemoryBudgetMB());
+    ui->scratchDirLineEdit->setText(m_settingsManager->getScratchDirectory());
+    ui->recognitionThreadsSpinBox->setValue(m_settingsManager->getRecognitionThreads());
+    ui->decodingProfileComboBox->setCurrentIndex(m_settingsManager->getDecodingProfile() == "beam" ? 1 : 0);
+    ui->metricsEnabledCheckBox->setChecked(m_settingsManager->isMetricsEnabled());
+    ui->metricsPortSpinBox->setValue(m_settingsManager->getMetricsPort());
+    ui->watchFoldersCheckBox->setChecked(m_settingsManager->isWatchFoldersEnabled());
 }
 
 void SettingsDialog::saveSettingsFromUI()
@@ -57,6 +67,16 @@ void SettingsDialog::saveSettingsFromUI()
     
     // 保存字幕设置
     m_settingsManager->setSubtitleSaveDirectory(ui->subtitleDirLineEdit->text());
+    m_settingsManager->setWordTimestampsEnabled(ui->wordTimestampsCheckBox->isChecked());
+    
+    // 保存性能设置
+    m_settingsManager->setAudioMemoryBudgetMB(ui->audioMemoryBudgetSpinBox->value());
+    m_settingsManager->setScratchDirectory(ui->scratchDirLineEdit->text());
+    m_settingsManager->setRecognitionThreads(ui->recognitionThreadsSpinBox->value());
+    m_settingsManager->setDecodingProfile(ui->decodingProfileComboBox->currentIndex() == 1 ? "beam" : "greedy");
+    m_settingsManager->setMetricsEnabled(ui->metricsEnabledCheckBox->isChecked());
+    m_settingsManager->setMetricsPort(ui->metricsPortSpinBox->value());
+    m_settingsManager->setWatchFoldersEnabled(ui->watchFoldersCheckBox->isChecked());
     
     // 保存到文件
     m_settingsManager->saveSettings();
@@ -104,6 +124,19 @@ void SettingsDialog::on_browseSubtitleDirButton_clicked()
     }
 }
 
+void SettingsDialog::on_browseScratchDirButton_clicked()
+{
+    QString dir = QFileDialog::getExistingDirectory(
+        this,
+        tr("选择音频暂存目录"),
+        ui->scratchDirLineEdit->text()
+    );
+    
+    if (!dir.isEmpty()) {
+        ui->scratchDirLineEdit->setText(dir);
+    }
+}
+
 void SettingsDialog::on_downloadModelButton_clicked()
 {
     // 模型下载提示，提供更多信息
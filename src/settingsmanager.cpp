@@ -45,6 +45,14 @@ void SettingsManager::setDefaultValues()
     m_recognitionLanguage = "auto";
     m_preferOnlineAPI = false;
     m_apiUrl = "https://api.example.com/asr";
+    m_audioMemoryBudgetMB = 512;
+    m_scratchDirectory = "";
+    m_recognitionThreads = 0;
+    m_decodingProfile = "greedy";
+    m_wordTimestamps = false;
+    m_metricsEnabled = false;
+    m_metricsPort = 9464;
+    m_watchFolders = false;
     
     // 默认字幕保存目录为用户的文档目录
     m_subtitleSaveDirectory = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + QDir::separator() + "EnPlayer" + QDir::separator() + "Subtitles";
@@ -141,6 +149,110 @@ void SettingsManager::setSubtitleSaveDirectory(const QString &directory)
     }
 }
 
+int SettingsManager::getAudioMemoryBudgetMB() const
+{
+    return m_audioMemoryBudgetMB;
+}
+
+void SettingsManager::setAudioMemoryBudgetMB(int megabytes)
+{
+    if (m_audioMemoryBudgetMB != megabytes) {
+        m_audioMemoryBudgetMB = megabytes;
+        emit settingsChanged();
+    }
+}
+
+QString SettingsManager::getScratchDirectory() const
+{
+    return m_scratchDirectory;
+}
+
+void SettingsManager::setScratchDirectory(const QString &directory)
+{
+    if (m_scratchDirectory != directory) {
+        m_scratchDirectory = directory;
+        emit settingsChanged();
+    }
+}
+
+int SettingsManager::getRecognitionThreads() const
+{
+    return m_recognitionThreads;
+}
+
+void SettingsManager::setRecognitionThreads(int threads)
+{
+    if (m_recognitionThreads != threads) {
+        m_recognitionThreads = threads;
+        emit settingsChanged();
+    }
+}
+
+QString SettingsManager::getDecodingProfile() const
+{
+    return m_decodingProfile;
+}
+
+void SettingsManager::setDecodingProfile(const QString &profile)
+{
+    if (m_decodingProfile != profile) {
+        m_decodingProfile = profile;
+        emit settingsChanged();
+    }
+}
+
+bool SettingsManager::isWordTimestampsEnabled() const
+{
+    return m_wordTimestamps;
+}
+
+void SettingsManager::setWordTimestampsEnabled(bool enabled)
+{
+    if (m_wordTimestamps != enabled) {
+        m_wordTimestamps = enabled;
+        emit settingsChanged();
+    }
+}
+
+bool SettingsManager::isMetricsEnabled() const
+{
+    return m_metricsEnabled;
+}
+
+void SettingsManager::setMetricsEnabled(bool enabled)
+{
+    if (m_metricsEnabled != enabled) {
+        m_metricsEnabled = enabled;
+        emit settingsChanged();
+    }
+}
+
+int SettingsManager::getMetricsPort() const
+{
+    return m_metricsPort;
+}
+
+void SettingsManager::setMetricsPort(int port)
+{
+    if (m_metricsPort != port) {
+        m_metricsPort = port;
+        emit settingsChanged();
+    }
+}
+
+bool SettingsManager::isWatchFoldersEnabled() const
+{
+    return m_watchFolders;
+}
+
+void SettingsManager::setWatchFoldersEnabled(bool enabled)
+{
+    if (m_watchFolders != enabled) {
+        m_watchFolders = enabled;
+        emit settingsChanged();
+    }
+}
+
 void SettingsManager::saveSettings()
 {
     if (!m_settings) {
@@ -158,6 +270,23 @@ void SettingsManager::saveSettings()
     
     m_settings->beginGroup("Subtitles");
     m_settings->setValue("SaveDirectory", m_subtitleSaveDirectory);
+    m_settings->setValue("WordTimestamps", m_wordTimestamps);
+    m_settings->endGroup();
+    
+    m_settings->beginGroup("Performance");
+    m_settings->setValue("AudioMemoryBudgetMB", m_audioMemoryBudgetMB);
+    m_settings->setValue("ScratchDirectory", m_scratchDirectory);
+    m_settings->setValue("RecognitionThreads", m_recognitionThreads);
+    m_settings->setValue("DecodingProfile", m_decodingProfile);
+    m_settings->endGroup();
+    
+    m_settings->beginGroup("Monitoring");
+    m_settings->setValue("MetricsEnabled", m_metricsEnabled);
+    m_settings->setValue("MetricsPort", m_metricsPort);
+    m_settings->endGroup();
+    
+    m_settings->beginGroup("Library");
+    m_settings->setValue("WatchFolders", m_watchFolders);
     m_settings->endGroup();
     
     // 确保保存设置
@@ -206,6 +335,23 @@ void SettingsManager::loadSettings()
     m_settings->beginGroup("Subtitles");
     m_subtitleSaveDirectory = m_settings->value("SaveDirectory", 
         QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + QDir::separator() + "EnPlayer" + QDir::separator() + "Subtitles").toString();
+    m_wordTimestamps = m_settings->value("WordTimestamps", false).toBool();
+    m_settings->endGroup();
+    
+    m_settings->beginGroup("Performance");
+    m_audioMemoryBudgetMB = m_settings->value("AudioMemoryBudgetMB", 512).toInt();
+    m_scratchDirectory = m_settings->value("ScratchDirectory", "").toString();
+    m_recognitionThreads = m_settings->value("RecognitionThreads", 0).toInt();
+    m_decodingProfile = m_settings->value("DecodingProfile", "greedy").toString();
+    m_settings->endGroup();
+    
+    m_settings->beginGroup("Monitoring");
+    m_metricsEnabled = m_settings->value("MetricsEnabled", false).toBool();
+    m_metricsPort = m_settings->value("MetricsPort", 9464).toInt();
+    m_settings->endGroup();
+    
+    m_settings->beginGroup("Library");
+    m_watchFolders = m_settings->value("WatchFolders", false).toBool();
     m_settings->endGroup();
     
     // 确保字幕目录存在
@@ -1,5 +1,14 @@
 #include "speechrecognizer.h"
 #include "settingsmanager.h"
+#include "wavreader.h"
+#include "pcmconvert.h"
+#include "resampler.h"
+#include "vad.h"
+#include "recognizermetrics.h"
+#include "segmentstore.h"
+#include "alignment.h"
+#include "audiostreamreader.h"
+#include "segmenteddecode.h"
 
 #include <QDir>
 #include <QFileInfo>
@@ -7,10 +16,242 @@
 #include <QFile>
 #include <QJsonParseError>
 #include <QCoreApplication>
+#include <QMutex>
+#include <QWaitCondition>
+#include <cmath>
 #include <cstring>
 #include <fstream>
+#include <memory>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <functional>
+
+namespace {
+
+// 每次交给whisper的窗口长度，窗口内的样本才会转换为浮点数
+const int kRecognitionWindowSeconds = 300;
+
+// 在窗口末尾向前搜索静音切分点的范围和帧长
+const size_t kCutSearchSamples = 2 * WHISPER_SAMPLE_RATE;
+const size_t kCutFrameSamples = WHISPER_SAMPLE_RATE / 50;
+
+// 从映射的WAV文件转换时每次处理的帧数
+const qint64 kConvertChunkFrames = 1 << 16;
+
+// 跟随识别：每积累这么多新音频就识别一次，识别结果比写入方落后几秒
+const size_t kFollowStepSamples = 3 * WHISPER_SAMPLE_RATE;
+
+// 跟随识别时在新音频末尾向前搜索切分点的范围，切分点之后的音频留到下一次，避免把正在说的词切断
+const size_t kFollowCutSearchSamples = WHISPER_SAMPLE_RATE;
+
+// 网络流每次最多识别的长度；识别跟不上时读取器丢弃旧音频，落后时间不超过窗口加上读取队列的容量
+const int kLiveWindowSeconds = 30;
+
+// whisper的编码器窗口为30秒，时间戳token的精度为20毫秒
+const int kAlignmentWindowSeconds = 30;
+const int kTimestampStepMs = 20;
+const int kTimestampCount = kAlignmentWindowSeconds * 1000 / kTimestampStepMs;
+
+// 时间戳概率低于此值时不作为词起点的估计（与识别时的thold_pt相同）
+const float kTimestampHintThreshold = 0.01f;
+
+/**
+ * @brief 在一段浮点样本中找能量最低的20毫秒帧，返回其起点相对samples的偏移
+ */
+size_t findQuietestFrame(const float *samples, size_t count)
+{
+    std::vector<float> energies;
+    computeFrameEnergies(samples, count, kCutFrameSamples, energies);
+    if (energies.empty()) {
+        return count;
+    }
+    return size_t(std::min_element(energies.begin(), energies.end()) - energies.begin()) * kCutFrameSamples;
+}
+
+/**
+ * @brief 在target之前的一段范围内找能量最低的20毫秒帧作为窗口切分点，尽量避免把词切断
+ */
+size_t findQuietCutPoint(const PcmBuffer &buffer, size_t target, size_t searchSamples)
+{
+    if (target <= searchSamples + kCutFrameSamples) {
+        return target;
+    }
+
+    const size_t searchStart = target - searchSamples;
+    std::vector<float> samples(searchSamples);
+    buffer.toFloat(searchStart, searchSamples, samples.data());
+    return searchStart + findQuietestFrame(samples.data(), searchSamples);
+}
+
+/**
+ * @brief 同上，用于跟随识别中尚未识别的16位样本
+ */
+size_t findQuietCutPoint(const std::vector<int16_t> &pending, size_t target, size_t searchSamples)
+{
+    if (target <= searchSamples + kCutFrameSamples) {
+        return target;
+    }
+
+    const size_t searchStart = target - searchSamples;
+    std::vector<float> samples(searchSamples);
+    convertS16ToF32(pending.data() + searchStart, samples.data(), searchSamples);
+    return searchStart + findQuietestFrame(samples.data(), searchSamples);
+}
+
+/**
+ * @brief 读取whisper的识别结果：state为空时读取上下文自带的状态，否则读取并行识别音轨时各自的状态
+ */
+struct WhisperResults
+{
+    whisper_context *ctx;
+    whisper_state *state;
+
+    int segmentCount() const
+    {
+        return state ? whisper_full_n_segments_from_state(state) : whisper_full_n_segments(ctx);
+    }
+    int64_t segmentT0(int i) const
+    {
+        return state ? whisper_full_get_segment_t0_from_state(state, i) : whisper_full_get_segment_t0(ctx, i);
+    }
+    int64_t segmentT1(int i) const
+    {
+        return state ? whisper_full_get_segment_t1_from_state(state, i) : whisper_full_get_segment_t1(ctx, i);
+    }
+    const char *segmentText(int i) const
+    {
+        return state ? whisper_full_get_segment_text_from_state(state, i) : whisper_full_get_segment_text(ctx, i);
+    }
+    int tokenCount(int i) const
+    {
+        return state ? whisper_full_n_tokens_from_state(state, i) : whisper_full_n_tokens(ctx, i);
+    }
+    whisper_token tokenId(int i, int j) const
+    {
+        return state ? whisper_full_get_token_id_from_state(state, i, j) : whisper_full_get_token_id(ctx, i, j);
+    }
+    float tokenP(int i, int j) const
+    {
+        return state ? whisper_full_get_token_p_from_state(state, i, j) : whisper_full_get_token_p(ctx, i, j);
+    }
+    const char *tokenText(int i, int j) const
+    {
+        return state ? whisper_full_get_token_text_from_state(ctx, state, i, j) : whisper_full_get_token_text(ctx, i, j);
+    }
+    whisper_token_data tokenData(int i, int j) const
+    {
+        return state ? whisper_full_get_token_data_from_state(state, i, j) : whisper_full_get_token_data(ctx, i, j);
+    }
+};
+
+/**
+ * @brief 从片段的token时间戳中整理出各词的时间
+ *
+ * 以空格开头的token开始一个新词，其余token（词的后半部分、标点）并入前一个词。
+ * token文本是UTF-8字节，多字节字符可能跨token，因此先记录字节偏移，最后再换算为字符偏移。
+ */
+TranscriptWords collectWordTimings(const WhisperResults &results, int segment, whisper_token eotToken)
+{
+    TranscriptWords words;
+    const int64_t segmentT0 = results.segmentT0(segment);
+    const int tokenCount = results.tokenCount(segment);
+    QByteArray text;
+    std::vector<int> byteOffsets;
+
+    for (int j = 0; j < tokenCount; ++j) {
+        if (results.tokenId(segment, j) >= eotToken) {
+            continue;
+        }
+        const char *piece = results.tokenText(segment, j);
+        if (!piece || !*piece) {
+            continue;
+        }
+        const whisper_token_data data = results.tokenData(segment, j);
+        const qint32 startMs = qint32(qMax<int64_t>(0, data.t0 - segmentT0) * 10);
+        const qint32 endMs = qint32(qMax<int64_t>(0, data.t1 - segmentT0) * 10);
+
+        const bool leadingSpace = (piece[0] == ' ');
+        if (words.isEmpty() || (leadingSpace && piece[1] != '\0')) {
+            byteOffsets.push_back(text.size() + (leadingSpace ? 1 : 0));
+            words.startMs.append(startMs);
+            words.endMs.append(qMax(startMs, endMs));
+        } else {
+            words.endMs.last() = qMax(words.endMs.last(), endMs);
+        }
+        text += piece;
+    }
+
+    // 片段文本去掉了首尾空白，偏移要减去开头的空白字符
+    int leadingBytes = 0;
+    while (leadingBytes < text.size() && QChar(text.at(leadingBytes)).isSpace()) {
+        ++leadingBytes;
+    }
+
+    words.textOffset.reserve(int(byteOffsets.size()));
+    int previousBytes = leadingBytes;
+    int characters = 0;
+    for (int offset : byteOffsets) {
+        if (offset > previousBytes) {
+            characters += QString::fromUtf8(text.constData() + previousBytes, offset - previousBytes).size();
+            previousBytes = offset;
+        }
+        words.textOffset.append(characters);
+    }
+    return words;
+}
+
+// 长文件分段并行解码：最多同时运行的ffmpeg数，以及每段的最短时长（太短时启动和预热的开销不划算）
+const int kMaxDecodeParts = 8;
+const qint64 kMinDecodePartMs = 5 * 60 * 1000;
+
+/**
+ * @brief 为ffmpeg解码路径规划并行解码的区间，不值得分段时只返回一段
+ *
+ * 时长来自ffprobe，取ffmpeg默认会选择的音轨（声道数最多的一条）。
+ * 探测的时长只用于确定分段，最后一段总是解码到区间或文件的真实结尾。
+ */
+QVector<DecodeRange> planParallelDecode(const QString &audioFilePath, qint64 startMs, qint64 durationMs)
+{
+    const int maxParts = qMin(kMaxDecodeParts, QThread::idealThreadCount());
+    // 指定的区间太短，不会分段，不必为此多启动一个ffprobe
+    if (maxParts < 2 || (durationMs > 0 && durationMs < 2 * kMinDecodePartMs)) {
+        return QVector<DecodeRange>();
+    }
+
+    QVector<AudioTrack> tracks;
+    if (!probeAudioTracks(audioFilePath, tracks) || tracks.isEmpty()) {
+        return QVector<DecodeRange>();
+    }
+    const AudioTrack *track = &tracks.first();
+    for (const AudioTrack &candidate : tracks) {
+        if (candidate.channels > track->channels) {
+            track = &candidate;
+        }
+    }
+    if (track->durationMs <= startMs) {
+        return QVector<DecodeRange>();
+    }
+
+    const qint64 availableMs = track->durationMs - startMs;
+    const bool toEnd = durationMs <= 0 || durationMs >= availableMs;
+    return planDecodeRanges(startMs, toEnd ? availableMs : durationMs, toEnd, maxParts, kMinDecodePartMs);
+}
+
+/**
+ * @brief 多音轨识别时一条音轨的样本队列：解码线程追加，识别线程按窗口取走
+ */
+struct TrackFeed
+{
+    QMutex mutex;
+    QWaitCondition changed;
+    std::vector<int16_t> pending;  ///< 已解码、尚未识别的样本
+    qint64 received = 0;           ///< 解码出的样本总数
+    bool finished = false;         ///< 解码已结束，不会再有新样本
+    bool done = false;             ///< 识别线程已退出，不再取样本
+};
+
+} // namespace
 
 SpeechRecognizer::SpeechRecognizer(QObject *parent) : QObject(parent)
 {
@@ -24,9 +265,34 @@ SpeechRecognizer::SpeechRecognizer(QObject *parent) : QObject(parent)
     m_modelSize = "small";
     m_apiUrl = "https://api.example.com/asr";
     m_preferOnlineAPI = false;
+    m_preferOnlineAPIFixed = false;
+    m_audioMemoryBudgetMB = 512;
+    m_threadCount = 0;
+    m_decodingProfile = "greedy";
+    m_wordTimestamps = false;
     m_isRecognizing = false;
     m_audioSampleRate = 0;
     m_shouldStop = false;
+    m_finishFollowing = false;
+    m_rangeStartMs = -1;
+    m_rangeEndMs = -1;
+    m_windowOffsetMs = 0;
+    m_loadedSourceBytes = 0;
+    m_trackResidentBytes = 0;
+    m_jobCpuStart = 0;
+    m_jobActive = false;
+    
+    qRegisterMetaType<TranscriptSegment>("TranscriptSegment");
+    qRegisterMetaType<QVector<TranscriptSegment>>("QVector<TranscriptSegment>");
+    qRegisterMetaType<RecognitionJobStats>("RecognitionJobStats");
+    qRegisterMetaType<AudioTrack>("AudioTrack");
+    
+    // 所有失败都经过recognitionError，在这里统一计数；只计已经开始的任务，开始前的参数检查失败不算
+    connect(this, &SpeechRecognizer::recognitionError, this, [this]() {
+        if (m_jobActive.exchange(false)) {
+            recognizerMetrics().jobsFailed.increment();
+        }
+    });
     
     // 连接设置更改信号
     connect(SettingsManager::instance(), &SettingsManager::settingsChanged, this, &SpeechRecognizer::applySettings);
@@ -166,7 +432,10 @@ bool SpeechRecognizer::initialize(const QString &modelPath)
             
             // 尝试初始化模型并记录详细错误信息
             qDebug() << "尝试初始化Whisper上下文...";
+            QElapsedTimer loadTimer;
+            loadTimer.start();
             m_whisperCtx = whisper_init_from_file_with_params(m_whisperPath.toUtf8().constData(), ctx_params);
+            recognizerMetrics().modelLoadSeconds.observe(loadTimer.nsecsElapsed() / 1e9);
             
             if (m_whisperCtx == nullptr) {
                 qWarning() << "初始化Whisper上下文失败:" << m_whisperPath;
@@ -267,6 +536,11 @@ void SpeechRecognizer::applySettings()
     }
     }
     
+    // 应用性能设置
+    m_threadCount = settings->getRecognitionThreads();
+    m_decodingProfile = settings->getDecodingProfile();
+    m_wordTimestamps = settings->isWordTimestampsEnabled();
+    
     // 应用语言设置
     m_language = settings->getRecognitionLanguage();
     if (m_language.isEmpty()) {
@@ -282,8 +556,14 @@ void SpeechRecognizer::applySettings()
     // 应用API设置
     m_apiUrl = settings->getApiUrl();
     
-    // 应用优先使用API设置
-    m_preferOnlineAPI = settings->isPreferOnlineAPI();
+    // 应用优先使用API设置（调用方固定了识别方式时除外）
+    if (!m_preferOnlineAPIFixed) {
+        m_preferOnlineAPI = settings->isPreferOnlineAPI();
+    }
+    
+    // 应用解码音频内存预算设置
+    m_audioMemoryBudgetMB = settings->getAudioMemoryBudgetMB();
+    m_scratchDirectory = settings->getScratchDirectory();
     
     qDebug() << "Applied settings:";
     qDebug() << "- Whisper model path:" << m_whisperPath;
@@ -291,13 +571,15 @@ void SpeechRecognizer::applySettings()
     qDebug() << "- Model size (for compatibility):" << m_modelSize;
     qDebug() << "- API URL:" << m_apiUrl;
     qDebug() << "- Prefer online API:" << m_preferOnlineAPI;
+    qDebug() << "- Audio memory budget (MB):" << m_audioMemoryBudgetMB;
+    qDebug() << "- Scratch directory:" << m_scratchDirectory;
 }
 
 bool SpeechRecognizer::recognizeFile(const QString &audioFilePath)
 {
     // 检查是否已经在识别中
     if (m_isRecognizing) {
-        emit recognitionError("Already recognizing audio.");
+        rejectWhileBusy();
         return false;
     }
     
@@ -310,6 +592,11 @@ bool SpeechRecognizer::recognizeFile(const QString &audioFilePath)
     // 保存当前处理的音频文件路径
     m_currentAudioFile = audioFilePath;
     
+    // 识别整个文件
+    m_rangeStartMs = -1;
+    m_rangeEndMs = -1;
+    m_alignmentWords.clear();
+    
     // 根据优先设置选择识别方式
     if (m_preferOnlineAPI && !m_apiUrl.isEmpty()) {
         // 优先使用在线API
@@ -338,65 +625,844 @@ void SpeechRecognizer::recognizeAudioAsync()
     
     qCritical() << "[SpeechRecognizer] 开始在独立线程中进行识别...";
     
-    // 设置whisper参数
-    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    // 语言字符串在whisper_full执行期间必须保持有效
+    const QByteArray language = m_language.toUtf8();
+    whisper_full_params params = recognitionParams(language);
+    
+    // 按窗口把16位样本转换为浮点数交给whisper，整段音频不会同时以浮点形式驻留内存
+    const size_t totalSamples = m_audioSamples.size();
+    const size_t windowSamples = size_t(kRecognitionWindowSeconds) * WHISPER_SAMPLE_RATE;
+    const qint64 rangeOffsetMs = qMax<qint64>(0, m_rangeStartMs);
+    std::vector<float> window;
+    SegmentStore store;
+    size_t windowStart = 0;
+    int tokensGenerated = 0;
+    QElapsedTimer inferenceTimer;
+    inferenceTimer.start();
+    
+    while (windowStart < totalSamples) {
+        if (m_shouldStop) {
+            qCritical() << "[SpeechRecognizer] 识别已停止";
+            return;
+        }
+        
+        size_t windowEnd = std::min(totalSamples, windowStart + windowSamples);
+        if (windowEnd < totalSamples) {
+            windowEnd = std::max(windowStart + 1, findQuietCutPoint(m_audioSamples, windowEnd, kCutSearchSamples));
+        }
+        
+        const size_t count = windowEnd - windowStart;
+        window.resize(count);
+        m_audioSamples.toFloat(windowStart, count, window.data());
+        
+        // 第一个窗口之后保留前文作为上下文，减少窗口边界处的识别差异
+        params.no_context = (windowStart == 0);
+        m_windowOffsetMs = rangeOffsetMs + qint64(windowStart) * 1000 / WHISPER_SAMPLE_RATE;
+        
+        // 执行语音识别
+        if (whisper_full(m_whisperCtx, params, window.data(), int(count)) != 0) {
+            if (m_shouldStop) {
+                qCritical() << "[SpeechRecognizer] 识别已停止";
+                return;
+            }
+            QMetaObject::invokeMethod(this, [=]() {
+                emit recognitionError("Whisper处理音频失败。");
+                m_isRecognizing = false;
+            });
+            return;
+        }
+        
+        tokensGenerated += collectWindowSegments(nullptr, m_windowOffsetMs, store);
+        
+        windowStart = windowEnd;
+        recognizerMetrics().jobPositionMs.set(qint64(windowStart) * 1000 / WHISPER_SAMPLE_RATE);
+        const int progress = int(qint64(windowStart) * 100 / qint64(totalSamples));
+        QMetaObject::invokeMethod(this, [=]() {
+            emit recognitionProgress(progress);
+        });
+    }
+    
+    qCritical() << "[SpeechRecognizer] 识别完成，共有" << store.size() << "个文本片段";
+    
+    const RecognitionJobStats stats = finishJobStats(inferenceTimer.elapsed(), tokensGenerated, store.size());
+    
+    // 发送结果信号；存储是隐式共享的，交给界面线程时不复制，片段的QString在界面线程中生成
+    const QString mediaFile = m_currentAudioFile;
+    const qint64 rangeStartMs = m_rangeStartMs;
+    const qint64 rangeEndMs = m_rangeEndMs;
+    QMetaObject::invokeMethod(this, [=]() {
+        const QString result = store.joinedText();
+        const QVector<TranscriptSegment> segments = store.toSegments();
+        qCritical() << "[SpeechRecognizer] 识别完成，结果长度:" << result.length() << "字符";
+        qInfo().noquote() << "[SpeechRecognizer] 任务资源统计:" << stats.summary();
+        emit jobStatsReady(stats);
+        emit segmentsRecognized(mediaFile, segments, rangeStartMs, rangeEndMs);
+        emit recognitionFinished(result);
+        m_isRecognizing = false;
+    });
+}
+
+void SpeechRecognizer::followAudioAsync()
+{
+    // 读取线程持续从ffmpeg取数据放入有界队列，本线程只负责识别
+    const bool live = isStreamUrl(m_currentAudioFile);
+    AudioStreamReader reader(m_currentAudioFile, live ? AudioStreamReader::LiveStream : AudioStreamReader::FollowFile);
+    QString error;
+    if (!reader.start(&error)) {
+        QMetaObject::invokeMethod(this, [=]() {
+            emit recognitionError("无法读取音频: " + error);
+            m_isRecognizing = false;
+        });
+        return;
+    }
+    
+    const QByteArray language = m_language.toUtf8();
+    whisper_full_params params = recognitionParams(language);
+    const size_t windowSamples = size_t(live ? kLiveWindowSeconds : kRecognitionWindowSeconds) * WHISPER_SAMPLE_RATE;
+    std::vector<int16_t> pending;            // 尚未识别的样本，识别后从前面删除，内存不随时长增长
+    std::vector<int16_t> incoming;
+    std::vector<float> window;
+    qint64 pendingStartSamples = 0;          // pending[0]在时间轴上的位置
+    qint64 totalSamples = 0;
+    SegmentStore store;
+    int tokensGenerated = 0;
+    qint64 inferenceMs = 0;
+    bool firstWindow = true;
+    bool finishRequested = false;
+    
+    // 识别pending开头的count个样本
+    auto recognizePending = [&](size_t count) -> bool {
+        window.resize(count);
+        convertS16ToF32(pending.data(), window.data(), count);
+        
+        // 第一次之后保留前文作为上下文，新的音频接着之前的文本识别
+        params.no_context = firstWindow;
+        firstWindow = false;
+        m_windowOffsetMs = pendingStartSamples * 1000 / WHISPER_SAMPLE_RATE;
+        
+        QElapsedTimer inferenceTimer;
+        inferenceTimer.start();
+        if (whisper_full(m_whisperCtx, params, window.data(), int(count)) != 0) {
+            return false;
+        }
+        inferenceMs += inferenceTimer.elapsed();
+        
+        // 新片段已经通过handleNewSegments实时发给界面
+        tokensGenerated += collectWindowSegments(nullptr, m_windowOffsetMs, store);
+        pending.erase(pending.begin(), pending.begin() + std::ptrdiff_t(count));
+        pendingStartSamples += qint64(count);
+        recognizerMetrics().jobPositionMs.set(pendingStartSamples * 1000 / WHISPER_SAMPLE_RATE);
+        return true;
+    };
+    
+    // 识别全部pending，超过一个窗口时在静音处切分
+    auto recognizeAllPending = [&]() -> bool {
+        while (!pending.empty()) {
+            size_t count = std::min(pending.size(), windowSamples);
+            if (count < pending.size()) {
+                count = std::max<size_t>(1, findQuietCutPoint(pending, count, kCutSearchSamples));
+            }
+            if (!recognizePending(count)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    
+    auto failWithWhisperError = [&]() {
+        reader.stop();
+        if (m_shouldStop) {
+            qCritical() << "[SpeechRecognizer] 跟随识别已停止";
+            return;
+        }
+        QMetaObject::invokeMethod(this, [=]() {
+            emit recognitionError("Whisper处理音频失败。");
+            m_isRecognizing = false;
+        });
+    };
+    
+    // 每积累几秒新音频识别一次；识别慢于写入时下一次自然取更长的音频（最多一个窗口）
+    for (;;) {
+        if (m_shouldStop) {
+            reader.stop();
+            qCritical() << "[SpeechRecognizer] 跟随识别已停止";
+            return;
+        }
+        
+        // 用户要求结束：停止读取，队列中剩余的音频照常识别
+        if (m_finishFollowing && !finishRequested) {
+            finishRequested = true;
+            reader.stop();
+        }
+        
+        // 已有一个窗口的音频时先识别，不再取数据：读取队列随之积满，跟随文件时ffmpeg等待，网络流丢弃旧音频
+        qint64 gapSamples = 0;
+        bool more = true;
+        incoming.clear();
+        if (pending.size() < windowSamples) {
+            more = reader.read(incoming, gapSamples, 200);
+        }
+        
+        // 缺口（丢弃或断线）之前的音频先全部识别，之后的音频从缺口后的时间接着算
+        if (gapSamples > 0) {
+            if (!recognizeAllPending()) {
+                failWithWhisperError();
+                return;
+            }
+            pendingStartSamples += gapSamples;
+            qWarning() << "[SpeechRecognizer] 音频在" << pendingStartSamples * 1000 / WHISPER_SAMPLE_RATE
+                       << "毫秒之前有" << gapSamples * 1000 / WHISPER_SAMPLE_RATE << "毫秒的缺口";
+        }
+        pending.insert(pending.end(), incoming.begin(), incoming.end());
+        totalSamples += qint64(incoming.size());
+        
+        if (!more) {
+            if (!recognizeAllPending()) {
+                failWithWhisperError();
+                return;
+            }
+            break;
+        }
+        if (pending.size() < kFollowStepSamples) {
+            continue;
+        }
+        
+        // 在末尾找静音处切分，切分点之后的音频留到下一次
+        size_t count = std::min(pending.size(), windowSamples);
+        count = std::max<size_t>(1, findQuietCutPoint(pending, count, kFollowCutSearchSamples));
+        if (!recognizePending(count)) {
+            failWithWhisperError();
+            return;
+        }
+        qCritical() << "[SpeechRecognizer] 跟随识别到" << pendingStartSamples / WHISPER_SAMPLE_RATE << "秒，落后"
+                    << pending.size() / WHISPER_SAMPLE_RATE << "秒";
+    }
+    
+    const QString readError = reader.errorString();
+    if (totalSamples == 0) {
+        QMetaObject::invokeMethod(this, [=]() {
+            emit recognitionError("未能读取到音频数据: " + readError);
+            m_isRecognizing = false;
+        });
+        return;
+    }
+    if (!readError.isEmpty()) {
+        qWarning() << "[SpeechRecognizer] 读取中断:" << readError;
+    }
+    
+    qCritical() << "[SpeechRecognizer] 跟随识别完成，共有" << store.size() << "个文本片段，重连"
+                << reader.reconnects() << "次，丢弃" << reader.droppedSamples() * 1000 / WHISPER_SAMPLE_RATE << "毫秒";
+    
+    m_jobStats.sourceBytes = reader.sourceBytes();
+    m_jobStats.bytesDecoded = totalSamples * qint64(sizeof(int16_t));
+    m_jobStats.audioSeconds = double(totalSamples) / WHISPER_SAMPLE_RATE;
+    recognizerMetrics().sourceBytes.increment(uint64_t(m_jobStats.sourceBytes));
+    recognizerMetrics().decodedBytes.increment(uint64_t(m_jobStats.bytesDecoded));
+    const RecognitionJobStats stats = finishJobStats(inferenceMs, tokensGenerated, store.size());
+    
+    // 最终结果替换界面中实时插入的片段
+    const QString mediaFile = m_currentAudioFile;
+    QMetaObject::invokeMethod(this, [=]() {
+        const QString result = store.joinedText();
+        const QVector<TranscriptSegment> segments = store.toSegments();
+        qInfo().noquote() << "[SpeechRecognizer] 任务资源统计:" << stats.summary();
+        emit jobStatsReady(stats);
+        emit segmentsRecognized(mediaFile, segments, -1, -1);
+        emit recognitionFinished(result);
+        m_isRecognizing = false;
+    });
+}
+
+void SpeechRecognizer::recognizeTracksAsync(const QVector<AudioTrack> &tracks)
+{
+    // 识别线程数在音轨之间平分；只有第一条音轨实时发出新片段，界面列表显示的是第一条音轨
+    const int trackCount = tracks.size();
+    const QByteArray language = m_language.toUtf8();
+    const whisper_full_params baseParams = recognitionParams(language);
+    const int threadsPerTrack = std::max(1, baseParams.n_threads / trackCount);
+    const size_t windowSamples = size_t(kRecognitionWindowSeconds) * WHISPER_SAMPLE_RATE;
+    std::vector<TrackFeed> feeds(size_t(trackCount));
+    std::vector<SegmentStore> stores(size_t(trackCount));
+    std::atomic<qint64> recognizedSamples(0);
+    std::atomic<int> tokensGenerated(0);
+    std::atomic<bool> failed(false);
+    
+    // 进度按探测到的时长估计，有音轨时长未知时不报告进度
+    qint64 expectedSamples = 0;
+    for (const AudioTrack &track : tracks) {
+        if (track.durationMs <= 0) {
+            expectedSamples = 0;
+            break;
+        }
+        expectedSamples += track.durationMs * WHISPER_SAMPLE_RATE / 1000;
+    }
+    
+    // 解码和识别同时进行：每条音轨的识别线程从自己的队列中按窗口取样本，
+    // baseParams带有abort_callback，停止时每条音轨的whisper_full_with_state都会中止
+    auto recognizeTrack = [&](int k) {
+        TrackFeed &feed = feeds[size_t(k)];
+        whisper_state *state = whisper_init_state(m_whisperCtx);
+        if (!state) {
+            failed = true;
+        }
+        
+        whisper_full_params params = baseParams;
+        params.n_threads = threadsPerTrack;
+        if (k > 0) {
+            params.new_segment_callback = nullptr;
+            params.new_segment_callback_user_data = nullptr;
+        }
+        
+        std::vector<float> window;
+        size_t windowStart = 0;
+        while (state && !m_shouldStop && !failed) {
+            // 超过一个窗口时在窗口末尾附近找静音切分点，解码结束后剩下的样本作为最后一个窗口
+            size_t count = 0;
+            {
+                QMutexLocker locker(&feed.mutex);
+                while (feed.pending.size() <= windowSamples && !feed.finished && !m_shouldStop && !failed) {
+                    feed.changed.wait(&feed.mutex, 200);
+                }
+                if (m_shouldStop || failed || feed.pending.empty()) {
+                    break;
+                }
+                count = feed.pending.size();
+                if (count > windowSamples) {
+                    count = std::max<size_t>(1, findQuietCutPoint(feed.pending, windowSamples, kCutSearchSamples));
+                }
+                window.resize(count);
+                convertS16ToF32(feed.pending.data(), window.data(), count);
+                feed.pending.erase(feed.pending.begin(), feed.pending.begin() + std::ptrdiff_t(count));
+                feed.changed.wakeAll();
+            }
+            m_trackResidentBytes -= qint64(count * sizeof(int16_t));
+            
+            params.no_context = (windowStart == 0);
+            const qint64 offsetMs = qint64(windowStart) * 1000 / WHISPER_SAMPLE_RATE;
+            if (k == 0) {
+                m_windowOffsetMs = offsetMs;
+            }
+            if (whisper_full_with_state(m_whisperCtx, state, params, window.data(), int(count)) != 0) {
+                if (!m_shouldStop) {
+                    failed = true;
+                }
+                break;
+            }
+            tokensGenerated += collectWindowSegments(state, offsetMs, stores[size_t(k)]);
+            
+            windowStart += count;
+            const qint64 recognized = (recognizedSamples += qint64(count));
+            if (expectedSamples > 0) {
+                const int progress = int(qMin<qint64>(100, recognized * 100 / expectedSamples));
+                QMetaObject::invokeMethod(this, [=]() {
+                    emit recognitionProgress(progress);
+                });
+            }
+        }
+        
+        // 解码线程可能正等待队列腾出空间
+        {
+            QMutexLocker locker(&feed.mutex);
+            feed.done = true;
+            feed.changed.wakeAll();
+        }
+        if (state) {
+            whisper_free_state(state);
+        }
+    };
+    
+    QElapsedTimer inferenceTimer;
+    inferenceTimer.start();
+    std::vector<std::unique_ptr<QThread>> workers;
+    for (int k = 0; k < trackCount; ++k) {
+        workers.emplace_back(QThread::create([&recognizeTrack, k]() {
+            recognizeTrack(k);
+        }));
+        workers.back()->setObjectName(QString("EnTrack%1").arg(k));
+        workers.back()->start();
+    }
+    
+    // 容器只读取一遍，所有音轨同时解码；每条音轨最多积压两个窗口，识别跟不上时解码等待
+    auto deliver = [&](int k, const int16_t *samples, size_t count) {
+        TrackFeed &feed = feeds[size_t(k)];
+        QMutexLocker locker(&feed.mutex);
+        while (feed.pending.size() >= 2 * windowSamples && !feed.done && !m_shouldStop && !failed) {
+            feed.changed.wait(&feed.mutex, 200);
+        }
+        feed.received += qint64(count);
+        if (!feed.done) {
+            feed.pending.insert(feed.pending.end(), samples, samples + count);
+            m_trackResidentBytes += qint64(count * sizeof(int16_t));
+            feed.changed.wakeAll();
+        }
+        return !m_shouldStop && !failed;
+    };
+    qint64 sourceBytes = 0;
+    QString error;
+    const bool decoded = decodeAudioTracks(m_currentAudioFile, tracks, deliver, &sourceBytes, &error);
+    m_jobStats.decodeMs = m_jobTimer.elapsed();
+    
+    // 解码失败时丢弃积压的样本，识别线程在当前窗口结束后退出
+    for (TrackFeed &feed : feeds) {
+        QMutexLocker locker(&feed.mutex);
+        if (!decoded) {
+            feed.pending.clear();
+        }
+        feed.finished = true;
+        feed.changed.wakeAll();
+    }
+    for (const std::unique_ptr<QThread> &worker : workers) {
+        worker->wait();
+    }
+    m_trackResidentBytes = 0;
+    
+    if (m_shouldStop) {
+        qCritical() << "[SpeechRecognizer] 多音轨识别已停止";
+        return;
+    }
+    if (failed) {
+        QMetaObject::invokeMethod(this, [=]() {
+            emit recognitionError("Whisper处理音频失败。");
+            m_isRecognizing = false;
+        });
+        return;
+    }
+    if (!decoded) {
+        QMetaObject::invokeMethod(this, [=]() {
+            emit recognitionError("解码音轨失败: " + error);
+            m_isRecognizing = false;
+        });
+        return;
+    }
+    
+    qint64 totalSamples = 0;
+    for (int k = 0; k < trackCount; ++k) {
+        totalSamples += feeds[size_t(k)].received;
+        if (feeds[size_t(k)].received == 0) {
+            qWarning() << "[SpeechRecognizer] 音轨" << tracks.at(k).label() << "中没有音频数据";
+        }
+    }
+    if (totalSamples == 0) {
+        QMetaObject::invokeMethod(this, [=]() {
+            emit recognitionError("所选音轨中没有音频数据");
+            m_isRecognizing = false;
+        });
+        return;
+    }
+    
+    m_jobStats.sourceBytes = sourceBytes;
+    m_jobStats.bytesDecoded = totalSamples * qint64(sizeof(int16_t));
+    m_jobStats.audioSeconds = double(totalSamples) / WHISPER_SAMPLE_RATE;
+    recognizerMetrics().decodeSeconds.observe(m_jobStats.decodeMs / 1000.0);
+    recognizerMetrics().sourceBytes.increment(uint64_t(m_jobStats.sourceBytes));
+    recognizerMetrics().decodedBytes.increment(uint64_t(m_jobStats.bytesDecoded));
+    recognizerMetrics().loadsFfmpeg.increment();
+    
+    int segmentCount = 0;
+    for (const SegmentStore &store : stores) {
+        segmentCount += store.size();
+    }
+    qCritical() << "[SpeechRecognizer] 多音轨识别完成，" << trackCount << "条音轨共有" << segmentCount << "个文本片段";
+    const RecognitionJobStats stats = finishJobStats(inferenceTimer.elapsed(), tokensGenerated, segmentCount);
+    
+    // 各音轨的存储是隐式共享的，交给界面线程时不复制
+    const QString mediaFile = m_currentAudioFile;
+    QMetaObject::invokeMethod(this, [=]() {
+        qInfo().noquote() << "[SpeechRecognizer] 任务资源统计:" << stats.summary();
+        emit jobStatsReady(stats);
+        for (int k = 0; k < trackCount; ++k) {
+            emit trackSegmentsRecognized(mediaFile, tracks.at(k), stores[size_t(k)].toSegments());
+        }
+        emit segmentsRecognized(mediaFile, stores.front().toSegments(), -1, -1);
+        emit recognitionFinished(stores.front().joinedText());
+        m_isRecognizing = false;
+    });
+}
+
+whisper_full_params SpeechRecognizer::recognitionParams(const QByteArray &language)
+{
+    // 设置whisper参数，束搜索更准确但明显更慢
+    const bool beamSearch = (m_decodingProfile == "beam");
+    whisper_full_params params = whisper_full_default_params(beamSearch ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY);
+    if (beamSearch) {
+        params.beam_search.beam_size = 5;
+    }
     
     // 设置通用参数
-    params.n_threads = std::min(8, (int)QThread::idealThreadCount());
+    params.n_threads = m_threadCount > 0 ? m_threadCount : std::min(8, (int)QThread::idealThreadCount());
     params.translate = false;
     params.print_realtime = false;
     params.print_progress = false;
     params.print_timestamps = false;
     params.print_special = false;
-    params.token_timestamps = false;
+    params.token_timestamps = m_wordTimestamps;
     params.thold_pt = 0.01f;
     params.thold_ptsum = 0.01f;
     params.max_len = 0;
     params.split_on_word = true;
     params.max_tokens = 0;
     
+    // 每解码出新片段就通知界面，不必等整个窗口结束
+    params.new_segment_callback = &SpeechRecognizer::handleNewSegments;
+    params.new_segment_callback_user_data = this;
+    
+    // 停止时中断正在进行的whisper_full，不必等当前窗口识别完
+    params.abort_callback = &SpeechRecognizer::shouldAbort;
+    params.abort_callback_user_data = this;
+    
+    qCritical() << "[SpeechRecognizer] 线程数:" << params.n_threads << "，解码策略:" << (beamSearch ? "beam" : "greedy");
+    
     // 设置语言
     if (m_language != "auto") {
-        params.language = m_language.toUtf8().constData();
+        params.language = language.constData();
         params.detect_language = false;
     } else {
         params.language = nullptr; // nullptr表示自动检测语言
         params.detect_language = true;
     }
+    return params;
+}
+
+int SpeechRecognizer::collectWindowSegments(whisper_state *state, qint64 offsetMs, SegmentStore &store)
+{
+    // 收集识别结果，whisper的时间戳单位为10毫秒，需要加上窗口起点换算为绝对时间
+    const WhisperResults results = { m_whisperCtx, state };
+    const whisper_token eotToken = whisper_token_eot(m_whisperCtx);
+    const int n_segments = results.segmentCount();
+    int tokensGenerated = 0;
     
-    // 执行语音识别
-    if (whisper_full(m_whisperCtx, params, m_audioSamples.data(), m_audioSamples.size()) != 0) {
+    for (int i = 0; i < n_segments; ++i) {
+        // 特殊token（时间戳、语言标记等）的id都不小于EOT
+        const int n_tokens = results.tokenCount(i);
+        int textTokens = 0;
+        float probabilitySum = 0.0f;
+        for (int j = 0; j < n_tokens; ++j) {
+            if (results.tokenId(i, j) < eotToken) {
+                ++textTokens;
+                probabilitySum += results.tokenP(i, j);
+            }
+        }
+        tokensGenerated += textTokens;
+        
+        // 片段直接追加到存储的文本区，识别线程中不生成QString
+        const char *text = results.segmentText(i);
+        if (text) {
+            store.append(offsetMs + results.segmentT0(i) * 10,
+                         offsetMs + results.segmentT1(i) * 10,
+                         text, int(std::strlen(text)),
+                         textTokens > 0 ? probabilitySum / textTokens : -1.0f,
+                         m_wordTimestamps ? collectWordTimings(results, i, eotToken) : TranscriptWords());
+        }
+    }
+    return tokensGenerated;
+}
+
+RecognitionJobStats SpeechRecognizer::finishJobStats(qint64 inferenceMs, int tokens, int segments)
+{
+    m_jobActive = false;
+    RecognitionJobStats stats = m_jobStats;
+    stats.inferenceMs = inferenceMs;
+    stats.wallMs = m_jobTimer.elapsed();
+    stats.cpuSeconds = processCpuSeconds() - m_jobCpuStart;
+    stats.peakRssDeltaKb = m_jobRssSampler.stop() / 1024;
+    stats.tokensGenerated = tokens;
+    stats.segments = segments;
+    
+    RecognizerMetrics &metrics = recognizerMetrics();
+    metrics.inferenceSeconds.observe(stats.inferenceMs / 1000.0);
+    metrics.totalSeconds.observe(stats.wallMs / 1000.0);
+    if (stats.audioSeconds > 0) {
+        metrics.realTimeFactor.observe(stats.wallMs / 1000.0 / stats.audioSeconds);
+    }
+    metrics.tokens.increment(uint64_t(tokens));
+    metrics.jobsCompleted.increment();
+    return stats;
+}
+
+void SpeechRecognizer::alignAudioAsync()
+{
+    whisper_context *ctx = m_whisperCtx;
+    if (!ctx || m_audioSamples.empty()) {
         QMetaObject::invokeMethod(this, [=]() {
-            emit recognitionError("Whisper处理音频失败。");
+            emit recognitionError("Whisper上下文未初始化或没有音频数据。");
         });
         return;
     }
     
-    // 收集识别结果
-    std::string fullText;
-    const int n_segments = whisper_full_n_segments(m_whisperCtx);
+    const int threads = m_threadCount > 0 ? m_threadCount : std::min(8, (int)QThread::idealThreadCount());
+    qCritical() << "[SpeechRecognizer] 开始强制对齐，" << m_alignmentWords.size() << "个词，线程数:" << threads;
     
-    qCritical() << "[SpeechRecognizer] 识别完成，共有" << n_segments << "个文本片段";
+    auto fail = [this](const QString &message) {
+        QMetaObject::invokeMethod(this, [=]() {
+            emit recognitionError(message);
+            m_isRecognizing = false;
+        });
+    };
+    
+    // 逐词分词（BPE本来就按词切分，结果与整段分词相同），记录每个token属于哪个词；
+    // 词前加空格与whisper输出的文本形式一致
+    std::vector<whisper_token> tokens;
+    std::vector<int> tokenWord;
+    std::vector<whisper_token> buffer(64);
+    for (int w = 0; w < m_alignmentWords.size(); ++w) {
+        const QByteArray piece = " " + m_alignmentWords[w].toUtf8();
+        int n = whisper_tokenize(ctx, piece.constData(), buffer.data(), int(buffer.size()));
+        if (n < 0) {
+            buffer.resize(size_t(-n));
+            n = whisper_tokenize(ctx, piece.constData(), buffer.data(), int(buffer.size()));
+        }
+        for (int i = 0; i < n; ++i) {
+            tokens.push_back(buffer[size_t(i)]);
+            tokenWord.push_back(w);
+        }
+    }
+    if (tokens.empty()) {
+        fail("对齐文本为空");
+        return;
+    }
     
-    for (int i = 0; i < n_segments; ++i) {
-        const char *text = whisper_full_get_segment_text(m_whisperCtx, i);
-        if (text) {
-            fullText += text;
-            if (i < n_segments - 1) {
-                fullText += " ";
+    const int vocabSize = whisper_n_vocab(ctx);
+    const whisper_token eotToken = whisper_token_eot(ctx);
+    const whisper_token beginToken = whisper_token_beg(ctx);
+    const int maxTimestamp = std::min(kTimestampCount, vocabSize - 1 - beginToken);
+    // 一个窗口最多强制解码的token数，与whisper识别时的限制相同
+    const int tokenBudget = whisper_n_text_ctx(ctx) / 2;
+    const size_t totalSamples = m_audioSamples.size();
+    const size_t windowSamples = size_t(kAlignmentWindowSeconds) * WHISPER_SAMPLE_RATE;
+    const size_t samplesPerTimestamp = size_t(WHISPER_SAMPLE_RATE) * kTimestampStepMs / 1000;
+    
+    int languageId = (m_language != "auto") ? whisper_lang_id(m_language.toUtf8().constData()) : -1;
+    
+    QVector<TranscriptSegment> segments;
+    std::vector<float> window;
+    size_t seek = 0;
+    size_t tokenPos = 0;
+    int tokensDecoded = 0;
+    QElapsedTimer inferenceTimer;
+    inferenceTimer.start();
+    
+    // 把[first, last)的token所属的词组成片段，hints为各词起点的估计
+    auto appendSegment = [&](size_t first, size_t last, qint64 startMs, qint64 endMs, const QVector<qint64> &hints) {
+        if (first >= last) {
+            return;
+        }
+        const int firstWord = tokenWord[first];
+        const int lastWord = tokenWord[last - 1];
+        segments.append(buildAlignedSegment(m_alignmentWords.mid(firstWord, lastWord - firstWord + 1),
+                                            hints.mid(firstWord), startMs, endMs));
+    };
+    
+    while (tokenPos < tokens.size() && seek < totalSamples) {
+        if (m_shouldStop) {
+            qCritical() << "[SpeechRecognizer] 对齐已停止";
+            return;
+        }
+        
+        const size_t count = std::min(windowSamples, totalSamples - seek);
+        const qint64 windowOffsetMs = qint64(seek) * 1000 / WHISPER_SAMPLE_RATE;
+        const bool lastWindow = (seek + count >= totalSamples);
+        window.resize(count);
+        m_audioSamples.toFloat(seek, count, window.data());
+        
+        if (whisper_pcm_to_mel(ctx, window.data(), int(count), threads) != 0 || whisper_encode(ctx, 0, threads) != 0) {
+            fail("Whisper编码音频失败。");
+            return;
+        }
+        if (languageId < 0) {
+            languageId = std::max(0, whisper_lang_auto_detect(ctx, 0, threads, nullptr));
+        }
+        
+        // 每次只解码一个token，logits总是对应最后一个token
+        int pastTokens = 0;
+        auto feed = [&](whisper_token token) {
+            ++tokensDecoded;
+            return whisper_decode(ctx, &token, 1, pastTokens++, threads) == 0;
+        };
+        const whisper_token prompt[] = { whisper_token_sot(ctx), whisper_token_lang(ctx, languageId),
+                                         whisper_token_transcribe(ctx), beginToken };
+        bool ok = true;
+        for (whisper_token token : prompt) {
+            ok = ok && feed(token);
+        }
+        
+        const size_t windowFirstToken = tokenPos;
+        size_t segmentFirstToken = tokenPos;
+        int segmentStart = 0;          // 当前片段的开始时间戳
+        int committedTimestamp = -1;   // 最后一个完整片段的结束时间戳
+        size_t committedToken = tokenPos;
+        QVector<qint64> hints(m_alignmentWords.size(), -1);
+        int decodedInWindow = 0;
+        
+        while (ok) {
+            // 只在词边界考虑时间戳和结束token，片段总是包含完整的词
+            const bool atWordBoundary = tokenPos == tokens.size() || tokenPos == segmentFirstToken
+                    || tokenWord[tokenPos] != tokenWord[tokenPos - 1];
+            const bool hasText = tokenPos < tokens.size();
+            
+            // 在允许的候选（下一个文本token、不早于当前片段开始的时间戳、结束token）之间归一化
+            const float *logits = whisper_get_logits(ctx);
+            float maxLogit = logits[eotToken];
+            if (hasText) {
+                maxLogit = std::max(maxLogit, logits[tokens[tokenPos]]);
+            }
+            int bestTimestamp = segmentStart;
+            for (int t = segmentStart; t <= maxTimestamp; ++t) {
+                if (logits[beginToken + t] > logits[beginToken + bestTimestamp]) {
+                    bestTimestamp = t;
+                }
             }
+            maxLogit = std::max(maxLogit, logits[beginToken + bestTimestamp]);
+            double timestampSum = 0.0;
+            for (int t = segmentStart; t <= maxTimestamp; ++t) {
+                timestampSum += std::exp(double(logits[beginToken + t] - maxLogit));
+            }
+            const double textWeight = hasText ? std::exp(double(logits[tokens[tokenPos]] - maxLogit)) : 0.0;
+            const double endWeight = std::exp(double(logits[eotToken] - maxLogit));
+            const double total = timestampSum + textWeight + endWeight;
+            
+            if (hasText && atWordBoundary) {
+                // 此处最可能的时间戳即为下一个词起点的估计
+                const double bestProbability = std::exp(double(logits[beginToken + bestTimestamp] - maxLogit)) / total;
+                if (bestProbability >= kTimestampHintThreshold) {
+                    hints[tokenWord[tokenPos]] = windowOffsetMs + qint64(bestTimestamp) * kTimestampStepMs;
+                }
+            }
+            
+            const bool segmentHasText = tokenPos > segmentFirstToken;
+            if (segmentHasText && atWordBoundary && (!hasText || timestampSum > textWeight)) {
+                // 结束当前片段
+                appendSegment(segmentFirstToken, tokenPos, windowOffsetMs + qint64(segmentStart) * kTimestampStepMs,
+                              windowOffsetMs + qint64(bestTimestamp) * kTimestampStepMs, hints);
+                committedTimestamp = bestTimestamp;
+                committedToken = tokenPos;
+                segmentFirstToken = tokenPos;
+                if (!hasText || !feed(beginToken + bestTimestamp)) {
+                    break;
+                }
+                
+                // 下一个片段的开始时间戳，结束token更可能时本窗口结束
+                const float *next = whisper_get_logits(ctx);
+                int startTimestamp = bestTimestamp;
+                double nextTimestampSum = 0.0;
+                for (int t = bestTimestamp; t <= maxTimestamp; ++t) {
+                    if (next[beginToken + t] > next[beginToken + startTimestamp]) {
+                        startTimestamp = t;
+                    }
+                }
+                for (int t = bestTimestamp; t <= maxTimestamp; ++t) {
+                    nextTimestampSum += std::exp(double(next[beginToken + t] - next[beginToken + startTimestamp]));
+                }
+                if (std::exp(double(next[eotToken] - next[beginToken + startTimestamp])) > nextTimestampSum) {
+                    break;
+                }
+                segmentStart = startTimestamp;
+                ok = feed(beginToken + startTimestamp);
+            } else if (hasText && atWordBoundary && endWeight > textWeight && endWeight > timestampSum) {
+                // 模型认为本窗口已经结束，未结束的片段留给下一个窗口
+                break;
+            } else if (hasText && decodedInWindow < tokenBudget) {
+                ok = feed(tokens[tokenPos]);
+                ++tokenPos;
+                ++decodedInWindow;
+            } else {
+                break;
+            }
+        }
+        if (!ok) {
+            fail("Whisper解码失败。");
+            return;
         }
+        
+        if (committedTimestamp >= 0) {
+            // 从最后一个完整片段的结束处开始下一个窗口，未完成的片段重新对齐
+            tokenPos = committedToken;
+            seek += std::max<size_t>(size_t(committedTimestamp) * samplesPerTimestamp, lastWindow ? count : 0);
+            if (committedTimestamp == 0 && !lastWindow) {
+                seek += samplesPerTimestamp;
+            }
+        } else if (lastWindow || tokenPos > windowFirstToken) {
+            // 窗口内没有完整的片段：把已解码的词作为一个覆盖整个窗口的片段，保证每个窗口都有进展
+            appendSegment(windowFirstToken, tokenPos, windowOffsetMs, windowOffsetMs + qint64(count) * 1000 / WHISPER_SAMPLE_RATE,
+                          hints);
+            seek += count;
+        } else {
+            // 窗口内没有语音
+            seek += count;
+        }
+        
+        recognizerMetrics().jobPositionMs.set(qint64(seek) * 1000 / WHISPER_SAMPLE_RATE);
+        const int progress = int(qint64(std::min(seek, totalSamples)) * 100 / qint64(totalSamples));
+        QMetaObject::invokeMethod(this, [=]() {
+            emit recognitionProgress(progress);
+        });
+    }
+    
+    // 音频结束后仍有剩余的词，并入最后一个片段之后
+    if (tokenPos < tokens.size()) {
+        const qint64 audioEndMs = qint64(totalSamples) * 1000 / WHISPER_SAMPLE_RATE;
+        const qint64 startMs = segments.isEmpty() ? 0 : std::min(segments.last().endMs, audioEndMs);
+        appendSegment(tokenPos, tokens.size(), startMs, audioEndMs, QVector<qint64>());
     }
     
-    // 发送结果信号
-    const QString result = QString::fromUtf8(fullText.c_str());
+    // 片段时间为区间内的相对时间，区间对齐时换算为绝对时间
+    const qint64 rangeOffsetMs = qMax<qint64>(0, m_rangeStartMs);
+    QStringList texts;
+    for (TranscriptSegment &segment : segments) {
+        segment.startMs += rangeOffsetMs;
+        segment.endMs += rangeOffsetMs;
+        texts << segment.text;
+    }
+    
+    qCritical() << "[SpeechRecognizer] 对齐完成，共有" << segments.size() << "个片段，解码" << tokensDecoded << "个token";
+    const RecognitionJobStats stats = finishJobStats(inferenceTimer.elapsed(), tokensDecoded, segments.size());
+    
+    const QString mediaFile = m_currentAudioFile;
+    const qint64 rangeStartMs = m_rangeStartMs;
+    const qint64 rangeEndMs = m_rangeEndMs;
+    const QString result = texts.join(' ');
     QMetaObject::invokeMethod(this, [=]() {
-        qCritical() << "[SpeechRecognizer] 识别完成，结果长度:" << result.length() << "字符";
+        qInfo().noquote() << "[SpeechRecognizer] 任务资源统计:" << stats.summary();
+        emit jobStatsReady(stats);
+        emit segmentsRecognized(mediaFile, segments, rangeStartMs, rangeEndMs);
         emit recognitionFinished(result);
         m_isRecognizing = false;
     });
 }
 
+bool SpeechRecognizer::shouldAbort(void *userData)
+{
+    return static_cast<SpeechRecognizer *>(userData)->m_shouldStop;
+}
+
+void SpeechRecognizer::handleNewSegments(whisper_context *ctx, whisper_state *state, int newSegments, void *userData)
+{
+    SpeechRecognizer *self = static_cast<SpeechRecognizer *>(userData);
+    
+    // whisper_full_with_state识别时上下文自带的状态中没有结果，总是从回调给出的状态读取
+    const WhisperResults results = { ctx, state };
+    const int total = results.segmentCount();
+    const qint64 windowOffsetMs = self->m_windowOffsetMs;
+    SegmentStore store;
+    for (int i = std::max(0, total - newSegments); i < total; ++i) {
+        const char *text = results.segmentText(i);
+        if (!text) {
+            continue;
+        }
+        store.append(windowOffsetMs + results.segmentT0(i) * 10,
+                     windowOffsetMs + results.segmentT1(i) * 10,
+                     text, int(std::strlen(text)), -1.0f,
+                     self->m_wordTimestamps ? collectWordTimings(results, i, whisper_token_eot(ctx)) : TranscriptWords());
+    }
+    
+    if (!store.isEmpty()) {
+        const qint64 rangeOffsetMs = qMax<qint64>(0, self->m_rangeStartMs);
+        recognizerMetrics().jobPositionMs.set(store.record(store.size() - 1).endMs - rangeOffsetMs);
+        QMetaObject::invokeMethod(self, [self, store]() {
+            emit self->segmentsDecoded(store.toSegments());
+        });
+    }
+}
+
 bool SpeechRecognizer::recognizeFromVideo(const QString &videoFilePath, const QString &audioOutputPath)
 {
     qCritical() << "[SpeechRecognizer] 开始从视频中识别语音:" << videoFilePath;
@@ -464,15 +1530,191 @@ bool SpeechRecognizer::recognizeFromVideo(const QString &videoFilePath, const QS
     return success;
 }
 
+bool SpeechRecognizer::recognizeRange(const QString &mediaFilePath, qint64 startMs, qint64 endMs)
+{
+    qCritical() << "[SpeechRecognizer] 开始识别区间:" << mediaFilePath << startMs << "ms -" << endMs << "ms";
+    
+    if (m_isRecognizing) {
+        rejectWhileBusy();
+        return false;
+    }
+    
+    if (!QFile::exists(mediaFilePath)) {
+        emit recognitionError("Audio file not found: " + mediaFilePath);
+        return false;
+    }
+    
+    if (startMs < 0 || endMs <= startMs) {
+        QString errorMsg = QString("无效的识别区间: %1ms - %2ms").arg(startMs).arg(endMs);
+        qCritical() << "[SpeechRecognizer] 错误:" << errorMsg;
+        emit recognitionError(errorMsg);
+        return false;
+    }
+    
+    // 在线API不支持区间识别，只使用本地Whisper
+    if (!isLocalWhisperAvailable()) {
+        emit recognitionError("区间识别需要本地Whisper模型，请检查模型路径");
+        return false;
+    }
+    
+    m_currentAudioFile = mediaFilePath;
+    m_rangeStartMs = startMs;
+    m_rangeEndMs = endMs;
+    m_alignmentWords.clear();
+    
+    return recognizeWithWhisper(mediaFilePath);
+}
+
+bool SpeechRecognizer::alignText(const QString &mediaFilePath, const QString &text)
+{
+    qCritical() << "[SpeechRecognizer] 开始强制对齐:" << mediaFilePath;
+    
+    if (m_isRecognizing) {
+        rejectWhileBusy();
+        return false;
+    }
+    
+    if (!QFile::exists(mediaFilePath)) {
+        emit recognitionError("Audio file not found: " + mediaFilePath);
+        return false;
+    }
+    
+    const QStringList words = splitAlignmentWords(text);
+    if (words.isEmpty()) {
+        emit recognitionError("对齐文本为空");
+        return false;
+    }
+    
+    // 对齐需要whisper的解码器，在线API不支持
+    if (!isLocalWhisperAvailable()) {
+        emit recognitionError("强制对齐需要本地Whisper模型，请检查模型路径");
+        return false;
+    }
+    
+    m_currentAudioFile = mediaFilePath;
+    m_rangeStartMs = -1;
+    m_rangeEndMs = -1;
+    m_alignmentWords = words;
+    
+    return recognizeWithWhisper(mediaFilePath);
+}
+
+bool SpeechRecognizer::followFile(const QString &mediaFilePath)
+{
+    qCritical() << "[SpeechRecognizer] 开始跟随识别:" << mediaFilePath;
+    
+    if (!QFile::exists(mediaFilePath)) {
+        emit recognitionError("Audio file not found: " + mediaFilePath);
+        return false;
+    }
+    return startFollowing(mediaFilePath);
+}
+
+bool SpeechRecognizer::recognizeStream(const QString &url)
+{
+    qCritical() << "[SpeechRecognizer] 开始识别网络流:" << url;
+    
+    if (!isStreamUrl(url)) {
+        emit recognitionError("不支持的网络流地址: " + url);
+        return false;
+    }
+    return startFollowing(url);
+}
+
+void SpeechRecognizer::finishFollowing()
+{
+    if (m_isRecognizing) {
+        m_finishFollowing = true;
+    }
+}
+
+bool SpeechRecognizer::startFollowing(const QString &source)
+{
+    if (m_isRecognizing) {
+        rejectWhileBusy();
+        return false;
+    }
+    
+    // 增量识别需要本地模型保留上下文，在线API只能识别完整的文件
+    if (!isLocalWhisperAvailable()) {
+        emit recognitionError("跟随识别需要本地Whisper模型，请检查模型路径");
+        return false;
+    }
+    
+    if (!isFfmpegAvailable()) {
+        emit recognitionError("FFmpeg不可用，无法跟随识别");
+        return false;
+    }
+    
+    m_currentAudioFile = source;
+    m_rangeStartMs = -1;
+    m_rangeEndMs = -1;
+    m_alignmentWords.clear();
+    m_audioSamples.clear();
+    m_finishFollowing = false;
+    
+    beginJobStats(source);
+    startRecognitionThread("EnFollower", [this]() {
+        this->followAudioAsync();
+    });
+    return true;
+}
+
+bool SpeechRecognizer::recognizeTracks(const QString &mediaFilePath, const QVector<AudioTrack> &tracks)
+{
+    qCritical() << "[SpeechRecognizer] 开始识别" << tracks.size() << "条音轨:" << mediaFilePath;
+    
+    if (m_isRecognizing) {
+        rejectWhileBusy();
+        return false;
+    }
+    
+    if (!QFile::exists(mediaFilePath)) {
+        emit recognitionError("Audio file not found: " + mediaFilePath);
+        return false;
+    }
+    
+    if (tracks.isEmpty()) {
+        emit recognitionError("没有选择要识别的音轨");
+        return false;
+    }
+    
+    // 每条音轨需要独立的whisper状态，在线API不支持
+    if (!isLocalWhisperAvailable()) {
+        emit recognitionError("多音轨识别需要本地Whisper模型，请检查模型路径");
+        return false;
+    }
+    
+    if (!isFfmpegAvailable()) {
+        emit recognitionError("FFmpeg不可用，无法解码音轨");
+        return false;
+    }
+    
+    m_currentAudioFile = mediaFilePath;
+    m_rangeStartMs = -1;
+    m_rangeEndMs = -1;
+    m_alignmentWords.clear();
+    m_audioSamples.clear();
+    
+    // 解码整个容器可能要几分钟，放在识别线程中进行，不阻塞界面
+    beginJobStats(mediaFilePath);
+    startRecognitionThread("EnTracks", [this, tracks]() {
+        this->recognizeTracksAsync(tracks);
+    });
+    return true;
+}
+
 void SpeechRecognizer::stop()
 {
     // 停止识别线程
     if (m_isRecognizing) {
         qDebug() << "Stopping recognition...";
         m_shouldStop = true;
+        m_jobActive = false;  // 用户停止的任务不计为失败
         
+        // whisper通过abort_callback看到停止标志，很快返回；不能在线程还在运行时继续清理
         if (m_recognitionThread) {
-            m_recognitionThread->wait(3000);
+            m_recognitionThread->wait();
         }
         
         m_isRecognizing = false;
@@ -491,7 +1733,8 @@ void SpeechRecognizer::stop()
     cleanup();
 }
 
-bool SpeechRecognizer::loadAudioFile(const QString &audioFilePath, std::vector<float> &samples, int &sampleRate)
+bool SpeechRecognizer::loadAudioFile(const QString &audioFilePath, PcmBuffer &samples, int &sampleRate,
+                                     qint64 startMs, qint64 durationMs)
 {
     qCritical() << "[SpeechRecognizer] 加载音频文件:" << audioFilePath;
     
@@ -509,15 +1752,108 @@ bool SpeechRecognizer::loadAudioFile(const QString &audioFilePath, std::vector<f
         qCritical() << "[SpeechRecognizer] 警告: 音频文件可能无效，文件大小过小:" << audioInfo.size() << "字节";
     }
     
-    // 使用ffmpeg提取PCM音频数据
+    samples.clear();
+    m_loadedSourceBytes = 0;
+    
+    // 已经是16kHz单声道16位PCM的WAV文件直接引用内存映射，不启动ffmpeg也不拷贝样本
+    QSharedPointer<WavReader> wavReader(new WavReader);
+    if (wavReader->open(audioFilePath) && wavReader->isRecognizerCompatible()) {
+        const qint64 framesPerMs = WHISPER_SAMPLE_RATE / 1000;
+        const qint64 totalFrames = wavReader->frameCount();
+        const qint64 firstFrame = qMin(totalFrames, startMs * framesPerMs);
+        const qint64 lastFrame = durationMs > 0 ? qMin(totalFrames, firstFrame + durationMs * framesPerMs) : totalFrames;
+        
+        if (lastFrame <= firstFrame) {
+            qCritical() << "[SpeechRecognizer] 错误: WAV文件在指定区间内没有音频数据";
+            return false;
+        }
+        
+        samples.setMappedWav(wavReader, firstFrame, lastFrame - firstFrame);
+        sampleRate = WHISPER_SAMPLE_RATE;
+        m_loadedSourceBytes = (lastFrame - firstFrame) * qint64(sizeof(int16_t));
+        recognizerMetrics().loadsMapped.increment();
+        
+        qCritical() << "[SpeechRecognizer] WAV文件通过内存映射直接加载，样本数:" << samples.size() << "，采样率:" << sampleRate << "Hz";
+        return true;
+    }
+    
+    // 其他采样率或声道数的16位PCM WAV同样从映射中读取，在进程内降混和重采样
+    if (wavReader->isOpen() && wavReader->isPcm16()) {
+        const WavFormat &format = wavReader->format();
+        const qint64 totalFrames = wavReader->frameCount();
+        const qint64 firstFrame = qMin(totalFrames, startMs * format.sampleRate / 1000);
+        const qint64 lastFrame = durationMs > 0 ? qMin(totalFrames, firstFrame + durationMs * format.sampleRate / 1000) : totalFrames;
+        
+        if (lastFrame <= firstFrame) {
+            qCritical() << "[SpeechRecognizer] 错误: WAV文件在指定区间内没有音频数据";
+            return false;
+        }
+        
+        AudioConverter converter(format.sampleRate, format.channels, WHISPER_SAMPLE_RATE);
+        std::vector<int16_t> converted;
+        const int16_t *frames = wavReader->pcm16Data() + firstFrame * format.channels;
+        qint64 remainingFrames = lastFrame - firstFrame;
+        while (remainingFrames > 0) {
+            qint64 n = qMin(remainingFrames, kConvertChunkFrames);
+            converter.pushFrames(frames, size_t(n), converted);
+            samples.append(converted.data(), converted.size());
+            converted.clear();
+            frames += n * format.channels;
+            remainingFrames -= n;
+        }
+        converter.finish(converted);
+        samples.append(converted.data(), converted.size());
+        sampleRate = WHISPER_SAMPLE_RATE;
+        m_loadedSourceBytes = (lastFrame - firstFrame) * format.channels * qint64(sizeof(int16_t));
+        recognizerMetrics().loadsConverted.increment();
+        
+        qCritical() << "[SpeechRecognizer] WAV文件(" << format.sampleRate << "Hz," << format.channels
+                    << "声道)已在进程内转换，样本数:" << samples.size();
+        return true;
+    }
+    
+    if (wavReader->isOpen()) {
+        const WavFormat &format = wavReader->format();
+        qCritical() << "[SpeechRecognizer] WAV格式不能直接使用(" << format.sampleRate << "Hz," << format.channels
+                    << "声道," << format.bitsPerSample << "位)，使用ffmpeg解码";
+    }
+    wavReader.reset();
+    
+    // 长文件按时间分段，由多个ffmpeg同时解码后按顺序拼接；任何一段失败都改用下面的单个ffmpeg
+    const QVector<DecodeRange> ranges = planParallelDecode(audioFilePath, startMs, durationMs);
+    if (ranges.size() > 1) {
+        QString parallelError;
+        qint64 parallelBytes = 0;
+        if (decodeRangesInParallel(audioFilePath, ranges, samples, &parallelBytes, &parallelError) && !samples.empty()) {
+            sampleRate = WHISPER_SAMPLE_RATE;
+            m_loadedSourceBytes = parallelBytes;
+            recognizerMetrics().loadsFfmpegParallel.increment();
+            
+            qCritical() << "[SpeechRecognizer] 音频文件分" << ranges.size() << "段并行解码成功，样本数:" << samples.size()
+                        << "，占用内存:" << samples.residentBytes() / 1024 << "KB，暂存文件:" << samples.spilledBytes() / 1024 << "KB";
+            return true;
+        }
+        qWarning() << "[SpeechRecognizer] 分段并行解码失败，改用单个ffmpeg:" << parallelError;
+        samples.clear();
+    }
+    
+    // ffmpeg只负责解码，按原始采样率和声道数输出带WAV头的16位PCM，降混和重采样在进程内完成
     QProcess ffmpegProcess;
     QStringList ffmpegArgs;
-    ffmpegArgs << "-hide_banner" << "-i" << audioFilePath
-               << "-f" << "f32le"
-               << "-acodec" << "pcm_f32le"
-               << "-ar" << "16000"
-               << "-ac" << "1"
-               << "-filter:a" << "atempo=1.0"
+    ffmpegArgs << "-hide_banner";
+    
+    // -ss和-t作为输入选项，ffmpeg在容器中直接定位，解码器不会读取区间以外的数据
+    if (startMs > 0) {
+        ffmpegArgs << "-ss" << QString::number(startMs / 1000.0, 'f', 3);
+    }
+    if (durationMs > 0) {
+        ffmpegArgs << "-t" << QString::number(durationMs / 1000.0, 'f', 3);
+    }
+    
+    ffmpegArgs << "-i" << audioFilePath
+               << "-vn"
+               << "-f" << "wav"
+               << "-acodec" << "pcm_s16le"
                << "-";
     
     qCritical() << "[SpeechRecognizer] 执行ffmpeg命令加载音频: ffmpeg" << ffmpegArgs.join(" ");
@@ -525,38 +1861,55 @@ bool SpeechRecognizer::loadAudioFile(const QString &audioFilePath, std::vector<f
     ffmpegProcess.start("ffmpeg", ffmpegArgs);
     
     if (!ffmpegProcess.waitForStarted(2000)) {
-        qCritical() << "[SpeechRecognizer] 错误: 无法启动ffmpeg进程读取音频文件";
+        qCritical() << "[SpeechRecognizer] 错误: 无法启动ffmpeg进程读取音频文件，请安装FFmpeg并确保其在系统PATH中";
         return false;
     }
     
-    // 读取输出数据
-    QByteArray audioData;
+    // 读取输出数据：先解析WAV头得到格式，之后每个数据块转换后直接追加到16位样本缓冲区
     qCritical() << "[SpeechRecognizer] 开始读取音频数据...";
     
-    // 设置一个合理的超时时间
-    int totalWaitTime = 0;
-    const int maxWaitTime = 30000; // 30秒
+    WavStreamDecoder decoder;
+    std::vector<int16_t> converted;
+    
+    // 超时按连续无输出的时间计算，长文件只要ffmpeg持续输出就不会超时
+    int idleWaitTime = 0;
+    const int maxIdleWaitTime = 30000; // 30秒
+    qint64 totalBytes = 0;
+    int loggedSeconds = 0;
     
-    while (totalWaitTime < maxWaitTime) {
+    while (ffmpegProcess.state() == QProcess::Running) {
         if (ffmpegProcess.waitForReadyRead(1000)) {
             QByteArray chunk = ffmpegProcess.readAll();
-            audioData += chunk;
-            qCritical() << "[SpeechRecognizer] 读取到" << chunk.size() << "字节，累计" << audioData.size() << "字节";
-        }
-        
-        if (ffmpegProcess.state() != QProcess::Running) {
-            break;
+            decoder.push(chunk, converted);
+            samples.append(converted.data(), converted.size());
+            converted.clear();
+            totalBytes += chunk.size();
+            idleWaitTime = 0;
+            
+            // 每解码约一分钟音频记录一次进度
+            int decodedSeconds = int(samples.size() / WHISPER_SAMPLE_RATE);
+            if (decodedSeconds >= loggedSeconds + 60) {
+                loggedSeconds = decodedSeconds;
+                qCritical() << "[SpeechRecognizer] 已解码" << decodedSeconds << "秒音频";
+            }
+        } else {
+            idleWaitTime += 1000;
+            if (idleWaitTime >= maxIdleWaitTime) {
+                qCritical() << "[SpeechRecognizer] 错误: 读取音频数据超时(" << maxIdleWaitTime/1000 << "秒无输出)";
+                ffmpegProcess.kill();
+                ffmpegProcess.waitForFinished(1000);
+                samples.clear();
+                return false;
+            }
         }
-        
-        totalWaitTime += 1000;
     }
     
-    // 检查是否超时
-    if (totalWaitTime >= maxWaitTime) {
-        qCritical() << "[SpeechRecognizer] 错误: 读取音频数据超时(" << maxWaitTime/1000 << "秒)";
-        ffmpegProcess.kill();
-        return false;
-    }
+    // 读取进程退出前剩余的输出
+    QByteArray remaining = ffmpegProcess.readAll();
+    decoder.push(remaining, converted);
+    totalBytes += remaining.size();
+    decoder.finish(converted);
+    samples.append(converted.data(), converted.size());
     
     // 检查退出码
     int exitCode = ffmpegProcess.exitCode();
@@ -564,33 +1917,27 @@ bool SpeechRecognizer::loadAudioFile(const QString &audioFilePath, std::vector<f
     
     qCritical() << "[SpeechRecognizer] ffmpeg处理音频退出码:" << exitCode;
     
-    if (exitCode != 0) {
+    if (ffmpegProcess.exitStatus() != QProcess::NormalExit || exitCode != 0) {
         qCritical() << "[SpeechRecognizer] 错误: ffmpeg处理音频失败，退出码:" << exitCode;
         qCritical() << "[SpeechRecognizer] ffmpeg错误输出:" << errorOutput.left(200);
+        samples.clear();
         return false;
     }
     
+    qCritical() << "[SpeechRecognizer] 音频数据大小:" << totalBytes << "字节，样本数:" << samples.size();
+    
     // 检查是否读取到数据
-    if (audioData.isEmpty()) {
+    if (decoder.isInvalid() || samples.empty()) {
         qCritical() << "[SpeechRecognizer] 错误: 未能从音频文件读取数据";
         return false;
     }
     
-    // 将字节数据转换为浮点数样本
-    const size_t numSamples = audioData.size() / sizeof(float);
-    qCritical() << "[SpeechRecognizer] 音频数据大小:" << audioData.size() << "字节，样本数:" << numSamples;
-    
-    if (numSamples == 0) {
-        qCritical() << "[SpeechRecognizer] 错误: 音频数据转换失败，无法获取有效的音频样本";
-        return false;
-    }
-    
-    samples.resize(numSamples);
-    memcpy(samples.data(), audioData.constData(), numSamples * sizeof(float));
+    sampleRate = WHISPER_SAMPLE_RATE; // 转换器总是输出16000Hz
+    m_loadedSourceBytes = totalBytes;
+    recognizerMetrics().loadsFfmpeg.increment();
     
-    sampleRate = 16000; // 我们强制将采样率设置为16000Hz
-    
-    qCritical() << "[SpeechRecognizer] 音频文件加载成功，样本数:" << numSamples << "，采样率:" << sampleRate << "Hz";
+    qCritical() << "[SpeechRecognizer] 音频文件加载成功，样本数:" << samples.size() << "，采样率:" << sampleRate
+                << "Hz，占用内存:" << samples.residentBytes() / 1024 << "KB，暂存文件:" << samples.spilledBytes() / 1024 << "KB";
     return true;
 }
 
@@ -602,11 +1949,9 @@ void SpeechRecognizer::cleanup()
     if (m_recognitionThread && m_recognitionThread->isRunning()) {
         qCritical() << "[SpeechRecognizer] 停止识别线程...";
         m_shouldStop = true;
-        bool stopped = m_recognitionThread->wait(3000); // 等待3秒
         
-        if (!stopped) {
-            qCritical() << "[SpeechRecognizer] 警告：识别线程未能及时停止，强制结束...";
-        }
+        // 删除仍在运行的QThread会使程序中止，一直等到识别线程结束
+        m_recognitionThread->wait();
         
         try {
             delete m_recognitionThread;
@@ -637,14 +1982,10 @@ void SpeechRecognizer::cleanup()
         }
     }
     
-    // 清理临时文件
-    if (!m_currentAudioFile.isEmpty() && QFile::exists(m_currentAudioFile)) {
-        qCritical() << "[SpeechRecognizer] 删除临时音频文件:" << m_currentAudioFile;
-        if (!QFile::remove(m_currentAudioFile)) {
-            qCritical() << "[SpeechRecognizer] 警告：无法删除临时文件:" << m_currentAudioFile;
-        }
-        m_currentAudioFile.clear();
-    }
+    // 当前音频文件是用户的媒体文件，不能删除，只清除记录
+    m_currentAudioFile.clear();
+    m_rangeStartMs = -1;
+    m_rangeEndMs = -1;
     
     // 删除临时音频文件
     if (!m_tempAudioFile.isEmpty() && QFile::exists(m_tempAudioFile)) {
@@ -679,6 +2020,33 @@ bool SpeechRecognizer::isLocalWhisperAvailable() const
 void SpeechRecognizer::setPreferOnlineAPI(bool prefer)
 {
     m_preferOnlineAPI = prefer;
+    m_preferOnlineAPIFixed = true;
+}
+
+void SpeechRecognizer::setThreadCount(int threads)
+{
+    m_threadCount = std::max(0, threads);
+}
+
+qint64 SpeechRecognizer::modelFileBytes() const
+{
+    // whisper没有提供查询模型占用内存的接口，这里只报告模型文件的大小
+    return m_whisperCtx ? QFileInfo(m_whisperPath).size() : 0;
+}
+
+qint64 SpeechRecognizer::audioResidentBytes() const
+{
+    return m_audioSamples.residentBytes() + m_trackResidentBytes;
+}
+
+void SpeechRecognizer::setDecodingProfile(const QString &profile)
+{
+    m_decodingProfile = profile;
+}
+
+void SpeechRecognizer::setWordTimestamps(bool enabled)
+{
+    m_wordTimestamps = enabled;
 }
 
 bool SpeechRecognizer::isFfmpegAvailable()
@@ -829,13 +2197,7 @@ bool SpeechRecognizer::recognizeWithWhisper(const QString &audioFilePath)
 {
     qCritical() << "[SpeechRecognizer] recognizeWithWhisper: 开始使用Whisper模型进行识别";
     
-    // 首先检查FFmpeg是否可用
-    if (!isFfmpegAvailable()) {
-        QString errorMsg = "FFmpeg不可用，无法提取音频。请安装FFmpeg并确保其在系统PATH中。";
-        qCritical() << "[SpeechRecognizer]" << errorMsg;
-        emit recognitionError(errorMsg);
-        return false;
-    }
+    // FFmpeg的可用性在loadAudioFile中按需检查：兼容的WAV文件不需要启动任何子进程
     
     if (!isLocalWhisperAvailable()) {
         QString errorMsg = "Whisper模型不可用，请检查模型路径和初始化";
@@ -846,9 +2208,15 @@ bool SpeechRecognizer::recognizeWithWhisper(const QString &audioFilePath)
     
     qCritical() << "[SpeechRecognizer] Whisper上下文已初始化，准备加载音频文件";
     
-    // 加载音频文件
+    beginJobStats(audioFilePath);
+    
+    // 加载音频文件，区间识别时只解码区间内的音频；超出内存预算的部分写入暂存文件
     m_audioSamples.clear();
-    if (!loadAudioFile(audioFilePath, m_audioSamples, m_audioSampleRate)) {
+    m_audioSamples.setSpillPolicy(qint64(m_audioMemoryBudgetMB) * 1024 * 1024, m_scratchDirectory);
+    const qint64 rangeStartMs = m_rangeStartMs;
+    qint64 startMs = qMax<qint64>(0, rangeStartMs);
+    qint64 durationMs = rangeStartMs >= 0 ? m_rangeEndMs - rangeStartMs : -1;
+    if (!loadAudioFile(audioFilePath, m_audioSamples, m_audioSampleRate, startMs, durationMs)) {
         QString errorMsg = "加载音频文件失败: " + audioFilePath;
         qCritical() << "[SpeechRecognizer]" << errorMsg;
         emit recognitionError(errorMsg);
@@ -865,22 +2233,72 @@ bool SpeechRecognizer::recognizeWithWhisper(const QString &audioFilePath)
     
     qCritical() << "[SpeechRecognizer] 音频样本加载完成，样本数:" << m_audioSamples.size() << "，准备开始识别";
     
+    m_jobStats.decodeMs = m_jobTimer.elapsed();
+    m_jobStats.sourceBytes = m_loadedSourceBytes;
+    m_jobStats.bytesDecoded = qint64(m_audioSamples.size() * sizeof(int16_t));
+    m_jobStats.audioSeconds = double(m_audioSamples.size()) / WHISPER_SAMPLE_RATE;
+    recognizerMetrics().decodeSeconds.observe(m_jobStats.decodeMs / 1000.0);
+    recognizerMetrics().sourceBytes.increment(uint64_t(m_jobStats.sourceBytes));
+    recognizerMetrics().decodedBytes.increment(uint64_t(m_jobStats.bytesDecoded));
+    
+    startRecognitionThread("EnRecognizer", [this]() {
+        if (m_alignmentWords.isEmpty()) {
+            this->recognizeAudioAsync();
+        } else {
+            this->alignAudioAsync();
+        }
+    });
+    return true;
+}
+
+void SpeechRecognizer::rejectWhileBusy()
+{
+    // 拒绝的是新请求，正在进行的任务没有失败，发出错误时不能把它计为失败
+    const bool jobActive = m_jobActive.exchange(false);
+    emit recognitionError("Already recognizing audio.");
+    m_jobActive = jobActive;
+}
+
+void SpeechRecognizer::beginJobStats(const QString &mediaFilePath)
+{
+    // 开始统计本次任务的资源消耗；峰值内存由采样得到，不重置进程级的峰值RSS
+    m_jobStats = RecognitionJobStats();
+    m_jobStats.mediaFilePath = mediaFilePath;
+    m_jobActive = true;
+    m_jobTimer.start();
+    m_jobCpuStart = processCpuSeconds();
+    m_jobRssSampler.start();
+}
+
+void SpeechRecognizer::startRecognitionThread(const QString &threadName, const std::function<void()> &work)
+{
     // 设置识别状态
     m_isRecognizing = true;
     m_shouldStop = false;
     
     // 创建并启动新的识别线程
-    m_recognitionThread = QThread::create([this]() {
+    m_recognitionThread = QThread::create([work]() {
         qCritical() << "[SpeechRecognizer] 识别线程启动";
-        this->recognizeAudioAsync();
+        recognizerMetrics().jobsRunning.add(1);
+        recognizerMetrics().jobPositionMs.set(0);
+        work();
+        recognizerMetrics().jobsRunning.add(-1);
     });
     
-    connect(m_recognitionThread, &QThread::finished, m_recognitionThread, &QObject::deleteLater);
+    // Linux下线程名取自objectName，whisper创建的工作线程继承此名称，便于在性能面板中区分
+    m_recognitionThread->setObjectName(threadName);
+    
+    // 线程结束后自动释放，并清空指针避免后续访问已释放的线程对象
+    QThread *thread = m_recognitionThread;
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        if (m_recognitionThread == thread) {
+            m_recognitionThread = nullptr;
+        }
+    });
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
     
     qCritical() << "[SpeechRecognizer] 识别线程已创建并启动";
     m_recognitionThread->start();
-    
-    return true;
 }
 
 bool SpeechRecognizer::recognizeWithOnlineAPI(const QString &audioFilePath)
@@ -1075,7 +2493,7 @@ bool SpeechRecognizer::extractAudioFromVideo(const QString &videoFilePath, QStri
         emit recognitionProgress(50); // 音频提取完成，准备开始识别
         
         // 直接在当前线程加载音频文件并执行识别
-        std::vector<float> audioSamples;
+        PcmBuffer audioSamples;
         int sampleRate;
         
         qCritical() << "[CRITICAL] 开始加载提取的音频文件进行语音识别";
@@ -1112,10 +2530,13 @@ bool SpeechRecognizer::extractAudioFromVideo(const QString &videoFilePath, QStri
         params.max_len = 0;
         params.split_on_word = true;
         params.max_tokens = 0;
+        params.abort_callback = &SpeechRecognizer::shouldAbort;
+        params.abort_callback_user_data = this;
         
-        // 设置语言
+        // 设置语言（language指针在whisper_full执行期间必须保持有效）
+        const QByteArray language = m_language.toUtf8();
         if (m_language != "auto") {
-            params.language = m_language.toUtf8().constData();
+            params.language = language.constData();
             params.detect_language = false;
         } else {
             params.language = nullptr; // nullptr表示自动检测语言
@@ -1125,24 +2546,45 @@ bool SpeechRecognizer::extractAudioFromVideo(const QString &videoFilePath, QStri
         emit recognitionProgress(75); // 开始执行语音识别
         qCritical() << "[CRITICAL] 开始执行Whisper语音识别";
         
-        // 执行语音识别
-        if (whisper_full(m_whisperCtx, params, audioSamples.data(), audioSamples.size()) != 0) {
-            QString errorMsg = "Whisper处理音频失败，请检查模型和音频质量";
-            qCritical() << "[CRITICAL]" << errorMsg;
-            emit recognitionError(errorMsg);
-            return false;
-        }
-        
-        qCritical() << "[CRITICAL] Whisper识别完成，开始收集结果";
-        
-        // 收集识别结果
+        // 与recognizeAudioAsync一样按窗口转换为浮点数，整段音频不会同时以浮点形式驻留内存
+        const size_t totalSamples = audioSamples.size();
+        const size_t windowSamples = size_t(kRecognitionWindowSeconds) * WHISPER_SAMPLE_RATE;
+        std::vector<float> window;
         std::string fullText;
-        for (int i = 0; i < whisper_full_n_segments(m_whisperCtx); ++i) {
-            const char* text = whisper_full_get_segment_text(m_whisperCtx, i);
-            fullText += text;
-            fullText += "\n";
+        size_t windowStart = 0;
+        while (windowStart < totalSamples) {
+            size_t windowEnd = std::min(totalSamples, windowStart + windowSamples);
+            if (windowEnd < totalSamples) {
+                windowEnd = std::max(windowStart + 1, findQuietCutPoint(audioSamples, windowEnd, kCutSearchSamples));
+            }
+            
+            const size_t count = windowEnd - windowStart;
+            window.resize(count);
+            audioSamples.toFloat(windowStart, count, window.data());
+            params.no_context = (windowStart == 0);
+            
+            if (whisper_full(m_whisperCtx, params, window.data(), int(count)) != 0) {
+                if (m_shouldStop) {
+                    qCritical() << "[CRITICAL] Whisper识别已停止";
+                    return false;
+                }
+                QString errorMsg = "Whisper处理音频失败，请检查模型和音频质量";
+                qCritical() << "[CRITICAL]" << errorMsg;
+                emit recognitionError(errorMsg);
+                return false;
+            }
+            
+            // 收集本窗口的识别结果
+            for (int i = 0; i < whisper_full_n_segments(m_whisperCtx); ++i) {
+                const char* text = whisper_full_get_segment_text(m_whisperCtx, i);
+                fullText += text;
+                fullText += "\n";
+            }
+            windowStart = windowEnd;
         }
         
+        qCritical() << "[CRITICAL] Whisper识别完成";
+        
         QString recognizedText = QString::fromUtf8(fullText.c_str());
         qCritical() << "[CRITICAL] 识别结果长度:" << recognizedText.length() << "字符";
         
@@ -0,0 +1,219 @@
+#include "subtitleimport.h"
+#include "transcriptformats.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QHash>
+#include <QProcess>
+#include <algorithm>
+
+namespace {
+
+// ffprobe只读取容器头部，很快返回
+const int kProbeTimeoutMs = 15000;
+
+// 提取字幕流时ffmpeg要读完整个容器，超时按连续无输出的时间计算
+const int kExtractIdleTimeoutMs = 30000;
+
+// 可以转换为SRT的文本字幕编码
+const char *const kTextSubtitleCodecs[] = { "subrip", "srt", "ass", "ssa", "webvtt", "mov_text", "text", "microdvd", "subviewer" };
+
+bool isTextCodec(const QString &codec)
+{
+    for (const char *textCodec : kTextSubtitleCodecs) {
+        if (codec == QLatin1String(textCodec)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 语言标签是否与设置中的语言相同，设置使用ISO 639-1（en），容器标签多为ISO 639-2（eng）
+ */
+bool languageMatches(const QString &tag, const QString &preferred)
+{
+    static const QHash<QString, QStringList> aliases = {
+        { "en", { "eng" } }, { "zh", { "chi", "zho" } }, { "ja", { "jpn" } }, { "ko", { "kor" } },
+        { "fr", { "fre", "fra" } }, { "de", { "ger", "deu" } }, { "es", { "spa" } }, { "ru", { "rus" } },
+        { "it", { "ita" } }, { "pt", { "por" } }
+    };
+    const QString language = tag.toLower().section('-', 0, 0);
+    if (language.isEmpty() || preferred.isEmpty() || preferred == "auto") {
+        return false;
+    }
+    return language == preferred || aliases.value(preferred).contains(language);
+}
+
+/**
+ * @brief 从lecture.en.srt这样的文件名中取出语言标签
+ */
+QString sidecarLanguage(const QString &sidecarPath, const QString &mediaBaseName)
+{
+    const QString baseName = QFileInfo(sidecarPath).completeBaseName();
+    return baseName.length() > mediaBaseName.length() ? baseName.mid(mediaBaseName.length() + 1) : QString();
+}
+
+bool failWith(QString *error, const QString &reason)
+{
+    if (error) {
+        *error = reason;
+    }
+    return false;
+}
+
+} // namespace
+
+QStringList findSidecarSubtitles(const QString &mediaFilePath)
+{
+    const QFileInfo mediaInfo(mediaFilePath);
+    const QString baseName = mediaInfo.completeBaseName();
+    const QDir dir = mediaInfo.absoluteDir();
+
+    // 文件名按字面比较：发布名中常见的[]、*、?放进通配符里会被当作模式
+    QStringList exact;
+    QStringList tagged;
+    const QStringList candidates = dir.entryList(QStringList() << "*.srt" << "*.vtt", QDir::Files | QDir::Readable,
+                                                 QDir::Name);
+    for (const QString &name : candidates) {
+        if (QFileInfo(name).completeBaseName() == baseName) {
+            exact << dir.filePath(name);
+        } else if (name.startsWith(baseName + '.')) {
+            tagged << dir.filePath(name);
+        }
+    }
+    return exact + tagged;
+}
+
+bool probeSubtitleStreams(const QString &mediaFilePath, QVector<EmbeddedSubtitleStream> &streams, qint64 &durationMs,
+                          QString *error)
+{
+    streams.clear();
+    durationMs = -1;
+
+    QProcess ffprobe;
+    ffprobe.start("ffprobe", QStringList() << "-v" << "error"
+                  << "-show_entries" << "format=duration:stream=index,codec_type,codec_name:stream_tags=language,title"
+                  << "-of" << "json" << mediaFilePath);
+    if (!ffprobe.waitForStarted(2000)) {
+        return failWith(error, "无法启动ffprobe");
+    }
+    if (!ffprobe.waitForFinished(kProbeTimeoutMs)) {
+        ffprobe.kill();
+        ffprobe.waitForFinished(1000);
+        return failWith(error, "ffprobe超时");
+    }
+    if (ffprobe.exitStatus() != QProcess::NormalExit || ffprobe.exitCode() != 0) {
+        return failWith(error, QString("ffprobe失败: %1").arg(QString::fromUtf8(ffprobe.readAllStandardError()).left(200)));
+    }
+
+    const QJsonObject root = QJsonDocument::fromJson(ffprobe.readAllStandardOutput()).object();
+    bool ok = false;
+    const double seconds = root.value("format").toObject().value("duration").toString().toDouble(&ok);
+    if (ok) {
+        durationMs = qint64(seconds * 1000.0);
+    }
+
+    for (const QJsonValue &value : root.value("streams").toArray()) {
+        const QJsonObject object = value.toObject();
+        if (object.value("codec_type").toString() != "subtitle") {
+            continue;
+        }
+        const QJsonObject tags = object.value("tags").toObject();
+        EmbeddedSubtitleStream stream;
+        stream.index = object.value("index").toInt(-1);
+        stream.codec = object.value("codec_name").toString();
+        stream.language = tags.value("language").toString();
+        stream.title = tags.value("title").toString();
+        stream.isText = isTextCodec(stream.codec);
+        streams.append(stream);
+    }
+    return true;
+}
+
+bool extractEmbeddedSubtitles(const QString &mediaFilePath, int streamIndex, QVector<TranscriptSegment> &segments,
+                              QString *error)
+{
+    // 只解复用字幕流，不解码音视频；输出经管道分块交给流式解析器，不落盘也不整体缓存
+    QProcess ffmpeg;
+    ffmpeg.start("ffmpeg", QStringList() << "-hide_banner" << "-nostdin" << "-v" << "error"
+                 << "-i" << mediaFilePath << "-map" << QString("0:%1").arg(streamIndex)
+                 << "-vn" << "-an" << "-f" << "srt" << "-");
+    if (!ffmpeg.waitForStarted(2000)) {
+        return failWith(error, "无法启动ffmpeg");
+    }
+
+    SubtitleCueParser parser;
+    for (;;) {
+        if (ffmpeg.waitForReadyRead(kExtractIdleTimeoutMs)) {
+            const QByteArray chunk = ffmpeg.readAllStandardOutput();
+            parser.feed(chunk.constData(), chunk.size());
+        } else if (ffmpeg.state() == QProcess::Running) {
+            ffmpeg.kill();
+            ffmpeg.waitForFinished(1000);
+            return failWith(error, "ffmpeg提取字幕超时");
+        } else {
+            break;
+        }
+    }
+    ffmpeg.waitForFinished(1000);
+    const QByteArray remaining = ffmpeg.readAllStandardOutput();
+    parser.feed(remaining.constData(), remaining.size());
+    parser.finish();
+
+    if (ffmpeg.exitStatus() != QProcess::NormalExit || ffmpeg.exitCode() != 0) {
+        return failWith(error, QString("ffmpeg提取字幕失败: %1").arg(QString::fromUtf8(ffmpeg.readAllStandardError()).left(200)));
+    }
+    segments = parser.segments();
+    return !segments.isEmpty() || failWith(error, "字幕流中没有条目");
+}
+
+bool importExistingSubtitles(const QString &mediaFilePath, const QString &preferredLanguage, ImportedSubtitles &result)
+{
+    result = ImportedSubtitles();
+    const QString mediaBaseName = QFileInfo(mediaFilePath).completeBaseName();
+
+    QVector<EmbeddedSubtitleStream> streams;
+    QString error;
+    if (!probeSubtitleStreams(mediaFilePath, streams, result.durationMs, &error)) {
+        qWarning() << "[SubtitleImport] 无法探测字幕流:" << error;
+    }
+
+    // 同名字幕文件：语言匹配的优先，其次完全同名的
+    QStringList sidecars = findSidecarSubtitles(mediaFilePath);
+    std::stable_sort(sidecars.begin(), sidecars.end(), [&](const QString &a, const QString &b) {
+        return languageMatches(sidecarLanguage(a, mediaBaseName), preferredLanguage)
+                > languageMatches(sidecarLanguage(b, mediaBaseName), preferredLanguage);
+    });
+    for (const QString &sidecar : sidecars) {
+        if (readTranscriptFile(sidecar, result.segments, &error)) {
+            result.source = QFileInfo(sidecar).fileName();
+            return true;
+        }
+        qWarning() << "[SubtitleImport] 无法解析字幕文件" << sidecar << ":" << error;
+    }
+
+    // 内嵌字幕流：图形字幕无法转换为文本，跳过
+    QVector<EmbeddedSubtitleStream> textStreams;
+    for (const EmbeddedSubtitleStream &stream : streams) {
+        if (stream.isText) {
+            textStreams.append(stream);
+        }
+    }
+    std::stable_sort(textStreams.begin(), textStreams.end(), [&](const EmbeddedSubtitleStream &a, const EmbeddedSubtitleStream &b) {
+        return languageMatches(a.language, preferredLanguage) > languageMatches(b.language, preferredLanguage);
+    });
+    for (const EmbeddedSubtitleStream &stream : textStreams) {
+        if (extractEmbeddedSubtitles(mediaFilePath, stream.index, result.segments, &error)) {
+            result.source = QString("内嵌字幕流 #%1（%2%3）").arg(stream.index).arg(stream.codec)
+                    .arg(stream.language.isEmpty() ? QString() : ", " + stream.language);
+            return true;
+        }
+        qWarning() << "[SubtitleImport] 无法提取字幕流" << stream.index << ":" << error;
+    }
+    return false;
+}
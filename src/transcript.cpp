@@ -0,0 +1,229 @@
+#include "transcript.h"
+
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief 没有词级时间戳时按时间比例估计字符位置，文本有空白时对齐到词边界
+ * @param forward 向后对齐（尾部片段的起点）还是向前对齐（头部片段的终点）
+ */
+int estimateCharacter(const QString &text, qint64 elapsedMs, qint64 durationMs, bool forward)
+{
+    int position = durationMs > 0 ? int(qBound<qint64>(0, text.size() * elapsedMs / durationMs, text.size())) : 0;
+    bool hasSpace = false;
+    for (const QChar &c : text) {
+        if (c.isSpace()) {
+            hasSpace = true;
+            break;
+        }
+    }
+    // 中文等不以空格分词的文本直接按估计位置截断
+    if (!hasSpace) {
+        return position;
+    }
+    if (forward) {
+        while (position < text.size() && position > 0 && !text.at(position - 1).isSpace()) {
+            ++position;
+        }
+    } else {
+        while (position > 0 && position < text.size() && !text.at(position).isSpace()) {
+            --position;
+        }
+    }
+    return position;
+}
+
+/**
+ * @brief 片段文本开头的空白字符数；词的偏移相对去掉首尾空白后的文本，加上它才是在segment.text中的位置
+ */
+int leadingSpaces(const QString &text)
+{
+    int count = 0;
+    while (count < text.size() && text.at(count).isSpace()) {
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * @brief 截取片段的一部分：文本为segment.text的[charBegin, charEnd)，词为[wordBegin, wordEnd)，时间换算到新的开始时间
+ * @return 截取的片段，文本为空时startMs为-1
+ */
+TranscriptSegment sliceSegment(const TranscriptSegment &segment, int charBegin, int charEnd, int wordBegin,
+                               int wordEnd, qint64 startMs, qint64 endMs)
+{
+    TranscriptSegment piece;
+    piece.startMs = startMs;
+    piece.endMs = endMs;
+    piece.text = segment.text.mid(charBegin, charEnd - charBegin).trimmed();
+    if (piece.text.isEmpty() || endMs <= startMs) {
+        piece.startMs = -1;
+        return piece;
+    }
+    // 截取的文本从保留的第一个词开始，词的偏移都相对这个词
+    const qint32 firstOffset = wordBegin < wordEnd ? segment.words.textOffset.at(wordBegin) : 0;
+    for (int i = wordBegin; i < wordEnd; ++i) {
+        piece.words.startMs.append(qint32(segment.startMs + segment.words.startMs.at(i) - startMs));
+        piece.words.endMs.append(qint32(segment.startMs + segment.words.endMs.at(i) - startMs));
+        piece.words.textOffset.append(segment.words.textOffset.at(i) - firstOffset);
+    }
+    return piece;
+}
+
+/**
+ * @brief 片段在untilMs之前的部分：有词级时间戳时保留在untilMs之前结束的词
+ */
+TranscriptSegment segmentHead(const TranscriptSegment &segment, qint64 untilMs)
+{
+    const TranscriptWords &words = segment.words;
+    if (words.isEmpty()) {
+        const int charEnd = estimateCharacter(segment.text, untilMs - segment.startMs, segment.endMs - segment.startMs, false);
+        return sliceSegment(segment, 0, charEnd, 0, 0, segment.startMs, untilMs);
+    }
+    int wordEnd = 0;
+    while (wordEnd < words.size() && segment.startMs + words.endMs.at(wordEnd) <= untilMs) {
+        ++wordEnd;
+    }
+    const int charEnd = wordEnd < words.size() ? leadingSpaces(segment.text) + words.textOffset.at(wordEnd)
+                                               : segment.text.size();
+    return sliceSegment(segment, 0, charEnd, 0, wordEnd, segment.startMs, untilMs);
+}
+
+/**
+ * @brief 片段在fromMs之后的部分：有词级时间戳时保留在fromMs之后开始的词
+ */
+TranscriptSegment segmentTail(const TranscriptSegment &segment, qint64 fromMs)
+{
+    const TranscriptWords &words = segment.words;
+    if (words.isEmpty()) {
+        const int charBegin = estimateCharacter(segment.text, fromMs - segment.startMs, segment.endMs - segment.startMs, true);
+        return sliceSegment(segment, charBegin, segment.text.size(), 0, 0, fromMs, segment.endMs);
+    }
+    int wordBegin = 0;
+    while (wordBegin < words.size() && segment.startMs + words.startMs.at(wordBegin) < fromMs) {
+        ++wordBegin;
+    }
+    if (wordBegin == words.size()) {
+        return sliceSegment(segment, 0, 0, 0, 0, fromMs, segment.endMs);
+    }
+    const qint64 startMs = segment.startMs + words.startMs.at(wordBegin);
+    return sliceSegment(segment, leadingSpaces(segment.text) + words.textOffset.at(wordBegin), segment.text.size(),
+                        wordBegin, words.size(),
+                        startMs, segment.endMs);
+}
+
+} // namespace
+
+int TranscriptWords::wordAt(qint32 relativeMs) const
+{
+    return int(std::upper_bound(startMs.constBegin(), startMs.constEnd(), relativeMs) - startMs.constBegin()) - 1;
+}
+
+QVector<TranscriptSegment> mergeTranscriptSegments(const QVector<TranscriptSegment> &existing,
+                                                   const QVector<TranscriptSegment> &incoming,
+                                                   qint64 rangeStartMs, qint64 rangeEndMs)
+{
+    // 整个文件的识别结果直接替换已有内容
+    if (rangeStartMs < 0) {
+        return incoming;
+    }
+
+    QVector<TranscriptSegment> merged;
+    merged.reserve(existing.size() + incoming.size());
+
+    // 保留与新区间不重叠的旧片段；跨过区间边界的片段截掉区间内的部分，保留区间外的文本
+    for (const TranscriptSegment &segment : existing) {
+        bool overlaps = segment.startMs < rangeEndMs && segment.endMs > rangeStartMs;
+        if (!overlaps) {
+            merged.append(segment);
+            continue;
+        }
+        if (segment.startMs < rangeStartMs) {
+            const TranscriptSegment head = segmentHead(segment, rangeStartMs);
+            if (head.startMs >= 0) {
+                merged.append(head);
+            }
+        }
+        if (segment.endMs > rangeEndMs) {
+            const TranscriptSegment tail = segmentTail(segment, rangeEndMs);
+            if (tail.startMs >= 0) {
+                merged.append(tail);
+            }
+        }
+    }
+
+    for (const TranscriptSegment &segment : incoming) {
+        merged.append(segment);
+    }
+
+    std::stable_sort(merged.begin(), merged.end(),
+                     [](const TranscriptSegment &a, const TranscriptSegment &b) {
+                         return a.startMs < b.startMs;
+                     });
+    return merged;
+}
+
+QVector<TranscriptGap> findTranscriptGaps(const QVector<TranscriptSegment> &segments, qint64 durationMs,
+                                          qint64 minimumGapMs)
+{
+    QVector<TranscriptGap> gaps;
+    qint64 coveredUntil = 0;
+    for (const TranscriptSegment &segment : segments) {
+        if (segment.startMs < 0) {
+            continue;
+        }
+        if (segment.startMs - coveredUntil >= minimumGapMs) {
+            TranscriptGap gap;
+            gap.startMs = coveredUntil;
+            gap.endMs = segment.startMs;
+            gaps.append(gap);
+        }
+        // 片段可能重叠，已覆盖范围取最大的结束时间
+        coveredUntil = qMax(coveredUntil, segment.endMs);
+    }
+    if (durationMs >= 0 && durationMs - coveredUntil >= minimumGapMs) {
+        TranscriptGap gap;
+        gap.startMs = coveredUntil;
+        gap.endMs = durationMs;
+        gaps.append(gap);
+    }
+    return gaps;
+}
+
+QString formatTranscriptTimestamp(qint64 milliseconds)
+{
+    if (milliseconds < 0) {
+        milliseconds = 0;
+    }
+
+    qint64 ms = milliseconds % 1000;
+    qint64 seconds = milliseconds / 1000;
+    qint64 minutes = seconds / 60;
+    qint64 hours = minutes / 60;
+
+    seconds %= 60;
+    minutes %= 60;
+
+    return QString("%1:%2:%3.%4")
+            .arg(hours, 2, 10, QChar('0'))
+            .arg(minutes, 2, 10, QChar('0'))
+            .arg(seconds, 2, 10, QChar('0'))
+            .arg(ms, 3, 10, QChar('0'));
+}
+
+QString formatTranscript(const QVector<TranscriptSegment> &segments)
+{
+    QStringList lines;
+    lines.reserve(segments.size());
+
+    for (const TranscriptSegment &segment : segments) {
+        lines << QString("[%1 --> %2] %3")
+                 .arg(formatTranscriptTimestamp(segment.startMs))
+                 .arg(formatTranscriptTimestamp(segment.endMs))
+                 .arg(segment.text.trimmed());
+    }
+
+    return lines.join("\n");
+}
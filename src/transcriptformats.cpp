@@ -0,0 +1,475 @@
+#include "transcriptformats.h"
+#include "mappedtranscript.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStringList>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// SRT用逗号分隔毫秒，WebVTT用点
+QString formatCueTimestamp(qint64 milliseconds, QChar separator)
+{
+    // 小时超过两位时毫秒分隔符不在固定位置，从后往前找
+    QString timestamp = formatTranscriptTimestamp(milliseconds);
+    const int dot = timestamp.lastIndexOf('.');
+    if (dot >= 0) {
+        timestamp[dot] = separator;
+    }
+    return timestamp;
+}
+
+bool isBlank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+/**
+ * @brief 解析"HH:MM:SS,mmm"、"HH:MM:SS.mmm"或"MM:SS.mmm"，首尾空白已去掉
+ * @return 毫秒，格式不对时返回-1
+ */
+qint64 parseCueTimestamp(const char *text, int length)
+{
+    // 最多三个以冒号分隔的数字字段，最后一个字段带毫秒
+    qint64 fields[3] = { 0, 0, 0 };
+    int fieldCount = 0;
+    qint64 value = 0;
+    int digits = 0;
+    int i = 0;
+    for (; i < length; ++i) {
+        const char c = text[i];
+        if (c >= '0' && c <= '9') {
+            value = value * 10 + (c - '0');
+            ++digits;
+        } else if (c == ':' && digits > 0 && fieldCount < 2) {
+            fields[fieldCount++] = value;
+            value = 0;
+            digits = 0;
+        } else {
+            break;
+        }
+    }
+    if (i >= length || (text[i] != ',' && text[i] != '.') || digits == 0 || fieldCount == 0) {
+        return -1;
+    }
+    fields[fieldCount++] = value;
+
+    qint64 milliseconds = 0;
+    int fractionDigits = 0;
+    for (++i; i < length && fractionDigits < 3; ++i, ++fractionDigits) {
+        if (text[i] < '0' || text[i] > '9') {
+            return -1;
+        }
+        milliseconds = milliseconds * 10 + (text[i] - '0');
+    }
+    if (fractionDigits == 0 || i != length) {
+        return -1;
+    }
+    while (fractionDigits++ < 3) {
+        milliseconds *= 10;
+    }
+
+    const qint64 hours = fieldCount == 3 ? fields[0] : 0;
+    const qint64 minutes = fields[fieldCount - 2];
+    const qint64 seconds = fields[fieldCount - 1];
+    if (minutes >= 60 || seconds >= 60) {
+        return -1;
+    }
+    return ((hours * 60 + minutes) * 60 + seconds) * 1000 + milliseconds;
+}
+
+/**
+ * @brief 取[begin, end)中去掉首尾空白的部分
+ */
+void trimRange(const char *&begin, const char *&end)
+{
+    while (begin < end && isBlank(*begin)) {
+        ++begin;
+    }
+    while (end > begin && isBlank(end[-1])) {
+        --end;
+    }
+}
+
+bool startsWith(const char *line, int length, const char *prefix)
+{
+    const int prefixLength = int(std::strlen(prefix));
+    return length >= prefixLength && std::memcmp(line, prefix, size_t(prefixLength)) == 0
+            && (length == prefixLength || isBlank(line[prefixLength]));
+}
+
+QString formatCues(const QVector<TranscriptSegment> &segments, QChar separator, bool numbered)
+{
+    QStringList cues;
+    cues.reserve(segments.size());
+    int number = 0;
+    for (const TranscriptSegment &segment : segments) {
+        // 没有时间戳的行（在线API的结果）无法写成字幕条目
+        if (segment.startMs < 0) {
+            continue;
+        }
+        QString cue;
+        if (numbered) {
+            cue += QString::number(++number) + "\n";
+        }
+        cue += formatCueTimestamp(segment.startMs, separator) + " --> " + formatCueTimestamp(segment.endMs, separator)
+                + "\n" + segment.text.trimmed() + "\n";
+        cues << cue;
+    }
+    return cues.join("\n");
+}
+
+bool failWith(QString *error, const QString &reason)
+{
+    if (error) {
+        *error = reason;
+    }
+    return false;
+}
+
+} // namespace
+
+TranscriptFormat transcriptFormatForPath(const QString &filePath)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    if (suffix == "qet") {
+        return TranscriptFormat::Binary;
+    } else if (suffix == "srt") {
+        return TranscriptFormat::Srt;
+    } else if (suffix == "vtt") {
+        return TranscriptFormat::Vtt;
+    } else if (suffix == "json") {
+        return TranscriptFormat::Json;
+    }
+    return TranscriptFormat::Unknown;
+}
+
+QString toSrt(const QVector<TranscriptSegment> &segments)
+{
+    return formatCues(segments, ',', true);
+}
+
+QString toVtt(const QVector<TranscriptSegment> &segments)
+{
+    return "WEBVTT\n\n" + formatCues(segments, '.', false);
+}
+
+QByteArray toTranscriptJson(const QVector<TranscriptSegment> &segments)
+{
+    QJsonArray segmentArray;
+    for (const TranscriptSegment &segment : segments) {
+        QJsonObject object;
+        object.insert("start", double(segment.startMs));
+        object.insert("end", double(segment.endMs));
+        object.insert("text", segment.text.trimmed());
+        if (!segment.words.isEmpty()) {
+            QJsonArray wordArray;
+            for (int i = 0; i < segment.words.size(); ++i) {
+                QJsonObject word;
+                word.insert("start", double(segment.startMs + segment.words.startMs.at(i)));
+                word.insert("end", double(segment.startMs + segment.words.endMs.at(i)));
+                word.insert("offset", segment.words.textOffset.at(i));
+                wordArray.append(word);
+            }
+            object.insert("words", wordArray);
+        }
+        segmentArray.append(object);
+    }
+
+    QJsonObject root;
+    root.insert("version", 1);
+    root.insert("segments", segmentArray);
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+SubtitleCueParser::SubtitleCueParser() : m_state(State::Idle),
+                                         m_firstLine(true)
+{
+}
+
+void SubtitleCueParser::feed(const char *data, qint64 size)
+{
+    const char *end = data + size;
+    const char *line = data;
+
+    // 上一块留下的半行先与本块开头拼起来
+    if (!m_pending.isEmpty()) {
+        const char *newline = static_cast<const char *>(std::memchr(data, '\n', size_t(size)));
+        if (!newline) {
+            m_pending.append(data, int(size));
+            return;
+        }
+        m_pending.append(data, int(newline - data));
+        processLine(m_pending.constData(), m_pending.size());
+        m_pending.clear();
+        line = newline + 1;
+    }
+
+    while (line < end) {
+        const char *newline = static_cast<const char *>(std::memchr(line, '\n', size_t(end - line)));
+        if (!newline) {
+            m_pending.append(line, int(end - line));
+            return;
+        }
+        processLine(line, int(newline - line));
+        line = newline + 1;
+    }
+}
+
+void SubtitleCueParser::finish()
+{
+    if (!m_pending.isEmpty()) {
+        processLine(m_pending.constData(), m_pending.size());
+        m_pending.clear();
+    }
+    if (m_state == State::Cue) {
+        finishCue();
+    }
+    m_state = State::Idle;
+    std::stable_sort(m_segments.begin(), m_segments.end(), [](const TranscriptSegment &a, const TranscriptSegment &b) {
+        return a.startMs < b.startMs;
+    });
+}
+
+void SubtitleCueParser::processLine(const char *line, int length)
+{
+    if (length > 0 && line[length - 1] == '\r') {
+        --length;
+    }
+    if (m_firstLine) {
+        m_firstLine = false;
+        if (length >= 3 && std::memcmp(line, "\xEF\xBB\xBF", 3) == 0) {
+            line += 3;
+            length -= 3;
+        }
+    }
+
+    const char *begin = line;
+    const char *end = line + length;
+    trimRange(begin, end);
+    if (begin == end) {
+        if (m_state == State::Cue) {
+            finishCue();
+        }
+        m_state = State::Idle;
+        return;
+    }
+
+    switch (m_state) {
+    case State::Skip:
+        return;
+    case State::Cue:
+        // 多行文本以空格连接
+        if (!m_cueText.isEmpty()) {
+            m_cueText.append(' ');
+        }
+        m_cueText.append(begin, int(end - begin));
+        return;
+    case State::Idle:
+        break;
+    }
+
+    const int trimmedLength = int(end - begin);
+    if (startsWith(begin, trimmedLength, "NOTE") || startsWith(begin, trimmedLength, "STYLE")
+        || startsWith(begin, trimmedLength, "REGION")) {
+        m_state = State::Skip;
+        return;
+    }
+
+    // 不是时间行的是SRT的序号、WebVTT文件头或条目标识，忽略
+    const char *arrow = nullptr;
+    for (const char *p = begin; p + 3 <= end; ++p) {
+        if (p[0] == '-' && p[1] == '-' && p[2] == '>') {
+            arrow = p;
+            break;
+        }
+    }
+    if (!arrow) {
+        return;
+    }
+
+    // 时间行之后可能有WebVTT的条目设置（如align:start），只取第一个字段
+    const char *startBegin = begin;
+    const char *startEnd = arrow;
+    trimRange(startBegin, startEnd);
+    const char *endBegin = arrow + 3;
+    while (endBegin < end && isBlank(*endBegin)) {
+        ++endBegin;
+    }
+    const char *endEnd = endBegin;
+    while (endEnd < end && !isBlank(*endEnd)) {
+        ++endEnd;
+    }
+
+    m_cue = TranscriptSegment();
+    m_cue.startMs = parseCueTimestamp(startBegin, int(startEnd - startBegin));
+    m_cue.endMs = parseCueTimestamp(endBegin, int(endEnd - endBegin));
+    m_cueText.clear();
+    m_state = (m_cue.startMs >= 0 && m_cue.endMs >= 0) ? State::Cue : State::Skip;
+}
+
+void SubtitleCueParser::finishCue()
+{
+    // 去掉HTML样式标签和ASS覆盖标签，只保留文字
+    QByteArray text;
+    text.reserve(m_cueText.size());
+    char closing = 0;
+    for (char c : m_cueText) {
+        if (closing) {
+            if (c == closing) {
+                closing = 0;
+            }
+        } else if (c == '<') {
+            closing = '>';
+        } else if (c == '{') {
+            closing = '}';
+        } else {
+            text.append(c);
+        }
+    }
+
+    m_cue.text = QString::fromUtf8(text).trimmed();
+    if (!m_cue.text.isEmpty()) {
+        m_segments.append(m_cue);
+    }
+    m_cueText.clear();
+}
+
+bool parseSubtitleCues(const QString &content, QVector<TranscriptSegment> &segments, QString *error)
+{
+    const QByteArray utf8 = content.toUtf8();
+    SubtitleCueParser parser;
+    parser.feed(utf8.constData(), utf8.size());
+    parser.finish();
+    segments = parser.segments();
+    if (segments.isEmpty()) {
+        return failWith(error, "没有找到字幕条目");
+    }
+    return true;
+}
+
+bool parseTranscriptJson(const QByteArray &content, QVector<TranscriptSegment> &segments, QString *error)
+{
+    segments.clear();
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(content, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        return failWith(error, QString("JSON解析失败: %1").arg(parseError.errorString()));
+    }
+    const QJsonObject root = document.object();
+
+    if (root.contains("segments")) {
+        for (const QJsonValue &value : root.value("segments").toArray()) {
+            const QJsonObject object = value.toObject();
+            TranscriptSegment segment;
+            segment.startMs = qint64(object.value("start").toDouble(-1));
+            segment.endMs = qint64(object.value("end").toDouble(-1));
+            segment.text = object.value("text").toString();
+            for (const QJsonValue &wordValue : object.value("words").toArray()) {
+                const QJsonObject word = wordValue.toObject();
+                segment.words.startMs.append(qint32(qint64(word.value("start").toDouble()) - segment.startMs));
+                segment.words.endMs.append(qint32(qint64(word.value("end").toDouble()) - segment.startMs));
+                segment.words.textOffset.append(word.value("offset").toInt());
+            }
+            segments.append(segment);
+        }
+    } else if (root.contains("transcription")) {
+        // whisper.cpp -oj的输出，offsets为毫秒
+        for (const QJsonValue &value : root.value("transcription").toArray()) {
+            const QJsonObject object = value.toObject();
+            const QJsonObject offsets = object.value("offsets").toObject();
+            TranscriptSegment segment;
+            segment.startMs = qint64(offsets.value("from").toDouble());
+            segment.endMs = qint64(offsets.value("to").toDouble());
+            segment.text = object.value("text").toString();
+            segments.append(segment);
+        }
+    } else {
+        return failWith(error, "JSON中没有segments或transcription数组");
+    }
+
+    std::stable_sort(segments.begin(), segments.end(), [](const TranscriptSegment &a, const TranscriptSegment &b) {
+        return a.startMs < b.startMs;
+    });
+    return true;
+}
+
+bool readTranscriptFile(const QString &filePath, QVector<TranscriptSegment> &segments, QString *error)
+{
+    const TranscriptFormat format = transcriptFormatForPath(filePath);
+    if (format == TranscriptFormat::Unknown) {
+        return failWith(error, QString("无法识别的字幕格式: %1").arg(filePath));
+    }
+
+    if (format == TranscriptFormat::Binary) {
+        MappedTranscript transcript;
+        if (!transcript.open(filePath, error)) {
+            return false;
+        }
+        segments = transcript.toSegments();
+        return true;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return failWith(error, file.errorString());
+    }
+    if (format == TranscriptFormat::Json) {
+        return parseTranscriptJson(file.readAll(), segments, error);
+    }
+
+    // SRT和WebVTT直接在映射的文件上解析，不把整个文件读成字符串
+    SubtitleCueParser parser;
+    const qint64 size = file.size();
+    if (size > 0) {
+        const uchar *data = file.map(0, size);
+        if (data) {
+            parser.feed(reinterpret_cast<const char *>(data), size);
+            file.unmap(const_cast<uchar *>(data));
+        } else {
+            const QByteArray content = file.readAll();
+            parser.feed(content.constData(), content.size());
+        }
+    }
+    parser.finish();
+    segments = parser.segments();
+    if (segments.isEmpty()) {
+        return failWith(error, "没有找到字幕条目");
+    }
+    return true;
+}
+
+bool writeTranscriptFile(const QString &filePath, const QVector<TranscriptSegment> &segments, QString *error)
+{
+    const TranscriptFormat format = transcriptFormatForPath(filePath);
+    if (format == TranscriptFormat::Binary) {
+        return MappedTranscript::write(filePath, segments, error);
+    }
+
+    QByteArray content;
+    switch (format) {
+    case TranscriptFormat::Srt:
+        content = toSrt(segments).toUtf8();
+        break;
+    case TranscriptFormat::Vtt:
+        content = toVtt(segments).toUtf8();
+        break;
+    case TranscriptFormat::Json:
+        content = toTranscriptJson(segments);
+        break;
+    default:
+        return failWith(error, QString("无法识别的字幕格式: %1").arg(filePath));
+    }
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size() || !file.commit()) {
+        return failWith(error, file.errorString());
+    }
+    return true;
+}
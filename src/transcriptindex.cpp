@@ -0,0 +1,828 @@
+#include "transcriptindex.h"
+#include "mappedtranscript.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace {
+
+const char kRunMagic[4] = { 'Q', 'E', 'I', 'R' };
+const quint32 kRunVersion = 1;
+const int kManifestVersion = 1;
+const char kManifestName[] = "manifest.json";
+
+// 索引段数量的上限，超过时不论大小都合并最后两个
+const int kMaxRuns = 16;
+
+// 前缀匹配时最多展开的词数
+const int kMaxPrefixTerms = 64;
+
+/**
+ * @brief 倒排表中的一项：文档编号和片段开始时间，按此顺序排序
+ */
+struct Posting
+{
+    quint32 document;
+    quint32 startMs;
+
+    bool operator<(const Posting &other) const
+    {
+        return document != other.document ? document < other.document : startMs < other.startMs;
+    }
+    bool operator==(const Posting &other) const
+    {
+        return document == other.document && startMs == other.startMs;
+    }
+};
+
+/**
+ * @brief 索引段文件头，其后依次为倒排表、词典和词文本，各部分都从8字节边界开始
+ */
+struct RunHeader
+{
+    char magic[4];          ///< "QEIR"
+    quint32 version;        ///< 格式版本
+    quint32 termCount;      ///< 词数
+    quint32 reserved;       ///< 保留，始终为0
+    quint64 postingCount;   ///< 倒排项总数
+    quint64 postingsOffset; ///< 倒排表的文件偏移
+    quint64 termsOffset;    ///< 词典的文件偏移
+    quint64 stringsOffset;  ///< 词文本的文件偏移
+    quint64 stringsBytes;   ///< 词文本的字节数
+};
+
+/**
+ * @brief 词典中的一项，按词的UTF-8字节序排列
+ */
+struct TermEntry
+{
+    quint64 firstPosting;   ///< 第一个倒排项的序号
+    quint32 postingCount;   ///< 倒排项数
+    quint32 stringOffset;   ///< 词在词文本中的字节偏移
+    quint32 stringLength;   ///< 词的字节数
+    quint32 reserved;       ///< 保留，始终为0
+};
+
+static_assert(sizeof(Posting) == 8, "Posting must be packed");
+static_assert(sizeof(RunHeader) == 56, "RunHeader must be packed");
+static_assert(sizeof(TermEntry) == 24, "TermEntry must be packed");
+
+bool failWith(QString *error, const QString &reason)
+{
+    if (error) {
+        *error = reason;
+    }
+    return false;
+}
+
+int compareBytes(const char *a, int aLength, const char *b, int bLength)
+{
+    const int result = std::memcmp(a, b, size_t(qMin(aLength, bLength)));
+    return result != 0 ? result : aLength - bLength;
+}
+
+/**
+ * @brief 中日文字没有空格分词，每个字单独作为索引词
+ */
+bool isIdeographic(QChar c)
+{
+    const QChar::Script script = c.script();
+    return script == QChar::Script_Han || script == QChar::Script_Hiragana || script == QChar::Script_Katakana;
+}
+
+/**
+ * @brief 倒排表的一段连续数据
+ */
+struct PostingList
+{
+    const Posting *begin;
+    const Posting *end;
+};
+
+/**
+ * @brief 顺序写出一个索引段：先写倒排表，结束时写词典和词文本，最后回填文件头
+ */
+class RunWriter
+{
+public:
+    explicit RunWriter(const QString &filePath) : m_file(filePath), m_postingCount(0), m_termStart(0) {}
+
+    bool begin(QString *error)
+    {
+        if (!m_file.open(QIODevice::WriteOnly)) {
+            return failWith(error, m_file.errorString());
+        }
+        const RunHeader placeholder = RunHeader();
+        return m_file.write(reinterpret_cast<const char *>(&placeholder), sizeof(placeholder)) == qint64(sizeof(placeholder))
+                || failWith(error, m_file.errorString());
+    }
+
+    void beginTerm(const QByteArray &term)
+    {
+        m_currentTerm = term;
+        m_termStart = m_postingCount;
+    }
+
+    /**
+     * @brief 追加当前词的倒排项，documents不为空时只保留其中的文档
+     */
+    void appendPostings(const Posting *postings, int count, const QHash<quint32, int> *documents = nullptr)
+    {
+        if (!documents) {
+            m_file.write(reinterpret_cast<const char *>(postings), qint64(count) * qint64(sizeof(Posting)));
+            m_postingCount += quint64(count);
+            return;
+        }
+        m_scratch.clear();
+        for (int i = 0; i < count; ++i) {
+            if (documents->contains(postings[i].document)) {
+                m_scratch.append(postings[i]);
+            }
+        }
+        m_file.write(reinterpret_cast<const char *>(m_scratch.constData()), qint64(m_scratch.size()) * qint64(sizeof(Posting)));
+        m_postingCount += quint64(m_scratch.size());
+    }
+
+    void endTerm()
+    {
+        if (m_postingCount == m_termStart) {
+            return;
+        }
+        TermEntry entry = TermEntry();
+        entry.firstPosting = m_termStart;
+        entry.postingCount = quint32(m_postingCount - m_termStart);
+        entry.stringOffset = quint32(m_strings.size());
+        entry.stringLength = quint32(m_currentTerm.size());
+        m_terms.append(entry);
+        m_strings.append(m_currentTerm);
+    }
+
+    bool finish(QString *error)
+    {
+        RunHeader header = RunHeader();
+        std::memcpy(header.magic, kRunMagic, sizeof(header.magic));
+        header.version = kRunVersion;
+        header.termCount = quint32(m_terms.size());
+        header.postingCount = m_postingCount;
+        header.postingsOffset = sizeof(RunHeader);
+        header.termsOffset = header.postingsOffset + m_postingCount * sizeof(Posting);
+        header.stringsOffset = header.termsOffset + quint64(m_terms.size()) * sizeof(TermEntry);
+        header.stringsBytes = quint64(m_strings.size());
+
+        m_file.write(reinterpret_cast<const char *>(m_terms.constData()), qint64(m_terms.size()) * qint64(sizeof(TermEntry)));
+        m_file.write(m_strings);
+        if (!m_file.seek(0)
+            || m_file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))
+            || !m_file.commit()) {
+            return failWith(error, m_file.errorString());
+        }
+        return true;
+    }
+
+private:
+    QSaveFile m_file;
+    QVector<TermEntry> m_terms;
+    QByteArray m_strings;
+    QVector<Posting> m_scratch;
+    QByteArray m_currentTerm;
+    quint64 m_postingCount;
+    quint64 m_termStart;
+};
+
+} // namespace
+
+/**
+ * @brief 内存映射的索引段文件，打开后只读
+ */
+class TranscriptIndexRun
+{
+public:
+    TranscriptIndexRun() : m_data(nullptr), m_terms(nullptr), m_postings(nullptr), m_strings(nullptr)
+    {
+        std::memset(&m_header, 0, sizeof(m_header));
+    }
+
+    ~TranscriptIndexRun()
+    {
+        if (m_data) {
+            m_file.unmap(const_cast<uchar *>(m_data));
+        }
+    }
+
+    bool open(const QString &filePath, QString *error)
+    {
+        m_file.setFileName(filePath);
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            return failWith(error, m_file.errorString());
+        }
+        const quint64 fileSize = quint64(m_file.size());
+        if (fileSize < sizeof(RunHeader)) {
+            return failWith(error, "索引段文件头不完整: " + filePath);
+        }
+        const uchar *data = m_file.map(0, qint64(fileSize));
+        if (!data) {
+            return failWith(error, m_file.errorString());
+        }
+        m_data = data;
+        std::memcpy(&m_header, data, sizeof(m_header));
+
+        // 检查各部分都在文件范围内且按8字节对齐，之后按数组直接访问映射的数据
+        const RunHeader &h = m_header;
+        const bool valid = std::memcmp(h.magic, kRunMagic, sizeof(h.magic)) == 0 && h.version == kRunVersion
+                && h.postingsOffset % 8 == 0 && h.termsOffset % 8 == 0
+                && h.postingsOffset >= sizeof(RunHeader) && h.postingsOffset <= fileSize && h.postingCount <= (fileSize - h.postingsOffset) / sizeof(Posting)
+                && h.termsOffset <= fileSize && h.termCount <= (fileSize - h.termsOffset) / sizeof(TermEntry)
+                && h.stringsOffset <= fileSize && h.stringsBytes <= fileSize - h.stringsOffset;
+        if (!valid) {
+            return failWith(error, "不是有效的索引段文件: " + filePath);
+        }
+        m_postings = reinterpret_cast<const Posting *>(data + h.postingsOffset);
+        m_terms = reinterpret_cast<const TermEntry *>(data + h.termsOffset);
+        m_strings = reinterpret_cast<const char *>(data + h.stringsOffset);
+        for (quint32 i = 0; i < h.termCount; ++i) {
+            const TermEntry &entry = m_terms[i];
+            if (entry.firstPosting > h.postingCount || entry.postingCount > h.postingCount - entry.firstPosting
+                || entry.stringOffset > h.stringsBytes || entry.stringLength > h.stringsBytes - entry.stringOffset) {
+                return failWith(error, "索引段词典损坏: " + filePath);
+            }
+        }
+        return true;
+    }
+
+    QString fileName() const { return QFileInfo(m_file.fileName()).fileName(); }
+    QString filePath() const { return m_file.fileName(); }
+    quint64 postingCount() const { return m_header.postingCount; }
+    int termCount() const { return int(m_header.termCount); }
+
+    const char *termData(int index) const { return m_strings + m_terms[index].stringOffset; }
+    int termLength(int index) const { return int(m_terms[index].stringLength); }
+
+    int compareTerm(int index, const QByteArray &term) const
+    {
+        return compareBytes(termData(index), termLength(index), term.constData(), term.size());
+    }
+
+    /**
+     * @brief 第一个不小于term的词
+     */
+    int lowerBound(const QByteArray &term) const
+    {
+        int low = 0;
+        int high = termCount();
+        while (low < high) {
+            const int middle = low + (high - low) / 2;
+            if (compareTerm(middle, term) < 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    bool termHasPrefix(int index, const QByteArray &prefix) const
+    {
+        return termLength(index) >= prefix.size() && std::memcmp(termData(index), prefix.constData(), size_t(prefix.size())) == 0;
+    }
+
+    PostingList postings(int index) const
+    {
+        const TermEntry &entry = m_terms[index];
+        PostingList list;
+        list.begin = m_postings + entry.firstPosting;
+        list.end = list.begin + entry.postingCount;
+        return list;
+    }
+
+private:
+    Q_DISABLE_COPY(TranscriptIndexRun)
+
+    QFile m_file;
+    RunHeader m_header;
+    const uchar *m_data;
+    const TermEntry *m_terms;
+    const Posting *m_postings;
+    const char *m_strings;
+};
+
+TranscriptIndex::TranscriptIndex() : m_nextDocument(1),
+                                     m_nextRun(1)
+{
+}
+
+TranscriptIndex::~TranscriptIndex()
+{
+}
+
+QStringList TranscriptIndex::tokenize(const QString &text)
+{
+    QStringList terms;
+    QString current;
+    for (const QChar c : text) {
+        if (isIdeographic(c)) {
+            if (!current.isEmpty()) {
+                terms << current;
+                current.clear();
+            }
+            terms << QString(c);
+        } else if (c.isLetterOrNumber() || (c.isMark() && !current.isEmpty())) {
+            current += c.toCaseFolded();
+        } else if (!current.isEmpty()) {
+            terms << current;
+            current.clear();
+        }
+    }
+    if (!current.isEmpty()) {
+        terms << current;
+    }
+    return terms;
+}
+
+bool TranscriptIndex::open(const QString &directory, QString *error)
+{
+    QMutexLocker writeLock(&m_writeMutex);
+
+    QDir dir(directory);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        return failWith(error, "无法创建索引目录: " + directory);
+    }
+
+    QVector<QSharedPointer<TranscriptIndexRun>> runs;
+    QHash<quint32, Document> documents;
+    QHash<QString, quint32> documentByMedia;
+    quint32 nextDocument = 1;
+    quint32 nextRun = 1;
+    QStringList listedRuns;
+
+    QFile manifestFile(dir.filePath(kManifestName));
+    if (manifestFile.exists()) {
+        if (!manifestFile.open(QIODevice::ReadOnly)) {
+            return failWith(error, manifestFile.errorString());
+        }
+        QJsonParseError parseError;
+        const QJsonObject manifest = QJsonDocument::fromJson(manifestFile.readAll(), &parseError).object();
+        if (parseError.error != QJsonParseError::NoError || manifest.value("version").toInt() != kManifestVersion) {
+            return failWith(error, "索引清单损坏: " + manifestFile.fileName());
+        }
+        nextDocument = quint32(manifest.value("nextDocument").toDouble(1));
+        nextRun = quint32(manifest.value("nextRun").toDouble(1));
+        for (const QJsonValue &value : manifest.value("runs").toArray()) {
+            QSharedPointer<TranscriptIndexRun> run(new TranscriptIndexRun);
+            if (!run->open(dir.filePath(value.toString()), error)) {
+                return false;
+            }
+            runs.append(run);
+            listedRuns << value.toString();
+        }
+        for (const QJsonValue &value : manifest.value("documents").toArray()) {
+            const QJsonObject object = value.toObject();
+            const quint32 id = quint32(object.value("id").toDouble());
+            Document document;
+            document.mediaFilePath = object.value("media").toString();
+            document.transcriptPath = object.value("transcript").toString();
+            documents.insert(id, document);
+            documentByMedia.insert(document.mediaFilePath, id);
+        }
+    }
+
+    // 写入或合并中途退出时留下的索引段不在清单中，直接删除
+    for (const QString &name : dir.entryList(QStringList() << "run-*.qix", QDir::Files)) {
+        if (!listedRuns.contains(name)) {
+            dir.remove(name);
+        }
+    }
+
+    QMutexLocker stateLock(&m_stateMutex);
+    m_directory = dir.absolutePath();
+    m_runs = runs;
+    m_documents = documents;
+    m_documentByMedia = documentByMedia;
+    m_nextDocument = nextDocument;
+    m_nextRun = nextRun;
+    return true;
+}
+
+QString TranscriptIndex::directory() const
+{
+    QMutexLocker stateLock(&m_stateMutex);
+    return m_directory;
+}
+
+int TranscriptIndex::documentCount() const
+{
+    QMutexLocker stateLock(&m_stateMutex);
+    return m_documents.size();
+}
+
+int TranscriptIndex::runCount() const
+{
+    QMutexLocker stateLock(&m_stateMutex);
+    return m_runs.size();
+}
+
+QString TranscriptIndex::nextRunPath()
+{
+    return QDir(m_directory).filePath(QString("run-%1.qix").arg(m_nextRun++, 6, 10, QChar('0')));
+}
+
+bool TranscriptIndex::saveManifest(const QVector<QSharedPointer<TranscriptIndexRun>> &runs,
+                                   const QHash<quint32, Document> &documents, QString *error)
+{
+    QJsonArray runArray;
+    for (const QSharedPointer<TranscriptIndexRun> &run : runs) {
+        runArray.append(run->fileName());
+    }
+    QJsonArray documentArray;
+    for (auto it = documents.constBegin(); it != documents.constEnd(); ++it) {
+        QJsonObject object;
+        object["id"] = double(it.key());
+        object["media"] = it.value().mediaFilePath;
+        object["transcript"] = it.value().transcriptPath;
+        documentArray.append(object);
+    }
+    QJsonObject manifest;
+    manifest["version"] = kManifestVersion;
+    manifest["nextDocument"] = double(m_nextDocument);
+    manifest["nextRun"] = double(m_nextRun);
+    manifest["runs"] = runArray;
+    manifest["documents"] = documentArray;
+
+    QSaveFile file(QDir(m_directory).filePath(kManifestName));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return failWith(error, file.errorString());
+    }
+    file.write(QJsonDocument(manifest).toJson(QJsonDocument::Compact));
+    return file.commit() || failWith(error, file.errorString());
+}
+
+bool TranscriptIndex::addDocument(const QString &mediaFilePath, const QString &transcriptPath,
+                                  const QVector<TranscriptSegment> &segments, QString *error)
+{
+    QMutexLocker writeLock(&m_writeMutex);
+    if (m_directory.isEmpty()) {
+        return failWith(error, "索引未打开");
+    }
+
+    // 本文档的倒排表：词（UTF-8）到包含它的片段开始时间，std::map按字节序排列
+    const quint32 documentId = m_nextDocument;
+    std::map<QByteArray, QVector<quint32>> terms;
+    for (const TranscriptSegment &segment : segments) {
+        if (segment.startMs < 0) {
+            continue;
+        }
+        const quint32 startMs = quint32(qMin<qint64>(segment.startMs, 0xffffffffLL));
+        for (const QString &term : tokenize(segment.text)) {
+            QVector<quint32> &times = terms[term.toUtf8()];
+            if (times.isEmpty() || times.last() != startMs) {
+                times.append(startMs);
+            }
+        }
+    }
+
+    QSharedPointer<TranscriptIndexRun> run;
+    if (!terms.empty()) {
+        const QString runPath = nextRunPath();
+        RunWriter writer(runPath);
+        if (!writer.begin(error)) {
+            return false;
+        }
+        QVector<Posting> postings;
+        for (auto it = terms.begin(); it != terms.end(); ++it) {
+            QVector<quint32> &times = it->second;
+            std::sort(times.begin(), times.end());
+            times.erase(std::unique(times.begin(), times.end()), times.end());
+            postings.resize(times.size());
+            for (int i = 0; i < times.size(); ++i) {
+                postings[i].document = documentId;
+                postings[i].startMs = times[i];
+            }
+            writer.beginTerm(it->first);
+            writer.appendPostings(postings.constData(), postings.size());
+            writer.endTerm();
+        }
+        run.reset(new TranscriptIndexRun);
+        if (!writer.finish(error) || !run->open(runPath, error)) {
+            run.reset();
+            QFile::remove(runPath);
+            return false;
+        }
+    }
+
+    // 先写清单再替换查询使用的状态；同一媒体文件原来的文档随之失效，其倒排项在合并时清除
+    QVector<QSharedPointer<TranscriptIndexRun>> runs;
+    QHash<quint32, Document> documents;
+    {
+        QMutexLocker stateLock(&m_stateMutex);
+        runs = m_runs;
+        documents = m_documents;
+    }
+    if (run) {
+        runs.append(run);
+    }
+    documents.remove(m_documentByMedia.value(mediaFilePath));
+    Document document;
+    document.mediaFilePath = mediaFilePath;
+    document.transcriptPath = transcriptPath;
+    documents.insert(documentId, document);
+    ++m_nextDocument;
+
+    if (!saveManifest(runs, documents, error)) {
+        if (run) {
+            const QString runPath = run->filePath();
+            run.reset();
+            QFile::remove(runPath);
+        }
+        return false;
+    }
+    {
+        QMutexLocker stateLock(&m_stateMutex);
+        m_runs = runs;
+        m_documents = documents;
+        m_documentByMedia.insert(mediaFilePath, documentId);
+    }
+
+    // 合并失败不影响已写入的文档，只是索引段多一些
+    QString mergeError;
+    if (!mergeTail(&mergeError)) {
+        qWarning() << "[TranscriptIndex] 合并索引段失败:" << mergeError;
+    }
+    return true;
+}
+
+bool TranscriptIndex::removeDocument(const QString &mediaFilePath, QString *error)
+{
+    QMutexLocker writeLock(&m_writeMutex);
+    if (!m_documentByMedia.contains(mediaFilePath)) {
+        return true;
+    }
+
+    QVector<QSharedPointer<TranscriptIndexRun>> runs;
+    QHash<quint32, Document> documents;
+    {
+        QMutexLocker stateLock(&m_stateMutex);
+        runs = m_runs;
+        documents = m_documents;
+    }
+    documents.remove(m_documentByMedia.value(mediaFilePath));
+    if (!saveManifest(runs, documents, error)) {
+        return false;
+    }
+
+    QMutexLocker stateLock(&m_stateMutex);
+    m_documents = documents;
+    m_documentByMedia.remove(mediaFilePath);
+    return true;
+}
+
+bool TranscriptIndex::mergeTail(QString *error)
+{
+    QVector<QSharedPointer<TranscriptIndexRun>> runs;
+    QHash<quint32, Document> documents;
+    {
+        QMutexLocker stateLock(&m_stateMutex);
+        runs = m_runs;
+        documents = m_documents;
+    }
+
+    // 从最新的索引段向前，前一个不超过已选部分两倍时一起合并，这样每个倒排项只被合并O(log n)次。
+    // 总是合并末尾连续的几个，合并后索引段仍按文档编号排列，倒排表直接按索引段顺序拼接
+    const int count = runs.size();
+    if (count < 2) {
+        return true;
+    }
+    int first = count - 1;
+    quint64 tailPostings = runs[first]->postingCount();
+    while (first > 0 && runs[first - 1]->postingCount() <= 2 * tailPostings) {
+        --first;
+        tailPostings += runs[first]->postingCount();
+    }
+    if (first == count - 1) {
+        if (count <= kMaxRuns) {
+            return true;
+        }
+        first = count - 2;
+    }
+
+    QHash<quint32, int> liveDocuments;
+    for (auto it = documents.constBegin(); it != documents.constEnd(); ++it) {
+        liveDocuments.insert(it.key(), 0);
+    }
+
+    const QString mergedPath = nextRunPath();
+    RunWriter writer(mergedPath);
+    if (!writer.begin(error)) {
+        return false;
+    }
+    QVector<QSharedPointer<TranscriptIndexRun>> sources = runs.mid(first);
+    QVector<int> cursors(sources.size(), 0);
+    for (;;) {
+        // 各索引段当前位置最小的词
+        int best = -1;
+        for (int r = 0; r < sources.size(); ++r) {
+            if (cursors[r] >= sources[r]->termCount()) {
+                continue;
+            }
+            if (best < 0 || compareBytes(sources[r]->termData(cursors[r]), sources[r]->termLength(cursors[r]),
+                                         sources[best]->termData(cursors[best]), sources[best]->termLength(cursors[best])) < 0) {
+                best = r;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        const QByteArray term(sources[best]->termData(cursors[best]), sources[best]->termLength(cursors[best]));
+        writer.beginTerm(term);
+        for (int r = 0; r < sources.size(); ++r) {
+            if (cursors[r] < sources[r]->termCount() && sources[r]->compareTerm(cursors[r], term) == 0) {
+                const PostingList list = sources[r]->postings(cursors[r]);
+                writer.appendPostings(list.begin, int(list.end - list.begin), &liveDocuments);
+                ++cursors[r];
+            }
+        }
+        writer.endTerm();
+    }
+
+    QSharedPointer<TranscriptIndexRun> merged(new TranscriptIndexRun);
+    if (!writer.finish(error) || !merged->open(mergedPath, error)) {
+        merged.reset();
+        QFile::remove(mergedPath);
+        return false;
+    }
+
+    QVector<QSharedPointer<TranscriptIndexRun>> newRuns = runs.mid(0, first);
+    newRuns.append(merged);
+    if (!saveManifest(newRuns, documents, error)) {
+        merged.reset();
+        QFile::remove(mergedPath);
+        return false;
+    }
+    {
+        QMutexLocker stateLock(&m_stateMutex);
+        m_runs = newRuns;
+    }
+
+    // 查询只在状态锁内使用索引段，替换后旧索引段只剩这里的引用，先解除映射再删除文件
+    QStringList obsolete;
+    for (const QSharedPointer<TranscriptIndexRun> &run : sources) {
+        obsolete << run->filePath();
+    }
+    runs.clear();
+    sources.clear();
+    for (const QString &path : obsolete) {
+        QFile::remove(path);
+    }
+    return true;
+}
+
+QVector<TranscriptSearchHit> TranscriptIndex::search(const QString &query, int maxHits) const
+{
+    QVector<TranscriptSearchHit> hits;
+    QStringList terms = tokenize(query);
+    if (terms.isEmpty() || maxHits <= 0) {
+        return hits;
+    }
+    const bool prefixLast = !query.at(query.size() - 1).isSpace();
+    const QString lastTerm = terms.last();
+    terms.removeLast();
+    terms.removeDuplicates();
+    terms.removeAll(lastTerm);
+
+    QVector<Posting> matches;
+    {
+        QMutexLocker stateLock(&m_stateMutex);
+
+        // 从最新的索引段开始，凑够maxHits即停止
+        QVector<PostingList> lists;
+        QVector<Posting> prefixPostings;
+        for (int r = m_runs.size() - 1; r >= 0 && matches.size() < maxHits; --r) {
+            const TranscriptIndexRun &run = *m_runs[r];
+            lists.clear();
+            bool missing = false;
+            for (const QString &term : terms) {
+                const QByteArray bytes = term.toUtf8();
+                const int index = run.lowerBound(bytes);
+                if (index >= run.termCount() || run.compareTerm(index, bytes) != 0) {
+                    missing = true;
+                    break;
+                }
+                lists.append(run.postings(index));
+            }
+            if (missing) {
+                continue;
+            }
+
+            // 最后一个词：前缀匹配时合并以它开头的词的倒排表
+            const QByteArray lastBytes = lastTerm.toUtf8();
+            const int lastIndex = run.lowerBound(lastBytes);
+            if (!prefixLast) {
+                if (lastIndex >= run.termCount() || run.compareTerm(lastIndex, lastBytes) != 0) {
+                    continue;
+                }
+                lists.append(run.postings(lastIndex));
+            } else {
+                prefixPostings.clear();
+                for (int i = lastIndex; i < run.termCount() && i - lastIndex < kMaxPrefixTerms && run.termHasPrefix(i, lastBytes); ++i) {
+                    const PostingList list = run.postings(i);
+                    for (const Posting *p = list.begin; p != list.end; ++p) {
+                        prefixPostings.append(*p);
+                    }
+                }
+                if (prefixPostings.isEmpty()) {
+                    continue;
+                }
+                std::sort(prefixPostings.begin(), prefixPostings.end());
+                prefixPostings.erase(std::unique(prefixPostings.begin(), prefixPostings.end()), prefixPostings.end());
+                PostingList list;
+                list.begin = prefixPostings.constData();
+                list.end = list.begin + prefixPostings.size();
+                lists.append(list);
+            }
+
+            // 从最短的倒排表末尾（最新的文档）向前，在其余倒排表中二分查找；
+            // 候选递减，每个倒排表的查找范围随之缩小
+            std::sort(lists.begin(), lists.end(), [](const PostingList &a, const PostingList &b) {
+                return (a.end - a.begin) < (b.end - b.begin);
+            });
+            QVector<const Posting *> limits;
+            for (const PostingList &list : lists) {
+                limits.append(list.end);
+            }
+            for (const Posting *candidate = lists[0].end; candidate != lists[0].begin && matches.size() < maxHits;) {
+                --candidate;
+                if (!m_documents.contains(candidate->document)) {
+                    continue;
+                }
+                bool inAll = true;
+                for (int l = 1; l < lists.size() && inAll; ++l) {
+                    const Posting *found = std::lower_bound(lists[l].begin, limits[l], *candidate);
+                    inAll = (found != limits[l] && *found == *candidate);
+                    limits[l] = found;
+                }
+                if (inAll) {
+                    matches.append(*candidate);
+                }
+            }
+        }
+
+        hits.reserve(matches.size());
+        for (const Posting &match : matches) {
+            const Document document = m_documents.value(match.document);
+            TranscriptSearchHit hit;
+            hit.mediaFilePath = document.mediaFilePath;
+            hit.transcriptPath = document.transcriptPath;
+            hit.startMs = match.startMs;
+            hits.append(hit);
+        }
+    }
+
+    // 文档从新到旧（匹配时已是此顺序），同一文档内按时间排序
+    QVector<int> documentOrder;
+    documentOrder.reserve(matches.size());
+    for (int i = 0; i < matches.size(); ++i) {
+        documentOrder.append(i);
+    }
+    std::stable_sort(documentOrder.begin(), documentOrder.end(), [&](int a, int b) {
+        if (matches[a].document != matches[b].document) {
+            return matches[a].document > matches[b].document;
+        }
+        return matches[a].startMs < matches[b].startMs;
+    });
+    QVector<TranscriptSearchHit> ordered;
+    ordered.reserve(hits.size());
+    for (int i : documentOrder) {
+        ordered.append(hits[i]);
+    }
+
+    // 片段文本和结束时间从字幕缓存中读取，同一文档只映射一次
+    QHash<QString, QSharedPointer<MappedTranscript>> transcripts;
+    for (TranscriptSearchHit &hit : ordered) {
+        QSharedPointer<MappedTranscript> &transcript = transcripts[hit.transcriptPath];
+        if (!transcript) {
+            transcript.reset(new MappedTranscript);
+            transcript->open(hit.transcriptPath);
+        }
+        if (!transcript->isOpen()) {
+            continue;
+        }
+        // 与前一个片段重叠时查到的可能是前一个片段，向后找开始时间相同的
+        int index = transcript->firstSegmentFrom(hit.startMs);
+        while (index < transcript->size() && transcript->record(index).startMs < hit.startMs) {
+            ++index;
+        }
+        if (index < transcript->size() && transcript->record(index).startMs == hit.startMs) {
+            hit.endMs = transcript->record(index).endMs;
+            hit.text = transcript->text(index);
+        }
+    }
+    return ordered;
+}
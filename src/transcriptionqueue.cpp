@@ -0,0 +1,194 @@
+#include "transcriptionqueue.h"
+#include "recognizermetrics.h"
+#include "speechrecognizer.h"
+
+#include <QDebug>
+
+namespace {
+
+// 队列空闲多久后释放模型
+const int kReleaseIdleMs = 60000;
+
+} // namespace
+
+TranscriptionQueue::TranscriptionQueue(QObject *parent) : QObject(parent),
+                                                          m_recognizer(nullptr),
+                                                          m_rerunCurrent(false),
+                                                          m_recognizerStale(false)
+{
+    m_workerThread.setObjectName("EnBackground");
+    m_workerThread.start(QThread::IdlePriority);
+
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(kReleaseIdleMs);
+    connect(&m_idleTimer, &QTimer::timeout, this, &TranscriptionQueue::releaseRecognizer);
+}
+
+TranscriptionQueue::~TranscriptionQueue()
+{
+    m_pending.clear();
+    updateQueuedMetric();
+
+    // 在工作线程中停止识别并释放识别器，然后结束工作线程
+    if (m_recognizer) {
+        SpeechRecognizer *recognizer = m_recognizer;
+        m_recognizer = nullptr;
+        disconnect(recognizer, nullptr, this, nullptr);
+        QMetaObject::invokeMethod(recognizer, [recognizer]() {
+            recognizer->stop();
+            recognizer->deleteLater();
+        }, Qt::BlockingQueuedConnection);
+    }
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+bool TranscriptionQueue::enqueue(const QString &mediaFilePath)
+{
+    if (mediaFilePath == m_current) {
+        m_rerunCurrent = true;
+        return false;
+    }
+    if (m_pending.contains(mediaFilePath)) {
+        return false;
+    }
+    m_pending.append(mediaFilePath);
+    updateQueuedMetric();
+    startNext();
+    return true;
+}
+
+void TranscriptionQueue::remove(const QString &mediaFilePath)
+{
+    if (m_pending.removeAll(mediaFilePath) > 0) {
+        updateQueuedMetric();
+    }
+    if (mediaFilePath == m_current) {
+        m_rerunCurrent = false;
+    }
+}
+
+int TranscriptionQueue::pendingCount() const
+{
+    return m_pending.size();
+}
+
+QString TranscriptionQueue::currentFile() const
+{
+    return m_current;
+}
+
+void TranscriptionQueue::reloadSettings()
+{
+    m_recognizerStale = true;
+    if (m_current.isEmpty()) {
+        releaseRecognizer();
+    }
+}
+
+void TranscriptionQueue::startNext()
+{
+    if (!m_current.isEmpty() || m_pending.isEmpty()) {
+        return;
+    }
+    m_idleTimer.stop();
+
+    if (m_recognizer && m_recognizerStale) {
+        releaseRecognizer();
+    }
+    m_recognizerStale = false;
+
+    // 识别器在界面线程中创建后移到工作线程，模型在工作线程中加载
+    const bool needsInitialize = !m_recognizer;
+    if (needsInitialize) {
+        m_recognizer = new SpeechRecognizer;
+        // 后台识别整个媒体库，只用本地whisper，不把用户的文件批量上传到在线API
+        m_recognizer->setPreferOnlineAPI(false);
+        m_recognizer->moveToThread(&m_workerThread);
+        connect(m_recognizer, &SpeechRecognizer::segmentsRecognized, this,
+                [this](const QString &mediaFilePath, const QVector<TranscriptSegment> &segments) {
+            onSegmentsRecognized(mediaFilePath, segments);
+        });
+        connect(m_recognizer, &SpeechRecognizer::recognitionFinished, this, &TranscriptionQueue::onRecognitionFinished);
+        connect(m_recognizer, &SpeechRecognizer::recognitionError, this, &TranscriptionQueue::onRecognitionError);
+        connect(m_recognizer, &SpeechRecognizer::jobStatsReady, this, &TranscriptionQueue::jobStatsReady);
+    }
+
+    m_current = m_pending.takeFirst();
+    m_currentSegments.clear();
+    m_rerunCurrent = false;
+    updateQueuedMetric();
+    emit jobStarted(m_current);
+
+    SpeechRecognizer *recognizer = m_recognizer;
+    const QString mediaFilePath = m_current;
+    QMetaObject::invokeMethod(recognizer, [recognizer, mediaFilePath, needsInitialize]() {
+        if (needsInitialize) {
+            recognizer->initialize();
+        }
+        recognizer->recognizeFile(mediaFilePath);
+    });
+}
+
+void TranscriptionQueue::finishJob()
+{
+    // 识别期间文件又被修改，排到队尾重新识别
+    if (m_rerunCurrent && !m_pending.contains(m_current)) {
+        m_pending.append(m_current);
+    }
+    m_current.clear();
+    m_currentSegments.clear();
+    m_rerunCurrent = false;
+    updateQueuedMetric();
+
+    if (m_pending.isEmpty()) {
+        m_idleTimer.start();
+    } else {
+        startNext();
+    }
+}
+
+void TranscriptionQueue::releaseRecognizer()
+{
+    if (!m_recognizer || !m_current.isEmpty()) {
+        return;
+    }
+    SpeechRecognizer *recognizer = m_recognizer;
+    m_recognizer = nullptr;
+    disconnect(recognizer, nullptr, this, nullptr);
+    QMetaObject::invokeMethod(recognizer, [recognizer]() {
+        recognizer->stop();
+        recognizer->deleteLater();
+    });
+    qInfo() << "[TranscriptionQueue] 后台识别器已释放";
+}
+
+void TranscriptionQueue::updateQueuedMetric()
+{
+    recognizerMetrics().jobsQueued.set(m_pending.size());
+}
+
+void TranscriptionQueue::onSegmentsRecognized(const QString &mediaFilePath, const QVector<TranscriptSegment> &segments)
+{
+    if (mediaFilePath == m_current) {
+        m_currentSegments = segments;
+    }
+}
+
+void TranscriptionQueue::onRecognitionFinished()
+{
+    if (m_current.isEmpty()) {
+        return;
+    }
+    emit jobFinished(m_current, m_currentSegments);
+    finishJob();
+}
+
+void TranscriptionQueue::onRecognitionError(const QString &errorMessage)
+{
+    if (m_current.isEmpty()) {
+        return;
+    }
+    emit jobFailed(m_current, errorMessage);
+    finishJob();
+}
@@ -0,0 +1,266 @@
+#include "transcriptmodel.h"
+
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+
+bool sameSegment(const TranscriptSegment &a, const TranscriptSegment &b)
+{
+    return a.startMs == b.startMs && a.endMs == b.endMs && a.text == b.text && a.words == b.words;
+}
+
+// 与TextRole相同的去掉首尾空白后的长度，不复制字符串
+int trimmedLength(const QString &text)
+{
+    int begin = 0;
+    int end = text.size();
+    while (begin < end && text.at(begin).isSpace()) {
+        ++begin;
+    }
+    while (end > begin && text.at(end - 1).isSpace()) {
+        --end;
+    }
+    return end - begin;
+}
+
+} // namespace
+
+TranscriptModel::TranscriptModel(QObject *parent) : QAbstractListModel(parent)
+{
+    rebuildIndex(0);
+}
+
+int TranscriptModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_segments.size();
+}
+
+QVariant TranscriptModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_segments.size()) {
+        return QVariant();
+    }
+
+    const TranscriptSegment &segment = m_segments.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        if (segment.startMs < 0) {
+            return segment.text;
+        }
+        return QString("[%1 --> %2] %3")
+                .arg(formatTranscriptTimestamp(segment.startMs))
+                .arg(formatTranscriptTimestamp(segment.endMs))
+                .arg(segment.text.trimmed());
+    case Qt::ToolTipRole:
+    case TextRole:
+        return segment.text.trimmed();
+    case StartMsRole:
+        return segment.startMs;
+    case EndMsRole:
+        return segment.endMs;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> TranscriptModel::roleNames() const
+{
+    QHash<int, QByteArray> roles = QAbstractListModel::roleNames();
+    roles.insert(StartMsRole, "startMs");
+    roles.insert(EndMsRole, "endMs");
+    roles.insert(TextRole, "text");
+    return roles;
+}
+
+void TranscriptModel::setSegments(const QVector<TranscriptSegment> &segments)
+{
+    // 找出新旧内容的公共前缀和公共后缀，只替换中间不同的部分
+    const int oldCount = m_segments.size();
+    const int newCount = segments.size();
+    int prefix = 0;
+    while (prefix < oldCount && prefix < newCount && sameSegment(m_segments.at(prefix), segments.at(prefix))) {
+        ++prefix;
+    }
+    int suffix = 0;
+    while (suffix < oldCount - prefix && suffix < newCount - prefix
+           && sameSegment(m_segments.at(oldCount - 1 - suffix), segments.at(newCount - 1 - suffix))) {
+        ++suffix;
+    }
+
+    const int removeCount = oldCount - prefix - suffix;
+    const int insertCount = newCount - prefix - suffix;
+
+    // 相同位置上行数不变时只通知内容变化，视图不需要重新计算滚动范围
+    if (removeCount == insertCount) {
+        if (removeCount > 0) {
+            std::copy(segments.begin() + prefix, segments.begin() + prefix + insertCount, m_segments.begin() + prefix);
+            rebuildIndex(prefix);
+            emit dataChanged(index(prefix), index(prefix + insertCount - 1));
+        }
+        return;
+    }
+
+    if (removeCount > 0) {
+        beginRemoveRows(QModelIndex(), prefix, prefix + removeCount - 1);
+        m_segments.remove(prefix, removeCount);
+        rebuildIndex(prefix);
+        endRemoveRows();
+    }
+    if (insertCount > 0) {
+        beginInsertRows(QModelIndex(), prefix, prefix + insertCount - 1);
+        m_segments.insert(prefix, insertCount, TranscriptSegment());
+        std::copy(segments.begin() + prefix, segments.begin() + prefix + insertCount, m_segments.begin() + prefix);
+        rebuildIndex(prefix);
+        endInsertRows();
+    }
+}
+
+void TranscriptModel::insertSegments(const QVector<TranscriptSegment> &segments)
+{
+    if (segments.isEmpty()) {
+        return;
+    }
+
+    // 流式结果通常追加在末尾；区间识别时插入到区间所在位置
+    const TranscriptSegment &first = segments.first();
+    const int position = int(std::upper_bound(m_segments.begin(), m_segments.end(), first,
+                                              [](const TranscriptSegment &a, const TranscriptSegment &b) {
+                                                  return a.startMs < b.startMs;
+                                              }) - m_segments.begin());
+
+    beginInsertRows(QModelIndex(), position, position + segments.size() - 1);
+    m_segments.insert(position, segments.size(), TranscriptSegment());
+    std::copy(segments.begin(), segments.end(), m_segments.begin() + position);
+    rebuildIndex(position);
+    endInsertRows();
+}
+
+void TranscriptModel::replaceRange(const QVector<TranscriptSegment> &segments, qint64 rangeStartMs, qint64 rangeEndMs)
+{
+    setSegments(mergeTranscriptSegments(m_segments, segments, rangeStartMs, rangeEndMs));
+}
+
+void TranscriptModel::setUntimedText(const QString &text)
+{
+    QVector<TranscriptSegment> segments;
+    for (const QString &line : text.split('\n', QString::SkipEmptyParts)) {
+        TranscriptSegment segment;
+        segment.startMs = -1;
+        segment.endMs = -1;
+        segment.text = line;
+        segments.append(segment);
+    }
+    setSegments(segments);
+}
+
+void TranscriptModel::clear()
+{
+    if (m_segments.isEmpty()) {
+        return;
+    }
+    beginResetModel();
+    m_segments.clear();
+    m_segments.squeeze();
+    rebuildIndex(0);
+    endResetModel();
+}
+
+int TranscriptModel::rowAtTime(qint64 timeMs) const
+{
+    const int row = int(std::upper_bound(m_startTimes.constBegin(), m_startTimes.constEnd(), timeMs)
+                        - m_startTimes.constBegin()) - 1;
+    if (row < 0 || m_startTimes.at(row) < 0) {
+        return -1;
+    }
+    return row;
+}
+
+qint64 TranscriptModel::timeAtCharacter(int row, int characterIndex) const
+{
+    if (row < 0 || row >= m_segments.size()) {
+        return -1;
+    }
+    const TranscriptSegment &segment = m_segments.at(row);
+    if (segment.startMs < 0) {
+        return -1;
+    }
+
+    const TranscriptWords &words = segment.words;
+    if (!words.isEmpty()) {
+        const int word = int(std::upper_bound(words.textOffset.constBegin(), words.textOffset.constEnd(), characterIndex)
+                             - words.textOffset.constBegin()) - 1;
+        return segment.startMs + words.startMs.at(qMax(0, word));
+    }
+
+    const qint64 length = m_textOffsets.at(row + 1) - m_textOffsets.at(row) - 1;
+    const qint64 duration = qMax<qint64>(0, segment.endMs - segment.startMs);
+    if (length <= 0 || characterIndex <= 0) {
+        return segment.startMs;
+    }
+    return segment.startMs + duration * qMin<qint64>(characterIndex, length) / length;
+}
+
+int TranscriptModel::rowAtTextOffset(qint64 offset) const
+{
+    if (offset < 0 || m_segments.isEmpty() || offset >= m_textOffsets.last()) {
+        return -1;
+    }
+    return int(std::upper_bound(m_textOffsets.constBegin(), m_textOffsets.constEnd(), offset)
+               - m_textOffsets.constBegin()) - 1;
+}
+
+qint64 TranscriptModel::timeAtTextOffset(qint64 offset) const
+{
+    const int row = rowAtTextOffset(offset);
+    if (row < 0) {
+        return -1;
+    }
+    return timeAtCharacter(row, int(offset - m_textOffsets.at(row)));
+}
+
+qint64 TranscriptModel::textOffsetAtTime(qint64 timeMs) const
+{
+    const int row = rowAtTime(timeMs);
+    if (row < 0) {
+        return -1;
+    }
+
+    const TranscriptSegment &segment = m_segments.at(row);
+    const qint64 length = m_textOffsets.at(row + 1) - m_textOffsets.at(row) - 1;
+    const qint64 duration = segment.endMs - segment.startMs;
+    if (duration <= 0 || timeMs >= segment.endMs) {
+        return m_textOffsets.at(row) + length;
+    }
+    return m_textOffsets.at(row) + length * (timeMs - segment.startMs) / duration;
+}
+
+void TranscriptModel::rebuildIndex(int firstRow)
+{
+    // 变化位置之前的前缀不受影响；流式追加时只计算新增的行
+    const int count = m_segments.size();
+    firstRow = qBound(0, firstRow, count);
+    m_startTimes.resize(count);
+    m_textOffsets.resize(count + 1);
+    if (firstRow == 0) {
+        m_textOffsets[0] = 0;
+    }
+    for (int row = firstRow; row < count; ++row) {
+        const TranscriptSegment &segment = m_segments.at(row);
+        m_startTimes[row] = segment.startMs;
+        // 每行后面算一个换行符
+        m_textOffsets[row + 1] = m_textOffsets.at(row) + trimmedLength(segment.text) + 1;
+    }
+}
+
+qint64 TranscriptModel::memoryBytes() const
+{
+    qint64 bytes = qint64(m_segments.capacity()) * qint64(sizeof(TranscriptSegment))
+            + qint64(m_startTimes.capacity() + m_textOffsets.capacity()) * qint64(sizeof(qint64));
+    for (const TranscriptSegment &segment : m_segments) {
+        bytes += qint64(segment.text.capacity()) * qint64(sizeof(QChar))
+                + qint64(segment.words.startMs.capacity() + segment.words.endMs.capacity()
+                         + segment.words.textOffset.capacity()) * qint64(sizeof(qint32));
+    }
+    return bytes;
+}
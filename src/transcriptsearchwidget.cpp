@@ -0,0 +1,95 @@
+#include "transcriptsearchwidget.h"
+#include "transcriptindex.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+// 输入停顿多久后开始搜索
+const int kSearchDelayMs = 150;
+
+// 最多显示的结果数
+const int kMaxHits = 500;
+
+// 结果项中保存媒体文件和时间的数据角色
+const int kMediaFileRole = Qt::UserRole;
+const int kStartMsRole = Qt::UserRole + 1;
+
+} // namespace
+
+TranscriptSearchWidget::TranscriptSearchWidget(TranscriptIndex *index, QWidget *parent) : QWidget(parent),
+                                                                                           m_index(index)
+{
+    m_queryEdit = new QLineEdit;
+    m_queryEdit->setPlaceholderText(tr("在所有已识别的字幕中搜索"));
+    m_queryEdit->setClearButtonEnabled(true);
+
+    m_resultTree = new QTreeWidget;
+    m_resultTree->setColumnCount(3);
+    m_resultTree->setHeaderLabels(QStringList() << tr("文件") << tr("时间") << tr("内容"));
+    m_resultTree->setRootIsDecorated(false);
+    m_resultTree->setUniformRowHeights(true);
+    m_resultTree->header()->setSectionResizeMode(2, QHeaderView::Stretch);
+
+    m_statusLabel = new QLabel;
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(m_queryEdit);
+    layout->addWidget(m_resultTree, 1);
+    layout->addWidget(m_statusLabel);
+
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(kSearchDelayMs);
+    connect(&m_debounceTimer, &QTimer::timeout, this, &TranscriptSearchWidget::runSearch);
+    connect(m_queryEdit, &QLineEdit::textChanged, &m_debounceTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_queryEdit, &QLineEdit::returnPressed, this, &TranscriptSearchWidget::runSearch);
+    connect(m_resultTree, &QTreeWidget::itemActivated, this, &TranscriptSearchWidget::onItemActivated);
+}
+
+void TranscriptSearchWidget::runSearch()
+{
+    m_debounceTimer.stop();
+    m_resultTree->clear();
+    const QString query = m_queryEdit->text();
+    if (query.trimmed().isEmpty()) {
+        m_statusLabel->clear();
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<TranscriptSearchHit> hits = m_index->search(query, kMaxHits);
+    const qint64 elapsedMs = timer.elapsed();
+
+    QList<QTreeWidgetItem *> items;
+    items.reserve(hits.size());
+    for (const TranscriptSearchHit &hit : hits) {
+        QTreeWidgetItem *item = new QTreeWidgetItem;
+        item->setText(0, QFileInfo(hit.mediaFilePath).fileName());
+        item->setToolTip(0, hit.mediaFilePath);
+        item->setText(1, formatTranscriptTimestamp(hit.startMs));
+        item->setText(2, hit.text);
+        item->setData(0, kMediaFileRole, hit.mediaFilePath);
+        item->setData(0, kStartMsRole, hit.startMs);
+        items.append(item);
+    }
+    m_resultTree->addTopLevelItems(items);
+    m_resultTree->resizeColumnToContents(0);
+    m_resultTree->resizeColumnToContents(1);
+
+    m_statusLabel->setText(hits.size() >= kMaxHits
+                           ? tr("前%1条结果（%2个文件已索引），耗时%3毫秒").arg(hits.size()).arg(m_index->documentCount()).arg(elapsedMs)
+                           : tr("%1条结果（%2个文件已索引），耗时%3毫秒").arg(hits.size()).arg(m_index->documentCount()).arg(elapsedMs));
+}
+
+void TranscriptSearchWidget::onItemActivated(QTreeWidgetItem *item, int column)
+{
+    Q_UNUSED(column);
+    emit hitActivated(item->data(0, kMediaFileRole).toString(), item->data(0, kStartMsRole).toLongLong());
+}
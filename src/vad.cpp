@@ -0,0 +1,28 @@
+#include "vad.h"
+
+void computeFrameEnergies(const float *samples, size_t count, size_t frameSamples, std::vector<float> &energies)
+{
+    energies.clear();
+    if (frameSamples == 0) {
+        return;
+    }
+
+    const size_t frames = count / frameSamples;
+    energies.resize(frames);
+    for (size_t frame = 0; frame < frames; ++frame) {
+        const float *p = samples + frame * frameSamples;
+        // 四路累加，便于编译器向量化
+        float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+        size_t i = 0;
+        for (; i + 4 <= frameSamples; i += 4) {
+            sum0 += p[i] * p[i];
+            sum1 += p[i + 1] * p[i + 1];
+            sum2 += p[i + 2] * p[i + 2];
+            sum3 += p[i + 3] * p[i + 3];
+        }
+        for (; i < frameSamples; ++i) {
+            sum0 += p[i] * p[i];
+        }
+        energies[frame] = (sum0 + sum1 + sum2 + sum3) / float(frameSamples);
+    }
+}
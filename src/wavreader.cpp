@@ -0,0 +1,188 @@
+#include "wavreader.h"
+
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+const int kWaveFormatPcm = 1;
+const int kWaveFormatExtensible = 0xFFFE;
+
+quint16 readLe16(const uchar *p)
+{
+    return quint16(p[0]) | (quint16(p[1]) << 8);
+}
+
+quint32 readLe32(const uchar *p)
+{
+    return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24);
+}
+
+WavParseResult fail(QString *errorMessage, const QString &message)
+{
+    if (errorMessage) {
+        *errorMessage = message;
+    }
+    return WavParseInvalid;
+}
+
+} // namespace
+
+WavParseResult parseWavHeader(const uchar *data, qint64 size, WavFormat &format, QString *errorMessage)
+{
+    format = WavFormat();
+
+    if (size < 12) {
+        return WavParseNeedMoreData;
+    }
+
+    if (memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) {
+        return fail(errorMessage, "不是RIFF/WAVE文件");
+    }
+
+    bool haveFormat = false;
+    qint64 offset = 12;
+
+    // 依次遍历各个块，块长度为奇数时后面有一个填充字节
+    while (offset + 8 <= size) {
+        const uchar *chunk = data + offset;
+        quint32 chunkSize = readLe32(chunk + 4);
+        qint64 body = offset + 8;
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16) {
+                return fail(errorMessage, "fmt块长度无效");
+            }
+            if (body + 16 > size) {
+                return WavParseNeedMoreData;
+            }
+
+            format.audioFormat = readLe16(data + body);
+            format.channels = readLe16(data + body + 2);
+            format.sampleRate = int(readLe32(data + body + 4));
+            format.blockAlign = readLe16(data + body + 12);
+            format.bitsPerSample = readLe16(data + body + 14);
+
+            // WAVE_FORMAT_EXTENSIBLE的子格式GUID前两个字节即实际格式
+            if (format.audioFormat == kWaveFormatExtensible) {
+                if (chunkSize < 40) {
+                    return fail(errorMessage, "扩展fmt块长度无效");
+                }
+                if (body + 26 > size) {
+                    return WavParseNeedMoreData;
+                }
+                format.audioFormat = readLe16(data + body + 24);
+            }
+
+            if (format.channels <= 0 || format.sampleRate <= 0 || format.blockAlign <= 0) {
+                return fail(errorMessage, "fmt块参数无效");
+            }
+            haveFormat = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                return fail(errorMessage, "data块出现在fmt块之前");
+            }
+            format.dataOffset = quint64(body);
+            format.dataSize = chunkSize;
+            return WavParseOk;
+        }
+
+        offset = body + qint64(chunkSize) + (chunkSize & 1);
+    }
+
+    return WavParseNeedMoreData;
+}
+
+WavReader::WavReader() : m_map(nullptr), m_mapSize(0)
+{
+}
+
+WavReader::~WavReader()
+{
+    close();
+}
+
+bool WavReader::open(const QString &filePath)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = "无法打开文件: " + m_file.errorString();
+        return false;
+    }
+
+    m_mapSize = m_file.size();
+    if (m_mapSize < 44) {
+        m_errorString = "文件过小，不是有效的WAV文件";
+        close();
+        return false;
+    }
+
+    m_map = m_file.map(0, m_mapSize);
+    if (!m_map) {
+        m_errorString = "内存映射失败: " + m_file.errorString();
+        close();
+        return false;
+    }
+
+    QString error;
+    WavParseResult result = parseWavHeader(m_map, m_mapSize, m_format, &error);
+    if (result != WavParseOk) {
+        m_errorString = result == WavParseNeedMoreData ? QString("WAV文件头不完整") : error;
+        close();
+        return false;
+    }
+
+    // 流式写出的WAV（例如ffmpeg输出到管道）没有正确的data长度，以实际文件长度为准
+    quint64 available = quint64(m_mapSize) - m_format.dataOffset;
+    if (m_format.dataSize == 0 || m_format.dataSize > available) {
+        m_format.dataSize = available;
+    }
+
+    return true;
+}
+
+void WavReader::close()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_mapSize = 0;
+    m_format = WavFormat();
+}
+
+bool WavReader::isPcm16() const
+{
+    // 样本按2字节对齐才能直接以int16_t访问映射内存
+    return isOpen()
+            && m_format.audioFormat == kWaveFormatPcm
+            && m_format.bitsPerSample == 16
+            && m_format.blockAlign == 2 * m_format.channels
+            && (m_format.dataOffset % 2) == 0;
+}
+
+bool WavReader::isRecognizerCompatible() const
+{
+    return isPcm16() && m_format.channels == 1 && m_format.sampleRate == 16000;
+}
+
+const int16_t *WavReader::pcm16Data() const
+{
+    if (!isPcm16()) {
+        return nullptr;
+    }
+    return reinterpret_cast<const int16_t *>(m_map + m_format.dataOffset);
+}
+
+qint64 WavReader::frameCount() const
+{
+    if (!isOpen() || m_format.blockAlign <= 0) {
+        return 0;
+    }
+    return qint64(m_format.dataSize / quint64(m_format.blockAlign));
+}
@@ -0,0 +1,139 @@
+#include "wer.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+bool isCjk(uint codePoint)
+{
+    return (codePoint >= 0x3040 && codePoint <= 0x30FF)     // 平假名、片假名
+        || (codePoint >= 0x3400 && codePoint <= 0x4DBF)     // CJK扩展A
+        || (codePoint >= 0x4E00 && codePoint <= 0x9FFF)     // CJK统一汉字
+        || (codePoint >= 0xAC00 && codePoint <= 0xD7AF)     // 韩文音节
+        || (codePoint >= 0xF900 && codePoint <= 0xFAFF)     // CJK兼容汉字
+        || (codePoint >= 0x20000 && codePoint <= 0x2FA1F);  // CJK扩展B及以后
+}
+
+/**
+ * @brief 编辑距离表中的一格：总代价和对应的替换、删除、插入数
+ */
+struct Cell
+{
+    int cost;
+    int substitutions;
+    int deletions;
+    int insertions;
+};
+
+} // namespace
+
+double WerResult::wer() const
+{
+    if (referenceWords == 0) {
+        return errors() == 0 ? 0.0 : 1.0;
+    }
+    return double(errors()) / referenceWords;
+}
+
+WerResult &WerResult::operator+=(const WerResult &other)
+{
+    substitutions += other.substitutions;
+    deletions += other.deletions;
+    insertions += other.insertions;
+    referenceWords += other.referenceWords;
+    return *this;
+}
+
+QStringList tokenizeForWer(const QString &text)
+{
+    QStringList words;
+    QString current;
+
+    auto flush = [&]() {
+        // 去掉词首尾的撇号，例如引号用法的'word'
+        while (current.startsWith('\'')) {
+            current.remove(0, 1);
+        }
+        while (current.endsWith('\'')) {
+            current.chop(1);
+        }
+        if (!current.isEmpty()) {
+            words << current;
+        }
+        current.clear();
+    };
+
+    const QVector<uint> codePoints = text.toLower().toUcs4();
+    for (uint codePoint : codePoints) {
+        if (isCjk(codePoint)) {
+            flush();
+            words << QString::fromUcs4(&codePoint, 1);
+        } else if (QChar::isLetterOrNumber(codePoint) || QChar::category(codePoint) == QChar::Mark_NonSpacing) {
+            current += QString::fromUcs4(&codePoint, 1);
+        } else if (codePoint == '\'' || codePoint == 0x2019) {
+            current += '\'';
+        } else {
+            flush();
+        }
+    }
+    flush();
+    return words;
+}
+
+WerResult computeWordErrorRate(const QStringList &reference, const QStringList &hypothesis)
+{
+    const int n = reference.size();
+    const int m = hypothesis.size();
+
+    // 只保留两行；代价相同时优先替换，其次删除、插入，与常见的WER工具一致
+    std::vector<Cell> previous(size_t(m) + 1);
+    std::vector<Cell> current(size_t(m) + 1);
+    for (int j = 0; j <= m; ++j) {
+        previous[size_t(j)] = { j, 0, 0, j };
+    }
+
+    for (int i = 1; i <= n; ++i) {
+        current[0] = { i, 0, i, 0 };
+        for (int j = 1; j <= m; ++j) {
+            const Cell &diagonal = previous[size_t(j - 1)];
+            Cell best;
+            if (reference[i - 1] == hypothesis[j - 1]) {
+                best = diagonal;
+            } else {
+                best = diagonal;
+                best.cost += 1;
+                best.substitutions += 1;
+            }
+
+            const Cell &up = previous[size_t(j)];
+            if (up.cost + 1 < best.cost) {
+                best = up;
+                best.cost += 1;
+                best.deletions += 1;
+            }
+
+            const Cell &left = current[size_t(j - 1)];
+            if (left.cost + 1 < best.cost) {
+                best = left;
+                best.cost += 1;
+                best.insertions += 1;
+            }
+            current[size_t(j)] = best;
+        }
+        std::swap(previous, current);
+    }
+
+    const Cell &last = previous[size_t(m)];
+    WerResult result;
+    result.substitutions = last.substitutions;
+    result.deletions = last.deletions;
+    result.insertions = last.insertions;
+    result.referenceWords = n;
+    return result;
+}
+
+WerResult computeWordErrorRate(const QString &referenceText, const QString &hypothesisText)
+{
+    return computeWordErrorRate(tokenizeForWer(referenceText), tokenizeForWer(hypothesisText));
+}
@@ -0,0 +1,44 @@
+// 强制对齐辅助函数的单元测试：拆分文本和估计词级时间
+// 用法：test_alignment，全部通过时返回0
+
+#include "alignment.h"
+#include "testcheck.h"
+
+namespace {
+
+QVector<qint32> values(std::initializer_list<qint32> list)
+{
+    return QVector<qint32>(list);
+}
+
+} // namespace
+
+int main()
+{
+    check(splitAlignmentWords("  Hello,\n\tworld  again ") == (QStringList() << "Hello," << "world" << "again"),
+          "words split on any whitespace");
+    check(splitAlignmentWords(" \n ").isEmpty(), "blank text has no words");
+
+    const QStringList words = QStringList() << "a" << "bbb" << "cc";
+
+    const TranscriptSegment proportional = buildAlignedSegment(words, QVector<qint64>(), 1000, 1600);
+    check(proportional.text == "a bbb cc" && proportional.startMs == 1000 && proportional.endMs == 1600, "segment text and span");
+    check(proportional.words.startMs == values({ 0, 100, 400 }) && proportional.words.endMs == values({ 100, 400, 600 }),
+          "times distributed by character count");
+    check(proportional.words.textOffset == values({ 0, 2, 6 }), "word offsets in joined text");
+
+    const TranscriptSegment hinted = buildAlignedSegment(words, QVector<qint64>() << -1 << -1 << 1500, 1000, 1600);
+    check(hinted.words.startMs == values({ 0, 125, 500 }) && hinted.words.endMs == values({ 125, 500, 600 }),
+          "word start hint used as anchor");
+
+    const TranscriptSegment rejected = buildAlignedSegment(words, QVector<qint64>() << -1 << 900 << 2000, 1000, 1600);
+    check(rejected.words == proportional.words, "hints outside the segment ignored");
+
+    const TranscriptSegment backwards = buildAlignedSegment(words, QVector<qint64>() << -1 << 1300 << 1200, 1000, 1600);
+    check(backwards.words.startMs == values({ 0, 300, 480 }), "non-increasing hint ignored");
+
+    const TranscriptSegment empty = buildAlignedSegment(QStringList(), QVector<qint64>(), 500, 400);
+    check(empty.text.isEmpty() && empty.words.isEmpty() && empty.endMs == 500, "empty segment clamped");
+
+    return testResult();
+}
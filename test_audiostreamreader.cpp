@@ -0,0 +1,191 @@
+// 音频流读取的单元测试：ffmpeg参数、从本机HTTP服务读取HLS、识别跟不上时丢弃旧音频、连接失败后重连、跟随文件
+// 用法：test_audiostreamreader，全部通过时返回0；没有ffmpeg时只检查参数
+//
+// HLS由ffmpeg从生成的正弦波切片，测试内置的HTTP服务只监听127.0.0.1，不需要访问外网。
+
+#include "audiostreamreader.h"
+#include "testcheck.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QThread>
+#include <cstdio>
+
+namespace {
+
+bool runFfmpeg(const QStringList &args)
+{
+    QProcess process;
+    process.start("ffmpeg", QStringList() << "-hide_banner" << "-loglevel" << "error" << "-y" << args);
+    return process.waitForFinished(60000) && process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+}
+
+/**
+ * @brief 只处理GET请求的静态文件服务，每个请求响应后关闭连接
+ */
+class StaticFileServer : public QTcpServer
+{
+public:
+    explicit StaticFileServer(const QString &root) : m_root(root) {}
+
+protected:
+    void incomingConnection(qintptr descriptor) override
+    {
+        QTcpSocket *socket = new QTcpSocket(this);
+        socket->setSocketDescriptor(descriptor);
+        connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() {
+            const QByteArray request = socket->peek(8192);
+            if (!request.contains("\r\n\r\n")) {
+                return;
+            }
+            socket->readAll();
+            const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+            const QString path = requestLine.size() >= 2 ? QString::fromUtf8(requestLine.at(1)).section('?', 0, 0) : QString();
+            QFile file(QDir(m_root).filePath(path.mid(1)));
+            if (path.contains("..") || !file.open(QIODevice::ReadOnly)) {
+                socket->write("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            } else {
+                const QByteArray body = file.readAll();
+                socket->write("HTTP/1.1 200 OK\r\nContent-Length: " + QByteArray::number(body.size())
+                              + "\r\nConnection: close\r\n\r\n" + body);
+            }
+            socket->disconnectFromHost();
+        });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+
+private:
+    QString m_root;
+};
+
+/**
+ * @brief 一直读到结束，读取期间处理事件（测试中的HTTP服务在主线程运行）
+ */
+qint64 readAll(AudioStreamReader &reader, qint64 &gapSamples, int readDelayMs = 0)
+{
+    std::vector<int16_t> samples;
+    qint64 total = 0;
+    gapSamples = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (;;) {
+        qint64 gap = 0;
+        QCoreApplication::processEvents();
+        if (!reader.read(samples, gap, 20)) {
+            break;
+        }
+        total += qint64(samples.size());
+        gapSamples += gap;
+        if (timer.elapsed() > 60000) {
+            break;
+        }
+        if (readDelayMs > 0 && !samples.empty()) {
+            QThread::msleep(readDelayMs);
+        }
+    }
+    return total;
+}
+
+// 允许AAC编码器的前导样本和最后一帧的补齐
+bool nearSeconds(qint64 samples, double seconds)
+{
+    return qAbs(samples - qint64(seconds * 16000)) < 16000 / 2;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    check(isStreamUrl("http://127.0.0.1:8000/live.m3u8") && isStreamUrl("RTSP://camera/stream")
+          && isStreamUrl("rtmp://server/app/key") && !isStreamUrl("/home/user/video.mp4")
+          && !isStreamUrl("C:/videos/lecture.mkv") && !isStreamUrl("file:///tmp/a.wav"), "stream URLs recognized");
+
+    const QStringList httpArgs = AudioStreamReader::ffmpegArguments("http://host/live.m3u8", AudioStreamReader::LiveStream, 15);
+    const QStringList rtspArgs = AudioStreamReader::ffmpegArguments("rtsp://host/stream", AudioStreamReader::LiveStream, 15);
+    const QStringList followArgs = AudioStreamReader::ffmpegArguments("/tmp/rec.mkv", AudioStreamReader::FollowFile, 30);
+    check(httpArgs.contains("-reconnect") && !httpArgs.contains("-rtsp_transport") && httpArgs.contains("nobuffer"),
+          "http options only for http");
+    check(rtspArgs.contains("-rtsp_transport") && !rtspArgs.contains("-reconnect"), "rtsp uses tcp transport");
+    check(followArgs.contains("-follow") && followArgs.at(followArgs.indexOf("-rw_timeout") + 1) == "30000000"
+          && followArgs.indexOf("-follow") < followArgs.indexOf("-i"), "follow mode input options");
+
+    if (!runFfmpeg(QStringList() << "-version")) {
+        std::printf("ffmpeg not available, stream tests skipped\n");
+        return testResult();
+    }
+
+    QTemporaryDir dir;
+    const QDir root(dir.path());
+    check(runFfmpeg(QStringList() << "-f" << "lavfi" << "-i" << "sine=frequency=440:sample_rate=44100:duration=6"
+                    << "-ac" << "2" << "-c:a" << "aac" << "-f" << "hls" << "-hls_time" << "1"
+                    << "-hls_playlist_type" << "vod" << root.filePath("stream.m3u8")),
+          "HLS fixture generated");
+
+    StaticFileServer server(dir.path());
+    check(server.listen(QHostAddress::LocalHost), "local HTTP server listening");
+    const QString url = QString("http://127.0.0.1:%1/stream.m3u8").arg(server.serverPort());
+
+    {
+        AudioStreamReader reader(url, AudioStreamReader::LiveStream);
+        qint64 gapSamples = 0;
+        const qint64 total = reader.start() ? readAll(reader, gapSamples) : 0;
+        check(nearSeconds(total, 6.0) && gapSamples == 0 && reader.errorString().isEmpty() && reader.reconnects() == 0,
+              "local HLS read completely");
+    }
+
+    {
+        // 没有服务监听的端口：重连一次后放弃
+        QTcpServer unused;
+        unused.listen(QHostAddress::LocalHost);
+        const QString deadUrl = QString("http://127.0.0.1:%1/stream.m3u8").arg(unused.serverPort());
+        unused.close();
+        AudioStreamReader reader(deadUrl, AudioStreamReader::LiveStream);
+        reader.setMaxReconnects(1);
+        qint64 gapSamples = 0;
+        const qint64 total = reader.start() ? readAll(reader, gapSamples) : -1;
+        check(total == 0 && reader.reconnects() == 1 && !reader.errorString().isEmpty(), "failed connection retried then reported");
+    }
+
+    {
+        // 跟随文件：没有新数据超过空闲超时后结束
+        const QString wavPath = root.filePath("recording.wav");
+        check(runFfmpeg(QStringList() << "-f" << "lavfi" << "-i" << "sine=frequency=220:sample_rate=16000:duration=2"
+                        << "-ac" << "1" << wavPath), "WAV fixture generated");
+        AudioStreamReader reader(wavPath, AudioStreamReader::FollowFile);
+        reader.setIdleTimeoutSeconds(1);
+        qint64 gapSamples = 0;
+        const qint64 total = reader.start() ? readAll(reader, gapSamples) : 0;
+        check(nearSeconds(total, 2.0) && gapSamples == 0 && reader.errorString().isEmpty(), "followed file ends after idle timeout");
+    }
+
+    {
+        // 读得慢、队列只有1秒：丢弃的音频作为缺口报告，收到的加上缺口仍等于整个流
+        // 用本地文件作为源，ffmpeg的输出远快于读取，不依赖HTTP服务的处理速度
+        const QString longPath = root.filePath("long.wav");
+        check(runFfmpeg(QStringList() << "-f" << "lavfi" << "-i" << "sine=frequency=330:sample_rate=16000:duration=6"
+                        << "-ac" << "1" << longPath), "long WAV fixture generated");
+        AudioStreamReader reader(longPath, AudioStreamReader::LiveStream);
+        reader.setCapacitySeconds(1);
+        qint64 gapSamples = 0;
+        const qint64 total = reader.start() ? readAll(reader, gapSamples, 300) : 0;
+        check(reader.droppedSamples() > 0 && gapSamples == reader.droppedSamples() && nearSeconds(total + gapSamples, 6.0),
+              "slow consumer drops oldest audio as a gap");
+    }
+
+    {
+        AudioStreamReader reader(root.filePath("missing.wav"), AudioStreamReader::FollowFile);
+        qint64 gapSamples = 0;
+        const qint64 total = reader.start() ? readAll(reader, gapSamples) : -1;
+        check(total == 0 && !reader.errorString().isEmpty(), "missing file reported");
+    }
+
+    return testResult();
+}
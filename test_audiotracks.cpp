@@ -0,0 +1,135 @@
+// 多音轨解码的单元测试：ffmpeg参数、ffprobe列出音轨、一次解码多条采样率和时长不同的音轨并按声道拆分
+// 用法：test_audiotracks，全部通过时返回0；没有ffmpeg时只检查参数
+
+#include "audiotracks.h"
+#include "pcmbuffer.h"
+#include "testcheck.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+bool runFfmpeg(const QStringList &args)
+{
+    QProcess process;
+    process.start("ffmpeg", QStringList() << "-hide_banner" << "-loglevel" << "error" << "-y" << args);
+    return process.waitForFinished(60000) && process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+}
+
+AudioTrack makeTrack(int index, qint64 durationMs)
+{
+    AudioTrack track;
+    track.index = index;
+    track.durationMs = durationMs;
+    return track;
+}
+
+// 允许AAC编码器的前导样本和最后一帧的补齐
+bool nearSeconds(size_t samples, double seconds)
+{
+    return qAbs(qint64(samples) - qint64(seconds * 16000)) < 16000 / 2;
+}
+
+/**
+ * @brief 由第一秒的过零次数估计正弦波的频率
+ */
+int estimateFrequency(const PcmBuffer &buffer)
+{
+    std::vector<float> samples(16000);
+    const size_t count = buffer.toFloat(0, samples.size(), samples.data());
+    int crossings = 0;
+    for (size_t i = 1; i < count; ++i) {
+        if ((samples[i - 1] < 0.0f) != (samples[i] < 0.0f)) {
+            ++crossings;
+        }
+    }
+    return crossings / 2;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList single = audioTracksFfmpegArguments("/tmp/a.mkv", QVector<AudioTrack>() << makeTrack(1, 6000));
+    check(!single.join(' ').contains("amerge") && !single.join(' ').contains("apad") && !single.contains("-t")
+          && single.join(' ').contains("[0:1]aresample=16000"), "single track needs no merge");
+
+    const QStringList merged = audioTracksFfmpegArguments("/tmp/a.mkv", QVector<AudioTrack>() << makeTrack(1, 4000) << makeTrack(3, 6500));
+    check(merged.join(' ').contains("[t0][t1]amerge=inputs=2[out]") && merged.join(' ').contains("[0:3]")
+          && merged.join(' ').contains("apad") && merged.at(merged.indexOf("-t") + 1) == "6.500",
+          "tracks padded to the longest and merged");
+
+    const QStringList unknown = audioTracksFfmpegArguments("/tmp/a.mkv", QVector<AudioTrack>() << makeTrack(1, -1) << makeTrack(2, 6000));
+    check(!unknown.join(' ').contains("apad") && !unknown.contains("-t"), "no padding when a duration is unknown");
+
+    if (!runFfmpeg(QStringList() << "-version")) {
+        std::printf("ffmpeg not available, decoding tests skipped\n");
+        return testResult();
+    }
+
+    // 一条视频和三条音轨：采样率、声道数和时长各不相同
+    QTemporaryDir dir;
+    const QString mediaPath = QDir(dir.path()).filePath("lecture.mkv");
+    check(runFfmpeg(QStringList()
+                    << "-f" << "lavfi" << "-i" << "color=size=64x64:duration=6"
+                    << "-f" << "lavfi" << "-i" << "sine=frequency=300:sample_rate=44100:duration=6"
+                    << "-f" << "lavfi" << "-i" << "sine=frequency=800:sample_rate=48000:duration=4"
+                    << "-f" << "lavfi" << "-i" << "sine=frequency=500:sample_rate=22050:duration=6"
+                    << "-map" << "0" << "-map" << "1" << "-map" << "2" << "-map" << "3"
+                    << "-ac:a:0" << "2" << "-c:v" << "mpeg4" << "-c:a" << "aac"
+                    << "-metadata:s:a:0" << "language=eng" << "-metadata:s:a:1" << "language=chi"
+                    << "-metadata:s:a:1" << "title=interpreter" << mediaPath),
+          "multi-track fixture generated");
+
+    QVector<AudioTrack> tracks;
+    QString error;
+    check(probeAudioTracks(mediaPath, tracks, &error) && tracks.size() == 3, "audio tracks probed");
+    if (tracks.size() != 3) {
+        return testResult();
+    }
+    check(tracks.at(0).index == 1 && tracks.at(0).language == "eng" && tracks.at(0).channels == 2
+          && tracks.at(1).title == "interpreter" && tracks.at(1).sampleRate == 48000,
+          "track metadata read");
+    check(qAbs(tracks.at(1).durationMs - 4000) < 200 && qAbs(tracks.at(2).durationMs - 6000) < 200,
+          "per-track durations read");
+    check(tracks.at(1).label().contains("#2") && tracks.at(1).label().contains("interpreter"), "track label");
+
+    // 一次解码第二、三条音轨：短的音轨不带补齐的静音
+    PcmBuffer interpreter;
+    PcmBuffer commentary;
+    qint64 sourceBytes = 0;
+    check(decodeAudioTracks(mediaPath, QVector<AudioTrack>() << tracks.at(1) << tracks.at(2),
+                            QVector<PcmBuffer *>() << &interpreter << &commentary, &sourceBytes, &error),
+          "two tracks decoded in one pass");
+    check(nearSeconds(interpreter.size(), 4.0) && nearSeconds(commentary.size(), 6.0), "each track keeps its own length");
+    check(qAbs(estimateFrequency(interpreter) - 800) < 20 && qAbs(estimateFrequency(commentary) - 500) < 20,
+          "channels split to the right tracks");
+    check(sourceBytes > qint64(commentary.size() * 2 * sizeof(int16_t)), "interleaved output counted");
+
+    PcmBuffer original;
+    check(decodeAudioTracks(mediaPath, QVector<AudioTrack>() << tracks.at(0), QVector<PcmBuffer *>() << &original,
+                            nullptr, &error)
+          && nearSeconds(original.size(), 6.0) && qAbs(estimateFrequency(original) - 300) < 20,
+          "single stereo track downmixed");
+
+    // 边解码边交给接收者：接收者返回false时结束ffmpeg
+    qint64 streamed = 0;
+    check(!decodeAudioTracks(mediaPath, QVector<AudioTrack>() << tracks.at(0) << tracks.at(2),
+                             [&streamed](int, const int16_t *, size_t count) {
+                                 streamed += qint64(count);
+                                 return streamed < 16000;
+                             }, nullptr, &error)
+          && error.contains("取消") && streamed < 16000 * 3, "sink stops decoding");
+
+    check(!decodeAudioTracks(mediaPath, QVector<AudioTrack>() << tracks.at(0), QVector<PcmBuffer *>(), nullptr, &error)
+          && !error.isEmpty(), "mismatched outputs rejected");
+
+    return testResult();
+}
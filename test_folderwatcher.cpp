@@ -0,0 +1,119 @@
+// 文件夹监视的单元测试：关闭后报告、过滤扩展名、新建子目录、只打开不写入时不重复报告、未关闭的文件等静默期
+// 用法：test_folderwatcher，全部通过时返回0；不支持inotify的平台直接通过
+
+#include "folderwatcher.h"
+#include "testcheck.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <cstdio>
+
+namespace {
+
+bool writeFile(const QString &path, const QByteArray &content)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(content) == content.size();
+}
+
+// 处理事件直到报告了path或超时
+bool waitForReady(QStringList &ready, const QString &path, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!ready.contains(path) && timer.elapsed() < timeoutMs) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+    }
+    return ready.contains(path);
+}
+
+void processEventsFor(int milliseconds)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < milliseconds) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    if (!FolderWatcher::isSupported()) {
+        std::printf("folder watching not supported on this platform, skipped\n");
+        return 0;
+    }
+
+    QTemporaryDir dir;
+    const QDir root(dir.path());
+    QString error;
+
+    FolderWatcher watcher;
+    watcher.setNameFilters(QStringList() << "*.mp4" << "*.mkv");
+    watcher.setQuietPeriod(300);
+    QStringList ready;
+    QObject::connect(&watcher, &FolderWatcher::fileReady, [&ready](const QString &path) { ready << path; });
+
+    check(watcher.setFolders(QStringList() << dir.path(), &error) && error.isEmpty()
+          && watcher.folders().size() == 1, "folder watched");
+
+    const QString lecture = root.filePath("lecture.MP4");
+    check(writeFile(lecture, "video") && waitForReady(ready, lecture, 5000) && ready.count(lecture) == 1,
+          "closed file reported once");
+
+    const QString notes = root.filePath("notes.txt");
+    check(writeFile(notes, "text") && (processEventsFor(1500), !ready.contains(notes)), "other extensions ignored");
+
+    // 只打开后关闭，大小和修改时间都没变
+    ready.clear();
+    {
+        QFile file(lecture);
+        file.open(QIODevice::ReadWrite);
+    }
+    processEventsFor(1500);
+    check(!ready.contains(lecture), "unchanged file not reported again");
+
+    const QString nested = root.filePath("course/week1/lecture2.mkv");
+    check(root.mkpath("course/week1") && (processEventsFor(200), writeFile(nested, "second"))
+          && waitForReady(ready, nested, 5000), "file in new subdirectory reported");
+
+    // 整个目录移出再移回：没有单个文件的事件，记录要在重新扫描后清理，移回的文件才会再报告
+    QTemporaryDir outside;
+    const QString movedOut = QDir(outside.path()).filePath("course");
+    check(QDir().rename(root.filePath("course"), movedOut) && (processEventsFor(200), true), "directory moved out");
+    watcher.pruneReported();
+    ready.clear();
+    check(QDir().rename(movedOut, root.filePath("course")) && waitForReady(ready, nested, 5000),
+          "file moved back reported after pruning");
+
+    // 写入方一直不关闭文件：静默期内有写入时不报告
+    const QString recording = root.filePath("recording.mp4");
+    QFile growing(recording);
+    check(growing.open(QIODevice::WriteOnly), "growing file opened");
+    for (int i = 0; i < 5; ++i) {
+        growing.write(QByteArray(1024, 'x'));
+        growing.flush();
+        processEventsFor(150);
+    }
+    check(!ready.contains(recording), "file still being written not reported");
+    check(waitForReady(ready, recording, 5000), "file reported after quiet period");
+    growing.close();
+
+    check(watcher.setFolders(QStringList(), &error) && watcher.folders().isEmpty(), "watching stopped");
+    ready.clear();
+    check(writeFile(root.filePath("after.mp4"), "late") && (processEventsFor(1500), ready.isEmpty()),
+          "no reports after stop");
+
+    check(!watcher.setFolders(QStringList() << root.filePath("missing"), &error) && !error.isEmpty(),
+          "missing folder rejected");
+
+    return testResult();
+}
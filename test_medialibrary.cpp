@@ -0,0 +1,113 @@
+// 媒体库的单元测试：首次扫描、未变化时跳过、修改时间变化、内容变化、移动、删除和移除目录
+// 用法：test_medialibrary，全部通过时返回0
+//
+// 测试文件不是真正的媒体文件，ffprobe失败时文件仍然加入媒体库，这里不检查媒体信息。
+
+#include "medialibrary.h"
+#include "testcheck.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace {
+
+bool writeFile(const QString &path, const QByteArray &content)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(content) == content.size();
+}
+
+bool setModified(const QString &path, const QDateTime &time)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadWrite) && file.setFileTime(time, QFileDevice::FileModificationTime);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir dir;
+    const QDir root(dir.path());
+    const QString mediaDir = root.filePath("media");
+    QString error;
+
+    const QString lecture1 = QDir(mediaDir).filePath("lecture1.mp4");
+    const QString lecture2 = QDir(mediaDir).filePath("course/lecture2.MKV");
+    const QString notes = QDir(mediaDir).filePath("notes.txt");
+    check(writeFile(lecture1, QByteArray(300 * 1024, 'a')) && writeFile(lecture2, "second lecture")
+          && writeFile(notes, "not media"), "fixture written");
+
+    const QByteArray hash1 = mediaContentHash(lecture1);
+    check(hash1.size() == 20 && hash1 == mediaContentHash(lecture1) && hash1 != mediaContentHash(lecture2),
+          "content hash stable and distinct");
+
+    MediaLibrary library;
+    check(library.open(root.filePath("db/library.db"), &error), "database created");
+
+    MediaScanStats stats;
+    check(library.scan(mediaDir, stats, &error) && stats.filesSeen == 2 && stats.added == 2 && library.size() == 2,
+          "first scan adds media files only");
+    check(library.folders() == QStringList() << QDir::cleanPath(QFileInfo(mediaDir).absoluteFilePath()), "folder recorded");
+
+    MediaLibraryEntry entry;
+    check(library.entry(lecture1, entry) && entry.size == 300 * 1024 && entry.contentHash == hash1
+          && entry.transcriptStatus == TranscriptStatus::None, "entry stored");
+    check(library.entries("COURSE").size() == 1 && library.entries("%").isEmpty(), "filter matches path, wildcards escaped");
+
+    int progressCalls = 0;
+    check(library.scan(mediaDir, stats, &error, [&progressCalls](int, int) { ++progressCalls; })
+          && stats.unchanged == 2 && stats.added == 0 && progressCalls == 0, "rescan skips unchanged files without hashing");
+
+    check(library.setTranscriptStatus(lecture1, TranscriptStatus::Transcribed, "/subs/lecture1.qet", &error)
+          && library.entry(lecture1, entry) && entry.transcriptStatus == TranscriptStatus::Transcribed
+          && entry.transcriptPath == "/subs/lecture1.qet", "transcript status updated");
+
+    // 只改修改时间：计算指纹后发现内容没变，字幕状态保留
+    check(setModified(lecture1, QDateTime::currentDateTime().addSecs(-3600))
+          && library.scan(mediaDir, stats, &error) && stats.touched == 1 && stats.unchanged == 1
+          && library.entry(lecture1, entry) && entry.transcriptStatus == TranscriptStatus::Transcribed,
+          "touched file keeps transcript");
+
+    // 改名：指纹与消失的文件相同，视为移动
+    const QString renamed = QDir(mediaDir).filePath("archive/lecture1-final.mp4");
+    QDir().mkpath(QFileInfo(renamed).absolutePath());
+    check(QFile::rename(lecture1, renamed) && library.scan(mediaDir, stats, &error) && stats.moved == 1
+          && stats.added == 0 && stats.removed == 0 && !library.entry(lecture1, entry)
+          && library.entry(renamed, entry) && entry.transcriptPath == "/subs/lecture1.qet", "moved file keeps transcript");
+
+    // 内容变化：字幕作废
+    check(library.setTranscriptStatus(lecture2, TranscriptStatus::Transcribed, "/subs/lecture2.qet", &error)
+          && writeFile(lecture2, "second lecture, re-encoded") && setModified(lecture2, QDateTime::currentDateTime().addSecs(60))
+          && library.scan(mediaDir, stats, &error) && stats.updated == 1 && library.entry(lecture2, entry)
+          && entry.transcriptStatus == TranscriptStatus::None && entry.size == 26, "changed file resets transcript");
+
+    check(QFile::remove(lecture2) && library.scan(mediaDir, stats, &error) && stats.removed == 1 && library.size() == 1,
+          "deleted file removed");
+    check(!library.scan(root.filePath("missing"), stats, &error) && library.size() == 1, "missing folder rejected");
+    const std::atomic<bool> cancelled(true);
+    check(writeFile(QDir(mediaDir).filePath("lecture4.mp3"), "fourth")
+          && !library.scan(mediaDir, stats, &error, MediaLibrary::ProgressCallback(), &cancelled) && library.size() == 1,
+          "cancelled scan writes nothing");
+    check(QFile::remove(QDir(mediaDir).filePath("lecture4.mp3")), "cancelled fixture removed");
+
+    // 子目录单独加入后，移除父目录保留子目录中的文件
+    const QString archiveDir = QFileInfo(renamed).absolutePath();
+    check(writeFile(QDir(mediaDir).filePath("lecture3.mp3"), "third") && library.scan(mediaDir, stats, &error)
+          && library.scan(archiveDir, stats, &error) && library.size() == 2 && library.folders().size() == 2,
+          "nested folder added");
+    check(library.removeFolder(mediaDir, &error) && library.size() == 1 && library.entry(renamed, entry)
+          && library.folders().size() == 1, "removing parent keeps nested folder files");
+
+    MediaLibrary reopened;
+    check(reopened.open(root.filePath("db/library.db"), &error) && reopened.size() == 1
+          && reopened.entry(renamed, entry) && entry.transcriptStatus == TranscriptStatus::Transcribed, "library persisted");
+
+    return testResult();
+}
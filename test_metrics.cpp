@@ -0,0 +1,74 @@
+// 指标注册表的单元测试
+// 用法：test_metrics，全部通过时返回0
+
+#include "metrics.h"
+#include "testcheck.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+bool contains(const std::string &text, const std::string &needle)
+{
+    return text.find(needle) != std::string::npos;
+}
+
+} // namespace
+
+int main()
+{
+    MetricsRegistry &registry = MetricsRegistry::instance();
+
+    // 多个线程并发更新，导出时汇总所有分片
+    MetricCounter &jobs = registry.counter("test_jobs_total", "Jobs processed.");
+    MetricHistogram &latency = registry.histogram("test_latency_seconds", "Latency.", { 0.1, 1.0 }, "stage=\"decode\"");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 32; ++t) {
+        threads.emplace_back([&jobs, &latency]() {
+            for (int i = 0; i < 10000; ++i) {
+                jobs.increment();
+            }
+            latency.observe(0.05);
+            latency.observe(0.5);
+            latency.observe(5.0);
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    check(jobs.value() == 320000, "counter sums all shards");
+    check(&registry.counter("test_jobs_total", "Jobs processed.") == &jobs, "re-registering returns the same counter");
+
+    std::vector<uint64_t> buckets;
+    double sum = 0;
+    check(latency.snapshot(buckets, sum) == 96 && buckets[0] == 32 && buckets[1] == 32 && buckets[2] == 32,
+          "histogram buckets are per-bucket counts");
+
+    registry.histogram("test_latency_seconds", "Latency.", { 0.1, 1.0 }, "stage=\"inference\"").observe(0.2);
+    registry.gauge("test_running", "Running jobs.").set(3);
+    registry.gaugeCallback("test_memory_bytes", "Memory.", []() { return 1048576.0; });
+
+    // 以其他类型注册已有的指标族：返回的对象可用，但不混入导出
+    MetricGauge &conflicting = registry.gauge("test_jobs_total", "Wrong type.");
+    conflicting.set(7);
+    registry.gauge("test_jobs_total", "Wrong type.", "kind=\"other\"").set(8);
+    check(conflicting.value() == 7, "conflicting registration still usable");
+
+    const std::string text = registry.renderPrometheus();
+    check(contains(text, "# TYPE test_jobs_total counter\ntest_jobs_total 320000\n"), "counter exposition");
+    check(contains(text, "test_latency_seconds_bucket{stage=\"decode\",le=\"0.1\"} 32\n"), "first bucket");
+    check(contains(text, "test_latency_seconds_bucket{stage=\"decode\",le=\"1\"} 64\n"), "buckets are cumulative");
+    check(contains(text, "test_latency_seconds_bucket{stage=\"decode\",le=\"+Inf\"} 96\n"), "+Inf bucket");
+    check(contains(text, "test_latency_seconds_count{stage=\"decode\"} 96\n"), "histogram count");
+    check(contains(text, "test_latency_seconds_sum{stage=\"inference\"} 0.2\n"), "second label set");
+    check(text.find("# TYPE test_latency_seconds histogram") == text.rfind("# TYPE test_latency_seconds histogram"),
+          "family header emitted once");
+    check(contains(text, "test_running 3\n"), "gauge exposition");
+    check(contains(text, "test_memory_bytes 1048576\n"), "callback gauge evaluated at scrape");
+    check(!contains(text, "# TYPE test_jobs_total gauge") && !contains(text, "test_jobs_total 7")
+          && !contains(text, "kind=\"other\""), "type conflicts are not exported");
+
+    return testResult();
+}
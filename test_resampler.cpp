@@ -0,0 +1,302 @@
+// 重采样器和降混的精度测试，并输出吞吐量
+// 用法：test_resampler，全部通过时返回0
+
+#include "resampler.h"
+#include "pcmconvert.h"
+#include "testcheck.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+std::vector<float> makeSine(int rate, double frequency, size_t count, double amplitude = 0.5)
+{
+    std::vector<float> samples(count);
+    for (size_t i = 0; i < count; ++i) {
+        samples[i] = float(amplitude * std::sin(2.0 * kPi * frequency * i / rate));
+    }
+    return samples;
+}
+
+std::vector<float> resampleAll(PolyphaseResampler &resampler, const std::vector<float> &input)
+{
+    std::vector<float> output;
+    resampler.process(input.data(), input.size(), output);
+    resampler.flush(output);
+    return output;
+}
+
+// 直接按定义计算的双精度参考：y[n] = sum_k x[k] * h(n*M/L - k)，按相位归一化
+std::vector<double> reference(const PolyphaseResampler &resampler, const std::vector<float> &input)
+{
+    const int up = resampler.upFactor();
+    const int down = resampler.downFactor();
+    const int halfTaps = resampler.tapsPerPhase() / 2;
+    const size_t outputCount = size_t((int64_t(input.size()) * up + down - 1) / down);
+
+    std::vector<double> output(outputCount);
+    for (size_t n = 0; n < outputCount; ++n) {
+        const int64_t q = int64_t(n) * down / up;
+        const double t = double(int64_t(n) * down) / up;
+        double sum = 0.0;
+        double weight = 0.0;
+        for (int64_t k = q - halfTaps + 1; k <= q + halfTaps; ++k) {
+            double h = resampler.kernel(t - k);
+            weight += h;
+            if (k >= 0 && k < int64_t(input.size())) {
+                sum += input[size_t(k)] * h;
+            }
+        }
+        output[n] = sum / weight;
+    }
+    return output;
+}
+
+// 最小二乘拟合已知频率的正弦，返回信号与残差的功率比（dB）
+double sineSnr(const std::vector<float> &samples, int rate, double frequency, size_t skip)
+{
+    double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+    for (size_t i = skip; i + skip < samples.size(); ++i) {
+        double s = std::sin(2.0 * kPi * frequency * i / rate);
+        double c = std::cos(2.0 * kPi * frequency * i / rate);
+        ss += s * s;
+        sc += s * c;
+        cc += c * c;
+        ys += samples[i] * s;
+        yc += samples[i] * c;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det;
+    double b = (yc * ss - ys * sc) / det;
+
+    double signal = 0, noise = 0;
+    for (size_t i = skip; i + skip < samples.size(); ++i) {
+        double fit = a * std::sin(2.0 * kPi * frequency * i / rate) + b * std::cos(2.0 * kPi * frequency * i / rate);
+        signal += fit * fit;
+        noise += (samples[i] - fit) * (samples[i] - fit);
+    }
+    return 10.0 * std::log10(signal / noise);
+}
+
+double rms(const std::vector<float> &samples, size_t skip)
+{
+    double sum = 0;
+    size_t count = 0;
+    for (size_t i = skip; i + skip < samples.size(); ++i) {
+        sum += double(samples[i]) * samples[i];
+        ++count;
+    }
+    return std::sqrt(sum / count);
+}
+
+void testAgainstReference(int inputRate)
+{
+    PolyphaseResampler resampler(inputRate, 16000);
+
+    std::vector<float> input(inputRate / 4);
+    std::srand(1);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = float(std::rand()) / RAND_MAX - 0.5f;
+    }
+
+    std::vector<float> output = resampleAll(resampler, input);
+    std::vector<double> expected = reference(resampler, input);
+
+    double maxError = 0;
+    for (size_t i = 0; i < expected.size() && i < output.size(); ++i) {
+        maxError = std::max(maxError, std::fabs(output[i] - expected[i]));
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%d->16000 length matches reference", inputRate);
+    check(output.size() == expected.size(), name, double(output.size()));
+    std::snprintf(name, sizeof(name), "%d->16000 max error vs reference", inputRate);
+    check(maxError < 1e-5, name, maxError);
+}
+
+void testSineQuality(int inputRate, double frequency)
+{
+    PolyphaseResampler resampler(inputRate, 16000);
+    std::vector<float> output = resampleAll(resampler, makeSine(inputRate, frequency, size_t(inputRate)));
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%d->16000 %gHz sine SNR (dB)", inputRate, frequency);
+    double snr = sineSnr(output, 16000, frequency, 400);
+    check(snr > 70.0, name, snr);
+}
+
+void testAliasRejection(int inputRate, double frequency)
+{
+    // 高于输出奈奎斯特频率的信号应当被滤除，而不是折叠到低频
+    PolyphaseResampler resampler(inputRate, 16000);
+    std::vector<float> output = resampleAll(resampler, makeSine(inputRate, frequency, size_t(inputRate)));
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%d->16000 %gHz alias level (dB)", inputRate, frequency);
+    double level = 20.0 * std::log10(rms(output, 400) / (0.5 / std::sqrt(2.0)) + 1e-12);
+    check(level < -70.0, name, level);
+}
+
+void testStreaming(int inputRate)
+{
+    std::vector<float> input = makeSine(inputRate, 997.0, size_t(inputRate) / 2);
+
+    PolyphaseResampler oneShot(inputRate, 16000);
+    std::vector<float> expected = resampleAll(oneShot, input);
+
+    // 不规则的分块大小，包括1个样本的块
+    PolyphaseResampler chunked(inputRate, 16000);
+    std::vector<float> output;
+    size_t offset = 0;
+    size_t chunk = 1;
+    while (offset < input.size()) {
+        size_t n = std::min(chunk, input.size() - offset);
+        chunked.process(input.data() + offset, n, output);
+        offset += n;
+        chunk = chunk * 7 % 1013 + 1;
+    }
+    chunked.flush(output);
+
+    bool identical = output == expected;
+    char name[64];
+    std::snprintf(name, sizeof(name), "%d->16000 chunked equals one-shot", inputRate);
+    check(identical, name, double(output.size()));
+}
+
+void testDownmix(int channels)
+{
+    const size_t frames = 10007;
+    std::vector<int16_t> interleaved(frames * channels);
+    std::srand(channels);
+    for (size_t i = 0; i < interleaved.size(); ++i) {
+        interleaved[i] = int16_t(std::rand() % 65536 - 32768);
+    }
+
+    std::vector<float> output(frames);
+    downmixS16ToMono(interleaved.data(), frames, channels, output.data());
+
+    double maxError = 0;
+    for (size_t i = 0; i < frames; ++i) {
+        const int16_t *frame = &interleaved[i * channels];
+        double expected = 0;
+        if (channels == 6) {
+            const double c = std::sqrt(0.5);
+            expected = (0.5 * (frame[0] + frame[1]) + c * frame[2] + 0.5 * c * (frame[4] + frame[5]))
+                     / (1.0 + 2.0 * c) / 32768.0;
+        } else {
+            for (int ch = 0; ch < channels; ++ch) {
+                expected += frame[ch];
+            }
+            expected /= channels * 32768.0;
+        }
+        maxError = std::max(maxError, std::fabs(output[i] - expected));
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "downmix %d channels max error", channels);
+    check(maxError < 1e-6, name, maxError);
+}
+
+void testConverter()
+{
+    // 立体声44.1kHz按任意字节切分推入，结果应与一次推入完全相同
+    const int rate = 44100;
+    std::vector<int16_t> interleaved(size_t(rate) * 2);
+    for (size_t i = 0; i < interleaved.size() / 2; ++i) {
+        int16_t value = int16_t(10000.0 * std::sin(2.0 * kPi * 440.0 * i / rate));
+        interleaved[i * 2] = value;
+        interleaved[i * 2 + 1] = value;
+    }
+    const char *bytes = reinterpret_cast<const char *>(interleaved.data());
+    const size_t size = interleaved.size() * sizeof(int16_t);
+
+    AudioConverter whole(rate, 2, 16000);
+    std::vector<int16_t> expected;
+    whole.pushBytes(bytes, size, expected);
+    whole.finish(expected);
+
+    AudioConverter pieces(rate, 2, 16000);
+    std::vector<int16_t> output;
+    size_t offset = 0;
+    size_t chunk = 3;
+    while (offset < size) {
+        size_t n = std::min(chunk, size - offset);
+        pieces.pushBytes(bytes + offset, n, output);
+        offset += n;
+        chunk = chunk * 5 % 4099 + 1;
+    }
+    pieces.finish(output);
+
+    check(output == expected, "converter byte-split equals one-shot", double(output.size()));
+    check(expected.size() == 16000, "converter output length", double(expected.size()));
+
+    std::vector<float> asFloat(expected.size());
+    convertS16ToF32(expected.data(), asFloat.data(), expected.size());
+    double snr = sineSnr(asFloat, 16000, 440.0, 400);
+    check(snr > 60.0, "converter 440Hz SNR after int16 (dB)", snr);
+}
+
+void benchmark(int inputRate, int channels)
+{
+    const size_t frames = size_t(inputRate) * 60;
+    std::vector<int16_t> interleaved(frames * channels);
+    for (size_t i = 0; i < frames; ++i) {
+        int16_t value = int16_t(8000.0 * std::sin(2.0 * kPi * 440.0 * i / inputRate));
+        for (int ch = 0; ch < channels; ++ch) {
+            interleaved[i * channels + ch] = value;
+        }
+    }
+
+    AudioConverter converter(inputRate, channels, 16000);
+    std::vector<int16_t> output;
+    output.reserve(16000 * 61);
+
+    auto start = std::chrono::steady_clock::now();
+    converter.pushFrames(interleaved.data(), frames, output);
+    converter.finish(output);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("[BENCH] %dHz x%d -> 16000Hz mono: 60s audio in %.1f ms (%.0fx realtime, %.1f Msamples/s in)\n",
+                inputRate, channels, seconds * 1000.0, 60.0 / seconds, frames / seconds / 1e6);
+}
+
+} // namespace
+
+int main()
+{
+    testAgainstReference(48000);
+    testAgainstReference(44100);
+    testAgainstReference(22050);
+    testAgainstReference(8000);
+
+    testSineQuality(48000, 1000.0);
+    testSineQuality(44100, 1000.0);
+    testSineQuality(44100, 6500.0);
+
+    testAliasRejection(48000, 12000.0);
+    testAliasRejection(44100, 9000.0);
+
+    testStreaming(48000);
+    testStreaming(44100);
+    testStreaming(22050);
+
+    testDownmix(1);
+    testDownmix(2);
+    testDownmix(6);
+    testDownmix(3);
+
+    testConverter();
+
+    benchmark(48000, 2);
+    benchmark(44100, 2);
+    benchmark(44100, 6);
+    benchmark(22050, 1);
+
+    return testResult();
+}
@@ -0,0 +1,121 @@
+// 分段并行解码的单元测试：分段规划、ffmpeg参数、并行解码拼接后与单个ffmpeg解码的结果一致
+// 用法：test_segmenteddecode，全部通过时返回0；没有ffmpeg时只检查规划和参数
+
+#include "segmenteddecode.h"
+#include "pcmbuffer.h"
+#include "testcheck.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+bool runFfmpeg(const QStringList &args)
+{
+    QProcess process;
+    process.start("ffmpeg", QStringList() << "-hide_banner" << "-loglevel" << "error" << "-y" << args);
+    return process.waitForFinished(60000) && process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+}
+
+QString argumentAfter(const QStringList &args, const QString &option)
+{
+    const int index = args.indexOf(option);
+    return index >= 0 && index + 1 < args.size() ? args.at(index + 1) : QString();
+}
+
+/**
+ * @brief 两段样本逐个比较，返回最大差值
+ */
+int maxDifference(const PcmBuffer &a, const PcmBuffer &b)
+{
+    const size_t count = qMin(a.size(), b.size());
+    std::vector<int16_t> left(16000);
+    std::vector<int16_t> right(16000);
+    int worst = 0;
+    for (size_t offset = 0; offset < count; offset += left.size()) {
+        const size_t n = a.toInt16(offset, qMin(left.size(), count - offset), left.data());
+        b.toInt16(offset, n, right.data());
+        for (size_t i = 0; i < n; ++i) {
+            worst = qMax(worst, std::abs(int(left[i]) - int(right[i])));
+        }
+    }
+    return worst;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    check(planDecodeRanges(0, 0, true, 8, 300000).isEmpty(), "nothing planned for empty media");
+
+    const QVector<DecodeRange> shortMedia = planDecodeRanges(0, 180000, true, 8, 300000);
+    check(shortMedia.size() == 1 && shortMedia.first().durationMs == -1 && shortMedia.first().leadInMs == 0,
+          "short media decoded in one part");
+
+    // 30分钟从第60秒开始，最多4段
+    const QVector<DecodeRange> lecture = planDecodeRanges(60000, 1800000, false, 4, 300000);
+    check(lecture.size() == 4 && lecture.at(1).startMs == 510000 && lecture.at(3).startMs == 1410000,
+          "parts evenly spaced from the start");
+    check(lecture.at(0).leadInMs == 0 && lecture.at(1).leadInMs == 1000 && lecture.at(0).durationMs == 450000
+          && lecture.at(3).durationMs == 450000, "lead-in only after a boundary");
+
+    // 边界向上取整到整秒，最后一段取剩余部分
+    const QVector<DecodeRange> rounded = planDecodeRanges(0, 1000500, false, 2, 1000);
+    check(rounded.size() == 2 && rounded.at(1).startMs == 501000 && rounded.at(1).durationMs == 499500,
+          "boundaries rounded to whole seconds");
+    check(planDecodeRanges(0, 1000500, true, 2, 1000).last().durationMs == -1, "last part can run to the end");
+
+    DecodeRange middle;
+    middle.startMs = 600000;
+    middle.durationMs = 300000;
+    middle.leadInMs = 1000;
+    const QStringList middleArgs = decodeRangeFfmpegArguments("/tmp/a.m4a", middle);
+    check(argumentAfter(middleArgs, "-ss") == "599.000" && argumentAfter(middleArgs, "-t") == "302.000"
+          && middleArgs.indexOf("-ss") < middleArgs.indexOf("-i"), "seek covers lead-in and lead-out");
+    const QStringList firstArgs = decodeRangeFfmpegArguments("/tmp/a.m4a", DecodeRange());
+    check(!firstArgs.contains("-ss") && !firstArgs.contains("-t"), "unbounded first part reads the whole file");
+
+    if (!runFfmpeg(QStringList() << "-version")) {
+        std::printf("ffmpeg not available, decoding tests skipped\n");
+        return testResult();
+    }
+
+    // 频率随时间变化的扫频信号，拼接错位会产生明显的差值
+    QTemporaryDir dir;
+    const QString mediaPath = QDir(dir.path()).filePath("sweep.m4a");
+    check(runFfmpeg(QStringList() << "-f" << "lavfi" << "-i" << "aevalsrc=0.5*sin(2*PI*(200+20*t)*t):s=44100:d=40"
+                    << "-ac" << "2" << "-c:a" << "aac" << mediaPath),
+          "sweep fixture generated");
+
+    PcmBuffer whole;
+    QString error;
+    check(decodeRangesInParallel(mediaPath, planDecodeRanges(0, 40000, true, 1, 1000), whole, nullptr, &error),
+          "single range decoded");
+
+    PcmBuffer parts;
+    parts.setSpillPolicy(64 * 1024, dir.path());
+    qint64 sourceBytes = 0;
+    const QVector<DecodeRange> ranges = planDecodeRanges(0, 40000, true, 4, 5000);
+    check(ranges.size() == 4, "four parts planned");
+    check(decodeRangesInParallel(mediaPath, ranges, parts, &sourceBytes, &error), "parts decoded in parallel");
+    check(qAbs(qint64(parts.size()) - qint64(whole.size())) <= 16 && qAbs(qint64(whole.size()) - 40 * 16000) < 16000 / 2,
+          "joined length matches a single decode");
+    check(maxDifference(whole, parts) <= 256, "joined samples match a single decode");
+    check(sourceBytes > qint64(parts.size() * sizeof(int16_t)), "source bytes include every part");
+    check(parts.memoryBudgetBytes() == 64 * 1024, "memory budget restored after joining");
+
+    // 探测的时长比实际长：中间的段严重不足时整体失败，调用方改用单个ffmpeg
+    check(!decodeRangesInParallel(mediaPath, planDecodeRanges(0, 90000, false, 3, 1000), parts, nullptr, &error)
+          && parts.empty() && !error.isEmpty(), "short parts rejected");
+    check(!decodeRangesInParallel(QDir(dir.path()).filePath("missing.m4a"), ranges, parts, nullptr, &error)
+          && parts.empty(), "missing file rejected");
+
+    return testResult();
+}
@@ -0,0 +1,92 @@
+// 片段存储的单元测试：追加、隐式共享和读写
+// 用法：test_segmentstore，全部通过时返回0
+
+#include "segmentstore.h"
+#include "testcheck.h"
+
+#include <QBuffer>
+#include <cstring>
+
+namespace {
+
+bool sameSegments(const QVector<TranscriptSegment> &a, const QVector<TranscriptSegment> &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].startMs != b[i].startMs || a[i].endMs != b[i].endMs || a[i].text != b[i].text || !(a[i].words == b[i].words)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    QVector<TranscriptSegment> segments;
+    for (int i = 0; i < 1000; ++i) {
+        TranscriptSegment segment;
+        segment.startMs = i * 1000;
+        segment.endMs = i * 1000 + 900;
+        segment.text = QString::fromUtf8(" line %1 \xc3\xa9t\xc3\xa9").arg(i);
+        if (i % 2 == 0) {
+            segment.words.startMs << 0 << 300 << 600;
+            segment.words.endMs << 250 << 550 << 900;
+            segment.words.textOffset << 0 << 5 << 5 + QString::number(i).size() + 1;
+        }
+        segments.append(segment);
+    }
+
+    SegmentStore store = SegmentStore::fromSegments(segments);
+    check(store.size() == 1000, "all segments appended");
+    check(sameSegments(store.toSegments(), segments), "segments round trip through the store");
+    check(store.record(2).wordCount == 3 && store.record(3).wordCount == 0, "word ranges recorded per segment");
+
+    // 文本保存为UTF-8
+    const SegmentRecord &first = store.record(0);
+    check(first.textBytes == quint32(segments[0].text.toUtf8().size())
+          && std::memcmp(store.textData(0), segments[0].text.toUtf8().constData(), first.textBytes) == 0,
+          "text stored as UTF-8 in the arena");
+
+    TranscriptSegment a;
+    a.text = " hello";
+    TranscriptSegment b;
+    b.text = "world ";
+    check(SegmentStore::fromSegments(QVector<TranscriptSegment>() << a << b).joinedText() == " hello world ",
+          "joined text separates segments with a space");
+
+    // 复制只共享数据，修改副本不影响原存储
+    {
+        SegmentStore copy = store;
+        check(copy.textData(0) == store.textData(0), "copy shares the arena");
+        copy.append(a);
+        check(copy.size() == 1001 && store.size() == 1000, "modifying a copy detaches it");
+    }
+
+    // 写入后读回
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::ReadWrite);
+        check(store.writeTo(&buffer), "store written");
+        buffer.seek(0);
+        QString error;
+        const SegmentStore loaded = SegmentStore::readFrom(&buffer, &error);
+        check(error.isEmpty() && sameSegments(loaded.toSegments(), segments), "store read back unchanged");
+
+        QByteArray truncated = buffer.data();
+        truncated.chop(10);
+        QBuffer truncatedBuffer(&truncated);
+        truncatedBuffer.open(QIODevice::ReadOnly);
+        check(SegmentStore::readFrom(&truncatedBuffer, &error).isEmpty() && !error.isEmpty(), "truncated data rejected");
+
+        QByteArray garbage("not a store at all, just some bytes");
+        QBuffer garbageBuffer(&garbage);
+        garbageBuffer.open(QIODevice::ReadOnly);
+        check(SegmentStore::readFrom(&garbageBuffer, &error).isEmpty(), "foreign data rejected");
+    }
+
+    return testResult();
+}
@@ -0,0 +1,153 @@
+// 字幕文件格式的单元测试：SRT、WebVTT、JSON和内存映射二进制格式的读写，流式解析和字幕空白
+// 用法：test_transcriptformats，全部通过时返回0
+
+#include "mappedtranscript.h"
+#include "transcriptformats.h"
+#include "testcheck.h"
+
+#include <QDir>
+#include <QTemporaryDir>
+
+namespace {
+
+TranscriptSegment segment(qint64 startMs, qint64 endMs, const QString &text)
+{
+    TranscriptSegment result;
+    result.startMs = startMs;
+    result.endMs = endMs;
+    result.text = text;
+    return result;
+}
+
+bool sameTimingAndText(const QVector<TranscriptSegment> &a, const QVector<TranscriptSegment> &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].startMs != b[i].startMs || a[i].endMs != b[i].endMs || a[i].text.trimmed() != b[i].text.trimmed()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    QVector<TranscriptSegment> segments;
+    for (int i = 0; i < 2000; ++i) {
+        segments.append(segment(i * 1000, i * 1000 + 800, QString::fromUtf8(" caf\xc3\xa9 %1").arg(i)));
+    }
+    segments[1].words.startMs << 0 << 400;
+    segments[1].words.endMs << 300 << 800;
+    segments[1].words.textOffset << 0 << 5;
+
+    // 文本格式
+    {
+        const QString srt = toSrt(segments.mid(0, 2));
+        check(srt.startsWith(QString::fromUtf8("1\n00:00:00,000 --> 00:00:00,800\ncaf\xc3\xa9 0\n")), "SRT cue layout");
+
+        // 一百小时以上小时字段超过两位，毫秒分隔符仍然正确
+        TranscriptSegment late;
+        late.startMs = 100LL * 3600 * 1000 + 1500;
+        late.endMs = late.startMs + 500;
+        late.text = "late";
+        check(toSrt(QVector<TranscriptSegment>() << late).contains("100:00:01,500 --> 100:00:02,000"),
+              "three-digit hours keep the separator");
+
+        QVector<TranscriptSegment> parsed;
+        check(parseSubtitleCues(toSrt(segments), parsed) && sameTimingAndText(parsed, segments), "SRT round trip");
+        check(parseSubtitleCues(toVtt(segments), parsed) && sameTimingAndText(parsed, segments), "WebVTT round trip");
+
+        const QString vtt = "WEBVTT\n\nNOTE a comment\n\n00:01.500 --> 00:02.000 align:start\n<v Speaker>Hello\nthere</v>\n";
+        check(parseSubtitleCues(vtt, parsed) && parsed.size() == 1 && parsed[0].startMs == 1500
+              && parsed[0].text == "Hello there", "WebVTT short timestamps, settings and tags");
+
+        check(parseTranscriptJson(toTranscriptJson(segments), parsed) && sameTimingAndText(parsed, segments)
+              && parsed[1].words == segments[1].words, "JSON round trip with words");
+
+        const QByteArray whisperJson = "{\"transcription\":[{\"offsets\":{\"from\":1000,\"to\":2500},\"text\":\" hi\"}]}";
+        check(parseTranscriptJson(whisperJson, parsed) && parsed.size() == 1 && parsed[0].endMs == 2500,
+              "whisper.cpp JSON accepted");
+    }
+
+    // 流式解析：任意分块得到同样的结果，容忍BOM和CRLF
+    {
+        const QByteArray srt = QByteArray("\xef\xbb\xbf") + toSrt(segments.mid(0, 50)).toUtf8().replace("\n", "\r\n");
+        QVector<TranscriptSegment> whole;
+        check(parseSubtitleCues(toSrt(segments.mid(0, 50)), whole) && whole.size() == 50, "reference parse");
+
+        const int chunkSizes[] = { 1, 7, 4096 };
+        for (int chunkSize : chunkSizes) {
+            SubtitleCueParser parser;
+            for (int offset = 0; offset < srt.size(); offset += chunkSize) {
+                parser.feed(srt.constData() + offset, qMin(chunkSize, srt.size() - offset));
+            }
+            parser.finish();
+            check(sameTimingAndText(parser.segments(), whole),
+                  QString("chunked parse (%1 byte chunks)").arg(chunkSize).toUtf8().constData());
+        }
+
+        SubtitleCueParser parser;
+        const QByteArray unterminated = "1\n00:00:01,000 --> 00:00:02,000\n{\\an8}<i>last</i> line";
+        parser.feed(unterminated.constData(), unterminated.size());
+        parser.finish();
+        check(parser.segments().size() == 1 && parser.segments()[0].text == "last line",
+              "final cue without trailing newline");
+    }
+
+    // 已有字幕中的空白
+    {
+        QVector<TranscriptSegment> subtitles;
+        subtitles << segment(40000, 45000, "a") << segment(44000, 50000, "b") << segment(52000, 53000, "c")
+                  << segment(-1, -1, "untimed") << segment(100000, 101000, "d");
+        const QVector<TranscriptGap> gaps = findTranscriptGaps(subtitles, 200000, 30000);
+        check(gaps.size() == 3 && gaps[0].startMs == 0 && gaps[0].endMs == 40000
+              && gaps[1].startMs == 53000 && gaps[1].endMs == 100000
+              && gaps[2].startMs == 101000 && gaps[2].endMs == 200000, "gaps between and around subtitles");
+        check(findTranscriptGaps(subtitles, -1, 30000).size() == 2, "unknown duration has no trailing gap");
+        check(findTranscriptGaps(subtitles, 110000, 30000).size() == 2, "short trailing gap ignored");
+    }
+
+    // 二进制格式
+    {
+        QTemporaryDir dir;
+        const QString path = QDir(dir.path()).filePath("transcript.qet");
+        QString error;
+        check(writeTranscriptFile(path, segments, &error), "binary transcript written");
+
+        MappedTranscript transcript;
+        check(transcript.open(path, &error) && transcript.size() == 2000, "binary transcript mapped");
+        check(transcript.firstSegmentFrom(5400) == 5 && transcript.firstSegmentFrom(5900) == 6,
+              "segment found by time");
+
+        const QVector<TranscriptSegment> range = transcript.segmentsInRange(10500, 13000);
+        check(range.size() == 3 && range[0].startMs == 10000 && range[2].startMs == 12000, "time range query");
+        check(transcript.segment(1).words == segments[1].words, "word table preserved");
+
+        QVector<TranscriptSegment> loaded;
+        check(readTranscriptFile(path, loaded, &error) && sameTimingAndText(loaded, segments), "binary round trip");
+        check(transcript.sourceKey() == 0, "source key unset by default");
+
+        // 缓存按来源媒体的完整路径区分：同名文件在不同目录、只有扩展名不同时标识不同
+        const quint64 key = MappedTranscript::sourceKeyFor("/media/a/talk.mp4");
+        check(key != 0 && key == MappedTranscript::sourceKeyFor("/media/a/../a/talk.mp4")
+              && key != MappedTranscript::sourceKeyFor("/media/b/talk.mp4")
+              && key != MappedTranscript::sourceKeyFor("/media/a/talk.mkv"), "source key follows the full path");
+        const QString keyed = QDir(dir.path()).filePath("keyed.qet");
+        MappedTranscript keyedTranscript;
+        check(MappedTranscript::write(keyed, segments, &error, key) && keyedTranscript.open(keyed, &error)
+              && keyedTranscript.sourceKey() == key && keyedTranscript.size() == 2000, "source key stored in the header");
+
+        const QString bogus = QDir(dir.path()).filePath("bogus.qet");
+        QFile file(bogus);
+        file.open(QIODevice::WriteOnly);
+        file.write("definitely not a transcript file");
+        file.close();
+        check(!transcript.open(bogus, &error) && !error.isEmpty(), "foreign file rejected");
+    }
+
+    return testResult();
+}
@@ -0,0 +1,83 @@
+// 字幕全文索引的单元测试：分词、增量索引、合并、替换和删除文档、重新打开
+// 用法：test_transcriptindex，全部通过时返回0
+
+#include "mappedtranscript.h"
+#include "transcriptindex.h"
+#include "testcheck.h"
+
+#include <QDir>
+#include <QTemporaryDir>
+
+namespace {
+
+TranscriptSegment segment(qint64 startMs, qint64 endMs, const QString &text)
+{
+    TranscriptSegment result;
+    result.startMs = startMs;
+    result.endMs = endMs;
+    result.text = text;
+    return result;
+}
+
+QString mediaPath(int lecture)
+{
+    return QString("/media/lecture%1.mp4").arg(lecture);
+}
+
+} // namespace
+
+int main()
+{
+    check(TranscriptIndex::tokenize(QString::fromUtf8("Hello, WORLD! don't \xe4\xbd\xa0\xe5\xa5\xbd"))
+          == (QStringList() << "hello" << "world" << "don" << "t" << QString::fromUtf8("\xe4\xbd\xa0") << QString::fromUtf8("\xe5\xa5\xbd")),
+          "tokenize words and ideographs");
+
+    QTemporaryDir dir;
+    const QString indexDir = QDir(dir.path()).filePath("index");
+    QString error;
+
+    TranscriptIndex index;
+    check(index.open(indexDir, &error), "index created");
+
+    // 十个文档：偶数号讲座讲到了梯度下降
+    bool added = true;
+    for (int i = 0; i < 10; ++i) {
+        QVector<TranscriptSegment> segments;
+        segments << segment(0, 4000, QString(" Welcome to lecture %1").arg(i));
+        if (i % 2 == 0) {
+            segments << segment(5000, 8000, " Today we discuss gradient descent");
+        }
+        segments << segment(9000, 12000, " The gradient of a function");
+        const QString transcriptPath = QDir(dir.path()).filePath(QString("lecture%1.qet").arg(i));
+        added = added && MappedTranscript::write(transcriptPath, segments, &error)
+                && index.addDocument(mediaPath(i), transcriptPath, segments, &error);
+    }
+    check(added && index.documentCount() == 10, "documents added");
+    check(index.runCount() < 10, "runs merged as documents arrive");
+
+    QVector<TranscriptSearchHit> hits = index.search("Gradient descent ");
+    check(hits.size() == 5 && hits[0].mediaFilePath == mediaPath(8) && hits[4].mediaFilePath == mediaPath(0),
+          "all terms required, newest document first");
+    check(!hits.isEmpty() && hits[0].startMs == 5000 && hits[0].endMs == 8000
+          && hits[0].text == "Today we discuss gradient descent", "hit text read from transcript");
+
+    hits = index.search("gradi");
+    check(hits.size() == 15 && hits[0].mediaFilePath == mediaPath(9)
+          && hits[1].mediaFilePath == mediaPath(8) && hits[1].startMs == 5000 && hits[2].startMs == 9000,
+          "last term matched as prefix, hits ordered by time within a document");
+    check(index.search("gradi ").isEmpty(), "trailing space disables prefix match");
+    check(index.search("gradient", 3).size() == 3, "hit limit respected");
+    check(index.search("lecture 7 ").size() == 1, "number terms indexed");
+
+    // 重新索引同一媒体文件替换旧内容，删除的文档不再出现
+    const QVector<TranscriptSegment> replaced = QVector<TranscriptSegment>() << segment(0, 1000, " Nothing relevant");
+    check(index.addDocument(mediaPath(8), QDir(dir.path()).filePath("lecture8.qet"), replaced, &error)
+          && index.documentCount() == 10 && index.search("descent ").size() == 4, "reindexed document replaced");
+    check(index.removeDocument(mediaPath(0), &error) && index.search("descent ").size() == 3, "removed document hidden");
+
+    TranscriptIndex reopened;
+    check(reopened.open(indexDir, &error) && reopened.documentCount() == 9 && reopened.search("descent ").size() == 3
+          && reopened.search("relevant").size() == 1, "index persisted");
+
+    return testResult();
+}
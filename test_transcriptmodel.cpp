@@ -0,0 +1,198 @@
+// 字幕列表模型的单元测试：检查更新时只通知变化的行，以及时间与文本位置的换算
+// 用法：test_transcriptmodel，全部通过时返回0
+
+#include "transcriptmodel.h"
+#include "testcheck.h"
+
+namespace {
+
+TranscriptSegment segment(qint64 startMs, qint64 endMs, const QString &text)
+{
+    TranscriptSegment result;
+    result.startMs = startMs;
+    result.endMs = endMs;
+    result.text = text;
+    return result;
+}
+
+/**
+ * @brief 记录模型发出的结构变化通知
+ */
+struct ChangeLog
+{
+    int inserted = 0;
+    int removed = 0;
+    int changed = 0;
+    int resets = 0;
+
+    explicit ChangeLog(TranscriptModel &model)
+    {
+        QObject::connect(&model, &QAbstractItemModel::rowsInserted, [this](const QModelIndex &, int first, int last) {
+            inserted += last - first + 1;
+        });
+        QObject::connect(&model, &QAbstractItemModel::rowsRemoved, [this](const QModelIndex &, int first, int last) {
+            removed += last - first + 1;
+        });
+        QObject::connect(&model, &QAbstractItemModel::dataChanged, [this](const QModelIndex &first, const QModelIndex &last) {
+            changed += last.row() - first.row() + 1;
+        });
+        QObject::connect(&model, &QAbstractItemModel::modelReset, [this]() { ++resets; });
+    }
+
+    bool none() const { return inserted == 0 && removed == 0 && changed == 0 && resets == 0; }
+};
+
+} // namespace
+
+int main()
+{
+    QVector<TranscriptSegment> segments;
+    for (int i = 0; i < 1000; ++i) {
+        segments.append(segment(i * 1000, i * 1000 + 900, QString("line %1").arg(i)));
+    }
+
+    // 流式插入之后再用相同的最终结果覆盖，不应产生任何通知
+    {
+        TranscriptModel model;
+        model.insertSegments(segments.mid(0, 500));
+        model.insertSegments(segments.mid(500));
+        check(model.rowCount() == 1000, "streamed batches are appended");
+
+        ChangeLog log(model);
+        model.setSegments(segments);
+        check(log.none(), "final result identical to streamed rows is a no-op");
+    }
+
+    // 区间替换只影响区间内的行
+    {
+        TranscriptModel model;
+        model.setSegments(segments);
+        ChangeLog log(model);
+
+        QVector<TranscriptSegment> replacement;
+        replacement << segment(10000, 10500, "a") << segment(10500, 11000, "b") << segment(11000, 11900, "c");
+        model.replaceRange(replacement, 10000, 12000);
+        check(model.rowCount() == 1001, "range replaced with one extra row");
+        check(log.resets == 0 && log.removed == 2 && log.inserted == 3, "only rows in the range are touched");
+        check(model.index(10).data(TranscriptModel::TextRole).toString() == "a"
+              && model.index(13).data(TranscriptModel::TextRole).toString() == "line 12",
+              "replacement rows are in time order");
+    }
+
+    // 区间识别：先移除区间，再流式插入到区间位置
+    {
+        TranscriptModel model;
+        model.setSegments(segments);
+        model.replaceRange(QVector<TranscriptSegment>(), 5000, 7000);
+        check(model.rowCount() == 998, "range cleared before streaming");
+
+        model.insertSegments(QVector<TranscriptSegment>() << segment(5000, 6000, "x"));
+        check(model.index(5).data(TranscriptModel::TextRole).toString() == "x", "streamed row inserted at its time");
+    }
+
+    // 行数不变时只发出数据变化
+    {
+        TranscriptModel model;
+        model.setSegments(segments);
+        ChangeLog log(model);
+
+        QVector<TranscriptSegment> edited = segments;
+        edited[42].text = "edited";
+        model.setSegments(edited);
+        check(log.changed == 1 && log.inserted == 0 && log.removed == 0, "single edited row reported as dataChanged");
+    }
+
+    // 显示文本按需生成
+    {
+        TranscriptModel model;
+        model.setSegments(QVector<TranscriptSegment>() << segment(61000, 62500, " hello "));
+        check(model.index(0).data().toString() == "[00:01:01.000 --> 00:01:02.500] hello", "display role formats timestamps");
+
+        model.setUntimedText("first\nsecond\n");
+        check(model.rowCount() == 2 && model.index(1).data().toString() == "second", "untimed text shown line by line");
+    }
+
+    // 时间、行和全文偏移之间的换算
+    {
+        TranscriptModel model;
+        model.setSegments(segments);
+        check(model.rowAtTime(-5) == -1, "time before first row has no row");
+        check(model.rowAtTime(0) == 0 && model.rowAtTime(42999) == 42 && model.rowAtTime(5000000) == 999,
+              "row found by start time");
+        check(model.timeAtCharacter(42, 0) == 42000 && model.timeAtCharacter(42, 7) == 42900,
+              "character position interpolated within the segment");
+
+        // "line 0".."line 9"各6个字符，"line 10"起7个字符，每行加一个换行符
+        check(model.textOffsetOfRow(1) == 7 && model.textOffsetOfRow(11) == 78, "text offsets are prefix sums");
+        check(model.rowAtTextOffset(77) == 10 && model.rowAtTextOffset(78) == 11, "row found by text offset");
+        check(model.timeAtTextOffset(78) == 11000, "text offset maps to start time");
+        check(model.textOffsetAtTime(11000) == 78, "start time maps back to text offset");
+
+        // 插入和区间替换后前缀数组同步更新
+        model.replaceRange(QVector<TranscriptSegment>() << segment(10000, 11900, "replaced line"), 10000, 12000);
+        check(model.rowAtTime(11500) == 10 && model.rowAtTime(12000) == 11, "time index follows replaced range");
+        check(model.textOffsetOfRow(11) == 70 + 14, "text offsets follow replaced range");
+    }
+
+    // 有词级时间戳时按词定位
+    {
+        TranscriptSegment timed = segment(20000, 23000, " hello brave world");
+        timed.words.startMs << 0 << 1200 << 2000;
+        timed.words.endMs << 1000 << 1900 << 3000;
+        timed.words.textOffset << 0 << 6 << 12;
+        check(timed.words.wordAt(-1) == -1 && timed.words.wordAt(1500) == 1 && timed.words.wordAt(5000) == 2,
+              "word found by relative time");
+
+        TranscriptModel model;
+        model.setSegments(QVector<TranscriptSegment>() << timed);
+        check(model.timeAtCharacter(0, 8) == 21200, "character maps to the start of its word");
+    }
+
+    // 跨过区间边界的旧片段只截掉区间内的部分
+    {
+        TranscriptSegment straddling = segment(9000, 13000, "alpha beta gamma delta");
+        straddling.words.startMs << 0 << 1000 << 2500 << 3500;
+        straddling.words.endMs << 900 << 2000 << 3000 << 4000;
+        straddling.words.textOffset << 0 << 6 << 11 << 17;
+        const QVector<TranscriptSegment> merged = mergeTranscriptSegments(
+            QVector<TranscriptSegment>() << segment(0, 900, "before") << straddling,
+            QVector<TranscriptSegment>() << segment(10000, 12000, "replacement"), 10000, 12000);
+        check(merged.size() == 4 && merged.at(0).text == "before" && merged.at(2).text == "replacement",
+              "straddling segment split around the range");
+        check(merged.at(1).text == "alpha" && merged.at(1).startMs == 9000 && merged.at(1).endMs == 10000
+              && merged.at(1).words.size() == 1, "head keeps the words before the range");
+        check(merged.at(3).text == "delta" && merged.at(3).startMs == 12500 && merged.at(3).endMs == 13000
+              && merged.at(3).words.startMs.at(0) == 0 && merged.at(3).words.textOffset.at(0) == 0,
+              "tail keeps the words after the range");
+
+        // whisper的片段文本以空格开头，词的偏移相对去掉空白后的文本
+        TranscriptSegment spaced = straddling;
+        spaced.text = " alpha beta gamma delta";
+        spaced.words.endMs[1] = 1500;
+        spaced.words.startMs[2] = 2100;
+        const QVector<TranscriptSegment> leading = mergeTranscriptSegments(
+            QVector<TranscriptSegment>() << spaced, QVector<TranscriptSegment>(), 10600, 11000);
+        check(leading.size() == 2 && leading.at(0).text == "alpha beta" && leading.at(0).words.textOffset.at(1) == 6,
+              "head offsets kept for text with a leading space");
+        check(leading.at(1).text == "gamma delta" && leading.at(1).words.textOffset.at(0) == 0
+              && leading.at(1).words.textOffset.at(1) == 6, "tail offsets kept for text with a leading space");
+
+        // 没有词级时间戳时按时间比例截断，有空格的文本对齐到词边界
+        const QVector<TranscriptSegment> untimed = mergeTranscriptSegments(
+            QVector<TranscriptSegment>() << segment(8000, 12000, "one two three four"),
+            QVector<TranscriptSegment>(), 10000, 14000);
+        check(untimed.size() == 1 && untimed.at(0).text == "one two" && untimed.at(0).endMs == 10000,
+              "untimed head cut at a word boundary");
+        const QVector<TranscriptSegment> cjk = mergeTranscriptSegments(
+            QVector<TranscriptSegment>() << segment(0, 4000, QString::fromUtf8("一二三四")),
+            QVector<TranscriptSegment>(), 2000, 5000);
+        check(cjk.size() == 1 && cjk.at(0).text == QString::fromUtf8("一二"), "text without spaces cut by time");
+
+        const QVector<TranscriptSegment> covering = mergeTranscriptSegments(
+            QVector<TranscriptSegment>() << segment(0, 4000, "a b c d"), QVector<TranscriptSegment>(), 1000, 3000);
+        check(covering.size() == 2 && covering.at(0).text == "a" && covering.at(1).text == "d"
+              && covering.at(1).startMs == 3000, "segment covering the range keeps both ends");
+    }
+
+    return testResult();
+}
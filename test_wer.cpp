@@ -0,0 +1,56 @@
+// 词错误率计算的单元测试
+// 用法：test_wer，全部通过时返回0
+
+#include "wer.h"
+#include "testcheck.h"
+
+#include <cmath>
+
+namespace {
+
+bool counts(const WerResult &result, int substitutions, int deletions, int insertions, int referenceWords)
+{
+    return result.substitutions == substitutions && result.deletions == deletions
+        && result.insertions == insertions && result.referenceWords == referenceWords;
+}
+
+} // namespace
+
+int main()
+{
+    check(computeWordErrorRate(QString("the cat sat"), QString("the cat sat")).wer() == 0.0,
+          "identical text has zero errors");
+
+    check(counts(computeWordErrorRate(QString("the cat sat on the mat"), QString("the cat sit on mat")), 1, 1, 0, 6),
+          "one substitution and one deletion");
+
+    check(counts(computeWordErrorRate(QString("hello world"), QString("hello big wide world")), 0, 0, 2, 2),
+          "insertions are counted");
+
+    WerResult substitution = computeWordErrorRate(QString("a b c d"), QString("a x c d"));
+    check(std::fabs(substitution.wer() - 0.25) < 1e-12, "wer is errors over reference words");
+
+    check(computeWordErrorRate(QString("Hello, World! It's fine."), QString("hello world it's fine")).errors() == 0,
+          "case and punctuation are ignored");
+
+    check(tokenizeForWer(QString("'quoted' don’t")) == (QStringList() << "quoted" << "don't"),
+          "outer apostrophes stripped, inner kept");
+
+    check(tokenizeForWer(QString::fromUtf8("我们 学习English")) == (QStringList() << QString::fromUtf8("我")
+                                                                               << QString::fromUtf8("们")
+                                                                               << QString::fromUtf8("学")
+                                                                               << QString::fromUtf8("习")
+                                                                               << "english"),
+          "CJK characters are scored individually");
+
+    check(computeWordErrorRate(QString(""), QString("")).wer() == 0.0, "empty reference and hypothesis");
+    check(computeWordErrorRate(QString(""), QString("noise")).wer() == 1.0, "empty reference with output");
+    check(counts(computeWordErrorRate(QString("one two"), QString("")), 0, 2, 0, 2), "empty hypothesis deletes all");
+
+    WerResult corpus;
+    corpus += computeWordErrorRate(QString("a b"), QString("a c"));
+    corpus += computeWordErrorRate(QString("d e f g"), QString("d e f g"));
+    check(corpus.errors() == 1 && corpus.referenceWords == 6, "results accumulate across files");
+
+    return testResult();
+}
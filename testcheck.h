@@ -0,0 +1,50 @@
+#ifndef TESTCHECK_H
+#define TESTCHECK_H
+
+// 单元测试共用的检查和结果汇总：每项检查输出一行PASS/FAIL，main最后返回testResult()
+
+#include <cstdio>
+
+namespace testcheck {
+
+inline int &failures()
+{
+    static int count = 0;
+    return count;
+}
+
+} // namespace testcheck
+
+inline void check(bool condition, const char *name)
+{
+    std::printf("[%s] %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition) {
+        ++testcheck::failures();
+    }
+}
+
+/**
+ * @brief 同时输出测得的数值，用于精度类的检查
+ */
+inline void check(bool condition, const char *name, double value)
+{
+    std::printf("[%s] %-48s %g\n", condition ? "PASS" : "FAIL", name, value);
+    if (!condition) {
+        ++testcheck::failures();
+    }
+}
+
+/**
+ * @brief 输出汇总，全部通过时返回0，作为main的返回值
+ */
+inline int testResult()
+{
+    if (testcheck::failures() > 0) {
+        std::printf("%d test(s) failed\n", testcheck::failures());
+        return 1;
+    }
+    std::printf("all tests passed\n");
+    return 0;
+}
+
+#endif // TESTCHECK_H